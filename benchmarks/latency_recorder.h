@@ -0,0 +1,47 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+namespace rag {
+namespace bench {
+
+// Per-iteration wall-clock samples reported as p50/p95/p99 counters next to
+// Google Benchmark's mean time and items/s throughput.
+class LatencyRecorder {
+public:
+    void start() { begin_ = std::chrono::steady_clock::now(); }
+    
+    void stop() {
+        samples_.push_back(std::chrono::duration<double, std::micro>(
+            std::chrono::steady_clock::now() - begin_).count());
+    }
+    
+    void report(benchmark::State& state) {
+        if (samples_.empty()) {
+            return;
+        }
+        std::sort(samples_.begin(), samples_.end());
+        // Multi-threaded runs report the mean of per-thread percentiles
+        auto counter = [](double value) { return benchmark::Counter(value, benchmark::Counter::kAvgThreads); };
+        state.counters["p50_us"] = counter(percentile(0.50));
+        state.counters["p95_us"] = counter(percentile(0.95));
+        state.counters["p99_us"] = counter(percentile(0.99));
+        state.counters["max_us"] = counter(samples_.back());
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+    }
+    
+private:
+    std::chrono::steady_clock::time_point begin_;
+    std::vector<double> samples_;
+    
+    double percentile(double q) const {
+        size_t index = static_cast<size_t>(q * (samples_.size() - 1) + 0.5);
+        return samples_[std::min(index, samples_.size() - 1)];
+    }
+};
+
+} // namespace bench
+} // namespace rag
@@ -0,0 +1,501 @@
+#include "mock_api_server.h"
+#include <nlohmann/json.hpp>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <iomanip>
+
+namespace rag {
+namespace bench {
+
+namespace {
+
+uint64_t fnv1a(const std::string& text) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : text) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+uint64_t splitmix64(uint64_t& state) {
+    uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+double unitRandom(uint64_t& state) {
+    return (splitmix64(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+std::mt19937_64& threadRng() {
+    thread_local std::mt19937_64 rng(std::hash<std::thread::id>()(std::this_thread::get_id()));
+    return rng;
+}
+
+// Days since 1970-01-01 -> YYYY-MM-DD (proleptic Gregorian)
+std::string dateFromDays(int64_t z) {
+    z += 719468;
+    int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    int64_t doe = z - era * 146097;
+    int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int64_t y = yoe + era * 400;
+    int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int64_t mp = (5 * doy + 2) / 153;
+    int64_t d = doy - (153 * mp + 2) / 5 + 1;
+    int64_t m = mp < 10 ? mp + 3 : mp - 9;
+    y += m <= 2;
+    char buffer[16];
+    std::snprintf(buffer, sizeof(buffer), "%04d-%02d-%02d", static_cast<int>(y), static_cast<int>(m), static_cast<int>(d));
+    return buffer;
+}
+
+std::string formatPrice(double value) {
+    std::ostringstream ss;
+    ss << std::fixed << std::setprecision(4) << value;
+    return ss.str();
+}
+
+std::string statusText(int status) {
+    switch (status) {
+        case 200: return "OK";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 429: return "Too Many Requests";
+        default: return "Internal Server Error";
+    }
+}
+
+std::string urlDecode(const std::string& value) {
+    std::string decoded;
+    for (size_t i = 0; i < value.size(); ++i) {
+        if (value[i] == '%' && i + 2 < value.size()) {
+            decoded += static_cast<char>(std::stoi(value.substr(i + 1, 2), nullptr, 16));
+            i += 2;
+        } else if (value[i] == '+') {
+            decoded += ' ';
+        } else {
+            decoded += value[i];
+        }
+    }
+    return decoded;
+}
+
+std::map<std::string, std::string> parseQuery(const std::string& query) {
+    std::map<std::string, std::string> params;
+    std::stringstream ss(query);
+    std::string pair;
+    while (std::getline(ss, pair, '&')) {
+        size_t eq = pair.find('=');
+        if (eq != std::string::npos) {
+            params[pair.substr(0, eq)] = urlDecode(pair.substr(eq + 1));
+        }
+    }
+    return params;
+}
+
+nlohmann::json errorJson(const std::string& message, const std::string& type) {
+    return {{"error", {{"message", message}, {"type", type}}}};
+}
+
+// encoding_format "base64": the raw little-endian float32 bytes
+std::string base64Floats(const std::vector<float>& values) {
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    const auto* bytes = reinterpret_cast<const uint8_t*>(values.data());
+    size_t size = values.size() * sizeof(float);
+    std::string encoded;
+    encoded.reserve((size + 2) / 3 * 4);
+    for (size_t i = 0; i < size; i += 3) {
+        uint32_t group = uint32_t(bytes[i]) << 16;
+        group |= i + 1 < size ? uint32_t(bytes[i + 1]) << 8 : 0;
+        group |= i + 2 < size ? bytes[i + 2] : 0;
+        encoded += alphabet[(group >> 18) & 0x3F];
+        encoded += alphabet[(group >> 12) & 0x3F];
+        encoded += i + 1 < size ? alphabet[(group >> 6) & 0x3F] : '=';
+        encoded += i + 2 < size ? alphabet[group & 0x3F] : '=';
+    }
+    return encoded;
+}
+
+constexpr int64_t kLastSessionDay = 19902; // 2024-06-28, a Friday
+
+} // namespace
+
+MockApiServer::MockApiServer(const MockServerConfig& config) : config_(config) {
+}
+
+MockApiServer::~MockApiServer() {
+    stop();
+}
+
+std::string MockApiServer::baseUrl() const {
+    return "http://127.0.0.1:" + std::to_string(port_);
+}
+
+bool MockApiServer::start() {
+    listen_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd_ < 0) {
+        return false;
+    }
+    int reuse = 1;
+    ::setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(static_cast<uint16_t>(config_.port));
+    if (::bind(listen_fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(listen_fd_, 128) != 0) {
+        ::close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+    
+    socklen_t length = sizeof(address);
+    ::getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&address), &length);
+    port_ = ntohs(address.sin_port);
+    
+    running_ = true;
+    accept_thread_ = std::thread(&MockApiServer::acceptLoop, this);
+    return true;
+}
+
+void MockApiServer::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    ::shutdown(listen_fd_, SHUT_RDWR);
+    ::close(listen_fd_);
+    listen_fd_ = -1;
+    if (accept_thread_.joinable()) {
+        accept_thread_.join();
+    }
+    
+    std::vector<std::thread> threads;
+    {
+        std::lock_guard<std::mutex> lock(connections_mutex_);
+        for (int fd : connection_fds_) {
+            if (fd >= 0) {
+                ::shutdown(fd, SHUT_RDWR);
+            }
+        }
+        threads.swap(connection_threads_);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    connection_fds_.clear();
+}
+
+void MockApiServer::acceptLoop() {
+    while (running_) {
+        int fd = ::accept(listen_fd_, nullptr, nullptr);
+        if (fd < 0) {
+            if (!running_) {
+                break;
+            }
+            continue;
+        }
+        int nodelay = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+        
+        std::lock_guard<std::mutex> lock(connections_mutex_);
+        connection_fds_.push_back(fd);
+        connection_threads_.emplace_back(&MockApiServer::serveConnection, this, fd);
+    }
+}
+
+void MockApiServer::serveConnection(int fd) {
+    std::string buffer;
+    char chunk[16384];
+    bool keep_alive = true;
+    
+    while (keep_alive && running_) {
+        // Headers
+        size_t header_end;
+        while ((header_end = buffer.find("\r\n\r\n")) == std::string::npos) {
+            ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+            if (n <= 0) {
+                keep_alive = false;
+                break;
+            }
+            buffer.append(chunk, static_cast<size_t>(n));
+        }
+        if (!keep_alive) {
+            break;
+        }
+        
+        std::istringstream headers(buffer.substr(0, header_end));
+        std::string method, target, version, line;
+        headers >> method >> target >> version;
+        std::getline(headers, line);
+        size_t content_length = 0;
+        bool expect_continue = false;
+        keep_alive = version != "HTTP/1.0";
+        while (std::getline(headers, line)) {
+            size_t colon = line.find(':');
+            if (colon == std::string::npos) {
+                continue;
+            }
+            std::string name = line.substr(0, colon);
+            std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+            std::string value = line.substr(colon + 1);
+            value.erase(0, value.find_first_not_of(' '));
+            value.erase(value.find_last_not_of("\r ") + 1);
+            if (name == "content-length") {
+                content_length = std::stoul(value);
+            } else if (name == "connection") {
+                std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+                keep_alive = value != "close";
+            } else if (name == "expect") {
+                expect_continue = true; // libcurl waits for this on large POSTs
+            }
+        }
+        
+        // Body
+        size_t body_start = header_end + 4;
+        if (expect_continue && buffer.size() < body_start + content_length) {
+            static const char kContinue[] = "HTTP/1.1 100 Continue\r\n\r\n";
+            ::send(fd, kContinue, sizeof(kContinue) - 1, MSG_NOSIGNAL);
+        }
+        while (buffer.size() < body_start + content_length) {
+            ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+            if (n <= 0) {
+                keep_alive = false;
+                break;
+            }
+            buffer.append(chunk, static_cast<size_t>(n));
+        }
+        if (buffer.size() < body_start + content_length) {
+            break;
+        }
+        std::string body = buffer.substr(body_start, content_length);
+        buffer.erase(0, body_start + content_length);
+        
+        std::string response_body;
+        int status = handleRequest(method, target, body, response_body);
+        
+        std::string response = "HTTP/1.1 " + std::to_string(status) + " " + statusText(status) + "\r\n" +
+                               "Content-Type: application/json\r\n" +
+                               "Content-Length: " + std::to_string(response_body.size()) + "\r\n" +
+                               (keep_alive ? "" : "Connection: close\r\n") + "\r\n" + response_body;
+        size_t sent = 0;
+        while (sent < response.size()) {
+            ssize_t n = ::send(fd, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) {
+                keep_alive = false;
+                break;
+            }
+            sent += static_cast<size_t>(n);
+        }
+    }
+    
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+    auto it = std::find(connection_fds_.begin(), connection_fds_.end(), fd);
+    if (it != connection_fds_.end()) {
+        *it = -1;
+    }
+    ::close(fd);
+}
+
+int MockApiServer::handleRequest(const std::string& method, const std::string& target,
+                                 const std::string& body, std::string& response_body) {
+    request_count_++;
+    
+    std::string path = target.substr(0, target.find('?'));
+    std::string query = target.find('?') == std::string::npos ? "" : target.substr(target.find('?') + 1);
+    bool is_openai = path.rfind("/v1/", 0) == 0;
+    
+    int delay_ms = config_.latency_ms;
+    double roll = 0.0;
+    {
+        auto& rng = threadRng();
+        if (config_.latency_jitter_ms > 0) {
+            delay_ms += std::uniform_int_distribution<int>(0, config_.latency_jitter_ms)(rng);
+        }
+        roll = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+    }
+    if (delay_ms > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+    }
+    
+    if (roll < config_.error_rate) {
+        response_body = errorJson("Mock upstream failure", "server_error").dump();
+        return 500;
+    }
+    if (roll < config_.error_rate + config_.rate_limit_rate) {
+        if (is_openai) {
+            response_body = errorJson("Rate limit reached", "rate_limit_exceeded").dump();
+            return 429;
+        }
+        // Alpha Vantage throttles with a 200 and a "Note"
+        response_body = nlohmann::json{{"Note", "Thank you for using Alpha Vantage! Our standard API call frequency is 5 calls per minute."}}.dump();
+        return 200;
+    }
+    
+    int status = 200;
+    if (method == "POST" && path == "/v1/embeddings") {
+        response_body = embeddingsResponse(body, status);
+    } else if (method == "POST" && path == "/v1/chat/completions") {
+        response_body = chatResponse(body, status);
+    } else if (method == "GET" && path == "/query") {
+        response_body = alphaVantageResponse(parseQuery(query));
+    } else {
+        response_body = errorJson("Unknown endpoint " + path, "invalid_request_error").dump();
+        status = 404;
+    }
+    return status;
+}
+
+std::string MockApiServer::embeddingsResponse(const std::string& body, int& status) {
+    nlohmann::json request = nlohmann::json::parse(body, nullptr, false);
+    if (request.is_discarded() || !request.contains("input")) {
+        status = 400;
+        return errorJson("Invalid embeddings request", "invalid_request_error").dump();
+    }
+    
+    std::vector<std::string> inputs;
+    if (request["input"].is_array()) {
+        for (const auto& item : request["input"]) {
+            inputs.push_back(item.get<std::string>());
+        }
+    } else {
+        inputs.push_back(request["input"].get<std::string>());
+    }
+    
+    // Deterministic unit vectors seeded by the input text
+    nlohmann::json response;
+    response["object"] = "list";
+    response["model"] = request.value("model", "text-embedding-3-small");
+    response["data"] = nlohmann::json::array();
+    bool base64 = request.value("encoding_format", "float") == "base64";
+    size_t token_count = 0;
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        uint64_t state = fnv1a(inputs[i]);
+        std::vector<float> embedding(config_.embedding_dimension);
+        double norm = 0.0;
+        for (auto& value : embedding) {
+            value = static_cast<float>(unitRandom(state) * 2.0 - 1.0);
+            norm += value * value;
+        }
+        norm = std::sqrt(norm);
+        for (auto& value : embedding) {
+            value = static_cast<float>(value / norm);
+        }
+        if (base64) {
+            response["data"].push_back({{"object", "embedding"}, {"index", i}, {"embedding", base64Floats(embedding)}});
+        } else {
+            response["data"].push_back({{"object", "embedding"}, {"index", i}, {"embedding", embedding}});
+        }
+        token_count += inputs[i].size() / 4 + 1;
+    }
+    response["usage"] = {{"prompt_tokens", token_count}, {"total_tokens", token_count}};
+    return response.dump();
+}
+
+std::string MockApiServer::chatResponse(const std::string& body, int& status) {
+    nlohmann::json request = nlohmann::json::parse(body, nullptr, false);
+    if (request.is_discarded() || !request.contains("messages")) {
+        status = 400;
+        return errorJson("Invalid chat request", "invalid_request_error").dump();
+    }
+    
+    std::string content = "Mock analysis: ";
+    while (content.size() < config_.completion_chars) {
+        content += "Price action and recent news point to a balanced risk profile. ";
+    }
+    content.resize(config_.completion_chars);
+    
+    nlohmann::json response;
+    response["id"] = "chatcmpl-mock";
+    response["object"] = "chat.completion";
+    response["model"] = request.value("model", "gpt-3.5-turbo");
+    response["choices"] = nlohmann::json::array();
+    response["choices"].push_back({{"index", 0},
+                                   {"message", {{"role", "assistant"}, {"content", content}}},
+                                   {"finish_reason", "stop"}});
+    return response.dump();
+}
+
+std::string MockApiServer::alphaVantageResponse(const std::map<std::string, std::string>& params) {
+    auto get = [&](const std::string& key) {
+        auto it = params.find(key);
+        return it == params.end() ? std::string() : it->second;
+    };
+    std::string function = get("function");
+    std::string symbol = get("symbol");
+    uint64_t state = fnv1a(symbol);
+    
+    if (function == "TIME_SERIES_DAILY_ADJUSTED" || function == "TIME_SERIES_DAILY") {
+        int days = get("outputsize") == "full" ? config_.history_days : std::min(100, config_.history_days);
+        
+        std::vector<int64_t> sessions;
+        for (int64_t day = kLastSessionDay; static_cast<int>(sessions.size()) < days; --day) {
+            int weekday = static_cast<int>((day + 4) % 7); // 0 = Sunday
+            if (weekday != 0 && weekday != 6) {
+                sessions.push_back(day);
+            }
+        }
+        
+        nlohmann::json series = nlohmann::json::object();
+        double close = 50.0 + unitRandom(state) * 250.0;
+        for (auto it = sessions.rbegin(); it != sessions.rend(); ++it) {
+            double open = close * (1.0 + (unitRandom(state) - 0.5) * 0.01);
+            close = open * (1.0 + (unitRandom(state) - 0.5) * 0.04);
+            double high = std::max(open, close) * (1.0 + unitRandom(state) * 0.01);
+            double low = std::min(open, close) * (1.0 - unitRandom(state) * 0.01);
+            long volume = 1000000 + static_cast<long>(unitRandom(state) * 9000000);
+            series[dateFromDays(*it)] = {{"1. open", formatPrice(open)},
+                                         {"2. high", formatPrice(high)},
+                                         {"3. low", formatPrice(low)},
+                                         {"4. close", formatPrice(close)},
+                                         {"5. volume", std::to_string(volume)}};
+        }
+        return nlohmann::json{{"Meta Data", {{"2. Symbol", symbol}}}, {"Time Series (Daily)", series}}.dump();
+    }
+    
+    if (function == "GLOBAL_QUOTE") {
+        double price = 50.0 + unitRandom(state) * 250.0;
+        double change = (unitRandom(state) - 0.5) * 4.0;
+        return nlohmann::json{{"Global Quote", {{"01. symbol", symbol},
+                                                {"05. price", formatPrice(price)},
+                                                {"10. change percent", formatPrice(change) + "%"}}}}.dump();
+    }
+    
+    if (function == "NEWS_SENTIMENT") {
+        int limit = get("limit").empty() ? config_.news_articles : std::stoi(get("limit"));
+        limit = std::min(limit, config_.news_articles);
+        nlohmann::json feed = nlohmann::json::array();
+        for (int i = 0; i < limit; ++i) {
+            std::string index = std::to_string(i);
+            std::string published = dateFromDays(kLastSessionDay - i);
+            published.erase(std::remove(published.begin(), published.end(), '-'), published.end());
+            std::string summary = symbol + " story " + index + ": shares moved after the company updated guidance. " +
+                                  "Analysts noted margin trends and demand in key segments. " +
+                                  "Volume was " + std::to_string(1 + splitmix64(state) % 9) + "x the monthly average.";
+            feed.push_back({{"title", symbol + " shares move on guidance update #" + index},
+                            {"url", "https://news.example.com/" + symbol + "/" + index},
+                            {"time_published", published + "T093000"},
+                            {"summary", summary},
+                            {"source", "Mock Wire"},
+                            {"ticker_sentiment", nlohmann::json::array({{{"ticker", symbol}, {"relevance_score", "0.9"}}})}});
+        }
+        return nlohmann::json{{"items", std::to_string(limit)}, {"feed", feed}}.dump();
+    }
+    
+    return nlohmann::json{{"Error Message", "Invalid API call for function " + function}}.dump();
+}
+
+} // namespace bench
+} // namespace rag
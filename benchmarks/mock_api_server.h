@@ -0,0 +1,73 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+
+namespace rag {
+namespace bench {
+
+struct MockServerConfig {
+    int port = 0;                        // 0 picks a free port
+    int latency_ms = 0;                  // Added to every response
+    int latency_jitter_ms = 0;           // Uniform extra delay in [0, jitter]
+    double error_rate = 0.0;             // Fraction of requests answered with HTTP 500
+    double rate_limit_rate = 0.0;        // Fraction answered as throttled (429 / Alpha Vantage "Note")
+    size_t embedding_dimension = 1536;
+    int history_days = 100;              // Bars returned for outputsize=full
+    int news_articles = 50;              // Upper bound on feed size
+    size_t completion_chars = 600;       // Length of chat completion content
+};
+
+// Minimal HTTP/1.1 server emulating the OpenAI embeddings and chat
+// completions endpoints and the Alpha Vantage query endpoint, with
+// injectable latency and failures. Responses are deterministic per input so
+// runs are comparable. Connections are kept alive, one thread each.
+//
+//   POST /v1/embeddings         {"input": "..." | [...], "model": ..., "encoding_format": "float" | "base64"}
+//   POST /v1/chat/completions   {"messages": [...]}
+//   GET  /query?function=TIME_SERIES_DAILY_ADJUSTED|GLOBAL_QUOTE|NEWS_SENTIMENT&symbol=...
+class MockApiServer {
+public:
+    explicit MockApiServer(const MockServerConfig& config = MockServerConfig());
+    ~MockApiServer();
+    
+    bool start();
+    void stop();
+    
+    int port() const { return port_; }
+    std::string baseUrl() const;
+    std::string openAIBaseUrl() const { return baseUrl() + "/v1"; }
+    std::string alphaVantageUrl() const { return baseUrl() + "/query"; }
+    
+    uint64_t requestCount() const { return request_count_.load(); }
+    
+private:
+    MockServerConfig config_;
+    int listen_fd_ = -1;
+    int port_ = 0;
+    std::atomic<bool> running_{false};
+    std::atomic<uint64_t> request_count_{0};
+    std::thread accept_thread_;
+    std::vector<std::thread> connection_threads_;
+    std::vector<int> connection_fds_;
+    std::mutex connections_mutex_;
+    
+    void acceptLoop();
+    void serveConnection(int fd);
+    
+    // Returns the HTTP status; body receives the JSON payload
+    int handleRequest(const std::string& method, const std::string& target,
+                      const std::string& body, std::string& response_body);
+    
+    std::string embeddingsResponse(const std::string& body, int& status);
+    std::string chatResponse(const std::string& body, int& status);
+    std::string alphaVantageResponse(const std::map<std::string, std::string>& params);
+};
+
+} // namespace bench
+} // namespace rag
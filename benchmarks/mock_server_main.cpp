@@ -0,0 +1,62 @@
+// Standalone mock upstream for manual load tests:
+//
+//   mock_api_server [--port=N] [--latency_ms=N] [--jitter_ms=N] [--error_rate=F] [--rate_limit_rate=F]
+//
+// then run the server with ALPHA_VANTAGE_BASE_URL=http://127.0.0.1:N/query
+// and OPENAI_BASE_URL=http://127.0.0.1:N/v1.
+
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include "mock_api_server.h"
+
+static volatile std::sig_atomic_t g_stop = 0;
+
+static void handleSignal(int) {
+    g_stop = 1;
+}
+
+int main(int argc, char** argv) {
+    rag::bench::MockServerConfig config;
+    config.port = 8089;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        std::string value = arg.substr(arg.find('=') + 1);
+        if (arg.rfind("--port=", 0) == 0) {
+            config.port = std::atoi(value.c_str());
+        } else if (arg.rfind("--latency_ms=", 0) == 0) {
+            config.latency_ms = std::atoi(value.c_str());
+        } else if (arg.rfind("--jitter_ms=", 0) == 0) {
+            config.latency_jitter_ms = std::atoi(value.c_str());
+        } else if (arg.rfind("--error_rate=", 0) == 0) {
+            config.error_rate = std::atof(value.c_str());
+        } else if (arg.rfind("--rate_limit_rate=", 0) == 0) {
+            config.rate_limit_rate = std::atof(value.c_str());
+        } else {
+            std::fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+            return 1;
+        }
+    }
+    
+    rag::bench::MockApiServer server(config);
+    if (!server.start()) {
+        std::fprintf(stderr, "Failed to listen on port %d\n", config.port);
+        return 1;
+    }
+    std::printf("Mock API server on %s (OpenAI: %s, Alpha Vantage: %s)\n",
+                server.baseUrl().c_str(), server.openAIBaseUrl().c_str(), server.alphaVantageUrl().c_str());
+    std::fflush(stdout);
+    
+    std::signal(SIGINT, handleSignal);
+    std::signal(SIGTERM, handleSignal);
+    while (!g_stop) {
+        ::pause();
+    }
+    
+    server.stop();
+    std::printf("Served %llu requests\n", static_cast<unsigned long long>(server.requestCount()));
+    return 0;
+}
@@ -0,0 +1,981 @@
+// Serving-path benchmarks. External APIs are replaced by MockApiServer so
+// results reflect our own overhead plus the configured upstream latency.
+//
+//   rag_benchmarks [--mock_latency_ms=N] [--mock_jitter_ms=N] [--mock_error_rate=F]
+//                  [google benchmark flags...]
+
+#include <benchmark/benchmark.h>
+#include <grpcpp/grpcpp.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include "latency_recorder.h"
+#include "mock_api_server.h"
+#include "api/grpc_server.h"
+#include "data_ingestion/data_fetcher.h"
+#include "data_ingestion/database.h"
+#include "data_ingestion/market_data_stream.h"
+#include "rag/rag_agent.h"
+#include "utils/logger.h"
+#include "utils/metrics.h"
+#include "utils/bounded_queue.h"
+#include "utils/spsc_queue.h"
+#include "vectorization/embedding_service.h"
+#include "vectorization/faiss_index.h"
+#include "vectorization/inverted_index.h"
+#include "rag_service.grpc.pb.h"
+
+using rag::bench::LatencyRecorder;
+
+namespace {
+
+constexpr size_t kDimension = 1536;
+
+rag::bench::MockServerConfig g_mock_config;
+
+rag::bench::MockApiServer& mockServer() {
+    static rag::bench::MockApiServer server(g_mock_config);
+    static bool started = server.start();
+    if (!started) {
+        std::fprintf(stderr, "Failed to start mock API server\n");
+        std::exit(1);
+    }
+    return server;
+}
+
+std::vector<float> randomUnitVector(std::mt19937& rng) {
+    std::normal_distribution<float> normal(0.0f, 1.0f);
+    std::vector<float> vector(kDimension);
+    float norm = 0.0f;
+    for (auto& value : vector) {
+        value = normal(rng);
+        norm += value * value;
+    }
+    norm = std::sqrt(norm);
+    for (auto& value : vector) {
+        value /= norm;
+    }
+    return vector;
+}
+
+std::string articleText(size_t i) {
+    std::string text = "Article " + std::to_string(i) + ": ";
+    while (text.size() < 900) {
+        text += "Shares rallied after the quarterly report beat estimates on revenue and margins. ";
+    }
+    return text;
+}
+
+rag::vectorization::Document corpusDocument(size_t i) {
+    rag::vectorization::Document doc;
+    doc.doc_id = "doc_" + std::to_string(i);
+    doc.content = articleText(i);
+    doc.source = "Mock Wire";
+    doc.timestamp = "20240628T093000";
+    doc.metadata["symbol"] = "AAPL";
+    return doc;
+}
+
+// Indexes are expensive to build, so each corpus size is built once
+std::shared_ptr<rag::vectorization::FAISSIndex> corpusIndex(size_t size) {
+    static std::map<size_t, std::shared_ptr<rag::vectorization::FAISSIndex>> cache;
+    auto it = cache.find(size);
+    if (it != cache.end()) {
+        return it->second;
+    }
+    
+    auto index = std::make_shared<rag::vectorization::FAISSIndex>(kDimension);
+    index->initialize();
+    std::mt19937 rng(42);
+    const size_t batch = 1000;
+    for (size_t start = 0; start < size; start += batch) {
+        std::vector<rag::vectorization::Document> docs;
+        std::vector<std::vector<float>> embeddings;
+        for (size_t i = start; i < std::min(size, start + batch); ++i) {
+            docs.push_back(corpusDocument(i));
+            embeddings.push_back(randomUnitVector(rng));
+        }
+        index->addDocuments(docs, embeddings);
+    }
+    cache[size] = index;
+    return index;
+}
+
+std::string tempDatabasePath(const std::string& name) {
+    std::string path = "/tmp/rag_bench_" + name + "_" + std::to_string(::getpid()) + ".db";
+    std::remove(path.c_str());
+    return path;
+}
+
+std::vector<rag::data::OHLCVData> syntheticBars(size_t count) {
+    std::vector<rag::data::OHLCVData> bars;
+    double close = 100.0;
+    for (size_t i = 0; i < count; ++i) {
+        char date[16];
+        std::snprintf(date, sizeof(date), "%04zu-%02zu-%02zu", 2000 + i / 336, 1 + (i / 28) % 12, 1 + i % 28);
+        rag::data::OHLCVData bar;
+        bar.timestamp = date;
+        bar.open = close;
+        close *= 1.0 + (static_cast<double>((i * 7919) % 200) - 100.0) / 10000.0;
+        bar.close = close;
+        bar.high = std::max(bar.open, bar.close) * 1.005;
+        bar.low = std::min(bar.open, bar.close) * 0.995;
+        bar.volume = 1000000 + static_cast<long>(i);
+        bars.push_back(bar);
+    }
+    return bars;
+}
+
+std::vector<rag::agent::RAGContextDoc> contextDocs(size_t count) {
+    std::vector<rag::agent::RAGContextDoc> docs;
+    for (size_t i = 0; i < count; ++i) {
+        rag::agent::RAGContextDoc doc;
+        doc.doc_id = "doc_" + std::to_string(i);
+        doc.content = articleText(i);
+        doc.source = "Mock Wire";
+        doc.timestamp = "20240628T093000";
+        doc.similarity_score = 0.8;
+        doc.metadata["title"] = "Headline " + std::to_string(i);
+        doc.metadata["chunk_index"] = std::to_string(i % 2);
+        docs.push_back(doc);
+    }
+    return docs;
+}
+
+// Full serving stack against the mock upstream, hosted in-process
+struct GrpcFixture {
+    std::shared_ptr<rag::agent::RAGAgent> agent;
+    std::unique_ptr<grpc::Service> service;
+    std::unique_ptr<grpc::Server> server;
+    std::shared_ptr<grpc::Channel> channel;
+    std::string db_path;
+    
+    GrpcFixture() {
+        auto& mock = mockServer();
+        auto fetcher = std::make_shared<rag::data::DataFetcher>("bench");
+        fetcher->setBaseUrl(mock.alphaVantageUrl());
+        db_path = tempDatabasePath("grpc");
+        auto database = std::make_shared<rag::data::Database>(db_path);
+        database->initialize();
+        auto embeddings = std::make_shared<rag::vectorization::EmbeddingService>("bench", "openai");
+        embeddings->setBaseUrl(mock.openAIBaseUrl());
+        
+        agent = std::make_shared<rag::agent::RAGAgent>(fetcher, database, embeddings, corpusIndex(1000), "bench");
+        agent->setLLMBaseUrl(mock.openAIBaseUrl());
+        
+        service = CreateRAGAgentService(agent);
+        int port = 0;
+        grpc::ServerBuilder builder;
+        builder.AddListeningPort("127.0.0.1:0", grpc::InsecureServerCredentials(), &port);
+        builder.RegisterService(service.get());
+        server = builder.BuildAndStart();
+        channel = grpc::CreateChannel("127.0.0.1:" + std::to_string(port), grpc::InsecureChannelCredentials());
+    }
+    
+    ~GrpcFixture() {
+        server->Shutdown();
+        std::remove(db_path.c_str());
+    }
+};
+
+GrpcFixture& grpcFixture() {
+    static GrpcFixture fixture;
+    return fixture;
+}
+
+} // namespace
+
+static void BM_FAISSSearch(benchmark::State& state) {
+#ifdef NO_FAISS
+    state.SkipWithError("Built without FAISS");
+    return;
+#endif
+    auto index = corpusIndex(static_cast<size_t>(state.range(0)));
+    std::mt19937 rng(7);
+    std::vector<std::vector<float>> queries;
+    for (int i = 0; i < 64; ++i) {
+        queries.push_back(randomUnitVector(rng));
+    }
+    
+    LatencyRecorder latency;
+    size_t q = 0;
+    for (auto _ : state) {
+        latency.start();
+        auto results = index->search(queries[q++ % queries.size()], 10);
+        benchmark::DoNotOptimize(results);
+        latency.stop();
+    }
+    latency.report(state);
+}
+BENCHMARK(BM_FAISSSearch)->Arg(1000)->Arg(10000)->Arg(50000)->Unit(benchmark::kMicrosecond);
+
+// Making a 32-document batch durable in a 10k-document index: 0 saves the
+// whole index after each batch, 1 appends the batch to the WAL (one write
+// and fdatasync)
+static void BM_IndexDurability(benchmark::State& state) {
+    const size_t kCorpus = 10000;
+    const size_t kBatch = 32;
+    bool wal = state.range(0) == 1;
+    std::string path = "/tmp/rag_bench_index_" + std::to_string(::getpid());
+    
+    rag::vectorization::FAISSIndex index(kDimension);
+    index.initialize();
+    std::mt19937 rng(42);
+    std::vector<rag::vectorization::Document> docs;
+    std::vector<float> matrix;
+    for (size_t i = 0; i < kCorpus + kBatch; ++i) {
+        docs.push_back(corpusDocument(i));
+        auto vector = randomUnitVector(rng);
+        matrix.insert(matrix.end(), vector.begin(), vector.end());
+        if (docs.size() == (i < kCorpus ? 1000 : kBatch)) {
+            index.addDocumentMatrix(docs, matrix);
+            docs.clear();
+            matrix.clear();
+        }
+    }
+    for (size_t i = 0; i < kBatch; ++i) {
+        docs.push_back(corpusDocument(i));
+        auto vector = randomUnitVector(rng);
+        matrix.insert(matrix.end(), vector.begin(), vector.end());
+    }
+    if (wal && !index.openWal(path)) {
+        state.SkipWithError("Failed to open WAL");
+        return;
+    }
+    
+    size_t next = kCorpus + kBatch;
+    for (auto _ : state) {
+        for (auto& doc : docs) {
+            doc.doc_id = "doc_" + std::to_string(next++);
+        }
+        index.addDocumentMatrix(docs, matrix);
+        if (!wal) {
+            index.save(path);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * kBatch);
+    for (const char* suffix : {"", ".meta", ".wal"}) {
+        std::remove((path + suffix).c_str());
+    }
+}
+BENCHMARK(BM_IndexDurability)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Search latency in a 20k-document index with a writer adding 32 documents
+// every 10 ms: 0 without checkpoints, 1 with checkpoints running back to
+// back. Checkpoints snapshot and write outside the index lock, so p99_us
+// should only move by the CPU the checkpoint thread takes from searches
+// (on a single core, about what any thread copying the index would cost).
+static void BM_SearchDuringCheckpoint(benchmark::State& state) {
+#ifdef NO_FAISS
+    state.SkipWithError("Built without FAISS");
+    return;
+#endif
+    const size_t kCorpus = 20000;
+    const size_t kBatch = 32;
+    bool checkpointing = state.range(0) == 1;
+    std::string path = "/tmp/rag_bench_checkpoint_" + std::to_string(::getpid());
+    
+    rag::vectorization::FAISSIndex index(kDimension);
+    index.initialize();
+    std::mt19937 rng(42);
+    std::vector<rag::vectorization::Document> docs;
+    std::vector<float> matrix;
+    for (size_t i = 0; i < kCorpus; ++i) {
+        docs.push_back(corpusDocument(i));
+        auto vector = randomUnitVector(rng);
+        matrix.insert(matrix.end(), vector.begin(), vector.end());
+        if (docs.size() == 1000) {
+            index.addDocumentMatrix(docs, matrix);
+            docs.clear();
+            matrix.clear();
+        }
+    }
+    for (size_t i = 0; i < kBatch; ++i) {
+        docs.push_back(corpusDocument(i));
+        auto vector = randomUnitVector(rng);
+        matrix.insert(matrix.end(), vector.begin(), vector.end());
+    }
+    if (!index.openWal(path, false)) {
+        state.SkipWithError("Failed to open WAL");
+        return;
+    }
+    std::vector<std::vector<float>> queries;
+    for (int i = 0; i < 64; ++i) {
+        queries.push_back(randomUnitVector(rng));
+    }
+    
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> checkpoints{0};
+    std::vector<std::thread> background;
+    background.emplace_back([&]() {
+        size_t next = kCorpus;
+        while (!stop.load()) {
+            for (auto& doc : docs) {
+                doc.doc_id = "doc_" + std::to_string(next++);
+            }
+            index.addDocumentMatrix(docs, matrix);
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    });
+    if (checkpointing) {
+        background.emplace_back([&]() {
+            while (!stop.load()) {
+                if (index.save(path)) {
+                    ++checkpoints;
+                }
+            }
+        });
+    }
+    
+    LatencyRecorder latency;
+    size_t q = 0;
+    for (auto _ : state) {
+        latency.start();
+        auto results = index.search(queries[q++ % queries.size()], 10);
+        benchmark::DoNotOptimize(results);
+        latency.stop();
+    }
+    stop.store(true);
+    for (auto& thread : background) {
+        thread.join();
+    }
+    latency.report(state);
+    state.counters["checkpoints"] = static_cast<double>(checkpoints.load());
+    
+    index.save(path); // Drops the sealed WAL segments
+    for (const char* suffix : {"", ".meta", ".wal"}) {
+        std::remove((path + suffix).c_str());
+    }
+}
+BENCHMARK(BM_SearchDuringCheckpoint)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+static void BM_DatabaseWriteOHLCV(benchmark::State& state) {
+    std::string path = tempDatabasePath("write");
+    rag::data::Database database(path);
+    database.initialize();
+    auto bars = syntheticBars(static_cast<size_t>(state.range(0)));
+    
+    LatencyRecorder latency;
+    int64_t symbol = 0;
+    for (auto _ : state) {
+        latency.start();
+        database.storeOHLCVData("SYM" + std::to_string(symbol++), bars);
+        latency.stop();
+    }
+    latency.report(state);
+    state.counters["rows_per_second"] = benchmark::Counter(
+        static_cast<double>(state.iterations() * state.range(0)), benchmark::Counter::kIsRate);
+    std::remove(path.c_str());
+}
+BENCHMARK(BM_DatabaseWriteOHLCV)->Arg(100)->Arg(1000)->Unit(benchmark::kMicrosecond);
+
+static void BM_DatabaseReadOHLCV(benchmark::State& state) {
+    std::string path = tempDatabasePath("read");
+    rag::data::Database database(path);
+    database.initialize();
+    auto bars = syntheticBars(static_cast<size_t>(state.range(0)));
+    for (int i = 0; i < 20; ++i) {
+        database.storeOHLCVData("SYM" + std::to_string(i), bars);
+    }
+    
+    LatencyRecorder latency;
+    int symbol = 0;
+    for (auto _ : state) {
+        std::vector<rag::data::OHLCVData> data;
+        latency.start();
+        database.getOHLCVData("SYM" + std::to_string(symbol++ % 20), "0000-00-00", "9999-99-99", data);
+        latency.stop();
+        benchmark::DoNotOptimize(data);
+    }
+    latency.report(state);
+    std::remove(path.c_str());
+}
+BENCHMARK(BM_DatabaseReadOHLCV)->Arg(100)->Arg(1000)->Unit(benchmark::kMicrosecond);
+
+static void BM_DatabaseWriteNews(benchmark::State& state) {
+    std::string path = tempDatabasePath("news");
+    rag::data::Database database(path);
+    database.initialize();
+    
+    LatencyRecorder latency;
+    int64_t batch = 0;
+    for (auto _ : state) {
+        std::vector<rag::data::NewsArticle> articles;
+        for (int64_t i = 0; i < state.range(0); ++i) {
+            rag::data::NewsArticle article;
+            article.id = "https://news.example.com/" + std::to_string(batch) + "/" + std::to_string(i);
+            article.title = "Headline " + std::to_string(i);
+            article.content = articleText(static_cast<size_t>(i));
+            article.source = "Mock Wire";
+            article.published_time = "20240628T093000";
+            article.tickers = {"AAPL"};
+            articles.push_back(article);
+        }
+        ++batch;
+        latency.start();
+        database.storeNewsArticles(articles);
+        latency.stop();
+    }
+    latency.report(state);
+    std::remove(path.c_str());
+}
+BENCHMARK(BM_DatabaseWriteNews)->Arg(50)->Unit(benchmark::kMicrosecond);
+
+static void BM_BuildPrompt(benchmark::State& state) {
+    auto& fixture = grpcFixture();
+    auto docs = contextDocs(static_cast<size_t>(state.range(0)));
+    
+    LatencyRecorder latency;
+    for (auto _ : state) {
+        latency.start();
+        std::string prompt = fixture.agent->buildPrompt("Explain the volatility for AAPL on 2024-06-28.", docs);
+        benchmark::DoNotOptimize(prompt);
+        latency.stop();
+    }
+    latency.report(state);
+}
+BENCHMARK(BM_BuildPrompt)->Arg(5)->Arg(10)->Arg(20)->Unit(benchmark::kMicrosecond);
+
+// Alpha Vantage daily series as the API sends it: pretty-printed, newest first
+static std::string stockDataResponse(size_t bars) {
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<double> move(-0.02, 0.02);
+    std::string body = "{\n    \"Meta Data\": {\n        \"1. Information\": \"Daily Prices\",\n"
+                       "        \"2. Symbol\": \"AAPL\"\n    },\n    \"Time Series (Daily)\": {\n";
+    double close = 180.0;
+    char line[512];
+    for (size_t i = 0; i < bars; ++i) {
+        double open = close * (1.0 + move(rng));
+        int year = 2024 - static_cast<int>(i / 250);
+        int day_of_year = 250 - static_cast<int>(i % 250);
+        std::snprintf(line, sizeof(line),
+                      "        \"%04d-%02d-%02d\": {\n            \"1. open\": \"%.4f\",\n"
+                      "            \"2. high\": \"%.4f\",\n            \"3. low\": \"%.4f\",\n"
+                      "            \"4. close\": \"%.4f\",\n            \"5. volume\": \"%u\"\n        }%s\n",
+                      year, day_of_year / 21 + 1, day_of_year % 21 + 1, open, std::max(open, close) * 1.01,
+                      std::min(open, close) * 0.99, close, 1000000u + static_cast<unsigned>(rng() % 9000000u),
+                      i + 1 < bars ? "," : "");
+        body += line;
+        close = open;
+    }
+    body += "    }\n}";
+    return body;
+}
+
+static std::string newsResponse(size_t articles) {
+    nlohmann::json feed = nlohmann::json::array();
+    for (size_t i = 0; i < articles; ++i) {
+        std::string index = std::to_string(i);
+        feed.push_back({{"title", "Apple’s \"services\" push #" + index},
+                        {"url", "https://news.example.com/AAPL/" + index},
+                        {"time_published", "20240628T093000"},
+                        {"summary", std::string(600, 'x') + "\nShares moved after guidance."},
+                        {"source", "Mock Wire"},
+                        {"overall_sentiment_score", 0.21},
+                        {"topics", {{{"topic", "Earnings"}, {"relevance_score", "0.9"}}}},
+                        {"ticker_sentiment", {{{"ticker", "AAPL"}, {"relevance_score", "0.9"}},
+                                              {{"ticker", "MSFT"}, {"relevance_score", "0.2"}}}}});
+    }
+    return nlohmann::json{{"items", std::to_string(articles)}, {"feed", feed}}.dump(4);
+}
+
+// Arg 0: bars; arg 1: 1 = scanner (parseStockData), 0 = nlohmann DOM
+static void BM_ParseStockData(benchmark::State& state) {
+    std::string body = stockDataResponse(static_cast<size_t>(state.range(0)));
+    bool scanner = state.range(1) != 0;
+    for (auto _ : state) {
+        std::vector<rag::data::OHLCVData> bars;
+        bool ok = scanner ? rag::data::DataFetcher::parseStockData(body, static_cast<int>(state.range(0)), bars)
+                          : rag::data::DataFetcher::parseStockDataDom(body, static_cast<int>(state.range(0)), bars);
+        if (!ok) {
+            state.SkipWithError("parse failed");
+            break;
+        }
+        benchmark::DoNotOptimize(bars.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * body.size()));
+    state.SetLabel(scanner ? "scanner" : "dom");
+}
+BENCHMARK(BM_ParseStockData)->ArgsProduct({{100, 5000}, {0, 1}})->Unit(benchmark::kMicrosecond);
+
+static void BM_ParseNews(benchmark::State& state) {
+    std::string body = newsResponse(static_cast<size_t>(state.range(0)));
+    bool scanner = state.range(1) != 0;
+    for (auto _ : state) {
+        std::vector<rag::data::NewsArticle> articles;
+        bool ok = scanner ? rag::data::DataFetcher::parseNews(body, articles)
+                          : rag::data::DataFetcher::parseNewsDom(body, articles);
+        if (!ok) {
+            state.SkipWithError("parse failed");
+            break;
+        }
+        benchmark::DoNotOptimize(articles.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * body.size()));
+    state.SetLabel(scanner ? "scanner" : "dom");
+}
+BENCHMARK(BM_ParseNews)->ArgsProduct({{50, 1000}, {0, 1}})->Unit(benchmark::kMicrosecond);
+
+// Synthetic news with a skewed vocabulary, so posting lists range from a
+// handful of documents to most of the corpus, as with real text
+static std::shared_ptr<rag::vectorization::InvertedIndex> lexicalIndex(size_t size) {
+    static std::map<size_t, std::shared_ptr<rag::vectorization::InvertedIndex>> cache;
+    auto it = cache.find(size);
+    if (it != cache.end()) {
+        return it->second;
+    }
+    
+    auto index = std::make_shared<rag::vectorization::InvertedIndex>();
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    for (size_t i = 0; i < size; ++i) {
+        rag::vectorization::Document doc;
+        doc.doc_id = "news_" + std::to_string(i);
+        size_t words = 40 + rng() % 160;
+        for (size_t j = 0; j < words; ++j) {
+            doc.content += "term" + std::to_string(static_cast<int>(std::pow(uniform(rng), 3.0) * 5000)) + " ";
+        }
+        index->addDocument(doc);
+    }
+    cache[size] = index;
+    return index;
+}
+
+static void BM_LexicalSearch(benchmark::State& state) {
+    auto index = lexicalIndex(static_cast<size_t>(state.range(0)));
+    std::mt19937 rng(7);
+    
+    LatencyRecorder latency;
+    for (auto _ : state) {
+        std::string query;
+        for (int i = 0; i < 3; ++i) {
+            query += "term" + std::to_string(rng() % 500) + " ";
+        }
+        latency.start();
+        auto results = index->search(query, 20);
+        benchmark::DoNotOptimize(results);
+        latency.stop();
+    }
+    latency.report(state);
+}
+BENCHMARK(BM_LexicalSearch)->Arg(10000)->Arg(50000)->Unit(benchmark::kMicrosecond);
+
+// Second argument: 1 requests base64 vectors decoded into the reused matrix,
+// 0 JSON float arrays
+static void BM_EmbeddingRequest(benchmark::State& state) {
+    rag::vectorization::EmbeddingService service("bench", "openai");
+    service.setBaseUrl(mockServer().openAIBaseUrl());
+    service.setBase64Encoding(state.range(1) != 0);
+    std::vector<std::string> texts;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        texts.push_back(articleText(static_cast<size_t>(i)));
+    }
+    
+    LatencyRecorder latency;
+    int64_t failures = 0;
+    std::vector<float> matrix;
+    for (auto _ : state) {
+        latency.start();
+        if (!service.generateEmbeddingMatrix(texts, matrix)) {
+            ++failures;
+        }
+        latency.stop();
+    }
+    latency.report(state);
+    state.counters["failures"] = static_cast<double>(failures);
+}
+BENCHMARK(BM_EmbeddingRequest)->ArgsProduct({{1, 64}, {0, 1}})->Unit(benchmark::kMillisecond);
+
+// Synthetic 30k-token, 256-dim static model covering the article vocabulary;
+// compare with BM_EmbeddingRequest for the HTTP round trip it replaces
+static rag::vectorization::EmbeddingService& localEmbeddingService() {
+    static std::unique_ptr<rag::vectorization::EmbeddingService> service = [] {
+        std::vector<std::string> vocab = {"article", "shares", "rallied", "after", "the", "quarterly",
+                                          "report", "beat", "estimates", "on", "revenue", "and",
+                                          "margins", ".", ":"};
+        for (int i = 0; i < 10; ++i) {
+            vocab.push_back(std::to_string(i));
+            vocab.push_back("##" + std::to_string(i));
+        }
+        while (vocab.size() < 30000) {
+            vocab.push_back("word" + std::to_string(vocab.size()));
+        }
+        const uint32_t header[4] = {1, static_cast<uint32_t>(vocab.size()), 256, 1};
+        std::string path = tempDatabasePath("static_embeddings");
+        FILE* file = std::fopen(path.c_str(), "wb");
+        std::fwrite("RAGSTEMB", 1, 8, file);
+        std::fwrite(header, sizeof(uint32_t), 4, file);
+        for (const auto& token : vocab) {
+            uint16_t length = static_cast<uint16_t>(token.size());
+            std::fwrite(&length, sizeof(length), 1, file);
+            std::fwrite(token.data(), 1, token.size(), file);
+        }
+        std::mt19937 rng(42);
+        std::normal_distribution<float> normal(0.0f, 1.0f);
+        for (size_t i = 0; i < vocab.size() * 256; ++i) {
+            float value = normal(rng);
+            std::fwrite(&value, sizeof(value), 1, file);
+        }
+        std::fclose(file);
+        
+        auto local = std::make_unique<rag::vectorization::EmbeddingService>("", "local");
+        local->loadLocalModel(path);
+        std::remove(path.c_str());
+        return local;
+    }();
+    return *service;
+}
+
+static void BM_LocalEmbedding(benchmark::State& state) {
+    auto& service = localEmbeddingService();
+    std::vector<std::string> texts;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        texts.push_back(articleText(static_cast<size_t>(i)));
+    }
+    
+    LatencyRecorder latency;
+    int64_t failures = 0;
+    for (auto _ : state) {
+        std::vector<std::vector<float>> embeddings;
+        latency.start();
+        if (!service.generateEmbeddings(texts, embeddings)) {
+            ++failures;
+        }
+        latency.stop();
+    }
+    latency.report(state);
+    state.counters["failures"] = static_cast<double>(failures);
+}
+BENCHMARK(BM_LocalEmbedding)->Arg(1)->Arg(64)->Arg(1024)->Unit(benchmark::kMicrosecond);
+
+// Metrics stay on in production, so recording must stay cheap under contention
+static void BM_HistogramRecord(benchmark::State& state) {
+    static auto& histogram = rag::utils::stageHistogram("benchmark", "record");
+    uint64_t value = static_cast<uint64_t>(state.thread_index()) * 7919;
+    for (auto _ : state) {
+        histogram.record(value++ & 0xffff);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_HistogramRecord)->Threads(1)->Threads(8);
+
+// Handing ticks from a feed reader thread to a writer thread: 0 is the
+// mutex/condvar BoundedQueue, 1 the lock-free SpscQueue MarketDataStream uses
+static void BM_TickQueue(benchmark::State& state) {
+    const int64_t kTicks = 100000;
+    rag::data::MarketTick tick;
+    tick.symbol = "AAPL";
+    tick.price = 100.0;
+    
+    for (auto _ : state) {
+        int64_t received = 0;
+        if (state.range(0) == 0) {
+            rag::utils::BoundedQueue<rag::data::MarketTick> queue(65536);
+            std::thread consumer([&]() {
+                rag::data::MarketTick item;
+                while (queue.pop(item)) {
+                    ++received;
+                }
+            });
+            for (int64_t i = 0; i < kTicks; ++i) {
+                tick.timestamp_ms = i;
+                queue.push(tick);
+            }
+            queue.close();
+            consumer.join();
+        } else {
+            rag::utils::SpscQueue<rag::data::MarketTick> queue(65536);
+            std::thread consumer([&]() {
+                rag::data::MarketTick item;
+                while (received < kTicks) {
+                    if (queue.tryPop(item)) {
+                        ++received;
+                    } else {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+            for (int64_t i = 0; i < kTicks; ++i) {
+                rag::data::MarketTick item = tick;
+                item.timestamp_ms = i;
+                while (!queue.tryPush(item)) {
+                    std::this_thread::yield();
+                }
+            }
+            consumer.join();
+        }
+        benchmark::DoNotOptimize(received);
+    }
+    state.SetItemsProcessed(state.iterations() * kTicks);
+}
+BENCHMARK(BM_TickQueue)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Replaying a recorded session (50 symbols, 200k ticks) as fast as possible:
+// quotes updated and one-minute bars stored. tick_to_quote_p99_us is the
+// latency from a tick leaving the feed to it being queryable; unpaced, the
+// reader outruns the writer, so this is mostly time spent queued.
+static void BM_MarketReplay(benchmark::State& state) {
+    const int kSymbols = 50;
+    const int kTicks = 200000;
+    std::string ticks_path = "/tmp/rag_bench_ticks_" + std::to_string(::getpid()) + ".csv";
+    {
+        std::mt19937 rng(42);
+        std::normal_distribution<double> step(0.0, 0.05);
+        std::vector<double> prices(kSymbols, 100.0);
+        FILE* file = std::fopen(ticks_path.c_str(), "w");
+        for (int i = 0; i < kTicks; ++i) {
+            rag::data::MarketTick tick;
+            int symbol = i % kSymbols;
+            prices[symbol] += step(rng);
+            tick.symbol = "SYM" + std::to_string(symbol);
+            tick.timestamp_ms = 1700000000000 + i * 10;
+            tick.price = prices[symbol];
+            tick.size = 100;
+            std::fprintf(file, "%s\n", rag::data::formatTickLine(tick).c_str());
+        }
+        std::fclose(file);
+    }
+    
+    auto& quote_latency = rag::utils::stageHistogram("market_stream", "tick_to_quote");
+    uint64_t bars = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::string path = tempDatabasePath("replay");
+        auto database = std::make_shared<rag::data::Database>(path);
+        database->initialize();
+        state.ResumeTiming();
+        
+        rag::data::MarketDataStream stream(rag::data::createMarketFeed("replay:" + ticks_path), database);
+        stream.start();
+        stream.wait();
+        bars = stream.stats().bars_stored;
+        
+        state.PauseTiming();
+        stream.stop();
+        std::remove(path.c_str());
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * kTicks);
+    state.counters["bars"] = static_cast<double>(bars);
+    state.counters["tick_to_quote_p99_us"] = static_cast<double>(quote_latency.percentile(0.99));
+    std::remove(ticks_path.c_str());
+}
+BENCHMARK(BM_MarketReplay)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+template <typename Request, typename Response, typename Call>
+static void runRpc(benchmark::State& state, const Request& request, Call call) {
+    auto stub = rag::agent::RAGAgentService::NewStub(grpcFixture().channel);
+    LatencyRecorder latency;
+    int64_t failures = 0;
+    for (auto _ : state) {
+        grpc::ClientContext context;
+        Response response;
+        latency.start();
+        grpc::Status status = call(*stub, &context, request, &response);
+        latency.stop();
+        if (!status.ok()) {
+            ++failures;
+        }
+    }
+    latency.report(state);
+    state.counters["failures"] = benchmark::Counter(static_cast<double>(failures), benchmark::Counter::kAvgThreads);
+}
+
+static void BM_GrpcGetStockSummary(benchmark::State& state) {
+    rag::agent::StockSummaryRequest request;
+    request.set_symbol("AAPL");
+    request.set_period("1m");
+    runRpc<rag::agent::StockSummaryRequest, rag::agent::StockSummaryResponse>(state, request,
+        [](auto& stub, auto* context, const auto& req, auto* resp) { return stub.GetStockSummary(context, req, resp); });
+}
+BENCHMARK(BM_GrpcGetStockSummary)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_GrpcExplainVolatility(benchmark::State& state) {
+    rag::agent::VolatilityRequest request;
+    request.set_symbol("MSFT");
+    request.set_date("2024-06-28");
+    runRpc<rag::agent::VolatilityRequest, rag::agent::VolatilityResponse>(state, request,
+        [](auto& stub, auto* context, const auto& req, auto* resp) { return stub.ExplainVolatility(context, req, resp); });
+}
+BENCHMARK(BM_GrpcExplainVolatility)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_GrpcQueryRAG(benchmark::State& state) {
+    rag::agent::QueryRequest request;
+    request.set_query("What moved semiconductor stocks this week?");
+    request.add_symbols("NVDA");
+    runRpc<rag::agent::QueryRequest, rag::agent::QueryResponse>(state, request,
+        [](auto& stub, auto* context, const auto& req, auto* resp) { return stub.QueryRAG(context, req, resp); });
+}
+BENCHMARK(BM_GrpcQueryRAG)->Unit(benchmark::kMillisecond)->UseRealTime()->Threads(1)->Threads(8);
+
+// A 20-symbol dashboard refresh: 0 issues one GetStockSummary per symbol,
+// 1 a single streaming BatchGetStockSummary
+static void BM_GrpcWatchlistSummary(benchmark::State& state) {
+    static const std::vector<std::string> watchlist = {
+        "AAPL", "MSFT", "NVDA", "GOOGL", "AMZN", "META", "TSLA", "AMD", "INTC", "ORCL",
+        "CRM", "ADBE", "AVGO", "QCOM", "TXN", "IBM", "CSCO", "NFLX", "PYPL", "UBER"};
+    auto stub = rag::agent::RAGAgentService::NewStub(grpcFixture().channel);
+    LatencyRecorder latency;
+    int64_t failures = 0;
+    for (auto _ : state) {
+        latency.start();
+        if (state.range(0) == 0) {
+            for (const auto& symbol : watchlist) {
+                grpc::ClientContext context;
+                rag::agent::StockSummaryRequest request;
+                rag::agent::StockSummaryResponse response;
+                request.set_symbol(symbol);
+                request.set_period("1m");
+                if (!stub->GetStockSummary(&context, request, &response).ok()) {
+                    ++failures;
+                }
+            }
+        } else {
+            grpc::ClientContext context;
+            rag::agent::BatchStockSummaryRequest request;
+            for (const auto& symbol : watchlist) {
+                request.add_symbols(symbol);
+            }
+            request.set_period("1m");
+            auto reader = stub->BatchGetStockSummary(&context, request);
+            rag::agent::StockSummaryResponse response;
+            while (reader->Read(&response)) {
+                failures += response.error().empty() ? 0 : 1;
+            }
+            if (!reader->Finish().ok()) {
+                ++failures;
+            }
+        }
+        latency.stop();
+    }
+    latency.report(state);
+    state.counters["failures"] = static_cast<double>(failures);
+}
+BENCHMARK(BM_GrpcWatchlistSummary)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Regenerating a 20-symbol subscription after a change: 0 is news for every
+// symbol (context retrieved again), 1 a price move (cached context reused).
+// Each iteration is a new version of every symbol, so nothing is served
+// from the summary cache.
+static void BM_WatchlistRefresh(benchmark::State& state) {
+    static const std::vector<std::string> watchlist = {
+        "AAPL", "MSFT", "NVDA", "GOOGL", "AMZN", "META", "TSLA", "AMD", "INTC", "ORCL",
+        "CRM", "ADBE", "AVGO", "QCOM", "TXN", "IBM", "CSCO", "NFLX", "PYPL", "UBER"};
+    auto& agent = *grpcFixture().agent;
+    std::vector<rag::agent::WatchlistChange> changes;
+    for (const auto& symbol : watchlist) {
+        rag::agent::WatchlistChange change;
+        change.symbol = symbol;
+        change.initial = true;
+        change.has_price = true;
+        change.price = 100.0;
+        changes.push_back(change);
+    }
+    agent.refreshWatchlist(changes, "1d", [](rag::agent::BatchItemResult&&) {});
+    
+    for (auto& change : changes) {
+        change.initial = false;
+        change.news_changed = state.range(0) == 0;
+        change.new_articles = state.range(0) == 0 ? 1 : 0;
+        change.price_moved = state.range(0) == 1;
+        change.revision.new_articles = change.new_articles;
+        change.revision.price_changed = change.price_moved;
+    }
+    LatencyRecorder latency;
+    int64_t failures = 0;
+    for (auto _ : state) {
+        for (auto& change : changes) {
+            change.revision.version++;
+            if (state.range(0) == 0) {
+                change.revision.news_version = change.revision.version;
+            }
+        }
+        latency.start();
+        agent.refreshWatchlist(changes, "1d", [&](rag::agent::BatchItemResult&& result) {
+            failures += result.success ? 0 : 1;
+        });
+        latency.stop();
+    }
+    latency.report(state);
+    state.counters["failures"] = static_cast<double>(failures);
+}
+BENCHMARK(BM_WatchlistRefresh)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// One news change to a symbol watched by N subscriptions, each refreshed on
+// its own thread as the Subscribe handlers do. upstream_requests (embedding
+// and LLM calls per change) should not grow with N.
+static void BM_WatchlistFanout(benchmark::State& state) {
+    auto& agent = *grpcFixture().agent;
+    size_t subscribers = static_cast<size_t>(state.range(0));
+    rag::agent::WatchlistChange change;
+    change.symbol = "FANOUT";
+    change.has_price = true;
+    change.price = 100.0;
+    change.news_changed = true;
+    change.new_articles = 1;
+    change.revision.new_articles = 1;
+    
+    LatencyRecorder latency;
+    std::atomic<int64_t> failures{0};
+    uint64_t upstream = 0;
+    for (auto _ : state) {
+        change.revision.version++;
+        change.revision.news_version = change.revision.version;
+        uint64_t before = mockServer().requestCount();
+        latency.start();
+        std::vector<std::thread> handlers;
+        for (size_t i = 0; i < subscribers; ++i) {
+            handlers.emplace_back([&]() {
+                agent.refreshWatchlist({change}, "1d", [&](rag::agent::BatchItemResult&& result) {
+                    failures += result.success ? 0 : 1;
+                });
+            });
+        }
+        for (auto& handler : handlers) {
+            handler.join();
+        }
+        latency.stop();
+        upstream += mockServer().requestCount() - before;
+    }
+    latency.report(state);
+    state.counters["upstream_requests"] = static_cast<double>(upstream) / static_cast<double>(state.iterations());
+    state.counters["failures"] = static_cast<double>(failures.load());
+}
+BENCHMARK(BM_WatchlistFanout)->Arg(1)->Arg(100)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+int main(int argc, char** argv) {
+    // Our flags first; the rest go to Google Benchmark
+    std::vector<char*> remaining;
+    for (int i = 0; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--mock_latency_ms=", 0) == 0) {
+            g_mock_config.latency_ms = std::atoi(arg.c_str() + std::strlen("--mock_latency_ms="));
+        } else if (arg.rfind("--mock_jitter_ms=", 0) == 0) {
+            g_mock_config.latency_jitter_ms = std::atoi(arg.c_str() + std::strlen("--mock_jitter_ms="));
+        } else if (arg.rfind("--mock_error_rate=", 0) == 0) {
+            g_mock_config.error_rate = std::atof(arg.c_str() + std::strlen("--mock_error_rate="));
+        } else {
+            remaining.push_back(argv[i]);
+        }
+    }
+    int remaining_argc = static_cast<int>(remaining.size());
+    
+    rag::utils::Logger::getInstance().setLogLevel(rag::utils::LogLevel::ERROR);
+    
+    benchmark::Initialize(&remaining_argc, remaining.data());
+    if (benchmark::ReportUnrecognizedArguments(remaining_argc, remaining.data())) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -3,10 +3,14 @@
 #include <string>
 #include <vector>
 #include <memory>
-#include <curl/curl.h>
+#include <future>
 #include <nlohmann/json.hpp>
 
 namespace rag {
+namespace utils {
+struct HttpRequest;
+}
+
 namespace data {
 
 struct OHLCVData {
@@ -42,7 +46,12 @@ struct NewsArticle {
 class DataFetcher {
 public:
     DataFetcher(const std::string& api_key);
-    ~DataFetcher();
+    ~DataFetcher() = default;
+    
+    // Alpha Vantage query endpoint (default https://www.alphavantage.co/query);
+    // point at a mock server for benchmarks
+    void setBaseUrl(const std::string& base_url) { base_url_ = base_url; }
+    const std::string& getBaseUrl() const { return base_url_; }
     
     // Stock data
     bool fetchStockData(const std::string& symbol, const std::string& interval, 
@@ -56,16 +65,35 @@ public:
     bool fetchNews(const std::string& symbol, int max_articles, std::vector<NewsArticle>& articles);
     bool fetchCompanyFundamentals(const std::string& symbol, nlohmann::json& fundamentals);
     
-    // Volatility data
-    bool fetchVolatility(const std::string& symbol, const std::string& date, double& volatility);
+    // Non-blocking variants: the request is in flight when these return, and
+    // the future parses into the out-params (which must outlive it) on get()
+    std::future<bool> fetchRealTimeQuoteAsync(const std::string& symbol, double& price, double& change_percent);
+    std::future<bool> fetchNewsAsync(const std::string& symbol, int max_articles,
+                                     std::vector<NewsArticle>& articles);
+    std::future<bool> fetchStockDataAsync(const std::string& symbol, int days, std::vector<OHLCVData>& data);
+    
+    // Raw requests and parsers, split so bulk ingestion can fetch and parse in separate stages.
+    // The parsers decode in one pass with utils::JsonScanner, building no DOM.
+    bool requestStockData(const std::string& symbol, int days, std::string& response);
+    bool requestNews(const std::string& symbol, int max_articles, std::string& response);
+    static bool parseStockData(const std::string& response, int days, std::vector<OHLCVData>& data);
+    static bool parseNews(const std::string& response, std::vector<NewsArticle>& articles);
+    
+    // nlohmann::json DOM parsers: the fallback for input the scanner rejects,
+    // and the baseline in benchmarks
+    static bool parseStockDataDom(const std::string& response, int days, std::vector<OHLCVData>& data);
+    static bool parseNewsDom(const std::string& response, std::vector<NewsArticle>& articles);
+    static bool parseQuote(const std::string& symbol, const std::string& response,
+                           double& price, double& change_percent);
     
 private:
     std::string api_key_;
-    CURL* curl_handle_;
+    std::string base_url_ = "https://www.alphavantage.co/query";
     
-    static size_t writeCallback(void* contents, size_t size, size_t nmemb, std::string* data);
     bool makeHttpRequest(const std::string& url, std::string& response);
+    utils::HttpRequest buildRequest(const std::string& url) const;
     std::string buildAlphaVantageUrl(const std::string& function, const std::string& symbol);
+    std::string buildStockDataUrl(const std::string& symbol, int days);
     std::string buildPolygonUrl(const std::string& endpoint);
 };
 
@@ -3,12 +3,26 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <utility>
+#include <functional>
+#include <cstdint>
 #include <sqlite3.h>
 #include "data_ingestion/data_fetcher.h"
 
 namespace rag {
 namespace data {
 
+// Row filter and batching for Arrow exports
+struct ArrowExportOptions {
+    std::string symbol;              // Empty: every symbol
+    std::string start;               // Inclusive bounds on the table's time column; empty: unbounded
+    std::string end;
+    size_t batch_rows = 65536;       // Rows per record batch
+};
+
+// Receives an Arrow IPC stream in chunks; false aborts the export
+using ArrowByteSink = std::function<bool(const uint8_t* data, size_t size)>;
+
 class Database {
 public:
     Database(const std::string& db_path);
@@ -21,24 +35,46 @@ public:
     bool getOHLCVData(const std::string& symbol, const std::string& start_date, 
                      const std::string& end_date, std::vector<OHLCVData>& data);
     
+    // Intraday bars from the streaming feed, kept apart from the daily series.
+    // One transaction per call; timestamps are "YYYY-MM-DD HH:MM:SS" UTC bar starts.
+    bool storeIntradayBars(const std::vector<std::pair<std::string, OHLCVData>>& bars);
+    bool getIntradayBars(const std::string& symbol, const std::string& start_time,
+                         const std::string& end_time, std::vector<OHLCVData>& data);
+    
     // Options data operations
     bool storeOptionsData(const std::vector<OptionsData>& data);
     bool getOptionsData(const std::string& symbol, std::vector<OptionsData>& data);
     
     // News operations
     bool storeNewsArticle(const NewsArticle& article);
+    bool storeNewsArticles(const std::vector<NewsArticle>& articles);
     bool getNewsArticles(const std::string& symbol, int limit, std::vector<NewsArticle>& articles);
     bool getNewsArticlesByDate(const std::string& start_date, const std::string& end_date,
                               std::vector<NewsArticle>& articles);
+    bool getAllNewsArticles(std::vector<NewsArticle>& articles);
     
     // Volatility operations
     bool storeVolatility(const std::string& symbol, const std::string& date, double volatility);
+    bool storeVolatilitySeries(const std::string& symbol,
+                               const std::vector<std::pair<std::string, double>>& series);
     bool getVolatility(const std::string& symbol, const std::string& date, double& volatility);
     
     // Fundamentals
     bool storeFundamentals(const std::string& symbol, const std::string& json_data);
     bool getFundamentals(const std::string& symbol, std::string& json_data);
     
+    // Apache Arrow IPC export/import of a table: "ohlcv", "intraday_bars",
+    // "news" or "options". Rows go from SQLite straight into column builders
+    // and out as record batches; no per-row structs. A path ending in
+    // ".arrows" uses the IPC stream format, anything else the IPC file format
+    // (Feather v2). Import reads either and upserts in one transaction.
+    // All return false when built without Arrow (NO_ARROW).
+    bool exportArrow(const std::string& table, const std::string& path,
+                     const ArrowExportOptions& options, size_t& rows);
+    bool exportArrowStream(const std::string& table, const ArrowExportOptions& options,
+                           const ArrowByteSink& sink, size_t& rows);
+    bool importArrow(const std::string& table, const std::string& path, size_t& rows);
+    
 private:
     std::string db_path_;
     sqlite3* db_;
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <functional>
+#include "data_ingestion/data_fetcher.h"
+#include "data_ingestion/database.h"
+#include "data_ingestion/near_duplicate_detector.h"
+#include "data_ingestion/rate_limiter.h"
+#include "data_ingestion/volatility_engine.h"
+#include "vectorization/document_chunker.h"
+#include "vectorization/embedding_service.h"
+#include "vectorization/faiss_index.h"
+
+namespace rag {
+namespace data {
+
+struct IngestionConfig {
+    int fetch_workers = 8;
+    double requests_per_minute = 75.0;  // Alpha Vantage premium tier; free tier is 5
+    double request_burst = 5.0;
+    int max_rate_limit_retries = 3;
+    int history_days = 100;
+    int news_per_symbol = 50;
+    bool fetch_news = true;
+    vectorization::ChunkingConfig chunking;
+    size_t embed_batch_size = 64;
+    size_t queue_capacity = 128;
+    std::string base_url;  // Alpha Vantage endpoint override; empty keeps the default
+};
+
+struct IngestionStats {
+    size_t symbols_requested = 0;
+    size_t symbols_fetched = 0;
+    size_t fetch_failures = 0;
+    size_t bars_stored = 0;
+    size_t articles_stored = 0;
+    size_t duplicates_dropped = 0;
+    size_t documents_indexed = 0;
+    double elapsed_seconds = 0.0;
+};
+
+// Bulk multi-symbol ingestion. Stages run on their own threads and are
+// connected by bounded queues so a slow stage applies backpressure:
+//
+//   fetch pool (rate limited) -> parse -> embed (batched) -> store + index
+class IngestionPipeline {
+public:
+    IngestionPipeline(const std::string& api_key,
+                      std::shared_ptr<Database> database,
+                      std::shared_ptr<vectorization::EmbeddingService> embedding_service,
+                      std::shared_ptr<vectorization::FAISSIndex> faiss_index,
+                      const IngestionConfig& config = IngestionConfig());
+    
+    // Optional: keep streaming volatility estimates current as bars land
+    void setVolatilityEngine(std::shared_ptr<VolatilityEngine> volatility_engine);
+    
+    // Optional: drop syndicated copies before they are stored or embedded
+    void setNearDuplicateDetector(std::shared_ptr<NearDuplicateDetector> detector);
+    
+    // Refresh all symbols; blocks until every stage has drained
+    bool run(const std::vector<std::string>& symbols, IngestionStats& stats);
+    
+    // Index document for an article filed under symbol (before chunking)
+    static vectorization::Document toDocument(const std::string& symbol, const NewsArticle& article);
+    
+private:
+    struct RawPayload;
+    struct ParsedPayload;
+    struct StoreBatch;
+    
+    std::string api_key_;
+    std::shared_ptr<Database> database_;
+    std::shared_ptr<vectorization::EmbeddingService> embedding_service_;
+    std::shared_ptr<vectorization::FAISSIndex> faiss_index_;
+    std::shared_ptr<VolatilityEngine> volatility_engine_;
+    std::shared_ptr<NearDuplicateDetector> duplicate_detector_;
+    IngestionConfig config_;
+    TokenBucket alpha_vantage_limiter_;
+    
+    std::atomic<size_t> symbols_fetched_{0};
+    std::atomic<size_t> fetch_failures_{0};
+    std::atomic<size_t> bars_stored_{0};
+    std::atomic<size_t> articles_stored_{0};
+    std::atomic<size_t> duplicates_dropped_{0};
+    std::atomic<size_t> documents_indexed_{0};
+    
+    // Rate-limited request with backoff when the provider reports throttling
+    bool rateLimitedRequest(const std::function<bool(std::string&)>& request,
+                            const std::string& what, std::string& response);
+};
+
+} // namespace data
+} // namespace rag
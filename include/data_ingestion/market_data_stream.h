@@ -0,0 +1,125 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <unordered_map>
+#include <utility>
+#include "data_ingestion/database.h"
+#include "data_ingestion/market_feed.h"
+#include "utils/spsc_queue.h"
+
+namespace rag {
+namespace data {
+
+struct MarketStreamConfig {
+    size_t queue_capacity = 65536;   // Ticks between the reader and the writer
+    int bar_seconds = 60;
+    int flush_interval_ms = 200;     // Longest a closed bar waits before it is stored
+    size_t flush_batch = 1024;       // Bars that trigger an early flush
+    int reconnect_min_ms = 500;
+    int reconnect_max_ms = 30000;
+};
+
+// Latest state of a symbol from the stream
+struct LiveQuote {
+    double price = 0.0;
+    double change_percent = 0.0;     // From the previous close when the feed sends it, else the first tick seen
+    double session_high = 0.0;
+    double session_low = 0.0;
+    long volume = 0;                 // Since the stream started
+    int64_t timestamp_ms = 0;
+    std::chrono::steady_clock::time_point updated;
+};
+
+struct MarketStreamStats {
+    uint64_t ticks = 0;
+    uint64_t late_ticks = 0;         // Older than the bar being built; quote only
+    uint64_t bars_stored = 0;
+    uint64_t queue_full_waits = 0;   // Reader stalls while the writer caught up
+    uint64_t reconnects = 0;
+};
+
+// Streaming market data ingestion. A reader thread pulls ticks from the feed
+// into a lock-free SPSC queue; a writer thread drains it, updating the live
+// quote table (queryable as soon as a tick is drained) and building bars of
+// bar_seconds. A bar closes when the stream's clock (the newest tick time)
+// passes its end, and closed bars are stored in batches within
+// flush_interval_ms. Live feeds reconnect with exponential backoff, reset
+// only once a connection delivers ticks; a replay feed stores any partial
+// bars when it ends.
+class MarketDataStream {
+public:
+    MarketDataStream(std::unique_ptr<MarketFeed> feed, std::shared_ptr<Database> database,
+                     const MarketStreamConfig& config = MarketStreamConfig());
+    ~MarketDataStream();
+    
+    bool start();
+    // Stops reading, then stores everything received, partial bars included
+    void stop();
+    // Block until a replay has been fully stored (or stop() is called)
+    void wait();
+    
+    // False if the symbol hasn't ticked within max_age
+    bool getQuote(const std::string& symbol, LiveQuote& quote,
+                  std::chrono::milliseconds max_age = std::chrono::minutes(1)) const;
+    
+    MarketStreamStats stats() const;
+    const std::string& feedName() const { return feed_name_; }
+    
+private:
+    struct BarBuilder {
+        int64_t bucket_ms = -1;      // Start of the newest bar
+        bool open = false;           // False once that bar has closed
+        OHLCVData bar;
+    };
+    
+    struct SymbolState {
+        double reference_price = 0.0;
+        BarBuilder builder;
+    };
+    
+    std::unique_ptr<MarketFeed> feed_;
+    std::string feed_name_;
+    std::shared_ptr<Database> database_;
+    MarketStreamConfig config_;
+    utils::SpscQueue<MarketTick> queue_;
+    
+    std::atomic<bool> running_{false};
+    std::atomic<bool> input_done_{false};
+    bool finished_ = false;
+    std::mutex state_mutex_;
+    std::condition_variable state_cv_;
+    std::thread reader_;
+    std::thread writer_;
+    
+    std::unordered_map<std::string, LiveQuote> quotes_;
+    mutable std::shared_mutex quotes_mutex_;
+    
+    // Writer thread only
+    std::unordered_map<std::string, SymbolState> symbols_;
+    std::vector<std::pair<std::string, OHLCVData>> closed_bars_;
+    int64_t stream_clock_ms_ = 0;    // Newest tick time seen
+    int64_t closed_period_ = -1;     // Bar period closeBars() last ran for
+    
+    std::atomic<uint64_t> ticks_{0};
+    std::atomic<uint64_t> late_ticks_{0};
+    std::atomic<uint64_t> bars_stored_{0};
+    std::atomic<uint64_t> queue_full_waits_{0};
+    std::atomic<uint64_t> reconnects_{0};
+    
+    void readLoop();
+    void writeLoop();
+    void applyTicks(std::vector<MarketTick>& ticks);
+    void closeBars(int64_t clock_ms);
+    void flushBars();
+};
+
+} // namespace data
+} // namespace rag
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <fstream>
+#include <chrono>
+#include <cstdint>
+
+namespace rag {
+namespace data {
+
+// One trade from a streaming feed
+struct MarketTick {
+    std::string symbol;
+    int64_t timestamp_ms = 0;     // Exchange time, Unix epoch
+    double price = 0.0;
+    long size = 0;
+    double previous_close = 0.0;  // 0 when the feed doesn't send it
+    std::chrono::steady_clock::time_point received;  // Set by MarketDataStream
+};
+
+// Line protocol shared by every feed, one tick per line:
+//
+//   SYMBOL,TIMESTAMP_MS,PRICE,SIZE[,PREVIOUS_CLOSE]
+//
+// Blank lines and lines starting with '#' are not ticks.
+bool parseTickLine(std::string_view line, MarketTick& tick);
+std::string formatTickLine(const MarketTick& tick);
+
+// A source of ticks. read() blocks until the next tick and returns false at
+// the end of the stream or on a connection error, after which the caller
+// may open() again. close() may be called from another thread to unblock
+// a read() in progress; it is final, and later open() calls fail.
+class MarketFeed {
+public:
+    virtual ~MarketFeed() = default;
+    
+    virtual bool open() = 0;
+    virtual bool read(MarketTick& tick) = 0;
+    virtual void close() = 0;
+    
+    // Live feeds are reopened after errors; a replay ends
+    virtual bool live() const = 0;
+    virtual std::string name() const = 0;
+};
+
+// Newline-delimited ticks over plain TCP. subscribe_line, if set, is sent
+// after connecting.
+class TcpLineFeed : public MarketFeed {
+public:
+    TcpLineFeed(const std::string& host, int port, const std::string& subscribe_line = "");
+    ~TcpLineFeed() override;
+    
+    bool open() override;
+    bool read(MarketTick& tick) override;
+    void close() override;
+    bool live() const override { return true; }
+    std::string name() const override;
+    
+private:
+    std::string host_;
+    int port_;
+    std::string subscribe_line_;
+    std::atomic<int> fd_{-1};
+    std::atomic<bool> closed_{false};
+    std::string buffer_;
+    size_t offset_ = 0;
+};
+
+// Ticks in WebSocket text messages (ws:// only), one or more lines per
+// message. subscribe_message, if set, is sent as a text frame after the
+// handshake. Pings are answered.
+class WebSocketFeed : public MarketFeed {
+public:
+    WebSocketFeed(const std::string& url, const std::string& subscribe_message = "");
+    ~WebSocketFeed() override;
+    
+    bool open() override;
+    bool read(MarketTick& tick) override;
+    void close() override;
+    bool live() const override { return true; }
+    std::string name() const override { return url_; }
+    
+private:
+    std::string url_;
+    std::string host_;
+    int port_ = 80;
+    std::string path_ = "/";
+    std::string subscribe_message_;
+    std::atomic<int> fd_{-1};
+    std::atomic<bool> closed_{false};
+    std::string raw_;        // Bytes received, not yet framed
+    std::string lines_;      // Decoded message text, not yet parsed
+    size_t offset_ = 0;
+    
+    bool receive();
+    bool readFrame();
+    bool sendFrame(uint8_t opcode, std::string_view payload);
+};
+
+// Replays a recorded tick file. speed 0 replays as fast as possible; 1
+// paces ticks by their recorded timestamps, 10 ten times faster.
+class ReplayFeed : public MarketFeed {
+public:
+    ReplayFeed(const std::string& path, double speed = 0.0);
+    
+    bool open() override;
+    bool read(MarketTick& tick) override;
+    void close() override;
+    bool live() const override { return false; }
+    std::string name() const override { return "replay:" + path_; }
+    
+private:
+    std::string path_;
+    double speed_;
+    std::ifstream file_;
+    int64_t first_timestamp_ms_ = -1;
+    std::chrono::steady_clock::time_point started_;
+    std::atomic<bool> closed_{false};
+    std::mutex mutex_;
+    std::condition_variable closed_cv_;
+};
+
+// tcp://host:port, ws://host:port/path or replay:path[@speed];
+// nullptr for anything else
+std::unique_ptr<MarketFeed> createMarketFeed(const std::string& spec, const std::string& subscribe = "");
+
+} // namespace data
+} // namespace rag
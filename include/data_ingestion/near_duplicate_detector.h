@@ -0,0 +1,62 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+#include "data_ingestion/data_fetcher.h"
+
+namespace rag {
+namespace data {
+
+// Detects syndicated copies of the same story using 64-bit SimHash
+// fingerprints over word features. Fingerprints are indexed in LSH bands:
+// with max_distance + 1 bands, any two fingerprints within max_distance
+// bits share at least one band exactly, so lookups only compare a handful
+// of candidates.
+class NearDuplicateDetector {
+public:
+    NearDuplicateDetector(int max_distance = 5);
+    
+    static uint64_t fingerprint(const std::string& text);
+    static uint64_t fingerprint(const NewsArticle& article);
+    
+    // True if a near-duplicate has been seen (duplicate_of gets its id);
+    // otherwise the article is recorded and false is returned
+    bool checkAndInsert(const NewsArticle& article, std::string* duplicate_of = nullptr);
+    
+    // Lookup without recording
+    bool isDuplicate(const NewsArticle& article, std::string* duplicate_of = nullptr);
+    
+    // Record an article once it is stored and indexed; no-op if a
+    // near-duplicate is already recorded
+    void insert(const NewsArticle& article);
+    
+    int maxDistance() const { return max_distance_; }
+    
+    bool save(const std::string& filepath);
+    bool load(const std::string& filepath);
+    
+    size_t size();
+    
+private:
+    struct Entry {
+        uint64_t fingerprint;
+        std::string article_id;
+    };
+    
+    int max_distance_;
+    int band_count_;
+    int band_bits_;
+    std::vector<Entry> entries_;
+    std::vector<std::unordered_map<uint64_t, std::vector<uint32_t>>> bands_;
+    std::mutex mutex_;
+    
+    uint64_t bandKey(uint64_t fingerprint, int band) const;
+    bool findLocked(uint64_t fingerprint, std::string* duplicate_of) const;
+    void insertLocked(uint64_t fingerprint, const std::string& article_id);
+};
+
+} // namespace data
+} // namespace rag
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+
+namespace rag {
+namespace data {
+
+// Token bucket shared by all workers calling the same provider.
+// Tokens refill continuously at requests_per_minute; up to burst may be
+// spent at once.
+class TokenBucket {
+public:
+    TokenBucket(double requests_per_minute, double burst = 1.0);
+    
+    // Block until a token is available, then consume it
+    void acquire();
+    
+    // Consume a token if one is available right now
+    bool tryAcquire();
+    
+private:
+    using Clock = std::chrono::steady_clock;
+    
+    double rate_per_second_;
+    double capacity_;
+    double tokens_;
+    Clock::time_point last_refill_;
+    std::mutex mutex_;
+    
+    void refill(Clock::time_point now);
+};
+
+} // namespace data
+} // namespace rag
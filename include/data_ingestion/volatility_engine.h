@@ -0,0 +1,100 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include "data_ingestion/data_fetcher.h"
+#include "data_ingestion/database.h"
+
+namespace rag {
+namespace data {
+
+// Realized volatility estimates for a single bar, all annualized
+struct VolatilityEstimate {
+    std::string date;
+    double close_to_close = 0.0;  // Rolling stdev of log returns
+    double ewma = 0.0;            // Exponentially weighted (RiskMetrics)
+    double parkinson = 0.0;       // High/low range estimator
+    double garman_klass = 0.0;    // OHLC estimator
+    size_t observations = 0;      // Returns currently in the rolling window
+    bool close_to_close_only = false; // Persisted value: the other estimators are not set
+};
+
+// Per-symbol streaming volatility engine. Each new bar updates the rolling
+// window, EWMA and range estimators in O(1); estimates are kept per date so
+// historical lookups never refetch or recompute.
+class VolatilityEngine {
+public:
+    VolatilityEngine(size_t window = 30, double ewma_lambda = 0.94,
+                     std::shared_ptr<Database> database = nullptr);
+    
+    // Feed a single bar (must be newer than the last bar seen for the symbol)
+    bool update(const std::string& symbol, const OHLCVData& bar,
+                VolatilityEstimate* estimate = nullptr);
+    
+    // Feed a batch of bars in any order; bars already seen are skipped.
+    // Bars older than the symbol's first one are backfilled. complete marks
+    // the batch as the provider's whole history. Returns the number of bars applied.
+    size_t updateSeries(const std::string& symbol, const std::vector<OHLCVData>& bars,
+                        bool complete = false);
+    
+    // Estimate as of the latest bar on or before date (empty date = latest)
+    bool getEstimate(const std::string& symbol, const std::string& date,
+                    VolatilityEstimate& estimate);
+    
+    // Close-to-close volatility as of date, falling back to the database
+    bool getVolatility(const std::string& symbol, const std::string& date, double& volatility);
+    
+    // Timestamp of the newest bar applied for symbol (empty if none)
+    std::string lastTimestamp(const std::string& symbol);
+    
+    // Earliest date with an estimate (empty if none)
+    std::string firstEstimateDate(const std::string& symbol);
+    
+    // Whether a complete series has been applied, so nothing older exists
+    bool hasFullHistory(const std::string& symbol);
+    
+private:
+    struct RangeTerms {
+        double log_return;
+        double parkinson;
+        double garman_klass;
+    };
+    
+    struct SymbolState {
+        bool has_last_close = false;
+        double last_close = 0.0;
+        std::string first_timestamp;
+        std::string last_timestamp;
+        bool full_history = false;
+        
+        // Rolling window (Welford add/remove over log returns, plain sums for range terms)
+        std::deque<RangeTerms> window;
+        double mean = 0.0;
+        double m2 = 0.0;
+        double parkinson_sum = 0.0;
+        double garman_klass_sum = 0.0;
+        
+        bool has_ewma = false;
+        double ewma_variance = 0.0;
+        
+        std::map<std::string, VolatilityEstimate> history; // date -> estimate
+    };
+    
+    size_t window_;
+    double ewma_lambda_;
+    std::shared_ptr<Database> database_;
+    std::map<std::string, SymbolState> states_;
+    std::mutex mutex_;
+    
+    bool applyBar(const std::string& symbol, SymbolState& state, const OHLCVData& bar,
+                  VolatilityEstimate& estimate);
+    size_t backfill(const std::string& symbol, SymbolState& state, const std::vector<const OHLCVData*>& ordered,
+                    std::vector<std::pair<std::string, double>>& to_persist);
+};
+
+} // namespace data
+} // namespace rag
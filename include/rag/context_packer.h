@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace rag {
+namespace agent {
+
+struct RAGContextDoc;
+
+// Token limits for the retrieved context of one request type
+struct ContextBudget {
+    size_t max_context_tokens = 2000; // All documents together, including per-document headers
+    size_t max_doc_tokens = 500;      // Longer documents are truncated
+    size_t min_doc_tokens = 40;       // Don't include a document cut shorter than this
+};
+
+struct PackingStats {
+    size_t input_docs = 0;
+    size_t packed_docs = 0;
+    size_t duplicate_docs = 0;  // Dropped as identical to or contained in a higher-scored doc
+    size_t truncated_docs = 0;
+    size_t dropped_docs = 0;    // Did not fit the budget
+    size_t tokens = 0;          // Estimated prompt tokens used by the packed context
+};
+
+// Fits retrieved documents into a token budget: highest similarity first,
+// overlapping chunks of the same article are trimmed to their new text,
+// duplicates are dropped, and documents over the per-doc limit (or the
+// remaining budget) are cut at a sentence or token boundary.
+class ContextPacker {
+public:
+    static std::vector<RAGContextDoc> pack(std::vector<RAGContextDoc> docs,
+                                           const ContextBudget& budget,
+                                           PackingStats* stats = nullptr);
+    
+    // Defaults per request type ("stock_summary", "explain_volatility", ...)
+    static ContextBudget defaultBudget(const std::string& request_type);
+    
+    // Truncate text to at most max_tokens, preferring a sentence end
+    static std::string truncateToTokens(const std::string& text, size_t max_tokens);
+};
+
+} // namespace agent
+} // namespace rag
@@ -4,12 +4,26 @@
 #include <vector>
 #include <memory>
 #include <map>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
 #include "data_ingestion/data_fetcher.h"
 #include "data_ingestion/database.h"
+#include "data_ingestion/volatility_engine.h"
+#include "data_ingestion/market_data_stream.h"
 #include "vectorization/embedding_service.h"
 #include "vectorization/faiss_index.h"
+#include "vectorization/inverted_index.h"
+#include "rag/context_packer.h"
+#include "rag/reranker.h"
+#include "rag/watchlist_monitor.h"
 
 namespace rag {
+namespace utils {
+struct HttpRequest;
+struct HttpResponse;
+}
+
 namespace agent {
 
 // Note: ContextDoc is defined in generated protobuf files
@@ -23,6 +37,21 @@ struct RAGContextDoc {
     std::map<std::string, std::string> metadata;
 };
 
+// One symbol of a watchlist request
+struct BatchItemResult {
+    std::string symbol;
+    bool success = false;
+    std::string text;                       // Summary or explanation
+    bool has_price = false;                 // Summaries: quote fetched
+    double price = 0.0;
+    double change_percent = 0.0;
+    bool has_volatility = false;            // Explanations: estimate found
+    data::VolatilityEstimate volatility;
+    std::vector<RAGContextDoc> context_docs;
+};
+
+using BatchResultCallback = std::function<void(BatchItemResult&&)>;
+
 class RAGAgent {
 public:
     RAGAgent(std::shared_ptr<data::DataFetcher> data_fetcher,
@@ -53,22 +82,132 @@ public:
     bool queryRAG(const std::string& query, const std::vector<std::string>& symbols,
                  std::string& answer, std::vector<RAGContextDoc>& context_docs);
     
+    // Watchlist variants of getStockSummary/explainVolatility. Market data for
+    // every symbol is fetched concurrently, all queries go out in one embedding
+    // request and one index search, and the LLM calls run concurrently.
+    // on_result is called on this thread for each symbol as it completes.
+    // False if no symbol succeeded.
+    bool getStockSummaries(const std::vector<std::string>& symbols, const std::string& period,
+                           const BatchResultCallback& on_result);
+    bool explainVolatilities(const std::vector<std::string>& symbols, const std::string& date,
+                             const BatchResultCallback& on_result);
+    
+    // Stock summaries regenerated for what changed on a watchlist. One summary
+    // is written per symbol, period and state version (WatchlistRevision) and
+    // shared by every subscription that reaches it; a call needing a summary
+    // another call is writing waits for it. Retrieved context is only
+    // retrieved again when news was ingested.
+    bool refreshWatchlist(const std::vector<WatchlistChange>& changes, const std::string& period,
+                          const BatchResultCallback& on_result);
+    
+    // Source of changes for watchlist subscriptions (none: subscriptions
+    // unavailable). A symbol's cached context and summaries are dropped when
+    // its last subscriber leaves.
+    void setWatchlistMonitor(std::shared_ptr<WatchlistMonitor> monitor);
+    std::shared_ptr<WatchlistMonitor> watchlistMonitor() const { return watchlist_monitor_; }
+    
+    // Streamed quotes, used instead of a quote request while they are fresh
+    void setMarketDataStream(std::shared_ptr<data::MarketDataStream> market_stream) { market_stream_ = market_stream; }
+    
+    // Backing store, for bulk exports
+    std::shared_ptr<data::Database> database() const { return database_; }
+    
+    // Shared streaming volatility state (also fed by ingestion)
+    std::shared_ptr<data::VolatilityEngine> volatilityEngine() const { return volatility_engine_; }
+    
+    // OpenAI-compatible API root for chat completions (default https://api.openai.com/v1)
+    void setLLMBaseUrl(const std::string& base_url) { llm_base_url_ = base_url; }
+    
+    // BM25 index over news, fused with vector search (and used alone when embedding fails)
+    void setLexicalIndex(std::shared_ptr<vectorization::InvertedIndex> lexical_index) { lexical_index_ = lexical_index; }
+    
+    // Re-ranking of vector search candidates (over-fetch factor, score weights)
+    void setRerankConfig(const RerankConfig& config) { reranker_ = Reranker(config); }
+    
+    // Token budget for the retrieved context of a request type (see ContextPacker::defaultBudget)
+    void setContextBudget(const std::string& request_type, const ContextBudget& budget);
+    
+    // Prompt sent to the LLM for a query and its retrieved context
+    std::string buildPrompt(const std::string& query,
+                            const std::vector<RAGContextDoc>& context_docs) const;
+    
 private:
     std::shared_ptr<data::DataFetcher> data_fetcher_;
     std::shared_ptr<data::Database> database_;
     std::shared_ptr<vectorization::EmbeddingService> embedding_service_;
     std::shared_ptr<vectorization::FAISSIndex> faiss_index_;
+    std::shared_ptr<vectorization::InvertedIndex> lexical_index_;
+    std::shared_ptr<data::VolatilityEngine> volatility_engine_;
     std::string llm_api_key_;
+    std::string llm_base_url_ = "https://api.openai.com/v1";
+    std::map<std::string, ContextBudget> context_budgets_;
+    Reranker reranker_;
+    std::shared_ptr<WatchlistMonitor> watchlist_monitor_;
+    std::shared_ptr<data::MarketDataStream> market_stream_;
     
-    // Retrieve relevant context from vector store
-    std::vector<RAGContextDoc> retrieveContext(const std::string& query, size_t k = 5);
+    // Watchlist context and summary, by retrieval query (symbol and period)
+    struct WatchlistEntry {
+        std::string symbol;
+        bool has_context = false;
+        uint64_t context_version = 0;   // news_version it was retrieved at
+        std::vector<RAGContextDoc> context;
+        bool has_summary = false;
+        uint64_t summary_version = 0;
+        std::string summary;
+        bool generating = false;        // A call is writing generating_version
+        uint64_t generating_version = 0;
+        bool dropped = false;           // Unwatched while generating; erased by the writer
+    };
+    std::map<std::string, WatchlistEntry> watchlist_entries_;
+    std::mutex watchlist_mutex_;
+    std::condition_variable watchlist_generated_;
     
-    // Generate LLM response with context
+    // Streamed quote if fresh (already resolved), else a quote request
+    std::future<bool> fetchQuoteAsync(const std::string& symbol, double& price, double& change_percent);
+    
+    // Volatility estimate as of date, fetching only bars the engine hasn't seen
+    bool lookupVolatility(const std::string& symbol, const std::string& date,
+                          data::VolatilityEstimate& estimate);
+    // The engine's or the database's estimate, without fetching
+    bool cachedVolatility(const std::string& symbol, const std::string& date,
+                          data::VolatilityEstimate& estimate);
+    // Days of bars to fetch for an estimate as of date: the compact recent
+    // history, or the full one when date predates it; 0 if nothing older exists
+    int volatilityHistoryDays(const std::string& symbol, const std::string& date);
+    
+    // Retrieve relevant context: over-fetch from the vector store (fused with
+    // the lexical index when set), then re-rank
+    // (symbols default to ticker-like words in the query)
+    std::vector<RAGContextDoc> retrieveContext(const std::string& query, size_t k = 5,
+                                               const std::vector<std::string>& symbols = {});
+    // retrieveContext for several queries: one embedding request, one index search
+    std::vector<std::vector<RAGContextDoc>> retrieveContextBatch(const std::vector<std::string>& queries, size_t k,
+                                                                 const std::vector<std::vector<std::string>>& symbols);
+    // Fuse dense and lexical candidates and re-rank them down to k
+    std::vector<RAGContextDoc> fuseAndRerank(const std::string& query, size_t k,
+                                             const std::vector<std::string>& symbols,
+                                             std::vector<vectorization::SearchResult> dense_results,
+                                             std::vector<vectorization::SearchResult> lexical_results,
+                                             bool embedded);
+    
+    // Generate LLM response with context. context_docs is packed into the
+    // request type's token budget and left holding what the prompt used.
     std::string generateLLMResponse(const std::string& query, 
-                                   const std::vector<RAGContextDoc>& context_docs);
+                                   std::vector<RAGContextDoc>& context_docs,
+                                   const std::string& request_type);
+    // The packing and prompt half of generateLLMResponse
+    std::string packPrompt(const std::string& query, std::vector<RAGContextDoc>& context_docs,
+                           const std::string& request_type);
     
     // Query OpenAI GPT API
     std::string queryOpenAI(const std::string& prompt);
+    utils::HttpRequest buildLLMRequest(const std::string& prompt) const;
+    static std::string parseLLMResponse(const utils::HttpResponse& http_response);
+    
+    // Completions for all prompts, a bounded number in flight at a time;
+    // on_response(index, text) runs on this thread as each one arrives
+    void queryOpenAIConcurrent(const std::vector<std::string>& prompts,
+                               const std::function<void(size_t, std::string&&)>& on_response);
 };
 
 } // namespace agent
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace rag {
+namespace agent {
+
+struct RAGContextDoc;
+
+struct RerankConfig {
+    size_t candidate_multiplier = 4;      // Vector search over-fetch factor
+    double bm25_k1 = 1.2;
+    double bm25_b = 0.75;
+    double recency_half_life_days = 14.0;
+    
+    // Weights of the normalized component scores
+    double vector_weight = 0.45;
+    double lexical_weight = 0.30;
+    double recency_weight = 0.10;
+    double symbol_weight = 0.15;
+};
+
+// Cheap local second-stage ranker for vector search candidates. Combines the
+// vector similarity with BM25 over the candidate texts, exponential recency
+// decay relative to the newest candidate, and a match on the requested
+// symbols. The combined score replaces similarity_score; the original is
+// kept as "vector_score" metadata.
+class Reranker {
+public:
+    explicit Reranker(const RerankConfig& config = RerankConfig());
+    
+    std::vector<RAGContextDoc> rerank(const std::string& query,
+                                      const std::vector<std::string>& symbols,
+                                      std::vector<RAGContextDoc> candidates,
+                                      size_t top_k) const;
+    
+    const RerankConfig& config() const { return config_; }
+    
+    // Days since 1970-01-01 for "YYYY-MM-DD..." or "YYYYMMDDTHHMMSS"; -1 if unparseable
+    static long daysSinceEpoch(const std::string& timestamp);
+    
+private:
+    RerankConfig config_;
+};
+
+} // namespace agent
+} // namespace rag
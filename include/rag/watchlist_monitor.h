@@ -0,0 +1,196 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <unordered_set>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+#include "data_ingestion/data_fetcher.h"
+#include "data_ingestion/database.h"
+#include "data_ingestion/volatility_engine.h"
+#include "data_ingestion/market_data_stream.h"
+#include "data_ingestion/near_duplicate_detector.h"
+#include "vectorization/document_chunker.h"
+#include "vectorization/embedding_service.h"
+#include "vectorization/faiss_index.h"
+#include "vectorization/inverted_index.h"
+
+namespace rag {
+namespace agent {
+
+struct WatchlistMonitorConfig {
+    int quote_interval_seconds = 15;
+    int news_interval_seconds = 300;
+    int bars_interval_seconds = 3600;
+    int news_per_symbol = 50;
+    double price_threshold_percent = 1.0;       // Default move since a subscriber's last update
+    double volatility_threshold_percent = 5.0;  // Relative change in the close-to-close estimate
+    size_t max_subscriptions = 256;             // Each open Subscribe stream holds a server thread
+    vectorization::ChunkingConfig chunking;
+};
+
+// The latest change to a symbol's published state. It is the same for every
+// subscriber, so a summary written for one version can be shared by all.
+struct WatchlistRevision {
+    uint64_t version = 0;               // Bumped whenever the state changes
+    uint64_t news_version = 0;          // Version of the latest news ingested
+    size_t new_articles = 0;            // What changed in this version
+    bool price_changed = false;
+    bool volatility_changed = false;
+};
+
+// What changed for one symbol since a subscriber's last update. Changes
+// pending for the same symbol are merged, so a slow subscriber gets one
+// update carrying the latest data rather than a backlog.
+struct WatchlistChange {
+    std::string symbol;
+    bool initial = false;               // First update of the subscription
+    bool news_changed = false;
+    bool price_moved = false;
+    bool volatility_changed = false;
+    size_t new_articles = 0;            // Ingested since the last update
+    bool has_price = false;
+    double price = 0.0;
+    double change_percent = 0.0;
+    bool has_volatility = false;
+    data::VolatilityEstimate volatility;
+    WatchlistRevision revision;         // Symbol state the market data above comes from
+};
+
+// One client's view of the monitor: its symbols, price threshold, and the
+// changes not yet delivered
+class WatchlistSubscription {
+public:
+    const std::vector<std::string>& symbols() const { return symbols_; }
+    
+    // Wait up to timeout for changes; false on timeout or once closed
+    bool waitForChanges(std::vector<WatchlistChange>& changes, std::chrono::milliseconds timeout);
+    bool closed();
+    
+private:
+    friend class WatchlistMonitor;
+    
+    std::vector<std::string> symbols_;
+    double price_threshold_percent_ = 0.0;
+    std::set<std::string> awaiting_initial_;
+    std::map<std::string, double> delivered_prices_;  // Price in the last update per symbol
+    std::map<std::string, WatchlistChange> pending_;
+    bool closed_ = false;
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    
+    bool priceMoved(const std::string& symbol, double price);
+    void push(const WatchlistChange& change);
+    void close();
+};
+
+// Watches the union of all subscribed symbols on one background thread:
+// quotes, news and daily bars are polled per symbol (not per subscriber),
+// new articles are ingested into the database and indexes, and bars feed
+// the volatility engine. Subscribers are only woken when something they
+// care about changed.
+class WatchlistMonitor {
+public:
+    WatchlistMonitor(std::shared_ptr<data::DataFetcher> data_fetcher,
+                     std::shared_ptr<data::Database> database,
+                     std::shared_ptr<vectorization::EmbeddingService> embedding_service,
+                     std::shared_ptr<vectorization::FAISSIndex> faiss_index,
+                     std::shared_ptr<data::VolatilityEngine> volatility_engine,
+                     const WatchlistMonitorConfig& config = WatchlistMonitorConfig());
+    ~WatchlistMonitor();
+    
+    // Optional: keep the BM25 index current with ingested news
+    void setLexicalIndex(std::shared_ptr<vectorization::InvertedIndex> lexical_index) { lexical_index_ = lexical_index; }
+    
+    // Optional: take quotes from the stream while they are fresh instead of polling for them
+    void setMarketDataStream(std::shared_ptr<data::MarketDataStream> market_stream) { market_stream_ = market_stream; }
+    
+    // Optional: drop near-duplicate news (the detector bulk ingestion uses).
+    // Articles are fingerprinted once indexed and saved to save_path if set.
+    void setNearDuplicateDetector(std::shared_ptr<data::NearDuplicateDetector> detector,
+                                  const std::string& save_path = "") {
+        duplicate_detector_ = detector;
+        fingerprints_path_ = save_path;
+    }
+    
+    // Optional: called (outside the monitor's lock) with each symbol whose
+    // last subscriber left, so per-symbol caches elsewhere can be dropped
+    void setSymbolDroppedCallback(std::function<void(const std::string&)> callback) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        symbol_dropped_ = std::move(callback);
+    }
+    
+    void start();
+    void stop();
+    
+    // price_threshold_percent <= 0 uses the configured default. Each symbol's
+    // first change is marked initial, once its data has been polled. Null
+    // when max_subscriptions are already open.
+    std::shared_ptr<WatchlistSubscription> subscribe(const std::vector<std::string>& symbols,
+                                                     double price_threshold_percent = 0.0);
+    void unsubscribe(const std::shared_ptr<WatchlistSubscription>& subscription);
+    
+    size_t subscriptionCount();
+    size_t symbolCount();
+    
+private:
+    struct SymbolState {
+        size_t subscribers = 0;
+        bool polled = false;            // Quote, news and bars have each been fetched once
+        bool has_price = false;
+        double price = 0.0;
+        double change_percent = 0.0;
+        bool has_volatility = false;
+        data::VolatilityEstimate volatility;
+        WatchlistRevision revision;
+        std::chrono::steady_clock::time_point next_quote;
+        std::chrono::steady_clock::time_point next_news;
+        std::chrono::steady_clock::time_point next_bars;
+        bool quote_polled = false;
+        bool news_polled = false;
+        bool bars_polled = false;
+    };
+    
+    // Results of one polling round for a symbol
+    struct Poll;
+    
+    std::shared_ptr<data::DataFetcher> data_fetcher_;
+    std::shared_ptr<data::Database> database_;
+    std::shared_ptr<vectorization::EmbeddingService> embedding_service_;
+    std::shared_ptr<vectorization::FAISSIndex> faiss_index_;
+    std::shared_ptr<vectorization::InvertedIndex> lexical_index_;
+    std::shared_ptr<data::MarketDataStream> market_stream_;
+    std::shared_ptr<data::VolatilityEngine> volatility_engine_;
+    std::shared_ptr<data::NearDuplicateDetector> duplicate_detector_;
+    std::string fingerprints_path_;
+    WatchlistMonitorConfig config_;
+    vectorization::DocumentChunker chunker_;
+    
+    std::map<std::string, SymbolState> symbols_;
+    std::vector<std::shared_ptr<WatchlistSubscription>> subscriptions_;
+    std::vector<std::string> dropped_symbols_;  // No subscribers left; pruned by the monitor thread
+    std::function<void(const std::string&)> symbol_dropped_;
+    bool running_ = false;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::thread thread_;
+    
+    // Article ids seen per watched symbol (monitor thread only)
+    std::map<std::string, std::unordered_set<std::string>> seen_articles_;
+    
+    void run();
+    void poll(std::vector<Poll>& polls);
+    size_t ingestNews(const std::string& symbol, std::vector<data::NewsArticle>& articles);
+    void apply(const Poll& poll, std::chrono::steady_clock::time_point now);
+    WatchlistChange snapshot(const std::string& symbol, const SymbolState& state) const;
+};
+
+} // namespace agent
+} // namespace rag
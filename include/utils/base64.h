@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+
+namespace rag {
+namespace utils {
+
+// Standard-alphabet base64 (RFC 4648), padding optional on decode.
+
+// Bytes base64Decode will write for this input (no validation)
+size_t base64DecodedSize(std::string_view encoded);
+
+// Decode into out, which must hold base64DecodedSize(encoded) bytes.
+// False on characters outside the alphabet or misplaced padding.
+bool base64Decode(std::string_view encoded, uint8_t* out, size_t& written);
+
+std::string base64Encode(const void* data, size_t size);
+
+} // namespace utils
+} // namespace rag
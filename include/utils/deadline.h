@@ -0,0 +1,69 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <cstdint>
+#include <curl/curl.h>
+
+namespace rag {
+namespace utils {
+
+struct DeadlineState;
+struct CancelSource;
+
+// Time budget and cancellation of the request running on this thread. The
+// gRPC handlers install the client's deadline and cancellation check; agent
+// stages narrow it to a share of what is left; outbound HTTP calls inherit
+// it as a timeout and abort when the client goes away.
+class Deadline {
+public:
+    using Clock = std::chrono::steady_clock;
+    
+    // Whether a deadline or cancellation check is installed on this thread
+    static bool active();
+    
+    // Milliseconds left, or INT64_MAX when there is no deadline
+    static int64_t remainingMs();
+    
+    static bool cancelled();
+    
+    // Past the deadline or cancelled: further work is wasted
+    static bool expired();
+    
+    // Captured state, to continue the same budget on another thread
+    static std::shared_ptr<const DeadlineState> current();
+    
+    // Remaining time and cancellation of a captured state (null = unbounded)
+    static int64_t remainingMs(const std::shared_ptr<const DeadlineState>& state);
+    static bool expired(const std::shared_ptr<const DeadlineState>& state);
+};
+
+// Installs a deadline (and optionally a cancellation check) for the scope.
+// Nested scopes can only shorten the enclosing deadline, and keep its
+// cancellation check.
+class DeadlineScope {
+public:
+    DeadlineScope(Deadline::Clock::time_point deadline, std::function<bool()> is_cancelled = {});
+    explicit DeadlineScope(std::shared_ptr<const DeadlineState> state);
+    ~DeadlineScope();
+    
+    DeadlineScope(const DeadlineScope&) = delete;
+    DeadlineScope& operator=(const DeadlineScope&) = delete;
+    
+    // A stage's share of the remaining budget (no-op without a deadline);
+    // min_ms keeps a short tail from starving the stage outright
+    static DeadlineScope share(double fraction, int64_t min_ms = 50);
+    
+private:
+    std::shared_ptr<const DeadlineState> previous_;
+    std::shared_ptr<CancelSource> owned_cancel_; // Released when this scope ends
+};
+
+// Bounds a curl easy handle by the current deadline (and by default_timeout_ms
+// either way) and aborts the transfer when the request is cancelled. Returns
+// false, without touching the handle, when the request has already expired.
+bool applyDeadline(CURL* curl, int64_t default_timeout_ms);
+
+} // namespace utils
+} // namespace rag
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include "utils/http_engine.h"
+
+namespace rag {
+namespace utils {
+
+struct HttpRequest {
+    std::string method = "GET";     // GET or POST
+    std::string url;
+    std::string body;
+    std::vector<std::string> headers;
+    std::string endpoint;           // Metrics and circuit breaker key, e.g. "openai:embeddings"
+    std::string span_name;          // Client span, e.g. "POST /embeddings"
+    bool record_url = true;         // False when the URL carries credentials
+    bool idempotent = false;        // Safe to send twice, so it may be hedged
+    int64_t timeout_ms = 30000;     // Per attempt, further bounded by the request deadline
+};
+
+struct HttpResponse {
+    long status = 0;
+    std::string body;
+    std::string error;              // Transport error or breaker rejection
+    int attempts = 0;
+    bool hedged = false;            // A hedge was sent
+    
+    bool ok() const { return error.empty() && status >= 200 && status < 300; }
+};
+
+struct ResilienceConfig {
+    int max_retries = 2;                 // On 429, 5xx and transport errors
+    int64_t initial_backoff_ms = 200;
+    int64_t max_backoff_ms = 4000;       // Also caps Retry-After
+    bool hedging = true;
+    double hedge_quantile = 0.95;        // Hedge after this endpoint latency quantile
+    int64_t min_hedge_delay_ms = 20;
+    uint64_t hedge_min_samples = 50;     // Observed requests before hedging starts
+    uint32_t breaker_failure_threshold = 5; // Consecutive failures that open the breaker
+    int64_t breaker_open_ms = 10000;     // Fail fast this long, then let one probe through
+};
+
+// Outbound HTTP with retries, hedging and circuit breaking, shared by the
+// data, embedding and LLM clients. Transfers run on the HttpEngine event loop.
+// - Retries: 429, 5xx and transport errors, exponential backoff with jitter
+//   (honoring Retry-After), never past the request deadline.
+// - Hedging: idempotent requests still running after the endpoint's p95
+//   latency get a duplicate; the first good response wins and the other
+//   transfer is aborted.
+// - Circuit breakers: per endpoint; once open, calls fail immediately until
+//   a probe succeeds.
+// The caller's deadline and cancellation (utils::Deadline) are captured when
+// a request is issued and bound every attempt.
+class HttpClient {
+public:
+    using Callback = std::function<void(HttpResponse&&)>;
+    
+    static HttpClient& getInstance();
+    
+    void configure(const ResilienceConfig& config);
+    ResilienceConfig config() const;
+    
+    // Blocking. True for a 2xx response; response.status/body are filled either way
+    bool perform(const HttpRequest& request, HttpResponse& response);
+    
+    // Non-blocking. on_complete runs on the engine's loop thread (or inline
+    // when the circuit breaker rejects the call) and must not block
+    void performAsync(const HttpRequest& request, Callback on_complete);
+    
+    // Non-blocking; the future becomes ready with the final response
+    std::future<HttpResponse> submit(const HttpRequest& request);
+    
+private:
+    struct Breaker {
+        enum class State { CLOSED, OPEN, HALF_OPEN };
+        std::mutex mutex;
+        State state = State::CLOSED;
+        uint32_t consecutive_failures = 0;
+        std::chrono::steady_clock::time_point opened_at;
+        bool probe_in_flight = false;
+    };
+    
+    enum class Outcome { HEALTHY, FAILED, NEUTRAL }; // NEUTRAL: cut short by our own deadline
+    
+    struct Call;
+    
+    HttpClient() = default;
+    
+    ResilienceConfig config_;
+    mutable std::shared_mutex config_mutex_;
+    std::unordered_map<std::string, std::unique_ptr<Breaker>> breakers_;
+    std::shared_mutex breakers_mutex_;
+    
+    Breaker& breaker(const std::string& endpoint);
+    bool allowRequest(const std::string& endpoint, Breaker& breaker, const ResilienceConfig& config);
+    void recordOutcome(const std::string& endpoint, Breaker& breaker, Outcome outcome,
+                       const ResilienceConfig& config);
+    int64_t hedgeDelayMs(const std::string& endpoint, const ResilienceConfig& config) const;
+    
+    // Loop thread: the per-call state machine
+    void startAttempt(const std::shared_ptr<Call>& call);
+    void sendHedge(const std::shared_ptr<Call>& call, uint64_t attempt);
+    void onTransferDone(const std::shared_ptr<Call>& call, bool hedge, HttpTransferResult&& result);
+    void concludeAttempt(const std::shared_ptr<Call>& call, HttpTransferResult&& result);
+    void complete(const std::shared_ptr<Call>& call);
+};
+
+} // namespace utils
+} // namespace rag
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <queue>
+#include <functional>
+#include <unordered_map>
+#include <chrono>
+#include <cstdint>
+#include <curl/curl.h>
+
+namespace rag {
+namespace utils {
+
+struct DeadlineState;
+struct HttpRequest;
+
+struct HttpTransferResult {
+    CURLcode code = CURLE_OK;
+    long status = 0;
+    std::string body;
+    int64_t retry_after_ms = -1;    // From a Retry-After header
+};
+
+// Non-blocking outbound HTTP: one event-loop thread drives every transfer
+// through a single curl multi handle (epoll + curl_multi_socket_action on
+// Linux, curl_multi_poll elsewhere), so in-flight requests cost a socket and
+// a few KB instead of a blocked thread. Connections are reused across all
+// transfers. Completion callbacks and scheduled tasks run on the loop
+// thread and must not block; hand results to other threads (e.g. through a
+// promise) for anything heavier.
+class HttpEngine {
+public:
+    using Callback = std::function<void(HttpTransferResult&&)>;
+    
+    static HttpEngine& getInstance();
+    
+    // Run a task on the loop thread, now or after a delay
+    void post(std::function<void()> task);
+    void schedule(int64_t delay_ms, std::function<void()> task);
+    
+    // Loop thread only. Starts a transfer bounded by the captured deadline;
+    // returns 0 (and does not call back) if the deadline has already passed.
+    uint64_t start(const HttpRequest& request, std::shared_ptr<const DeadlineState> deadline,
+                   Callback on_complete);
+    // Loop thread only. Aborts a transfer without calling back.
+    void cancel(uint64_t id);
+    
+    bool onLoopThread() const { return std::this_thread::get_id() == loop_thread_id_; }
+    size_t inFlight() const { return in_flight_.load(std::memory_order_relaxed); }
+    
+    // Server certificates are verified unless turned off (self-signed test
+    // servers only); applies to transfers started afterwards
+    void setVerifyTls(bool verify) { verify_tls_.store(verify, std::memory_order_relaxed); }
+    
+private:
+    struct Transfer;
+    
+    struct Timer {
+        std::chrono::steady_clock::time_point due;
+        uint64_t sequence;
+        std::function<void()> task;
+        bool operator>(const Timer& other) const {
+            return due != other.due ? due > other.due : sequence > other.sequence;
+        }
+    };
+    
+    CURLM* multi_;
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1;
+    int64_t curl_timeout_ms_ = -1;  // From CURLMOPT_TIMERFUNCTION; -1 = none
+    std::chrono::steady_clock::time_point curl_timer_set_;
+    std::unordered_map<uint64_t, std::unique_ptr<Transfer>> transfers_;
+    uint64_t next_id_ = 1;
+    std::atomic<size_t> in_flight_{0};
+    std::atomic<bool> verify_tls_{true};
+    
+    std::mutex mutex_;              // Guards the two queues below
+    std::vector<std::function<void()>> posted_;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_;
+    uint64_t timer_sequence_ = 0;
+    
+    std::thread::id loop_thread_id_;
+    
+    HttpEngine();
+    
+    void run();
+    void wake();
+    int nextWaitMs();
+    void runTasks();
+    void processCompleted();
+    
+    static int socketCallback(CURL* easy, curl_socket_t socket, int what, void* userp, void* socketp);
+    static int timerCallback(CURLM* multi, long timeout_ms, void* userp);
+};
+
+} // namespace utils
+} // namespace rag
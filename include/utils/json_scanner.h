@@ -0,0 +1,75 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace rag {
+namespace utils {
+
+// Forward-only, on-demand JSON reader: the caller walks the document and pulls
+// the members it wants, skipping the rest, so nothing is materialized that
+// isn't used (no DOM, no per-node allocation). String and skip scans test 16
+// bytes at a time with SSE2.
+//
+// Structure is validated as it is read; any error makes every later call
+// return false. Views returned by readString/nextKey point into the input,
+// or into an internal buffer when the string has escapes, and stay valid
+// until the next call.
+//
+//   JsonScanner json(body);
+//   std::string_view key;
+//   if (json.beginObject()) {
+//       while (json.nextKey(key)) {
+//           key == "feed" ? readFeed(json) : json.skipValue();
+//       }
+//   }
+//   bool ok = json.ok();
+class JsonScanner {
+public:
+    explicit JsonScanner(std::string_view input) : input_(input) {}
+    
+    // Enter the object/array that comes next
+    bool beginObject();
+    bool beginArray();
+    
+    // Next member of the current object; false (and the object is left) at '}'
+    bool nextKey(std::string_view& key);
+    // Whether the current array has another element; false (and the array is left) at ']'
+    bool nextElement();
+    
+    bool readString(std::string_view& value);
+    bool readString(std::string& value);
+    bool readNumber(double& value);
+    bool skipValue();
+    
+    // Next value's first character (0 at the end or after an error)
+    char peek();
+    
+    bool ok() const { return !failed_; }
+    size_t offset() const { return pos_; }
+    
+private:
+    std::string_view input_;
+    size_t pos_ = 0;
+    bool failed_ = false;
+    std::vector<uint8_t> first_;    // Per open container: no element read yet
+    std::string scratch_;           // Unescaped strings
+    
+    void skipWhitespace();
+    bool fail();
+    bool expect(char c);
+    bool readKey(std::string_view& key);
+    size_t findQuoteOrEscape(size_t from) const;
+    bool unescape(size_t start, size_t& end);
+};
+
+// Full-string numeric conversions with std::from_chars: no locale, no
+// allocation. Leading/trailing whitespace and a leading '+' are tolerated.
+bool parseDouble(std::string_view text, double& value);
+bool parseInt64(std::string_view text, int64_t& value);
+
+} // namespace utils
+} // namespace rag
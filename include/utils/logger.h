@@ -1,8 +1,12 @@
 #pragma once
 
 #include <string>
-#include <fstream>
+#include <cstdio>
+#include <cstdint>
+#include <atomic>
 #include <mutex>
+#include <condition_variable>
+#include <thread>
 #include <memory>
 
 namespace rag {
@@ -15,6 +19,10 @@ enum class LogLevel {
     ERROR
 };
 
+// Asynchronous logger. Callers copy the message into a lock-free bounded
+// ring buffer and return; a background thread formats timestamps and writes
+// batches to stdout and the log file. When the ring is full, messages are
+// dropped (and counted) rather than blocking the caller.
 class Logger {
 public:
     static Logger& getInstance();
@@ -22,23 +30,78 @@ public:
     void setLogLevel(LogLevel level);
     void setLogFile(const std::string& filepath);
     
+    // Cheap check so callers can skip building messages (see RAG_LOG_* macros)
+    bool isEnabled(LogLevel level) const {
+        return static_cast<int>(level) >= log_level_.load(std::memory_order_relaxed);
+    }
+    
     void log(LogLevel level, const std::string& message);
     void debug(const std::string& message);
     void info(const std::string& message);
     void warning(const std::string& message);
     void error(const std::string& message);
     
+    // Block until everything logged so far has been written
+    void flush();
+    
+    // Messages discarded because the ring buffer was full
+    uint64_t droppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+    
 private:
-    Logger() = default;
+    static constexpr size_t kRingCapacity = 4096; // Power of two
+    static constexpr size_t kMaxMessageBytes = 1000;
+    
+    struct Record {
+        std::atomic<size_t> sequence;
+        int64_t timestamp_us;
+        LogLevel level;
+        uint32_t length;
+        char text[kMaxMessageBytes];
+    };
+    
+    Logger();
+    ~Logger();
     Logger(const Logger&) = delete;
     Logger& operator=(const Logger&) = delete;
     
-    std::string levelToString(LogLevel level);
-    std::ofstream log_file_;
-    LogLevel log_level_ = LogLevel::INFO;
-    std::mutex mutex_;
+    const char* levelToString(LogLevel level);
+    bool dequeue(std::string& batch, int64_t& last_second, std::string& time_prefix);
+    void writerLoop();
+    
+    std::unique_ptr<Record[]> ring_;
+    std::atomic<size_t> enqueue_pos_{0};
+    size_t dequeue_pos_ = 0; // Writer thread only
+    
+    std::atomic<int> log_level_{static_cast<int>(LogLevel::INFO)};
+    std::atomic<uint64_t> dropped_{0};
+    uint64_t dropped_reported_ = 0;
+    
+    std::FILE* log_file_ = nullptr;
+    std::mutex file_mutex_;
+    
+    std::atomic<bool> running_{true};
+    std::atomic<bool> writer_sleeping_{false};
+    std::atomic<uint64_t> written_{0};
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+    std::condition_variable flushed_cv_;
+    std::thread writer_;
 };
 
 } // namespace utils
 } // namespace rag
 
+// Level-checked logging: the message expression is only evaluated when the
+// level is enabled, so debug strings cost nothing in production.
+#define RAG_LOG(level, message)                                             \
+    do {                                                                    \
+        auto& rag_logger_ = ::rag::utils::Logger::getInstance();            \
+        if (rag_logger_.isEnabled(level)) {                                 \
+            rag_logger_.log(level, message);                                \
+        }                                                                   \
+    } while (0)
+
+#define RAG_LOG_DEBUG(message) RAG_LOG(::rag::utils::LogLevel::DEBUG, message)
+#define RAG_LOG_INFO(message) RAG_LOG(::rag::utils::LogLevel::INFO, message)
+#define RAG_LOG_WARNING(message) RAG_LOG(::rag::utils::LogLevel::WARNING, message)
+#define RAG_LOG_ERROR(message) RAG_LOG(::rag::utils::LogLevel::ERROR, message)
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <shared_mutex>
+#include <cstdint>
+
+namespace rag {
+namespace utils {
+
+using MetricLabels = std::vector<std::pair<std::string, std::string>>;
+
+class Counter {
+public:
+    void increment(uint64_t n = 1) { value_.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t value() const { return value_.load(std::memory_order_relaxed); }
+    
+private:
+    std::atomic<uint64_t> value_{0};
+};
+
+class Gauge {
+public:
+    void set(double value) { value_.store(value, std::memory_order_relaxed); }
+    void add(double delta);
+    double value() const { return value_.load(std::memory_order_relaxed); }
+    
+private:
+    std::atomic<double> value_{0.0};
+};
+
+// Log-linear (HDR-style) histogram of microsecond durations: 16 linear
+// sub-buckets per power of two, so any recorded value is reproduced within
+// ~6%. Recording is a few relaxed atomic adds; no locks, no allocation.
+class Histogram {
+public:
+    static constexpr int kSubBucketBits = 4;
+    static constexpr int kSubBuckets = 1 << kSubBucketBits;
+    static constexpr int kBucketCount = (64 - kSubBucketBits + 1) * kSubBuckets;
+    
+    void record(uint64_t micros);
+    
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    uint64_t sum() const { return sum_.load(std::memory_order_relaxed); }
+    
+    // Value at quantile q (0..1), in microseconds
+    uint64_t percentile(double q) const;
+    
+private:
+    std::atomic<uint64_t> buckets_[kBucketCount] = {};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+    
+    static int bucketIndex(uint64_t value);
+    static uint64_t bucketUpperBound(int index);
+};
+
+// Records the scope's wall time into a histogram on destruction
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Histogram& histogram)
+        : histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() {
+        histogram_.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start_).count()));
+    }
+    
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+    
+private:
+    Histogram& histogram_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+// Process-wide metric registry rendered in the Prometheus text format.
+// Lookups return stable references; hot paths should look a metric up once
+// (e.g. into a function-local static) and then only touch the atomics.
+class MetricsRegistry {
+public:
+    static MetricsRegistry& getInstance();
+    
+    Counter& counter(const std::string& name, const std::string& help, const MetricLabels& labels = {});
+    Gauge& gauge(const std::string& name, const std::string& help, const MetricLabels& labels = {});
+    
+    // Exported as a summary in seconds (quantiles 0.5/0.9/0.95/0.99, _sum, _count)
+    Histogram& histogram(const std::string& name, const std::string& help, const MetricLabels& labels = {});
+    
+    // Gauge computed at scrape time (e.g. index size)
+    void gaugeCallback(const std::string& name, const std::string& help,
+                       std::function<double()> callback, const MetricLabels& labels = {});
+    
+    std::string renderPrometheus() const;
+    
+private:
+    enum class Type { COUNTER, GAUGE, SUMMARY };
+    
+    struct Series {
+        std::unique_ptr<Counter> counter;
+        std::unique_ptr<Gauge> gauge;
+        std::unique_ptr<Histogram> histogram;
+        std::function<double()> callback;
+    };
+    
+    struct Family {
+        std::string help;
+        Type type;
+        std::map<std::string, Series> series; // Rendered label set -> series
+    };
+    
+    MetricsRegistry() = default;
+    
+    Series& series(const std::string& name, const std::string& help, Type type, const MetricLabels& labels);
+    static std::string formatLabels(const MetricLabels& labels);
+    
+    std::map<std::string, Family> families_;
+    mutable std::shared_mutex mutex_;
+};
+
+// Shorthand for the common per-stage duration histogram
+Histogram& stageHistogram(const std::string& component, const std::string& stage);
+
+// External HTTP call latency and outcome, by endpoint (e.g. "openai:embeddings")
+void recordHttpRequest(const std::string& endpoint, uint64_t micros, bool success);
+
+} // namespace utils
+} // namespace rag
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <thread>
+#include <atomic>
+
+namespace rag {
+namespace utils {
+
+// Serves MetricsRegistry over plain HTTP (GET /metrics) for Prometheus
+// scrapes. One connection at a time on a background thread; scrapes are
+// infrequent and rendering is cheap.
+class MetricsServer {
+public:
+    MetricsServer(const std::string& address = "0.0.0.0", int port = 9464);
+    ~MetricsServer();
+    
+    bool start();
+    void stop();
+    
+    int port() const { return port_; }
+    
+private:
+    std::string address_;
+    int port_;
+    int listen_fd_ = -1;
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+    
+    void serveLoop();
+    void handleConnection(int fd);
+};
+
+} // namespace utils
+} // namespace rag
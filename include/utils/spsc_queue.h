@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace rag {
+namespace utils {
+
+// Lock-free single-producer/single-consumer ring buffer. Exactly one thread
+// may push and one (other) thread may pop. Each side caches the other's
+// index, so an uncontended push or pop touches no shared cache line.
+// Capacity is rounded up to a power of two.
+template <typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity)
+        : mask_(roundUp(capacity) - 1),
+          slots_(new T[mask_ + 1]) {}
+    
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+    
+    // False when full; item is left untouched
+    bool tryPush(T& item) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_cache_ > mask_) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail - head_cache_ > mask_) {
+                return false;
+            }
+        }
+        slots_[tail & mask_] = std::move(item);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+    
+    // False when empty
+    bool tryPop(T& item) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_cache_) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (head == tail_cache_) {
+                return false;
+            }
+        }
+        item = std::move(slots_[head & mask_]);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+    
+    // Approximate when called concurrently with push or pop
+    size_t size() const {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+    
+    size_t capacity() const { return mask_ + 1; }
+    
+private:
+    static constexpr size_t kCacheLine = 64;
+    
+    static size_t roundUp(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        return size;
+    }
+    
+    const size_t mask_;
+    std::unique_ptr<T[]> slots_;
+    
+    // Consumer-owned line: its index and its view of the producer's
+    alignas(kCacheLine) std::atomic<size_t> head_{0};
+    size_t tail_cache_ = 0;
+    
+    // Producer-owned line
+    alignas(kCacheLine) std::atomic<size_t> tail_{0};
+    size_t head_cache_ = 0;
+};
+
+} // namespace utils
+} // namespace rag
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <utility>
+
+namespace rag {
+namespace utils {
+
+enum class SpanKind {
+    INTERNAL,
+    SERVER,
+    CLIENT
+};
+
+struct SpanData {
+    std::string trace_id;        // 32 hex chars
+    std::string span_id;         // 16 hex chars
+    std::string parent_span_id;  // Empty for the local root
+    std::string name;
+    SpanKind kind = SpanKind::INTERNAL;
+    int64_t start_unix_nanos = 0;
+    int64_t end_unix_nanos = 0;
+    std::vector<std::pair<std::string, std::string>> attributes;
+    bool error = false;
+    std::string status_message;
+};
+
+class SpanExporter {
+public:
+    virtual ~SpanExporter() = default;
+    virtual void exportSpans(std::vector<SpanData> spans) = 0;
+};
+
+// Writes spans as OTLP/JSON (one ExportTraceServiceRequest per line) from a
+// background thread, so exporting never blocks a request.
+class OtlpFileExporter : public SpanExporter {
+public:
+    OtlpFileExporter(const std::string& filepath, const std::string& service_name = "rag-agent");
+    ~OtlpFileExporter() override;
+    
+    void exportSpans(std::vector<SpanData> spans) override;
+    
+private:
+    std::string service_name_;
+    std::FILE* file_;
+    std::vector<SpanData> pending_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool running_ = true;
+    std::thread writer_;
+    
+    void writerLoop();
+    std::string toJson(const std::vector<SpanData>& spans) const;
+};
+
+struct TracingConfig {
+    double sample_rate = 0.05;        // Head sampling for traces without an upstream decision
+    int64_t slow_threshold_ms = 1000; // Unsampled traces slower than this are exported anyway
+    size_t max_spans_per_trace = 512;
+};
+
+struct TraceBuffer;
+
+// Trace state carried by the current thread; capture it to continue a trace
+// on another thread (see TraceContextScope)
+struct TraceContext {
+    std::shared_ptr<TraceBuffer> buffer;
+    std::string span_id;
+};
+
+class Tracer {
+public:
+    static Tracer& getInstance();
+    
+    // Tracing is off (spans are no-ops) until an exporter is configured
+    void configure(const TracingConfig& config, std::shared_ptr<SpanExporter> exporter);
+    bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+    
+    const TracingConfig& config() const { return config_; }
+    std::shared_ptr<SpanExporter> exporter() const;
+    
+    static TraceContext currentContext();
+    
+private:
+    Tracer() = default;
+    
+    TracingConfig config_;
+    std::shared_ptr<SpanExporter> exporter_;
+    std::atomic<bool> enabled_{false};
+    mutable std::mutex mutex_;
+};
+
+// RAII span. A root span (constructed with a W3C traceparent, possibly
+// empty) starts or continues a trace on this thread; other spans become
+// children of the innermost active span and are no-ops outside a trace.
+// Every trace is recorded in memory; it is exported when head-sampled
+// (or sampled upstream) or when the root runs past the slow threshold,
+// so tail-latency outliers are always kept.
+class Span {
+public:
+    explicit Span(const std::string& name, SpanKind kind = SpanKind::INTERNAL);
+    Span(const std::string& name, const std::string& traceparent, SpanKind kind);
+    ~Span();
+    
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+    
+    void setAttribute(const std::string& key, const std::string& value);
+    void setError(const std::string& message);
+    
+    bool active() const { return active_; }
+    const std::string& traceId() const { return data_.trace_id; }
+    
+    // traceparent header value for propagating this span downstream
+    std::string traceparent() const;
+    
+private:
+    bool active_ = false;
+    bool root_ = false;
+    SpanData data_;
+    TraceContext previous_;
+    
+    void begin(const std::string& name, SpanKind kind);
+};
+
+// Makes a captured TraceContext current on this thread for the scope
+class TraceContextScope {
+public:
+    explicit TraceContextScope(const TraceContext& context);
+    ~TraceContextScope();
+    
+private:
+    TraceContext previous_;
+};
+
+} // namespace utils
+} // namespace rag
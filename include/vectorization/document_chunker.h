@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <unordered_set>
+#include "vectorization/faiss_index.h"
+
+namespace rag {
+namespace vectorization {
+
+struct ChunkingConfig {
+    size_t max_tokens = 256;     // Upper bound per chunk
+    size_t overlap_tokens = 32;  // Context repeated at the start of the next chunk
+};
+
+// Splits documents into overlapping, token-bounded chunks before embedding.
+// Chunks prefer to end on sentence boundaries and carry parent linkage in
+// their metadata (parent_doc_id, chunk_index, chunk_count, content_hash).
+// Chunks identical to one already produced, or already indexed, are dropped.
+class DocumentChunker {
+public:
+    DocumentChunker(const ChunkingConfig& config = ChunkingConfig(),
+                    std::shared_ptr<FAISSIndex> faiss_index = nullptr);
+    
+    // Append the new (non-duplicate) chunks of parent; returns how many were added
+    size_t chunk(const Document& parent, std::vector<Document>& chunks);
+    
+    // Hash of whitespace/case-normalized text, used to detect identical chunks
+    static std::string contentHash(const std::string& text);
+    
+private:
+    ChunkingConfig config_;
+    std::shared_ptr<FAISSIndex> faiss_index_;
+    std::unordered_set<std::string> seen_hashes_;
+    std::mutex mutex_;
+    
+    std::vector<std::string> split(const std::string& text) const;
+};
+
+} // namespace vectorization
+} // namespace rag
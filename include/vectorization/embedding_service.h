@@ -3,8 +3,17 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <future>
+#include <functional>
+#include <nlohmann/json.hpp>
+#include "vectorization/local_embedding_model.h"
 
 namespace rag {
+namespace utils {
+struct HttpRequest;
+struct HttpResponse;
+}
+
 namespace vectorization {
 
 class EmbeddingService {
@@ -15,19 +24,50 @@ public:
     // Generate embeddings for text
     bool generateEmbedding(const std::string& text, std::vector<float>& embedding);
     
+    // Non-blocking for remote providers: the request is in flight when this
+    // returns and get() parses into embedding (which must outlive the future).
+    // The local provider embeds on get().
+    std::future<bool> generateEmbeddingAsync(const std::string& text, std::vector<float>& embedding);
+    
     // Generate embeddings for multiple texts (batch)
     bool generateEmbeddings(const std::vector<std::string>& texts, 
                            std::vector<std::vector<float>>& embeddings);
     
+    // Batch into one row-major matrix of texts.size() x getEmbeddingDimension()
+    // floats, ready for FAISSIndex::addDocumentMatrix. Remote vectors are
+    // decoded straight into their rows; the matrix's capacity is reused.
+    bool generateEmbeddingMatrix(const std::vector<std::string>& texts, std::vector<float>& matrix);
+    
     // Get embedding dimension
     size_t getEmbeddingDimension() const { return embedding_dimension_; }
     
+    // OpenAI-compatible API root (default https://api.openai.com/v1)
+    void setBaseUrl(const std::string& base_url) { base_url_ = base_url; }
+    
+    // Request vectors as base64 little-endian float32 (encoding_format
+    // "base64", the default) rather than JSON float arrays
+    void setBase64Encoding(bool enabled) { base64_encoding_ = enabled; }
+    
+    // Model file for the "local" provider; sets the embedding dimension
+    bool loadLocalModel(const std::string& filepath);
+    
 private:
     std::string api_key_;
     std::string provider_;
+    std::string base_url_ = "https://api.openai.com/v1";
     size_t embedding_dimension_;
+    bool base64_encoding_ = true;
+    LocalEmbeddingModel local_model_;
+    
+    // Where to decode the vector for an input index, or null to drop it
+    using RowSink = std::function<float*(size_t index, size_t dimension)>;
     
     bool generateOpenAIEmbedding(const std::string& text, std::vector<float>& embedding);
+    bool generateOpenAIEmbeddings(const std::vector<std::string>& texts, const RowSink& sink);
+    utils::HttpRequest buildOpenAIRequest(const nlohmann::json& input) const;
+    static bool parseOpenAIResponse(const utils::HttpResponse& http_response, const RowSink& sink,
+                                    size_t& rows);
+    RowSink embeddingSink(std::vector<float>& embedding);
     bool generateVertexAIEmbedding(const std::string& text, std::vector<float>& embedding);
 };
 
@@ -4,6 +4,15 @@
 #include <vector>
 #include <memory>
 #include <map>
+#include <shared_mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
 
 #ifdef NO_FAISS
 // Stub definitions when FAISS is not available
@@ -25,6 +34,9 @@ namespace faiss {
 namespace rag {
 namespace vectorization {
 
+class IndexWal;
+struct WalRecord;
+
 struct Document {
     std::string doc_id;
     std::string content;
@@ -42,6 +54,12 @@ struct SearchResult {
     std::map<std::string, std::string> metadata;
 };
 
+// When the background checkpointer folds the WAL into a new checkpoint
+struct CheckpointOptions {
+    std::chrono::seconds interval{300};   // Checkpoint logged changes at least this often
+    uint64_t wal_bytes = 64ull << 20;     // ...or as soon as the active WAL grows past this
+};
+
 class FAISSIndex {
 public:
     FAISSIndex(size_t dimension);
@@ -57,32 +75,92 @@ public:
     bool addDocuments(const std::vector<Document>& docs, 
                      const std::vector<std::vector<float>>& embeddings);
     
+    // Add documents with a row-major docs.size() x dimension embedding matrix
+    bool addDocumentMatrix(const std::vector<Document>& docs, const std::vector<float>& embedding_matrix);
+    bool addDocumentMatrix(const std::vector<Document>& docs, const float* embedding_matrix);
+    
     // Search for similar documents
     std::vector<SearchResult> search(const std::vector<float>& query_embedding, 
                                     size_t k = 10);
     
+    // Search for a row-major matrix of queries in one pass; one result list per row
+    std::vector<std::vector<SearchResult>> searchBatch(const std::vector<float>& query_matrix,
+                                                       size_t k = 10);
+    
+    // Batch search into caller-owned buffers (NumPy arrays from the Python
+    // bindings): queries is n x dimension, labels and scores n x k. Labels
+    // are index positions (see documentId); slots past the index size or
+    // holding removed documents get label -1 and score 0.
+    bool searchLabels(const float* queries, size_t n, size_t k, int64_t* labels, float* scores);
+    
+    // Document ID at an index position; empty if there is none
+    std::string documentId(int64_t label) const;
+    
     // Remove document from index
     bool removeDocument(const std::string& doc_id);
     
     // Get document by ID
     bool getDocument(const std::string& doc_id, Document& doc);
     
-    // Save index to disk
+    // Check whether a document is already indexed
+    bool contains(const std::string& doc_id) const;
+    
+    // Check whether a chunk with this content hash (metadata "content_hash") is indexed
+    bool containsContent(const std::string& content_hash) const;
+    
+    // Checkpoint to disk: filepath (FAISS) and filepath + ".meta", each written
+    // to a temp file and renamed into place. Writes a point-in-time snapshot
+    // copied in short chunks under the shared lock (document pointers and
+    // vectors), so searches never wait and writers at most for one chunk.
+    // Seals the WAL for filepath at the snapshot and deletes the sealed
+    // segments once the checkpoint is in place.
     bool save(const std::string& filepath);
     
-    // Load index from disk
+    // Load the checkpoint, then replay filepath + ".wal" (sealed segments first) over it
     bool load(const std::string& filepath);
     
+    // Log every add and remove to filepath + ".wal" before it returns, one
+    // sequential append per call; concurrent writers share a sync. Replays
+    // what the loaded checkpoint is missing. sync=false leaves flushing to the OS.
+    bool openWal(const std::string& filepath, bool sync = true);
+    
+    // Run save(filepath) on a low-priority background thread whenever the
+    // options say so; needs the WAL for filepath open. Stopped by the destructor.
+    bool startCheckpointer(const std::string& filepath, const CheckpointOptions& options = CheckpointOptions());
+    void stopCheckpointer();
+    
     // Get total number of documents
     size_t size() const;
     
+    size_t dimension() const { return dimension_; }
+    
 private:
     size_t dimension_;
     std::unique_ptr<faiss::IndexFlatL2> index_;
-    std::map<std::string, Document> documents_; // doc_id -> Document
+    std::map<std::string, std::shared_ptr<const Document>> documents_; // doc_id -> Document, shared with snapshots
     std::vector<std::string> doc_ids_; // Vector index -> doc_id mapping
+    std::unordered_set<std::string> content_hashes_; // Dedup of identical chunks
+    mutable std::shared_mutex mutex_; // Searches share, writers (ingestion) exclusive
+    std::unique_ptr<IndexWal> wal_;
+    std::atomic<bool> wal_open_{false};
+    uint64_t applied_lsn_ = 0; // Last logged operation reflected here (or in the checkpoint)
+    std::atomic<uint64_t> checkpoint_lsn_{0}; // Last logged operation in the checkpoint on disk
+    std::mutex checkpoint_mutex_; // One save or load at a time; taken before mutex_
+    bool snapshotting_ = false; // A checkpoint is copying; writers save pre-images
+    std::unordered_map<std::string, std::shared_ptr<const Document>> snapshot_undo_; // doc_id -> version at the snapshot
+    
+    std::thread checkpointer_;
+    std::mutex checkpointer_mutex_;
+    std::condition_variable checkpointer_cv_;
+    bool checkpointer_stop_ = false;
     
     bool buildIndex();
+    void runCheckpointer(std::string filepath, CheckpointOptions options);
+    bool insertDocuments(const Document* docs, size_t count, const float* embedding_matrix);
+    void trackDocument(const Document& doc);
+    void eraseDocument(std::map<std::string, std::shared_ptr<const Document>>::iterator it);
+    void preserveForSnapshot(const std::string& doc_id);
+    void applyRecord(WalRecord&& record);
 };
 
 } // namespace vectorization
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "vectorization/faiss_index.h"
+
+namespace rag {
+namespace vectorization {
+
+// One logged index operation
+struct WalRecord {
+    enum class Type : uint8_t { ADD = 1, REMOVE = 2 };
+    
+    Type type = Type::ADD;
+    uint64_t lsn = 0;
+    std::vector<Document> docs;      // ADD
+    std::vector<float> vectors;      // ADD: docs.size() x dimension, row-major
+    std::string doc_id;              // REMOVE
+};
+
+// Append-only write-ahead log of FAISSIndex adds and removes.
+//
+// Records are framed as [length][CRC-32][body][LSN], so a torn or corrupt
+// tail is detected on replay and cut off. Writers queue records in memory
+// (under the index lock, in apply order) and then wait for durability
+// outside it: the first waiter writes and syncs everything queued, so
+// concurrent writers share one fdatasync (group commit).
+//
+// A checkpoint seals the active file as path.<last LSN> and starts a new
+// one; sealed segments are immutable and deleted once a checkpoint covers
+// them. Replay reads the sealed segments in LSN order, then the active file.
+class IndexWal {
+public:
+    IndexWal(const std::string& path, size_t dimension, bool sync = true);
+    ~IndexWal();
+    
+    IndexWal(const IndexWal&) = delete;
+    IndexWal& operator=(const IndexWal&) = delete;
+    
+    // Calls apply for each intact record in order (sealed segments first),
+    // cuts off anything after the last one and opens the log for appending
+    // (creating it if missing). New records get LSNs above both the log's
+    // and min_lsn (the checkpoint's).
+    bool open(uint64_t min_lsn, const std::function<void(WalRecord&&)>& apply);
+    
+    // Reads every intact record of a log and its sealed segments without
+    // opening it; true if there are none
+    static bool replay(const std::string& path, size_t dimension,
+                       const std::function<void(WalRecord&&)>& apply);
+    
+    // Serialize a record; done before taking any lock
+    static std::string encodeAdd(const Document* docs, size_t count, const float* vectors, size_t dimension);
+    static std::string encodeRemove(const std::string& doc_id);
+    
+    // Queues an encoded record and returns its LSN (0 once the log has failed)
+    uint64_t append(std::string&& record);
+    
+    // Blocks until the record with this LSN is on disk; false if the log failed
+    bool waitDurable(uint64_t lsn);
+    
+    // Makes queued records durable, seals the active file and starts a new
+    // one. Call with appends excluded; sealed_lsn is the last record sealed.
+    bool rotate(uint64_t& sealed_lsn);
+    
+    // Deletes sealed segments ending at or below lsn (covered by a checkpoint)
+    void dropSealed(uint64_t lsn);
+    
+    const std::string& path() const { return path_; }
+    uint64_t lastLsn() const;
+    
+    // Bytes in the active file, including records not yet written
+    uint64_t activeBytes() const;
+    
+private:
+    std::string path_;
+    size_t dimension_;
+    bool sync_;
+    int fd_ = -1;
+    
+    mutable std::mutex mutex_;
+    std::condition_variable flushed_;
+    std::string pending_;            // Framed records not yet written
+    uint64_t last_lsn_ = 0;
+    uint64_t durable_lsn_ = 0;
+    uint64_t active_bytes_ = 0;
+    bool flushing_ = false;          // A waiter is writing pending_ out
+    bool failed_ = false;
+};
+
+} // namespace vectorization
+} // namespace rag
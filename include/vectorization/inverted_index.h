@@ -0,0 +1,81 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <shared_mutex>
+#include <cstdint>
+#include "vectorization/faiss_index.h"
+
+namespace rag {
+namespace data {
+class Database;
+}
+
+namespace vectorization {
+
+// In-memory BM25 index for lexical retrieval (tickers, filing names, exact
+// phrases that dense embeddings blur). Posting lists are split into blocks
+// of 128 postings, delta + varint encoded, with per-block maxima so top-k
+// queries can skip whole blocks (Block-Max WAND) instead of scoring every
+// matching document. Terms come from TextAnalyzer.
+class InvertedIndex {
+public:
+    InvertedIndex(double k1 = 1.2, double b = 0.75);
+    
+    // Index a document; documents already present (by doc_id) are skipped
+    bool addDocument(const Document& doc);
+    
+    // Index every stored news article (content is "title\ncontent", as ingested)
+    bool build(data::Database& database);
+    
+    // Top k documents by BM25; similarity_score holds the BM25 score
+    std::vector<SearchResult> search(const std::string& query, size_t k = 10) const;
+    
+    size_t size() const;
+    
+private:
+    static constexpr size_t kBlockSize = 128;
+    
+    struct Block {
+        uint32_t base_doc;     // Last doc of the previous block (delta base)
+        uint32_t last_doc;
+        uint32_t offset;       // Into PostingList::bytes
+        uint16_t count;
+        uint16_t max_tf;
+        uint32_t min_length;   // Shortest document in the block
+    };
+    
+    struct PostingList {
+        std::vector<uint8_t> bytes;     // Sealed blocks: varint(doc delta), varint(tf)
+        std::vector<Block> blocks;
+        std::vector<std::pair<uint32_t, uint32_t>> tail; // Unsealed (doc, tf)
+        uint32_t tail_max_tf = 0;
+        uint32_t tail_min_length = UINT32_MAX;
+        uint32_t document_frequency = 0;
+    };
+    
+    class Cursor;
+    
+    double k1_;
+    double b_;
+    std::unordered_map<std::string, PostingList> postings_;
+    std::vector<Document> documents_;
+    std::vector<uint32_t> lengths_;
+    std::unordered_map<std::string, uint32_t> ids_;
+    uint64_t total_length_ = 0;
+    mutable std::shared_mutex mutex_;
+    
+    void append(PostingList& list, uint32_t doc, uint32_t tf, uint32_t length);
+    static void seal(PostingList& list);
+};
+
+// Reciprocal rank fusion of dense and lexical results: score = sum of
+// 1 / (rrf_k + rank). Chunks fuse with their article via "parent_doc_id";
+// lexical-only hits are added as whole articles.
+std::vector<SearchResult> reciprocalRankFusion(std::vector<SearchResult> dense,
+                                               std::vector<SearchResult> lexical,
+                                               size_t k, double rrf_k = 60.0);
+
+} // namespace vectorization
+} // namespace rag
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+namespace rag {
+namespace vectorization {
+
+// On-CPU static sentence embeddings (Model2Vec-style): text is split into
+// WordPiece tokens, each token maps to a pre-distilled vector, and the
+// embedding is the L2-normalized mean. No network and no model runtime;
+// a query embeds in microseconds. Pooling uses AVX2 when the CPU has it.
+//
+// File format (little-endian, see scripts/export_static_embeddings.py):
+//   "RAGSTEMB" | u32 version=1 | u32 vocab_size | u32 dimension | u32 flags (1 = lowercase)
+//   vocab_size x (u16 length, bytes) | vocab_size x dimension float32
+class LocalEmbeddingModel {
+public:
+    bool load(const std::string& filepath);
+    
+    size_t dimension() const { return dimension_; }
+    bool loaded() const { return dimension_ > 0; }
+    
+    bool embed(const std::string& text, std::vector<float>& embedding) const;
+    
+    // Splits the batch across up to `threads` workers (0 = hardware concurrency)
+    bool embedBatch(const std::vector<std::string>& texts,
+                    std::vector<std::vector<float>>& embeddings, size_t threads = 0) const;
+    
+private:
+    size_t dimension_ = 0;
+    bool lowercase_ = true;
+    std::unordered_map<std::string, uint32_t> vocab_;
+    std::vector<float> vectors_;
+    
+    void tokenize(const std::string& text, std::vector<uint32_t>& ids) const;
+    void appendWordPieces(const std::string& word, std::vector<uint32_t>& ids) const;
+};
+
+} // namespace vectorization
+} // namespace rag
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace rag {
+namespace vectorization {
+
+// Turns text into index/search terms for lexical scoring: lowercased
+// alphanumeric runs that keep inner '-', '.' and '&' (so "10-K", "BRK.B" and
+// "S&P" survive as single terms), stopwords removed and plurals folded.
+class TextAnalyzer {
+public:
+    static std::vector<std::string> analyze(const std::string& text);
+    
+    // Ticker-like words in the original text ("AAPL", "BRK.B"): 1-5 capitals
+    static std::vector<std::string> extractSymbols(const std::string& text);
+};
+
+} // namespace vectorization
+} // namespace rag
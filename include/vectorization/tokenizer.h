@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace rag {
+namespace vectorization {
+
+// A pre-token: a word, number group, punctuation run or whitespace run,
+// split the way GPT-style BPE tokenizers split text before merging.
+struct TokenPiece {
+    size_t begin;
+    size_t end;
+    size_t tokens;        // Estimated BPE tokens for this piece
+    bool sentence_end;    // Piece closes a sentence or line
+};
+
+// Fast local token counter used for chunking and prompt budgeting. With BPE
+// ranks loaded (a tiktoken file such as cl100k_base.tiktoken) pieces are
+// merged exactly like the OpenAI tokenizer; otherwise counts fall back to a
+// heuristic that slightly overestimates cl100k counts for English text.
+class Tokenizer {
+public:
+    static std::vector<TokenPiece> pretokenize(const std::string& text);
+    static size_t countTokens(const std::string& text);
+    
+    // Load "<base64 token> <rank>" lines; call once at startup
+    static bool loadBpeRanks(const std::string& filepath);
+    static bool hasBpeRanks();
+};
+
+} // namespace vectorization
+} // namespace rag
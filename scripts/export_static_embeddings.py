@@ -0,0 +1,72 @@
+#!/usr/bin/env python3
+"""
+Convert a Model2Vec static embedding model into the binary format read by
+LocalEmbeddingModel (EMBEDDING_PROVIDER=local).
+
+Example:
+    pip install huggingface_hub safetensors numpy
+    huggingface-cli download minishlab/potion-base-8M --local-dir models/potion-base-8M
+    python scripts/export_static_embeddings.py models/potion-base-8M models/static_embeddings.bin
+"""
+
+import argparse
+import json
+import os
+import struct
+import sys
+
+import numpy as np
+from safetensors.numpy import load_file
+
+MAGIC = b"RAGSTEMB"
+VERSION = 1
+FLAG_LOWERCASE = 1
+
+
+def load_vocab(tokenizer_path):
+    with open(tokenizer_path, encoding="utf-8") as f:
+        tokenizer = json.load(f)
+    model = tokenizer.get("model", {})
+    if model.get("type") != "WordPiece":
+        sys.exit(f"Unsupported tokenizer type: {model.get('type')} (WordPiece expected)")
+    vocab = model["vocab"]
+    normalizer = tokenizer.get("normalizer") or {}
+    lowercase = bool(normalizer.get("lowercase", True))
+    tokens = [None] * len(vocab)
+    for token, index in vocab.items():
+        tokens[index] = token
+    return tokens, lowercase
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Export static embeddings for the local provider")
+    parser.add_argument("model_dir", help="Directory with model.safetensors and tokenizer.json")
+    parser.add_argument("output", help="Output .bin file")
+    args = parser.parse_args()
+
+    tokens, lowercase = load_vocab(os.path.join(args.model_dir, "tokenizer.json"))
+    tensors = load_file(os.path.join(args.model_dir, "model.safetensors"))
+    embeddings = tensors.get("embeddings")
+    if embeddings is None:
+        embeddings = next(iter(tensors.values()))
+    embeddings = np.ascontiguousarray(embeddings, dtype="<f4")
+
+    vocab_size, dimension = embeddings.shape
+    if vocab_size != len(tokens):
+        sys.exit(f"Vocabulary has {len(tokens)} tokens but the matrix has {vocab_size} rows")
+
+    with open(args.output, "wb") as out:
+        out.write(MAGIC)
+        out.write(struct.pack("<IIII", VERSION, vocab_size, dimension,
+                              FLAG_LOWERCASE if lowercase else 0))
+        for token in tokens:
+            encoded = (token or "").encode("utf-8")
+            out.write(struct.pack("<H", len(encoded)))
+            out.write(encoded)
+        out.write(embeddings.tobytes())
+
+    print(f"✓ Wrote {args.output}: {vocab_size} tokens, dimension {dimension}")
+
+
+if __name__ == "__main__":
+    main()
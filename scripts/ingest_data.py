@@ -120,12 +120,11 @@ def store_time_series(conn: sqlite3.Connection, data: List[Dict]):
     """Store time series data in database using ohlcv_data table."""
     cursor = conn.cursor()
     try:
-        for row in data:
-            cursor.execute('''
-                INSERT OR REPLACE INTO ohlcv_data (symbol, timestamp, open, high, low, close, volume)
-                VALUES (?, ?, ?, ?, ?, ?, ?)
-            ''', (row['symbol'], row['date'], row['open'], row['high'], 
-                  row['low'], row['close'], row['volume']))
+        cursor.executemany('''
+            INSERT OR REPLACE INTO ohlcv_data (symbol, timestamp, open, high, low, close, volume)
+            VALUES (?, ?, ?, ?, ?, ?, ?)
+        ''', [(row['symbol'], row['date'], row['open'], row['high'],
+               row['low'], row['close'], row['volume']) for row in data])
         conn.commit()
         print(f"✓ Stored {len(data)} time series records")
     except Exception as e:
@@ -170,14 +169,13 @@ def store_news(conn: sqlite3.Connection, articles: List[Dict]):
     """Store news articles in database using news_articles table."""
     cursor = conn.cursor()
     try:
-        for article in articles:
-            # Generate a unique article_id from URL or title
-            article_id = article['url'] if article['url'] else article['title'][:100]
-            cursor.execute('''
-                INSERT OR REPLACE INTO news_articles (article_id, title, content, source, published_time, symbol)
-                VALUES (?, ?, ?, ?, ?, ?)
-            ''', (article_id, article['title'], article['summary'],
-                  article['source'], article['published_at'], article['symbol']))
+        # article_id is the URL, else the title
+        cursor.executemany('''
+            INSERT OR REPLACE INTO news_articles (article_id, title, content, source, published_time, symbol)
+            VALUES (?, ?, ?, ?, ?, ?)
+        ''', [(article['url'] if article['url'] else article['title'][:100], article['title'],
+               article['summary'], article['source'], article['published_at'], article['symbol'])
+              for article in articles])
         conn.commit()
         print(f"✓ Stored {len(articles)} news articles")
     except Exception as e:
@@ -1,9 +1,15 @@
 #include "rag/rag_agent.h"
 #include "utils/logger.h"
+#include "utils/tracing.h"
+#include "utils/deadline.h"
 #include "grpc_server.h"
 #include <grpcpp/grpcpp.h>
+#include <chrono>
+#include <map>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 // Generated proto files (created during build in build/generated/)
 #include "rag_service.pb.h"
@@ -12,6 +18,7 @@
 using grpc::Server;
 using grpc::ServerBuilder;
 using grpc::ServerContext;
+using grpc::ServerWriter;
 using grpc::Status;
 
 using rag::agent::RAGAgentService;
@@ -25,7 +32,81 @@ using rag::agent::PairRecommendationRequest;
 using rag::agent::PairRecommendationResponse;
 using rag::agent::QueryRequest;
 using rag::agent::QueryResponse;
+using rag::agent::BatchStockSummaryRequest;
+using rag::agent::BatchVolatilityRequest;
+using rag::agent::SubscribeRequest;
+using rag::agent::WatchlistUpdate;
+using rag::agent::ExportTableRequest;
+using rag::agent::ArrowChunk;
 using rag::agent::ContextDoc;
+using rag::utils::Span;
+using rag::utils::SpanKind;
+using rag::utils::Deadline;
+using rag::utils::DeadlineScope;
+
+// How often an idle subscription checks whether its client has gone away
+static const std::chrono::milliseconds kSubscriptionPollInterval(500);
+
+// Continues the caller's trace (W3C traceparent metadata) if present, and
+// echoes the trace id back so clients can look the request up
+static std::string incomingTraceparent(const ServerContext* context) {
+    auto it = context->client_metadata().find("traceparent");
+    if (it == context->client_metadata().end()) {
+        return "";
+    }
+    return std::string(it->second.data(), it->second.size());
+}
+
+static void attachTraceId(ServerContext* context, const Span& span) {
+    if (span.active()) {
+        context->AddInitialMetadata("x-trace-id", span.traceId());
+    }
+}
+
+// The client's deadline and cancellation, carried by this handler thread
+// into every stage and outbound call of the request
+static DeadlineScope requestDeadline(const ServerContext* context) {
+    auto deadline = context->deadline();
+    auto remaining = deadline - std::chrono::system_clock::now();
+    if (deadline == std::chrono::system_clock::time_point::max() || remaining > std::chrono::hours(24)) {
+        return DeadlineScope(Deadline::Clock::time_point::max(), [context]() { return context->IsCancelled(); });
+    }
+    return DeadlineScope(Deadline::Clock::now() + std::chrono::duration_cast<Deadline::Clock::duration>(remaining),
+                         [context]() { return context->IsCancelled(); });
+}
+
+// Report a failed request as cancelled or timed out when that is why it failed
+static Status failureStatus(const std::string& message) {
+    if (Deadline::cancelled()) {
+        return Status(grpc::StatusCode::CANCELLED, message);
+    }
+    if (Deadline::expired()) {
+        return Status(grpc::StatusCode::DEADLINE_EXCEEDED, message);
+    }
+    return Status(grpc::StatusCode::INTERNAL, message);
+}
+
+// Move the context docs into the response. The strings came out of the
+// index once and are moved from there to the wire, never copied again.
+// (Responses are not arena-allocated: the sync API owns the message, and a
+// string set on an arena message is copied rather than moved.)
+static void fillContextDocs(std::vector<rag::agent::RAGContextDoc>& context_docs,
+                            google::protobuf::RepeatedPtrField<ContextDoc>* proto_docs) {
+    proto_docs->Reserve(static_cast<int>(context_docs.size()));
+    for (auto& doc : context_docs) {
+        ContextDoc* proto_doc = proto_docs->Add();
+        proto_doc->set_doc_id(std::move(doc.doc_id));
+        proto_doc->set_content(std::move(doc.content));
+        proto_doc->set_source(std::move(doc.source));
+        proto_doc->set_timestamp(std::move(doc.timestamp));
+        proto_doc->set_similarity_score(doc.similarity_score);
+        auto& metadata = *proto_doc->mutable_metadata();
+        for (auto& [key, value] : doc.metadata) {
+            metadata[key] = std::move(value);
+        }
+    }
+    context_docs.clear();
+}
 
 class RAGAgentServiceImpl final : public RAGAgentService::Service {
 public:
@@ -35,160 +116,326 @@ public:
     
     Status GetStockSummary(ServerContext* context, const StockSummaryRequest* request,
                           StockSummaryResponse* response) override {
-        rag::utils::Logger::getInstance().info("GetStockSummary request for: " + request->symbol());
+        RAG_LOG_INFO("GetStockSummary request for: " + request->symbol());
+        
+        Span span("RAGAgentService/GetStockSummary", incomingTraceparent(context), SpanKind::SERVER);
+        span.setAttribute("rag.symbol", request->symbol());
+        attachTraceId(context, span);
+        DeadlineScope deadline = requestDeadline(context);
         
         std::string summary;
         std::vector<rag::agent::RAGContextDoc> context_docs;
         
         if (!rag_agent_->getStockSummary(request->symbol(), request->period(),
                                         summary, context_docs)) {
-            return Status(grpc::StatusCode::INTERNAL, "Failed to get stock summary");
+            span.setError("Failed to get stock summary");
+            return failureStatus("Failed to get stock summary");
         }
         
         response->set_symbol(request->symbol());
-        response->set_summary(summary);
-        
-        // Add context docs (convert from RAGContextDoc to protobuf ContextDoc)
-        for (const auto& doc : context_docs) {
-            ContextDoc* proto_doc = response->add_context_docs();
-            proto_doc->set_doc_id(doc.doc_id);
-            proto_doc->set_content(doc.content);
-            proto_doc->set_source(doc.source);
-            proto_doc->set_timestamp(doc.timestamp);
-            proto_doc->set_similarity_score(doc.similarity_score);
-            for (const auto& [key, value] : doc.metadata) {
-                (*proto_doc->mutable_metadata())[key] = value;
-            }
-        }
+        response->set_summary(std::move(summary));
+        
+        fillContextDocs(context_docs, response->mutable_context_docs());
         
         return Status::OK;
     }
     
     Status ExplainVolatility(ServerContext* context, const VolatilityRequest* request,
                             VolatilityResponse* response) override {
-        rag::utils::Logger::getInstance().info("ExplainVolatility request for: " + request->symbol());
+        RAG_LOG_INFO("ExplainVolatility request for: " + request->symbol());
+        
+        Span span("RAGAgentService/ExplainVolatility", incomingTraceparent(context), SpanKind::SERVER);
+        span.setAttribute("rag.symbol", request->symbol());
+        attachTraceId(context, span);
+        DeadlineScope deadline = requestDeadline(context);
         
         std::string explanation;
         std::vector<rag::agent::RAGContextDoc> context_docs;
         
         if (!rag_agent_->explainVolatility(request->symbol(), request->date(),
                                           explanation, context_docs)) {
-            return Status(grpc::StatusCode::INTERNAL, "Failed to explain volatility");
+            span.setError("Failed to explain volatility");
+            return failureStatus("Failed to explain volatility");
         }
         
         response->set_symbol(request->symbol());
         response->set_date(request->date());
-        response->set_explanation(explanation);
-        
-        // Add context docs (convert from RAGContextDoc to protobuf ContextDoc)
-        for (const auto& doc : context_docs) {
-            ContextDoc* proto_doc = response->add_context_docs();
-            proto_doc->set_doc_id(doc.doc_id);
-            proto_doc->set_content(doc.content);
-            proto_doc->set_source(doc.source);
-            proto_doc->set_timestamp(doc.timestamp);
-            proto_doc->set_similarity_score(doc.similarity_score);
-            for (const auto& [key, value] : doc.metadata) {
-                (*proto_doc->mutable_metadata())[key] = value;
-            }
-        }
+        response->set_explanation(std::move(explanation));
+        
+        fillContextDocs(context_docs, response->mutable_context_docs());
         
         return Status::OK;
     }
     
     Status CompareSentiment(ServerContext* context, const SentimentCompareRequest* request,
                            SentimentCompareResponse* response) override {
-        rag::utils::Logger::getInstance().info("CompareSentiment request for: " + 
+        RAG_LOG_INFO("CompareSentiment request for: " + 
                                                request->ticker1() + " vs " + request->ticker2());
         
+        Span span("RAGAgentService/CompareSentiment", incomingTraceparent(context), SpanKind::SERVER);
+        span.setAttribute("rag.symbols", request->ticker1() + "," + request->ticker2());
+        attachTraceId(context, span);
+        DeadlineScope deadline = requestDeadline(context);
+        
         std::string comparison;
         std::vector<rag::agent::RAGContextDoc> context_docs;
         
         if (!rag_agent_->compareSentiment(request->ticker1(), request->ticker2(),
                                          request->period(), comparison, context_docs)) {
-            return Status(grpc::StatusCode::INTERNAL, "Failed to compare sentiment");
+            span.setError("Failed to compare sentiment");
+            return failureStatus("Failed to compare sentiment");
         }
         
         response->set_ticker1(request->ticker1());
         response->set_ticker2(request->ticker2());
-        response->set_comparison(comparison);
-        
-        // Add context docs (convert from RAGContextDoc to protobuf ContextDoc)
-        for (const auto& doc : context_docs) {
-            ContextDoc* proto_doc = response->add_context_docs();
-            proto_doc->set_doc_id(doc.doc_id);
-            proto_doc->set_content(doc.content);
-            proto_doc->set_source(doc.source);
-            proto_doc->set_timestamp(doc.timestamp);
-            proto_doc->set_similarity_score(doc.similarity_score);
-            for (const auto& [key, value] : doc.metadata) {
-                (*proto_doc->mutable_metadata())[key] = value;
-            }
-        }
+        response->set_comparison(std::move(comparison));
+        
+        fillContextDocs(context_docs, response->mutable_context_docs());
         
         return Status::OK;
     }
     
     Status RecommendPair(ServerContext* context, const PairRecommendationRequest* request,
                         PairRecommendationResponse* response) override {
-        rag::utils::Logger::getInstance().info("RecommendPair request for sector: " + request->sector());
+        RAG_LOG_INFO("RecommendPair request for sector: " + request->sector());
+        
+        Span span("RAGAgentService/RecommendPair", incomingTraceparent(context), SpanKind::SERVER);
+        span.setAttribute("rag.sector", request->sector());
+        attachTraceId(context, span);
+        DeadlineScope deadline = requestDeadline(context);
         
         std::string long_ticker, short_ticker, reasoning;
         std::vector<rag::agent::RAGContextDoc> context_docs;
         
         if (!rag_agent_->recommendPair(request->sector(), long_ticker, short_ticker,
                                       reasoning, context_docs)) {
-            return Status(grpc::StatusCode::INTERNAL, "Failed to recommend pair");
-        }
-        
-        response->set_long_ticker(long_ticker);
-        response->set_short_ticker(short_ticker);
-        response->set_reasoning(reasoning);
-        
-        // Add context docs (convert from RAGContextDoc to protobuf ContextDoc)
-        for (const auto& doc : context_docs) {
-            ContextDoc* proto_doc = response->add_context_docs();
-            proto_doc->set_doc_id(doc.doc_id);
-            proto_doc->set_content(doc.content);
-            proto_doc->set_source(doc.source);
-            proto_doc->set_timestamp(doc.timestamp);
-            proto_doc->set_similarity_score(doc.similarity_score);
-            for (const auto& [key, value] : doc.metadata) {
-                (*proto_doc->mutable_metadata())[key] = value;
-            }
+            span.setError("Failed to recommend pair");
+            return failureStatus("Failed to recommend pair");
         }
         
+        response->set_long_ticker(std::move(long_ticker));
+        response->set_short_ticker(std::move(short_ticker));
+        response->set_reasoning(std::move(reasoning));
+        
+        fillContextDocs(context_docs, response->mutable_context_docs());
+        
         return Status::OK;
     }
     
     Status QueryRAG(ServerContext* context, const QueryRequest* request,
                    QueryResponse* response) override {
-        rag::utils::Logger::getInstance().info("QueryRAG request: " + request->query());
+        RAG_LOG_INFO("QueryRAG request: " + request->query());
+        
+        Span span("RAGAgentService/QueryRAG", incomingTraceparent(context), SpanKind::SERVER);
+        attachTraceId(context, span);
+        DeadlineScope deadline = requestDeadline(context);
         
         std::vector<std::string> symbols(request->symbols().begin(), request->symbols().end());
         std::string answer;
         std::vector<rag::agent::RAGContextDoc> context_docs;
         
         if (!rag_agent_->queryRAG(request->query(), symbols, answer, context_docs)) {
-            return Status(grpc::StatusCode::INTERNAL, "Failed to process RAG query");
+            span.setError("Failed to process RAG query");
+            return failureStatus("Failed to process RAG query");
         }
         
-        response->set_answer(answer);
+        response->set_answer(std::move(answer));
         response->set_confidence(0.85); // Placeholder
         
-        // Add context docs (convert from RAGContextDoc to protobuf ContextDoc)
-        for (const auto& doc : context_docs) {
-            ContextDoc* proto_doc = response->add_context_docs();
-            proto_doc->set_doc_id(doc.doc_id);
-            proto_doc->set_content(doc.content);
-            proto_doc->set_source(doc.source);
-            proto_doc->set_timestamp(doc.timestamp);
-            proto_doc->set_similarity_score(doc.similarity_score);
-            for (const auto& [key, value] : doc.metadata) {
-                (*proto_doc->mutable_metadata())[key] = value;
+        fillContextDocs(context_docs, response->mutable_context_docs());
+        
+        return Status::OK;
+    }
+    
+    Status BatchGetStockSummary(ServerContext* context, const BatchStockSummaryRequest* request,
+                                ServerWriter<StockSummaryResponse>* writer) override {
+        RAG_LOG_INFO("BatchGetStockSummary request for " + std::to_string(request->symbols_size()) + " symbols");
+        
+        Span span("RAGAgentService/BatchGetStockSummary", incomingTraceparent(context), SpanKind::SERVER);
+        span.setAttribute("rag.symbols", std::to_string(request->symbols_size()));
+        attachTraceId(context, span);
+        if (request->symbols_size() == 0) {
+            return Status(grpc::StatusCode::INVALID_ARGUMENT, "No symbols");
+        }
+        DeadlineScope deadline = requestDeadline(context);
+        
+        std::vector<std::string> symbols(request->symbols().begin(), request->symbols().end());
+        bool any = rag_agent_->getStockSummaries(symbols, request->period(),
+                                                 [writer](rag::agent::BatchItemResult&& result) {
+            StockSummaryResponse response;
+            response.set_symbol(std::move(result.symbol));
+            if (result.has_price) {
+                response.set_current_price(result.price);
+                response.set_change_percent(result.change_percent);
             }
+            if (result.success) {
+                response.set_summary(std::move(result.text));
+            } else {
+                response.set_error("Failed to get stock summary");
+            }
+            fillContextDocs(result.context_docs, response.mutable_context_docs());
+            writer->Write(response);
+        });
+        
+        if (!any) {
+            span.setError("Failed to get stock summaries");
+            return failureStatus("Failed to get stock summaries");
+        }
+        return Status::OK;
+    }
+    
+    Status BatchExplainVolatility(ServerContext* context, const BatchVolatilityRequest* request,
+                                  ServerWriter<VolatilityResponse>* writer) override {
+        RAG_LOG_INFO("BatchExplainVolatility request for " + std::to_string(request->symbols_size()) + " symbols");
+        
+        Span span("RAGAgentService/BatchExplainVolatility", incomingTraceparent(context), SpanKind::SERVER);
+        span.setAttribute("rag.symbols", std::to_string(request->symbols_size()));
+        attachTraceId(context, span);
+        if (request->symbols_size() == 0) {
+            return Status(grpc::StatusCode::INVALID_ARGUMENT, "No symbols");
         }
+        DeadlineScope deadline = requestDeadline(context);
         
+        std::vector<std::string> symbols(request->symbols().begin(), request->symbols().end());
+        bool any = rag_agent_->explainVolatilities(symbols, request->date(),
+                                                   [writer, request](rag::agent::BatchItemResult&& result) {
+            VolatilityResponse response;
+            response.set_symbol(std::move(result.symbol));
+            response.set_date(request->date());
+            if (result.has_volatility) {
+                response.set_volatility_value(result.volatility.close_to_close);
+            }
+            if (result.success) {
+                response.set_explanation(std::move(result.text));
+            } else {
+                response.set_error("Failed to explain volatility");
+            }
+            fillContextDocs(result.context_docs, response.mutable_context_docs());
+            writer->Write(response);
+        });
+        
+        if (!any) {
+            span.setError("Failed to explain volatility");
+            return failureStatus("Failed to explain volatility");
+        }
+        return Status::OK;
+    }
+    
+    Status Subscribe(ServerContext* context, const SubscribeRequest* request,
+                     ServerWriter<WatchlistUpdate>* writer) override {
+        RAG_LOG_INFO("Subscribe request for " + std::to_string(request->symbols_size()) + " symbols");
+        
+        if (request->symbols_size() == 0) {
+            return Status(grpc::StatusCode::INVALID_ARGUMENT, "No symbols");
+        }
+        auto monitor = rag_agent_->watchlistMonitor();
+        if (!monitor) {
+            return Status(grpc::StatusCode::UNAVAILABLE, "Watchlist subscriptions are disabled");
+        }
+        DeadlineScope deadline = requestDeadline(context);
+        
+        std::string period = request->period().empty() ? "1d" : request->period();
+        std::vector<std::string> symbols(request->symbols().begin(), request->symbols().end());
+        auto subscription = monitor->subscribe(symbols, request->price_threshold_percent());
+        if (!subscription) {
+            return Status(grpc::StatusCode::RESOURCE_EXHAUSTED, "Too many open watchlist subscriptions");
+        }
+        
+        // Nothing is generated until the monitor reports a change; the
+        // handler thread sleeps on the subscription in between
+        bool open = true;
+        while (open && !context->IsCancelled()) {
+            std::vector<rag::agent::WatchlistChange> changes;
+            if (!subscription->waitForChanges(changes, kSubscriptionPollInterval)) {
+                if (subscription->closed()) {
+                    break;
+                }
+                continue;
+            }
+            
+            std::map<std::string, const rag::agent::WatchlistChange*> by_symbol;
+            for (const auto& change : changes) {
+                by_symbol[change.symbol] = &change;
+            }
+            
+            Span span("RAGAgentService/Subscribe", incomingTraceparent(context), SpanKind::SERVER);
+            span.setAttribute("rag.symbols", std::to_string(changes.size()));
+            rag_agent_->refreshWatchlist(changes, period, [&](rag::agent::BatchItemResult&& result) {
+                const rag::agent::WatchlistChange& change = *by_symbol[result.symbol];
+                WatchlistUpdate update;
+                if (change.initial) {
+                    update.add_reasons(WatchlistUpdate::INITIAL);
+                }
+                if (change.news_changed) {
+                    update.add_reasons(WatchlistUpdate::NEWS);
+                    update.set_new_articles(static_cast<int32_t>(change.new_articles));
+                }
+                if (change.price_moved) {
+                    update.add_reasons(WatchlistUpdate::PRICE);
+                }
+                if (change.volatility_changed) {
+                    update.add_reasons(WatchlistUpdate::VOLATILITY);
+                }
+                update.set_symbol(std::move(result.symbol));
+                if (result.has_price) {
+                    update.set_current_price(result.price);
+                    update.set_change_percent(result.change_percent);
+                }
+                if (result.has_volatility) {
+                    update.set_volatility_value(result.volatility.close_to_close);
+                }
+                if (result.success) {
+                    update.set_summary(std::move(result.text));
+                } else {
+                    update.set_error("Failed to get stock summary");
+                }
+                fillContextDocs(result.context_docs, update.mutable_context_docs());
+                if (open && !writer->Write(update)) {
+                    open = false;
+                }
+            });
+        }
+        
+        monitor->unsubscribe(subscription);
+        if (context->IsCancelled() || !open) {
+            return Status::OK;
+        }
+        return Status(grpc::StatusCode::UNAVAILABLE, "Watchlist monitor stopped");
+    }
+    
+    Status ExportTable(ServerContext* context, const ExportTableRequest* request,
+                       ServerWriter<ArrowChunk>* writer) override {
+        RAG_LOG_INFO("ExportTable request for " + request->table());
+        
+        Span span("RAGAgentService/ExportTable", incomingTraceparent(context), SpanKind::SERVER);
+        attachTraceId(context, span);
+        span.setAttribute("rag.table", request->table());
+        
+        rag::data::ArrowExportOptions options;
+        options.symbol = request->symbol();
+        options.start = request->start();
+        options.end = request->end();
+        
+        // Chunks are written as the batches are encoded; a cancelled or
+        // disconnected client stops the export at the next chunk
+        ArrowChunk chunk;
+        size_t rows = 0;
+        bool ok = rag_agent_->database()->exportArrowStream(request->table(), options,
+            [&](const uint8_t* data, size_t size) {
+                if (context->IsCancelled()) {
+                    return false;
+                }
+                chunk.set_data(data, size);
+                return writer->Write(chunk);
+            }, rows);
+        if (context->IsCancelled()) {
+            return Status(grpc::StatusCode::CANCELLED, "Export cancelled");
+        }
+        if (!ok) {
+            span.setError("Failed to export " + request->table());
+            return Status(grpc::StatusCode::INVALID_ARGUMENT, "Failed to export " + request->table());
+        }
+        span.setAttribute("rag.rows", std::to_string(rows));
         return Status::OK;
     }
     
@@ -196,15 +443,19 @@ private:
     std::shared_ptr<rag::agent::RAGAgent> rag_agent_;
 };
 
+std::unique_ptr<grpc::Service> CreateRAGAgentService(std::shared_ptr<rag::agent::RAGAgent> rag_agent) {
+    return std::make_unique<RAGAgentServiceImpl>(rag_agent);
+}
+
 void RunServer(const std::string& server_address, std::shared_ptr<rag::agent::RAGAgent> rag_agent) {
-    RAGAgentServiceImpl service(rag_agent);
+    std::unique_ptr<grpc::Service> service = CreateRAGAgentService(rag_agent);
     
     ServerBuilder builder;
     builder.AddListeningPort(server_address, grpc::InsecureServerCredentials());
-    builder.RegisterService(&service);
+    builder.RegisterService(service.get());
     
     std::unique_ptr<Server> server(builder.BuildAndStart());
-    rag::utils::Logger::getInstance().info("Server listening on " + server_address);
+    RAG_LOG_INFO("Server listening on " + server_address);
     
     server->Wait();
 }
@@ -4,5 +4,12 @@
 #include <memory>
 #include "rag/rag_agent.h"
 
+namespace grpc {
+class Service;
+}
+
+// Service implementation, exposed so benchmarks can host it in-process
+std::unique_ptr<grpc::Service> CreateRAGAgentService(std::shared_ptr<rag::agent::RAGAgent> rag_agent);
+
 void RunServer(const std::string& server_address, std::shared_ptr<rag::agent::RAGAgent> rag_agent);
 
@@ -1,5 +1,9 @@
 #include "data_ingestion/data_fetcher.h"
 #include "utils/logger.h"
+#include "utils/metrics.h"
+#include "utils/http_client.h"
+#include "utils/json_scanner.h"
+#include <algorithm>
 #include <sstream>
 #include <iostream>
 
@@ -7,60 +11,51 @@ namespace rag {
 namespace data {
 
 DataFetcher::DataFetcher(const std::string& api_key) : api_key_(api_key) {
-    curl_handle_ = curl_easy_init();
-    if (!curl_handle_) {
-        rag::utils::Logger::getInstance().error("Failed to initialize CURL");
+}
+
+// Metrics label for a request URL: the Alpha Vantage function, or the provider
+static std::string endpointLabel(const std::string& url) {
+    size_t pos = url.find("function=");
+    if (pos == std::string::npos) {
+        return url.find("polygon.io") != std::string::npos ? "polygon" : "http";
     }
+    pos += 9;
+    return "alphavantage:" + url.substr(pos, url.find('&', pos) - pos);
 }
 
-DataFetcher::~DataFetcher() {
-    if (curl_handle_) {
-        curl_easy_cleanup(curl_handle_);
+// Body of a successful response; logs why otherwise
+static bool takeBody(utils::HttpResponse&& http_response, std::string& response) {
+    if (!http_response.ok()) {
+        if (!http_response.error.empty()) {
+            RAG_LOG_ERROR("CURL request failed: " + http_response.error);
+        } else {
+            RAG_LOG_ERROR("HTTP request failed with code: " + std::to_string(http_response.status));
+        }
+        return false;
     }
+    response = std::move(http_response.body);
+    return true;
 }
 
-size_t DataFetcher::writeCallback(void* contents, size_t size, size_t nmemb, std::string* data) {
-    size_t total_size = size * nmemb;
-    data->append((char*)contents, total_size);
-    return total_size;
+utils::HttpRequest DataFetcher::buildRequest(const std::string& url) const {
+    utils::HttpRequest request;
+    request.url = url;
+    request.endpoint = endpointLabel(url);
+    request.span_name = "GET " + request.endpoint;
+    request.record_url = false; // URL carries the API key
+    request.idempotent = true;
+    return request;
 }
 
 bool DataFetcher::makeHttpRequest(const std::string& url, std::string& response) {
-    if (!curl_handle_) {
-        return false;
-    }
-    
-    std::string read_buffer;
-    
-    curl_easy_setopt(curl_handle_, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl_handle_, CURLOPT_WRITEFUNCTION, writeCallback);
-    curl_easy_setopt(curl_handle_, CURLOPT_WRITEDATA, &read_buffer);
-    curl_easy_setopt(curl_handle_, CURLOPT_FOLLOWLOCATION, 1L);
-    curl_easy_setopt(curl_handle_, CURLOPT_SSL_VERIFYPEER, 0L);
-    curl_easy_setopt(curl_handle_, CURLOPT_TIMEOUT, 30L);
-    
-    CURLcode res = curl_easy_perform(curl_handle_);
-    
-    if (res != CURLE_OK) {
-        rag::utils::Logger::getInstance().error("CURL request failed: " + std::string(curl_easy_strerror(res)));
-        return false;
-    }
-    
-    long response_code;
-    curl_easy_getinfo(curl_handle_, CURLINFO_RESPONSE_CODE, &response_code);
-    
-    if (response_code != 200) {
-        rag::utils::Logger::getInstance().error("HTTP request failed with code: " + std::to_string(response_code));
-        return false;
-    }
-    
-    response = read_buffer;
-    return true;
+    utils::HttpResponse http_response;
+    utils::HttpClient::getInstance().perform(buildRequest(url), http_response);
+    return takeBody(std::move(http_response), response);
 }
 
 std::string DataFetcher::buildAlphaVantageUrl(const std::string& function, const std::string& symbol) {
     std::stringstream ss;
-    ss << "https://www.alphavantage.co/query?function=" << function
+    ss << base_url_ << "?function=" << function
        << "&symbol=" << symbol
        << "&apikey=" << api_key_
        << "&datatype=json";
@@ -74,20 +69,214 @@ std::string DataFetcher::buildPolygonUrl(const std::string& endpoint) {
     return ss.str();
 }
 
-bool DataFetcher::fetchStockData(const std::string& symbol, const std::string& interval,
-                                 int days, std::vector<OHLCVData>& data) {
+std::string DataFetcher::buildStockDataUrl(const std::string& symbol, int days) {
     std::string url = buildAlphaVantageUrl("TIME_SERIES_DAILY_ADJUSTED", symbol);
-    std::string response;
+    if (days > 100) {
+        url += "&outputsize=full"; // compact only covers the last 100 sessions
+    }
+    return url;
+}
+
+bool DataFetcher::requestStockData(const std::string& symbol, int days, std::string& response) {
+    return makeHttpRequest(buildStockDataUrl(symbol, days), response);
+}
+
+namespace {
+
+// Bars of "Time Series (Daily)", newest first (Alpha Vantage sends newest
+// first; anything else is sorted). False on anything unexpected, including
+// an API error object.
+bool scanStockData(std::string_view response, int days, std::vector<OHLCVData>& bars) {
+    utils::JsonScanner json(response);
+    std::string_view key;
+    if (!json.beginObject()) {
+        return false;
+    }
+    bool descending = true;
+    while (json.nextKey(key)) {
+        if (key == "Error Message" || key == "Note" || key == "Information") {
+            return false;
+        }
+        if (key != "Time Series (Daily)") {
+            json.skipValue();
+            continue;
+        }
+        if (!json.beginObject()) {
+            return false;
+        }
+        std::string_view date;
+        while (json.nextKey(date)) {
+            OHLCVData bar;
+            bar.timestamp.assign(date.data(), date.size());
+            if (!bars.empty() && bar.timestamp >= bars.back().timestamp) {
+                descending = false;
+            }
+            
+            // Plain and adjusted series number their fields differently
+            int found = 0;
+            std::string_view field, value;
+            if (!json.beginObject()) {
+                return false;
+            }
+            while (json.nextKey(field)) {
+                if (field.size() < 4 || field[1] != '.') {
+                    json.skipValue();
+                    continue;
+                }
+                std::string_view name = field.substr(3);
+                double* price = nullptr;
+                int bit = 0;
+                if (name == "open") {
+                    price = &bar.open;
+                    bit = 1;
+                } else if (name == "high") {
+                    price = &bar.high;
+                    bit = 2;
+                } else if (name == "low") {
+                    price = &bar.low;
+                    bit = 4;
+                } else if (name == "close") {
+                    price = &bar.close;
+                    bit = 8;
+                } else if (name == "volume") {
+                    bit = 16;
+                } else {
+                    json.skipValue();
+                    continue;
+                }
+                if (!json.readString(value)) {
+                    return false;
+                }
+                int64_t volume = 0;
+                if (price ? !utils::parseDouble(value, *price) : !utils::parseInt64(value, volume)) {
+                    return false;
+                }
+                if (!price) {
+                    bar.volume = static_cast<long>(volume);
+                }
+                found |= bit;
+            }
+            if (found != 31) {
+                return false;
+            }
+            bars.push_back(std::move(bar));
+        }
+    }
+    if (!json.ok()) {
+        return false;
+    }
     
-    if (!makeHttpRequest(url, response)) {
+    if (!descending) {
+        std::sort(bars.begin(), bars.end(), [](const OHLCVData& a, const OHLCVData& b) {
+            return a.timestamp > b.timestamp;
+        });
+        bars.erase(std::unique(bars.begin(), bars.end(), [](const OHLCVData& a, const OHLCVData& b) {
+            return a.timestamp == b.timestamp;
+        }), bars.end());
+    }
+    if (bars.size() > static_cast<size_t>(std::max(days, 0))) {
+        bars.resize(static_cast<size_t>(std::max(days, 0)));
+    }
+    return true;
+}
+
+bool scanTickers(utils::JsonScanner& json, std::vector<std::string>& tickers) {
+    if (!json.beginArray()) {
+        return false;
+    }
+    std::string_view key;
+    while (json.nextElement()) {
+        if (!json.beginObject()) {
+            return false;
+        }
+        std::string ticker;
+        while (json.nextKey(key)) {
+            if (key == "ticker") {
+                if (!json.readString(ticker)) {
+                    return false;
+                }
+            } else {
+                json.skipValue();
+            }
+        }
+        tickers.push_back(std::move(ticker));
+    }
+    return json.ok();
+}
+
+bool scanNews(std::string_view response, std::vector<NewsArticle>& articles) {
+    utils::JsonScanner json(response);
+    std::string_view key;
+    if (!json.beginObject()) {
         return false;
     }
+    while (json.nextKey(key)) {
+        if (key != "feed") {
+            json.skipValue();
+            continue;
+        }
+        if (!json.beginArray()) {
+            return false;
+        }
+        while (json.nextElement()) {
+            if (!json.beginObject()) {
+                return false;
+            }
+            NewsArticle article;
+            while (json.nextKey(key)) {
+                std::string* target = key == "url" ? &article.id : key == "title" ? &article.title
+                                    : key == "summary" ? &article.content : key == "source" ? &article.source
+                                    : key == "time_published" ? &article.published_time : nullptr;
+                if (target) {
+                    if (!json.readString(*target)) {
+                        return false;
+                    }
+                } else if (key == "ticker_sentiment") {
+                    if (!scanTickers(json, article.tickers)) {
+                        return false;
+                    }
+                } else {
+                    json.skipValue();
+                }
+            }
+            articles.push_back(std::move(article));
+        }
+    }
+    return json.ok();
+}
+
+} // namespace
+
+bool DataFetcher::parseStockData(const std::string& response, int days, std::vector<OHLCVData>& data) {
+    static auto& parse_latency = utils::stageHistogram("data_fetcher", "parse_stock_data");
+    utils::ScopedTimer timer(parse_latency);
+    
+    std::vector<OHLCVData> bars;
+    if (scanStockData(response, days, bars)) {
+        data.insert(data.end(), std::make_move_iterator(bars.begin()), std::make_move_iterator(bars.end()));
+        return true;
+    }
+    return parseStockDataDom(response, days, data); // Reports API errors and malformed JSON
+}
+
+bool DataFetcher::parseNews(const std::string& response, std::vector<NewsArticle>& articles) {
+    static auto& parse_latency = utils::stageHistogram("data_fetcher", "parse_news");
+    utils::ScopedTimer timer(parse_latency);
     
+    std::vector<NewsArticle> parsed;
+    if (scanNews(response, parsed)) {
+        articles.insert(articles.end(), std::make_move_iterator(parsed.begin()), std::make_move_iterator(parsed.end()));
+        return true;
+    }
+    return parseNewsDom(response, articles);
+}
+
+bool DataFetcher::parseStockDataDom(const std::string& response, int days, std::vector<OHLCVData>& data) {
     try {
         nlohmann::json json_data = nlohmann::json::parse(response);
         
         if (json_data.contains("Error Message") || json_data.contains("Note")) {
-            rag::utils::Logger::getInstance().error("API error: " + response);
+            RAG_LOG_ERROR("API error: " + response);
             return false;
         }
         
@@ -107,12 +296,39 @@ bool DataFetcher::fetchStockData(const std::string& symbol, const std::string& i
             }
         }
         
-        rag::utils::Logger::getInstance().info("Fetched " + std::to_string(data.size()) + " data points for " + symbol);
         return true;
     } catch (const std::exception& e) {
-        rag::utils::Logger::getInstance().error("Failed to parse JSON: " + std::string(e.what()));
+        RAG_LOG_ERROR("Failed to parse JSON: " + std::string(e.what()));
+        return false;
+    }
+}
+
+bool DataFetcher::fetchStockData(const std::string& symbol, const std::string& interval,
+                                 int days, std::vector<OHLCVData>& data) {
+    std::string response;
+    
+    if (!requestStockData(symbol, days, response)) {
         return false;
     }
+    
+    if (!parseStockData(response, days, data)) {
+        return false;
+    }
+    
+    RAG_LOG_INFO("Fetched " + std::to_string(data.size()) + " data points for " + symbol);
+    return true;
+}
+
+std::future<bool> DataFetcher::fetchStockDataAsync(const std::string& symbol, int days, std::vector<OHLCVData>& data) {
+    auto pending = utils::HttpClient::getInstance().submit(buildRequest(buildStockDataUrl(symbol, days)));
+    return std::async(std::launch::deferred, [pending = std::move(pending), symbol, days, &data]() mutable {
+        std::string response;
+        if (!takeBody(pending.get(), response) || !parseStockData(response, days, data)) {
+            return false;
+        }
+        RAG_LOG_INFO("Fetched " + std::to_string(data.size()) + " data points for " + symbol);
+        return true;
+    });
 }
 
 bool DataFetcher::fetchRealTimeQuote(const std::string& symbol, double& price, double& change_percent) {
@@ -120,21 +336,39 @@ bool DataFetcher::fetchRealTimeQuote(const std::string& symbol, double& price, d
     std::string response;
     
     if (!makeHttpRequest(url, response)) {
-        rag::utils::Logger::getInstance().error("HTTP request failed for quote: " + symbol);
+        RAG_LOG_ERROR("HTTP request failed for quote: " + symbol);
         return false;
     }
-    
+    return parseQuote(symbol, response, price, change_percent);
+}
+
+std::future<bool> DataFetcher::fetchRealTimeQuoteAsync(const std::string& symbol, double& price,
+                                                       double& change_percent) {
+    std::string url = buildAlphaVantageUrl("GLOBAL_QUOTE", symbol);
+    auto pending = utils::HttpClient::getInstance().submit(buildRequest(url));
+    return std::async(std::launch::deferred, [pending = std::move(pending), symbol, &price, &change_percent]() mutable {
+        std::string response;
+        if (!takeBody(pending.get(), response)) {
+            RAG_LOG_ERROR("HTTP request failed for quote: " + symbol);
+            return false;
+        }
+        return parseQuote(symbol, response, price, change_percent);
+    });
+}
+
+bool DataFetcher::parseQuote(const std::string& symbol, const std::string& response,
+                             double& price, double& change_percent) {
     try {
         nlohmann::json json_data = nlohmann::json::parse(response);
         
         // Check for API errors
         if (json_data.contains("Error Message")) {
-            rag::utils::Logger::getInstance().error("Alpha Vantage API error: " + json_data["Error Message"].get<std::string>());
+            RAG_LOG_ERROR("Alpha Vantage API error: " + json_data["Error Message"].get<std::string>());
             return false;
         }
         
         if (json_data.contains("Note")) {
-            rag::utils::Logger::getInstance().warning("Alpha Vantage API rate limit: " + json_data["Note"].get<std::string>());
+            RAG_LOG_WARNING("Alpha Vantage API rate limit: " + json_data["Note"].get<std::string>());
             return false;
         }
         
@@ -150,16 +384,16 @@ bool DataFetcher::fetchRealTimeQuote(const std::string& symbol, double& price, d
                     change_str.pop_back();
                 }
                 change_percent = std::stod(change_str);
-                rag::utils::Logger::getInstance().debug("Fetched quote for " + symbol + ": $" + std::to_string(price));
+                RAG_LOG_DEBUG("Fetched quote for " + symbol + ": $" + std::to_string(price));
                 return true;
             }
         } else {
-            rag::utils::Logger::getInstance().warning("No quote data in response for " + symbol);
-            rag::utils::Logger::getInstance().debug("Response: " + response.substr(0, 500));
+            RAG_LOG_WARNING("No quote data in response for " + symbol);
+            RAG_LOG_DEBUG("Response: " + response.substr(0, 500));
         }
     } catch (const std::exception& e) {
-        rag::utils::Logger::getInstance().error("Failed to parse quote JSON: " + std::string(e.what()));
-        rag::utils::Logger::getInstance().debug("Response: " + response.substr(0, 500));
+        RAG_LOG_ERROR("Failed to parse quote JSON: " + std::string(e.what()));
+        RAG_LOG_DEBUG("Response: " + response.substr(0, 500));
     }
     
     return false;
@@ -178,23 +412,21 @@ bool DataFetcher::fetchOptionsData(const std::string& symbol, std::vector<Option
     try {
         nlohmann::json json_data = nlohmann::json::parse(response);
         // Implementation depends on Polygon.io options API structure
-        rag::utils::Logger::getInstance().info("Options data fetched for " + symbol);
+        RAG_LOG_INFO("Options data fetched for " + symbol);
         return true;
     } catch (const std::exception& e) {
-        rag::utils::Logger::getInstance().error("Failed to parse options JSON: " + std::string(e.what()));
+        RAG_LOG_ERROR("Failed to parse options JSON: " + std::string(e.what()));
         return false;
     }
 }
 
-bool DataFetcher::fetchNews(const std::string& symbol, int max_articles, std::vector<NewsArticle>& articles) {
+bool DataFetcher::requestNews(const std::string& symbol, int max_articles, std::string& response) {
     std::string url = buildAlphaVantageUrl("NEWS_SENTIMENT", symbol);
     url += "&limit=" + std::to_string(max_articles);
-    std::string response;
-    
-    if (!makeHttpRequest(url, response)) {
-        return false;
-    }
-    
+    return makeHttpRequest(url, response);
+}
+
+bool DataFetcher::parseNewsDom(const std::string& response, std::vector<NewsArticle>& articles) {
     try {
         nlohmann::json json_data = nlohmann::json::parse(response);
         
@@ -217,51 +449,58 @@ bool DataFetcher::fetchNews(const std::string& symbol, int max_articles, std::ve
             }
         }
         
-        rag::utils::Logger::getInstance().info("Fetched " + std::to_string(articles.size()) + " news articles for " + symbol);
         return true;
     } catch (const std::exception& e) {
-        rag::utils::Logger::getInstance().error("Failed to parse news JSON: " + std::string(e.what()));
+        RAG_LOG_ERROR("Failed to parse news JSON: " + std::string(e.what()));
         return false;
     }
 }
 
-bool DataFetcher::fetchCompanyFundamentals(const std::string& symbol, nlohmann::json& fundamentals) {
-    std::string url = buildAlphaVantageUrl("OVERVIEW", symbol);
+bool DataFetcher::fetchNews(const std::string& symbol, int max_articles, std::vector<NewsArticle>& articles) {
     std::string response;
     
-    if (!makeHttpRequest(url, response)) {
+    if (!requestNews(symbol, max_articles, response)) {
         return false;
     }
     
-    try {
-        fundamentals = nlohmann::json::parse(response);
-        return true;
-    } catch (const std::exception& e) {
-        rag::utils::Logger::getInstance().error("Failed to parse fundamentals JSON: " + std::string(e.what()));
+    if (!parseNews(response, articles)) {
         return false;
     }
+    
+    RAG_LOG_INFO("Fetched " + std::to_string(articles.size()) + " news articles for " + symbol);
+    return true;
 }
 
-bool DataFetcher::fetchVolatility(const std::string& symbol, const std::string& date, double& volatility) {
-    // Fetch historical data and calculate volatility
-    std::vector<OHLCVData> data;
-    if (!fetchStockData(symbol, "daily", 30, data)) {
-        return false;
-    }
+std::future<bool> DataFetcher::fetchNewsAsync(const std::string& symbol, int max_articles,
+                                              std::vector<NewsArticle>& articles) {
+    std::string url = buildAlphaVantageUrl("NEWS_SENTIMENT", symbol);
+    url += "&limit=" + std::to_string(max_articles);
+    auto pending = utils::HttpClient::getInstance().submit(buildRequest(url));
+    return std::async(std::launch::deferred, [pending = std::move(pending), symbol, &articles]() mutable {
+        std::string response;
+        if (!takeBody(pending.get(), response) || !parseNews(response, articles)) {
+            return false;
+        }
+        RAG_LOG_INFO("Fetched " + std::to_string(articles.size()) + " news articles for " + symbol);
+        return true;
+    });
+}
+
+bool DataFetcher::fetchCompanyFundamentals(const std::string& symbol, nlohmann::json& fundamentals) {
+    std::string url = buildAlphaVantageUrl("OVERVIEW", symbol);
+    std::string response;
     
-    // Calculate realized volatility (simplified)
-    if (data.size() < 2) {
+    if (!makeHttpRequest(url, response)) {
         return false;
     }
     
-    double sum_returns_squared = 0.0;
-    for (size_t i = 1; i < data.size(); ++i) {
-        double returns = (data[i].close - data[i-1].close) / data[i-1].close;
-        sum_returns_squared += returns * returns;
+    try {
+        fundamentals = nlohmann::json::parse(response);
+        return true;
+    } catch (const std::exception& e) {
+        RAG_LOG_ERROR("Failed to parse fundamentals JSON: " + std::string(e.what()));
+        return false;
     }
-    
-    volatility = std::sqrt(sum_returns_squared / (data.size() - 1)) * std::sqrt(252); // Annualized
-    return true;
 }
 
 } // namespace data
@@ -18,7 +18,7 @@ Database::~Database() {
 bool Database::initialize() {
     int rc = sqlite3_open(db_path_.c_str(), &db_);
     if (rc != SQLITE_OK) {
-        rag::utils::Logger::getInstance().error("Cannot open database: " + std::string(sqlite3_errmsg(db_)));
+        RAG_LOG_ERROR("Cannot open database: " + std::string(sqlite3_errmsg(db_)));
         return false;
     }
     
@@ -40,6 +40,19 @@ bool Database::createTables() {
         );
     )";
     
+    const char* create_intraday_table = R"(
+        CREATE TABLE IF NOT EXISTS intraday_bars (
+            symbol TEXT NOT NULL,
+            timestamp TEXT NOT NULL,
+            open REAL NOT NULL,
+            high REAL NOT NULL,
+            low REAL NOT NULL,
+            close REAL NOT NULL,
+            volume INTEGER NOT NULL,
+            PRIMARY KEY(symbol, timestamp)
+        ) WITHOUT ROWID;
+    )";
+    
     const char* create_options_table = R"(
         CREATE TABLE IF NOT EXISTS options_data (
             id INTEGER PRIMARY KEY AUTOINCREMENT,
@@ -92,36 +105,42 @@ bool Database::createTables() {
     char* err_msg = nullptr;
     
     if (sqlite3_exec(db_, create_stock_table, nullptr, nullptr, &err_msg) != SQLITE_OK) {
-        rag::utils::Logger::getInstance().error("Error creating stock table: " + std::string(err_msg));
+        RAG_LOG_ERROR("Error creating stock table: " + std::string(err_msg));
+        sqlite3_free(err_msg);
+        return false;
+    }
+    
+    if (sqlite3_exec(db_, create_intraday_table, nullptr, nullptr, &err_msg) != SQLITE_OK) {
+        RAG_LOG_ERROR("Error creating intraday table: " + std::string(err_msg));
         sqlite3_free(err_msg);
         return false;
     }
     
     if (sqlite3_exec(db_, create_options_table, nullptr, nullptr, &err_msg) != SQLITE_OK) {
-        rag::utils::Logger::getInstance().error("Error creating options table: " + std::string(err_msg));
+        RAG_LOG_ERROR("Error creating options table: " + std::string(err_msg));
         sqlite3_free(err_msg);
         return false;
     }
     
     if (sqlite3_exec(db_, create_news_table, nullptr, nullptr, &err_msg) != SQLITE_OK) {
-        rag::utils::Logger::getInstance().error("Error creating news table: " + std::string(err_msg));
+        RAG_LOG_ERROR("Error creating news table: " + std::string(err_msg));
         sqlite3_free(err_msg);
         return false;
     }
     
     if (sqlite3_exec(db_, create_volatility_table, nullptr, nullptr, &err_msg) != SQLITE_OK) {
-        rag::utils::Logger::getInstance().error("Error creating volatility table: " + std::string(err_msg));
+        RAG_LOG_ERROR("Error creating volatility table: " + std::string(err_msg));
         sqlite3_free(err_msg);
         return false;
     }
     
     if (sqlite3_exec(db_, create_fundamentals_table, nullptr, nullptr, &err_msg) != SQLITE_OK) {
-        rag::utils::Logger::getInstance().error("Error creating fundamentals table: " + std::string(err_msg));
+        RAG_LOG_ERROR("Error creating fundamentals table: " + std::string(err_msg));
         sqlite3_free(err_msg);
         return false;
     }
     
-    rag::utils::Logger::getInstance().info("Database tables created successfully");
+    RAG_LOG_INFO("Database tables created successfully");
     return true;
 }
 
@@ -133,7 +152,7 @@ bool Database::storeOHLCVData(const std::string& symbol, const std::vector<OHLCV
     
     sqlite3_stmt* stmt;
     if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        rag::utils::Logger::getInstance().error("Failed to prepare statement: " + std::string(sqlite3_errmsg(db_)));
+        RAG_LOG_ERROR("Failed to prepare statement: " + std::string(sqlite3_errmsg(db_)));
         return false;
     }
     
@@ -149,7 +168,7 @@ bool Database::storeOHLCVData(const std::string& symbol, const std::vector<OHLCV
         sqlite3_bind_int64(stmt, 7, ohlcv.volume);
         
         if (sqlite3_step(stmt) != SQLITE_DONE) {
-            rag::utils::Logger::getInstance().error("Failed to insert OHLCV data: " + std::string(sqlite3_errmsg(db_)));
+            RAG_LOG_ERROR("Failed to insert OHLCV data: " + std::string(sqlite3_errmsg(db_)));
             sqlite3_finalize(stmt);
             sqlite3_exec(db_, "ROLLBACK", nullptr, nullptr, nullptr);
             return false;
@@ -161,7 +180,7 @@ bool Database::storeOHLCVData(const std::string& symbol, const std::vector<OHLCV
     sqlite3_exec(db_, "COMMIT", nullptr, nullptr, nullptr);
     sqlite3_finalize(stmt);
     
-    rag::utils::Logger::getInstance().info("Stored " + std::to_string(data.size()) + " OHLCV records for " + symbol);
+    RAG_LOG_INFO("Stored " + std::to_string(data.size()) + " OHLCV records for " + symbol);
     return true;
 }
 
@@ -198,6 +217,77 @@ bool Database::getOHLCVData(const std::string& symbol, const std::string& start_
     return true;
 }
 
+bool Database::storeIntradayBars(const std::vector<std::pair<std::string, OHLCVData>>& bars) {
+    const char* sql = R"(
+        INSERT OR REPLACE INTO intraday_bars (symbol, timestamp, open, high, low, close, volume)
+        VALUES (?, ?, ?, ?, ?, ?, ?)
+    )";
+    
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        RAG_LOG_ERROR("Failed to prepare statement: " + std::string(sqlite3_errmsg(db_)));
+        return false;
+    }
+    
+    sqlite3_exec(db_, "BEGIN TRANSACTION", nullptr, nullptr, nullptr);
+    
+    for (const auto& [symbol, bar] : bars) {
+        sqlite3_bind_text(stmt, 1, symbol.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, bar.timestamp.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_double(stmt, 3, bar.open);
+        sqlite3_bind_double(stmt, 4, bar.high);
+        sqlite3_bind_double(stmt, 5, bar.low);
+        sqlite3_bind_double(stmt, 6, bar.close);
+        sqlite3_bind_int64(stmt, 7, bar.volume);
+        
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            RAG_LOG_ERROR("Failed to insert intraday bar: " + std::string(sqlite3_errmsg(db_)));
+            sqlite3_finalize(stmt);
+            sqlite3_exec(db_, "ROLLBACK", nullptr, nullptr, nullptr);
+            return false;
+        }
+        
+        sqlite3_reset(stmt);
+    }
+    
+    sqlite3_exec(db_, "COMMIT", nullptr, nullptr, nullptr);
+    sqlite3_finalize(stmt);
+    return true;
+}
+
+bool Database::getIntradayBars(const std::string& symbol, const std::string& start_time,
+                               const std::string& end_time, std::vector<OHLCVData>& data) {
+    const char* sql = R"(
+        SELECT timestamp, open, high, low, close, volume
+        FROM intraday_bars
+        WHERE symbol = ? AND timestamp >= ? AND timestamp <= ?
+        ORDER BY timestamp ASC
+    )";
+    
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    
+    sqlite3_bind_text(stmt, 1, symbol.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, start_time.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, end_time.c_str(), -1, SQLITE_STATIC);
+    
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        OHLCVData bar;
+        bar.timestamp = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+        bar.open = sqlite3_column_double(stmt, 1);
+        bar.high = sqlite3_column_double(stmt, 2);
+        bar.low = sqlite3_column_double(stmt, 3);
+        bar.close = sqlite3_column_double(stmt, 4);
+        bar.volume = sqlite3_column_int64(stmt, 5);
+        data.push_back(bar);
+    }
+    
+    sqlite3_finalize(stmt);
+    return true;
+}
+
 bool Database::storeNewsArticle(const NewsArticle& article) {
     const char* sql = R"(
         INSERT OR REPLACE INTO news_articles (article_id, title, content, source, published_time, symbol)
@@ -221,6 +311,43 @@ bool Database::storeNewsArticle(const NewsArticle& article) {
     return success;
 }
 
+bool Database::storeNewsArticles(const std::vector<NewsArticle>& articles) {
+    const char* sql = R"(
+        INSERT OR REPLACE INTO news_articles (article_id, title, content, source, published_time, symbol)
+        VALUES (?, ?, ?, ?, ?, ?)
+    )";
+    
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        RAG_LOG_ERROR("Failed to prepare statement: " + std::string(sqlite3_errmsg(db_)));
+        return false;
+    }
+    
+    sqlite3_exec(db_, "BEGIN TRANSACTION", nullptr, nullptr, nullptr);
+    
+    for (const auto& article : articles) {
+        sqlite3_bind_text(stmt, 1, article.id.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, article.title.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 3, article.content.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 4, article.source.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 5, article.published_time.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 6, article.tickers.empty() ? "" : article.tickers[0].c_str(), -1, SQLITE_STATIC);
+        
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            RAG_LOG_ERROR("Failed to insert news article: " + std::string(sqlite3_errmsg(db_)));
+            sqlite3_finalize(stmt);
+            sqlite3_exec(db_, "ROLLBACK", nullptr, nullptr, nullptr);
+            return false;
+        }
+        
+        sqlite3_reset(stmt);
+    }
+    
+    sqlite3_exec(db_, "COMMIT", nullptr, nullptr, nullptr);
+    sqlite3_finalize(stmt);
+    return true;
+}
+
 bool Database::getNewsArticles(const std::string& symbol, int limit, std::vector<NewsArticle>& articles) {
     const char* sql = R"(
         SELECT article_id, title, content, source, published_time
@@ -288,6 +415,42 @@ bool Database::getNewsArticlesByDate(const std::string& start_date, const std::s
     return true;
 }
 
+bool Database::getAllNewsArticles(std::vector<NewsArticle>& articles) {
+    const char* sql = R"(
+        SELECT article_id, title, content, source, published_time, symbol
+        FROM news_articles
+        ORDER BY id
+    )";
+    
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    
+    // content, source and symbol may be NULL for older rows
+    auto column = [stmt](int index) {
+        const unsigned char* text = sqlite3_column_text(stmt, index);
+        return text ? std::string(reinterpret_cast<const char*>(text)) : std::string();
+    };
+    
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        NewsArticle article;
+        article.id = column(0);
+        article.title = column(1);
+        article.content = column(2);
+        article.source = column(3);
+        article.published_time = column(4);
+        std::string symbol = column(5);
+        if (!symbol.empty()) {
+            article.tickers.push_back(symbol);
+        }
+        articles.push_back(article);
+    }
+    
+    sqlite3_finalize(stmt);
+    return true;
+}
+
 bool Database::storeVolatility(const std::string& symbol, const std::string& date, double volatility) {
     const char* sql = R"(
         INSERT OR REPLACE INTO volatility (symbol, date, volatility)
@@ -308,6 +471,41 @@ bool Database::storeVolatility(const std::string& symbol, const std::string& dat
     return success;
 }
 
+bool Database::storeVolatilitySeries(const std::string& symbol,
+                                     const std::vector<std::pair<std::string, double>>& series) {
+    const char* sql = R"(
+        INSERT OR REPLACE INTO volatility (symbol, date, volatility)
+        VALUES (?, ?, ?)
+    )";
+    
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        RAG_LOG_ERROR("Failed to prepare statement: " + std::string(sqlite3_errmsg(db_)));
+        return false;
+    }
+    
+    sqlite3_exec(db_, "BEGIN TRANSACTION", nullptr, nullptr, nullptr);
+    
+    for (const auto& [date, volatility] : series) {
+        sqlite3_bind_text(stmt, 1, symbol.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, date.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_double(stmt, 3, volatility);
+        
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            RAG_LOG_ERROR("Failed to insert volatility: " + std::string(sqlite3_errmsg(db_)));
+            sqlite3_finalize(stmt);
+            sqlite3_exec(db_, "ROLLBACK", nullptr, nullptr, nullptr);
+            return false;
+        }
+        
+        sqlite3_reset(stmt);
+    }
+    
+    sqlite3_exec(db_, "COMMIT", nullptr, nullptr, nullptr);
+    sqlite3_finalize(stmt);
+    return true;
+}
+
 bool Database::getVolatility(const std::string& symbol, const std::string& date, double& volatility) {
     const char* sql = R"(
         SELECT volatility FROM volatility
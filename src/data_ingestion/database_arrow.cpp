@@ -0,0 +1,476 @@
+#include "data_ingestion/database.h"
+#include "utils/logger.h"
+#include "utils/metrics.h"
+
+#ifndef NO_ARROW
+#include <arrow/api.h>
+#include <arrow/io/api.h>
+#include <arrow/ipc/api.h>
+#include <algorithm>
+#endif
+
+namespace rag {
+namespace data {
+
+#ifdef NO_ARROW
+
+bool Database::exportArrow(const std::string& table, const std::string& /*path*/,
+                           const ArrowExportOptions& /*options*/, size_t& rows) {
+    rows = 0;
+    RAG_LOG_ERROR("Arrow export of " + table + " unavailable: built without Apache Arrow");
+    return false;
+}
+
+bool Database::exportArrowStream(const std::string& table, const ArrowExportOptions& /*options*/,
+                                 const ArrowByteSink& /*sink*/, size_t& rows) {
+    rows = 0;
+    RAG_LOG_ERROR("Arrow export of " + table + " unavailable: built without Apache Arrow");
+    return false;
+}
+
+bool Database::importArrow(const std::string& table, const std::string& /*path*/, size_t& rows) {
+    rows = 0;
+    RAG_LOG_ERROR("Arrow import into " + table + " unavailable: built without Apache Arrow");
+    return false;
+}
+
+#else
+
+namespace {
+
+enum class ColumnType { Text, Real, Integer };
+
+struct TableColumn {
+    const char* name;
+    ColumnType type;
+    bool nullable;
+};
+
+// How an exported table maps onto its SQLite table. Column names match the
+// SQLite columns, so an export can be imported unchanged.
+struct TableSpec {
+    const char* name;
+    const char* sql_table;
+    const char* time_column;         // Filtered by start/end; rows are ordered by symbol, then this
+    std::vector<TableColumn> columns;
+};
+
+const TableSpec* findTable(const std::string& name) {
+    static const std::vector<TableColumn> bar_columns = {
+        {"symbol", ColumnType::Text, false},
+        {"timestamp", ColumnType::Text, false},
+        {"open", ColumnType::Real, false},
+        {"high", ColumnType::Real, false},
+        {"low", ColumnType::Real, false},
+        {"close", ColumnType::Real, false},
+        {"volume", ColumnType::Integer, false},
+    };
+    static const std::vector<TableSpec> tables = {
+        {"ohlcv", "ohlcv_data", "timestamp", bar_columns},
+        {"intraday_bars", "intraday_bars", "timestamp", bar_columns},
+        {"news", "news_articles", "published_time", {
+            {"article_id", ColumnType::Text, false},
+            {"title", ColumnType::Text, false},
+            {"content", ColumnType::Text, true},
+            {"source", ColumnType::Text, true},
+            {"published_time", ColumnType::Text, true},
+            {"symbol", ColumnType::Text, true},
+        }},
+        {"options", "options_data", "expiry", {
+            {"symbol", ColumnType::Text, false},
+            {"expiry", ColumnType::Text, false},
+            {"strike", ColumnType::Real, false},
+            {"option_type", ColumnType::Text, false},
+            {"bid", ColumnType::Real, true},
+            {"ask", ColumnType::Real, true},
+            {"implied_volatility", ColumnType::Real, true},
+            {"volume", ColumnType::Integer, true},
+            {"open_interest", ColumnType::Integer, true},
+        }},
+    };
+    for (const auto& table : tables) {
+        if (name == table.name) {
+            return &table;
+        }
+    }
+    RAG_LOG_ERROR("Unknown Arrow table '" + name + "' (expected ohlcv, intraday_bars, news or options)");
+    return nullptr;
+}
+
+std::shared_ptr<arrow::Schema> tableSchema(const TableSpec& table) {
+    arrow::FieldVector fields;
+    for (const auto& column : table.columns) {
+        std::shared_ptr<arrow::DataType> type = column.type == ColumnType::Text ? arrow::utf8()
+                                              : column.type == ColumnType::Real ? arrow::float64()
+                                                                                : arrow::int64();
+        fields.push_back(arrow::field(column.name, type, column.nullable));
+    }
+    return arrow::schema(fields);
+}
+
+// Output stream handing the IPC stream to a sink in 1 MiB chunks
+class SinkOutputStream : public arrow::io::OutputStream {
+public:
+    explicit SinkOutputStream(const ArrowByteSink& sink) : sink_(sink) {
+        buffer_.reserve(kChunkBytes);
+    }
+    
+    using arrow::io::OutputStream::Write;
+    
+    arrow::Status Write(const void* data, int64_t nbytes) override {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        position_ += nbytes;
+        while (nbytes > 0) {
+            size_t take = std::min(static_cast<size_t>(nbytes), kChunkBytes - buffer_.size());
+            buffer_.insert(buffer_.end(), bytes, bytes + take);
+            bytes += take;
+            nbytes -= static_cast<int64_t>(take);
+            if (buffer_.size() == kChunkBytes) {
+                ARROW_RETURN_NOT_OK(Flush());
+            }
+        }
+        return arrow::Status::OK();
+    }
+    
+    arrow::Status Flush() override {
+        if (!buffer_.empty() && !sink_(buffer_.data(), buffer_.size())) {
+            return arrow::Status::Cancelled("Export receiver went away");
+        }
+        buffer_.clear();
+        return arrow::Status::OK();
+    }
+    
+    arrow::Status Close() override {
+        if (closed_) {
+            return arrow::Status::OK();
+        }
+        closed_ = true;
+        return Flush();
+    }
+    
+    arrow::Result<int64_t> Tell() const override { return position_; }
+    bool closed() const override { return closed_; }
+    
+private:
+    static constexpr size_t kChunkBytes = 1 << 20;
+    
+    const ArrowByteSink& sink_;
+    std::vector<uint8_t> buffer_;
+    int64_t position_ = 0;
+    bool closed_ = false;
+};
+
+// Closes a statement on every return path
+struct StatementGuard {
+    sqlite3_stmt* stmt = nullptr;
+    ~StatementGuard() {
+        sqlite3_finalize(stmt);
+    }
+};
+
+// Steps a SELECT over the table straight into column builders, writing a
+// record batch every batch_rows rows
+arrow::Status writeBatches(sqlite3* db, const TableSpec& table, const std::shared_ptr<arrow::Schema>& schema,
+                           const ArrowExportOptions& options, arrow::ipc::RecordBatchWriter& writer, size_t& rows) {
+    std::string sql = "SELECT ";
+    for (size_t c = 0; c < table.columns.size(); ++c) {
+        sql += (c > 0 ? ", " : "") + std::string(table.columns[c].name);
+    }
+    sql += " FROM " + std::string(table.sql_table) + " WHERE 1 = 1";
+    if (!options.symbol.empty()) {
+        sql += " AND symbol = ?";
+    }
+    if (!options.start.empty()) {
+        sql += " AND " + std::string(table.time_column) + " >= ?";
+    }
+    if (!options.end.empty()) {
+        sql += " AND " + std::string(table.time_column) + " <= ?";
+    }
+    sql += " ORDER BY symbol, " + std::string(table.time_column);
+    
+    StatementGuard statement;
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &statement.stmt, nullptr) != SQLITE_OK) {
+        return arrow::Status::IOError("Failed to prepare export: ", sqlite3_errmsg(db));
+    }
+    sqlite3_stmt* stmt = statement.stmt;
+    int param = 1;
+    for (const std::string* value : {&options.symbol, &options.start, &options.end}) {
+        if (!value->empty()) {
+            sqlite3_bind_text(stmt, param++, value->c_str(), -1, SQLITE_STATIC);
+        }
+    }
+    
+    const int64_t batch_rows = static_cast<int64_t>(std::max<size_t>(options.batch_rows, 1));
+    std::vector<std::unique_ptr<arrow::ArrayBuilder>> builders;
+    for (const auto& field : schema->fields()) {
+        ARROW_ASSIGN_OR_RAISE(auto builder, arrow::MakeBuilder(field->type()));
+        ARROW_RETURN_NOT_OK(builder->Reserve(batch_rows));
+        builders.push_back(std::move(builder));
+    }
+    
+    int64_t pending = 0;
+    auto flush = [&]() -> arrow::Status {
+        arrow::ArrayVector arrays;
+        for (auto& builder : builders) {
+            std::shared_ptr<arrow::Array> array;
+            ARROW_RETURN_NOT_OK(builder->Finish(&array));
+            ARROW_RETURN_NOT_OK(builder->Reserve(batch_rows));
+            arrays.push_back(std::move(array));
+        }
+        ARROW_RETURN_NOT_OK(writer.WriteRecordBatch(*arrow::RecordBatch::Make(schema, pending, std::move(arrays))));
+        rows += static_cast<size_t>(pending);
+        pending = 0;
+        return arrow::Status::OK();
+    };
+    
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        for (size_t c = 0; c < table.columns.size(); ++c) {
+            int index = static_cast<int>(c);
+            if (sqlite3_column_type(stmt, index) == SQLITE_NULL) {
+                ARROW_RETURN_NOT_OK(builders[c]->AppendNull());
+                continue;
+            }
+            switch (table.columns[c].type) {
+            case ColumnType::Text: {
+                const char* text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, index));
+                ARROW_RETURN_NOT_OK(static_cast<arrow::StringBuilder&>(*builders[c])
+                                        .Append(text, sqlite3_column_bytes(stmt, index)));
+                break;
+            }
+            case ColumnType::Real:
+                static_cast<arrow::DoubleBuilder&>(*builders[c]).UnsafeAppend(sqlite3_column_double(stmt, index));
+                break;
+            case ColumnType::Integer:
+                static_cast<arrow::Int64Builder&>(*builders[c]).UnsafeAppend(sqlite3_column_int64(stmt, index));
+                break;
+            }
+        }
+        if (++pending == batch_rows) {
+            ARROW_RETURN_NOT_OK(flush());
+        }
+    }
+    if (rc != SQLITE_DONE) {
+        return arrow::Status::IOError("Export query failed: ", sqlite3_errmsg(db));
+    }
+    if (pending > 0) {
+        ARROW_RETURN_NOT_OK(flush());
+    }
+    return arrow::Status::OK();
+}
+
+// The array of each table column in a batch's schema (-1: absent, stored as NULL)
+arrow::Result<std::vector<int>> columnIndices(const TableSpec& table, const arrow::Schema& schema) {
+    std::vector<int> indices;
+    for (const auto& column : table.columns) {
+        int index = schema.GetFieldIndex(column.name);
+        if (index < 0) {
+            if (!column.nullable) {
+                return arrow::Status::Invalid("Missing column '", column.name, "'");
+            }
+            indices.push_back(-1);
+            continue;
+        }
+        arrow::Type::type type = schema.field(index)->type()->id();
+        bool accepted = column.type == ColumnType::Text
+                            ? type == arrow::Type::STRING || type == arrow::Type::LARGE_STRING ||
+                                  type == arrow::Type::STRING_VIEW
+                            : column.type == ColumnType::Real
+                                  ? type == arrow::Type::DOUBLE || type == arrow::Type::FLOAT
+                                  : type == arrow::Type::INT64 || type == arrow::Type::INT32;
+        if (!accepted) {
+            return arrow::Status::TypeError("Column '", column.name, "' has unsupported type ",
+                                            schema.field(index)->type()->ToString());
+        }
+        indices.push_back(index);
+    }
+    return indices;
+}
+
+void bindValue(sqlite3_stmt* stmt, int param, const arrow::Array& array, int64_t row) {
+    if (array.IsNull(row)) {
+        sqlite3_bind_null(stmt, param);
+        return;
+    }
+    std::string_view text;
+    switch (array.type_id()) {
+    case arrow::Type::STRING:
+        text = static_cast<const arrow::StringArray&>(array).GetView(row);
+        break;
+    case arrow::Type::LARGE_STRING:
+        text = static_cast<const arrow::LargeStringArray&>(array).GetView(row);
+        break;
+    case arrow::Type::STRING_VIEW:
+        text = static_cast<const arrow::StringViewArray&>(array).GetView(row);
+        break;
+    case arrow::Type::DOUBLE:
+        sqlite3_bind_double(stmt, param, static_cast<const arrow::DoubleArray&>(array).Value(row));
+        return;
+    case arrow::Type::FLOAT:
+        sqlite3_bind_double(stmt, param, static_cast<const arrow::FloatArray&>(array).Value(row));
+        return;
+    case arrow::Type::INT64:
+        sqlite3_bind_int64(stmt, param, static_cast<const arrow::Int64Array&>(array).Value(row));
+        return;
+    default:
+        sqlite3_bind_int64(stmt, param, static_cast<const arrow::Int32Array&>(array).Value(row));
+        return;
+    }
+    // Strings are bound in place from the (memory-mapped) batch
+    sqlite3_bind_text(stmt, param, text.data(), static_cast<int>(text.size()), SQLITE_STATIC);
+}
+
+arrow::Status importBatches(sqlite3* db, const TableSpec& table, const std::string& path, size_t& rows) {
+    ARROW_ASSIGN_OR_RAISE(auto file, arrow::io::MemoryMappedFile::Open(path, arrow::io::FileMode::READ));
+    
+    // IPC file format first, else the stream format
+    std::vector<std::shared_ptr<arrow::RecordBatch>> file_batches;
+    std::shared_ptr<arrow::RecordBatchReader> stream;
+    auto file_reader = arrow::ipc::RecordBatchFileReader::Open(file);
+    if (file_reader.ok()) {
+        for (int i = 0; i < (*file_reader)->num_record_batches(); ++i) {
+            ARROW_ASSIGN_OR_RAISE(auto batch, (*file_reader)->ReadRecordBatch(i));
+            file_batches.push_back(std::move(batch));
+        }
+    } else {
+        ARROW_RETURN_NOT_OK(file->Seek(0));
+        ARROW_ASSIGN_OR_RAISE(stream, arrow::ipc::RecordBatchStreamReader::Open(file));
+    }
+    std::shared_ptr<arrow::Schema> schema = stream ? stream->schema() : (*file_reader)->schema();
+    ARROW_ASSIGN_OR_RAISE(auto indices, columnIndices(table, *schema));
+    
+    std::string sql = "INSERT OR REPLACE INTO " + std::string(table.sql_table) + " (";
+    std::string placeholders;
+    for (size_t c = 0; c < table.columns.size(); ++c) {
+        sql += (c > 0 ? ", " : "") + std::string(table.columns[c].name);
+        placeholders += c > 0 ? ", ?" : "?";
+    }
+    sql += ") VALUES (" + placeholders + ")";
+    
+    StatementGuard statement;
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &statement.stmt, nullptr) != SQLITE_OK) {
+        return arrow::Status::IOError("Failed to prepare import: ", sqlite3_errmsg(db));
+    }
+    sqlite3_stmt* stmt = statement.stmt;
+    
+    sqlite3_exec(db, "BEGIN TRANSACTION", nullptr, nullptr, nullptr);
+    auto insertBatch = [&](const arrow::RecordBatch& batch) -> arrow::Status {
+        for (int64_t row = 0; row < batch.num_rows(); ++row) {
+            for (size_t c = 0; c < indices.size(); ++c) {
+                int param = static_cast<int>(c) + 1;
+                if (indices[c] < 0) {
+                    sqlite3_bind_null(stmt, param);
+                } else {
+                    bindValue(stmt, param, *batch.column(indices[c]), row);
+                }
+            }
+            if (sqlite3_step(stmt) != SQLITE_DONE) {
+                return arrow::Status::IOError("Insert into ", table.sql_table, " failed: ", sqlite3_errmsg(db));
+            }
+            sqlite3_reset(stmt);
+        }
+        rows += static_cast<size_t>(batch.num_rows());
+        return arrow::Status::OK();
+    };
+    
+    arrow::Status status;
+    if (stream) {
+        std::shared_ptr<arrow::RecordBatch> batch;
+        while ((status = stream->ReadNext(&batch)).ok() && batch) {
+            if (!(status = insertBatch(*batch)).ok()) {
+                break;
+            }
+        }
+    } else {
+        for (const auto& batch : file_batches) {
+            if (!(status = insertBatch(*batch)).ok()) {
+                break;
+            }
+        }
+    }
+    sqlite3_exec(db, status.ok() ? "COMMIT" : "ROLLBACK", nullptr, nullptr, nullptr);
+    if (!status.ok()) {
+        rows = 0;
+    }
+    return status;
+}
+
+bool succeeded(const arrow::Status& status, const std::string& what) {
+    if (!status.ok()) {
+        RAG_LOG_ERROR(what + " failed: " + status.ToString());
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+bool Database::exportArrow(const std::string& table, const std::string& path,
+                           const ArrowExportOptions& options, size_t& rows) {
+    rows = 0;
+    const TableSpec* spec = findTable(table);
+    if (!spec) {
+        return false;
+    }
+    utils::ScopedTimer timer(utils::stageHistogram("arrow", "export"));
+    
+    bool stream_format = path.size() >= 7 && path.compare(path.size() - 7, 7, ".arrows") == 0;
+    auto status = [&]() -> arrow::Status {
+        auto schema = tableSchema(*spec);
+        ARROW_ASSIGN_OR_RAISE(auto file, arrow::io::FileOutputStream::Open(path));
+        std::shared_ptr<arrow::ipc::RecordBatchWriter> writer;
+        if (stream_format) {
+            ARROW_ASSIGN_OR_RAISE(writer, arrow::ipc::MakeStreamWriter(file, schema));
+        } else {
+            ARROW_ASSIGN_OR_RAISE(writer, arrow::ipc::MakeFileWriter(file, schema));
+        }
+        ARROW_RETURN_NOT_OK(writeBatches(db_, *spec, schema, options, *writer, rows));
+        ARROW_RETURN_NOT_OK(writer->Close());
+        return file->Close();
+    }();
+    if (!succeeded(status, "Arrow export of " + table + " to " + path)) {
+        return false;
+    }
+    RAG_LOG_INFO("Exported " + std::to_string(rows) + " " + table + " rows to " + path);
+    return true;
+}
+
+bool Database::exportArrowStream(const std::string& table, const ArrowExportOptions& options,
+                                 const ArrowByteSink& sink, size_t& rows) {
+    rows = 0;
+    const TableSpec* spec = findTable(table);
+    if (!spec) {
+        return false;
+    }
+    utils::ScopedTimer timer(utils::stageHistogram("arrow", "export"));
+    
+    auto status = [&]() -> arrow::Status {
+        auto schema = tableSchema(*spec);
+        auto output = std::make_shared<SinkOutputStream>(sink);
+        ARROW_ASSIGN_OR_RAISE(auto writer, arrow::ipc::MakeStreamWriter(output, schema));
+        ARROW_RETURN_NOT_OK(writeBatches(db_, *spec, schema, options, *writer, rows));
+        ARROW_RETURN_NOT_OK(writer->Close());
+        return output->Close();
+    }();
+    return succeeded(status, "Arrow export of " + table);
+}
+
+bool Database::importArrow(const std::string& table, const std::string& path, size_t& rows) {
+    rows = 0;
+    const TableSpec* spec = findTable(table);
+    if (!spec) {
+        return false;
+    }
+    utils::ScopedTimer timer(utils::stageHistogram("arrow", "import"));
+    
+    if (!succeeded(importBatches(db_, *spec, path, rows), "Arrow import of " + path + " into " + table)) {
+        return false;
+    }
+    RAG_LOG_INFO("Imported " + std::to_string(rows) + " " + table + " rows from " + path);
+    return true;
+}
+
+#endif
+
+} // namespace data
+} // namespace rag
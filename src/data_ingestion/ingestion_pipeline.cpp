@@ -0,0 +1,342 @@
+#include "data_ingestion/ingestion_pipeline.h"
+#include "utils/bounded_queue.h"
+#include "utils/logger.h"
+#include "utils/metrics.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <unordered_set>
+
+namespace rag {
+namespace data {
+
+struct IngestionPipeline::RawPayload {
+    std::string symbol;
+    std::string price_response;
+    std::string news_response;
+};
+
+struct IngestionPipeline::ParsedPayload {
+    std::string symbol;
+    std::vector<OHLCVData> bars;
+    std::vector<NewsArticle> articles;
+};
+
+struct IngestionPipeline::StoreBatch {
+    std::string symbol;
+    std::vector<OHLCVData> bars;
+    std::vector<NewsArticle> articles;
+    std::vector<vectorization::Document> documents;
+    std::vector<float> embeddings;     // Row-major, one row per document
+    std::vector<NewsArticle> indexed_articles; // Fingerprinted once the documents are indexed
+};
+
+IngestionPipeline::IngestionPipeline(const std::string& api_key,
+                                     std::shared_ptr<Database> database,
+                                     std::shared_ptr<vectorization::EmbeddingService> embedding_service,
+                                     std::shared_ptr<vectorization::FAISSIndex> faiss_index,
+                                     const IngestionConfig& config)
+    : api_key_(api_key),
+      database_(database),
+      embedding_service_(embedding_service),
+      faiss_index_(faiss_index),
+      config_(config),
+      alpha_vantage_limiter_(config.requests_per_minute, config.request_burst) {
+}
+
+void IngestionPipeline::setVolatilityEngine(std::shared_ptr<VolatilityEngine> volatility_engine) {
+    volatility_engine_ = volatility_engine;
+}
+
+void IngestionPipeline::setNearDuplicateDetector(std::shared_ptr<NearDuplicateDetector> detector) {
+    duplicate_detector_ = detector;
+}
+
+bool IngestionPipeline::rateLimitedRequest(const std::function<bool(std::string&)>& request,
+                                           const std::string& what, std::string& response) {
+    for (int attempt = 0; attempt <= config_.max_rate_limit_retries; ++attempt) {
+        alpha_vantage_limiter_.acquire();
+        
+        response.clear();
+        if (!request(response)) {
+            return false;
+        }
+        
+        // Alpha Vantage reports throttling in the body with HTTP 200
+        bool throttled = response.find("\"Note\"") != std::string::npos ||
+                         response.find("\"Information\"") != std::string::npos;
+        if (!throttled) {
+            return true;
+        }
+        
+        double backoff_seconds = std::min(60.0, (60.0 / config_.requests_per_minute) * (1 << attempt));
+        RAG_LOG_WARNING("Rate limited fetching " + what + ", retrying in " +
+                                                  std::to_string(static_cast<int>(backoff_seconds)) + "s");
+        std::this_thread::sleep_for(std::chrono::duration<double>(backoff_seconds));
+    }
+    
+    RAG_LOG_ERROR("Giving up on " + what + " after repeated rate limiting");
+    return false;
+}
+
+vectorization::Document IngestionPipeline::toDocument(const std::string& symbol, const NewsArticle& article) {
+    vectorization::Document doc;
+    doc.doc_id = article.id;
+    doc.content = article.title + "\n" + article.content;
+    doc.source = article.source;
+    doc.timestamp = article.published_time;
+    doc.metadata["symbol"] = symbol;
+    doc.metadata["title"] = article.title;
+    doc.metadata["type"] = "news";
+    return doc;
+}
+
+bool IngestionPipeline::run(const std::vector<std::string>& symbols, IngestionStats& stats) {
+    auto start_time = std::chrono::steady_clock::now();
+    
+    symbols_fetched_ = 0;
+    fetch_failures_ = 0;
+    bars_stored_ = 0;
+    articles_stored_ = 0;
+    duplicates_dropped_ = 0;
+    documents_indexed_ = 0;
+    
+    utils::BoundedQueue<std::string> symbol_queue(std::max<size_t>(symbols.size(), 1));
+    utils::BoundedQueue<RawPayload> raw_queue(config_.queue_capacity);
+    utils::BoundedQueue<ParsedPayload> parsed_queue(config_.queue_capacity);
+    utils::BoundedQueue<StoreBatch> store_queue(config_.queue_capacity);
+    
+    for (const auto& symbol : symbols) {
+        symbol_queue.push(symbol);
+    }
+    symbol_queue.close();
+    
+    // Stage 1: fetch pool. Each worker owns a DataFetcher; all workers send
+    // through the shared HttpClient and share the provider's token bucket.
+    std::vector<std::thread> fetch_workers;
+    int worker_count = std::max(1, std::min<int>(config_.fetch_workers, static_cast<int>(symbols.size())));
+    for (int i = 0; i < worker_count; ++i) {
+        fetch_workers.emplace_back([&]() {
+            DataFetcher fetcher(api_key_);
+            if (!config_.base_url.empty()) {
+                fetcher.setBaseUrl(config_.base_url);
+            }
+            std::string symbol;
+            while (symbol_queue.pop(symbol)) {
+                RawPayload payload;
+                payload.symbol = symbol;
+                
+                bool has_prices = rateLimitedRequest([&](std::string& response) {
+                    return fetcher.requestStockData(symbol, config_.history_days, response);
+                }, "prices for " + symbol, payload.price_response);
+                
+                bool has_news = false;
+                if (config_.fetch_news) {
+                    has_news = rateLimitedRequest([&](std::string& response) {
+                        return fetcher.requestNews(symbol, config_.news_per_symbol, response);
+                    }, "news for " + symbol, payload.news_response);
+                }
+                
+                if (!has_prices) {
+                    payload.price_response.clear();
+                }
+                if (!has_news) {
+                    payload.news_response.clear();
+                }
+                if (!has_prices && !has_news) {
+                    fetch_failures_++;
+                    continue;
+                }
+                
+                symbols_fetched_++;
+                raw_queue.push(std::move(payload));
+            }
+        });
+    }
+    
+    // Fingerprints are only recorded once an article is indexed (stage 4),
+    // so a failed batch is retried next run; copies within this run are
+    // caught here
+    std::unique_ptr<NearDuplicateDetector> in_flight;
+    if (duplicate_detector_) {
+        in_flight = std::make_unique<NearDuplicateDetector>(duplicate_detector_->maxDistance());
+    }
+    bool can_index = embedding_service_ && faiss_index_;
+    
+    // Stage 2: parse
+    std::thread parse_worker([&]() {
+        RawPayload raw;
+        while (raw_queue.pop(raw)) {
+            ParsedPayload parsed;
+            parsed.symbol = raw.symbol;
+            
+            if (!raw.price_response.empty()) {
+                DataFetcher::parseStockData(raw.price_response, config_.history_days, parsed.bars);
+            }
+            if (!raw.news_response.empty()) {
+                std::vector<NewsArticle> articles;
+                DataFetcher::parseNews(raw.news_response, articles);
+                
+                for (auto& article : articles) {
+                    std::string duplicate_of;
+                    if (duplicate_detector_ && (duplicate_detector_->isDuplicate(article, &duplicate_of) ||
+                                                in_flight->checkAndInsert(article, &duplicate_of))) {
+                        duplicates_dropped_++;
+                        RAG_LOG_DEBUG("Dropping near-duplicate " + article.id + " (of " + duplicate_of + ")");
+                        continue;
+                    }
+                    
+                    // The requested symbol is the one the article is filed under
+                    auto it = std::find(article.tickers.begin(), article.tickers.end(), raw.symbol);
+                    if (it != article.tickers.end()) {
+                        article.tickers.erase(it);
+                    }
+                    article.tickers.insert(article.tickers.begin(), raw.symbol);
+                    parsed.articles.push_back(std::move(article));
+                }
+            }
+            
+            parsed_queue.push(std::move(parsed));
+        }
+        parsed_queue.close();
+    });
+    
+    // Stage 3: embed news in batches; rows pass straight through to storage
+    std::thread embed_worker([&]() {
+        std::vector<vectorization::Document> pending_docs;
+        std::vector<NewsArticle> pending_articles; // Articles whose chunks are in pending_docs
+        std::unordered_set<std::string> seen_doc_ids;
+        vectorization::DocumentChunker chunker(config_.chunking, faiss_index_);
+        
+        auto flush_docs = [&]() {
+            if (pending_docs.empty()) {
+                // Every chunk was indexed before; only the fingerprints are new
+                if (!pending_articles.empty()) {
+                    StoreBatch batch;
+                    batch.indexed_articles = std::move(pending_articles);
+                    store_queue.push(std::move(batch));
+                    pending_articles.clear();
+                }
+                return;
+            }
+            
+            std::vector<std::string> texts;
+            texts.reserve(pending_docs.size());
+            for (const auto& doc : pending_docs) {
+                texts.push_back(doc.content);
+            }
+            
+            static auto& embed_latency = utils::stageHistogram("ingestion", "embed_batch");
+            StoreBatch batch;
+            bool embedded;
+            {
+                utils::ScopedTimer timer(embed_latency);
+                embedded = embedding_service_->generateEmbeddingMatrix(texts, batch.embeddings);
+            }
+            if (embedded) {
+                batch.documents = std::move(pending_docs);
+                batch.indexed_articles = std::move(pending_articles);
+                store_queue.push(std::move(batch));
+            } else {
+                // Not fingerprinted, so the next run picks these articles up again
+                RAG_LOG_WARNING("Embedding batch of " + std::to_string(pending_docs.size()) +
+                                                          " documents failed - skipping indexing for this batch");
+            }
+            pending_docs.clear();
+            pending_articles.clear();
+        };
+        
+        ParsedPayload parsed;
+        while (parsed_queue.pop(parsed)) {
+            if (can_index) {
+                // Chunks already indexed (same content hash) are dropped by the chunker
+                for (const auto& article : parsed.articles) {
+                    if (article.id.empty() || !seen_doc_ids.insert(article.id).second) {
+                        continue;
+                    }
+                    chunker.chunk(toDocument(parsed.symbol, article), pending_docs);
+                    if (duplicate_detector_) {
+                        pending_articles.push_back(article);
+                    }
+                }
+            }
+            
+            StoreBatch rows;
+            rows.symbol = parsed.symbol;
+            rows.bars = std::move(parsed.bars);
+            rows.articles = std::move(parsed.articles);
+            store_queue.push(std::move(rows));
+            
+            if (pending_docs.size() >= config_.embed_batch_size) {
+                flush_docs();
+            }
+        }
+        flush_docs();
+        store_queue.close();
+    });
+    
+    // Stage 4: store and index (single writer for SQLite)
+    std::thread store_worker([&]() {
+        static auto& store_latency = utils::stageHistogram("ingestion", "store_batch");
+        StoreBatch batch;
+        while (store_queue.pop(batch)) {
+            utils::ScopedTimer timer(store_latency);
+            if (!batch.bars.empty() && database_->storeOHLCVData(batch.symbol, batch.bars)) {
+                bars_stored_ += batch.bars.size();
+                if (volatility_engine_) {
+                    volatility_engine_->updateSeries(batch.symbol, batch.bars);
+                }
+            }
+            
+            if (!batch.articles.empty() && database_->storeNewsArticles(batch.articles)) {
+                articles_stored_ += batch.articles.size();
+                if (duplicate_detector_ && !can_index) {
+                    // Nothing to index: stored is done
+                    for (const auto& article : batch.articles) {
+                        duplicate_detector_->insert(article);
+                    }
+                }
+            }
+            
+            bool indexed = batch.documents.empty();
+            if (!batch.documents.empty() && faiss_index_->addDocumentMatrix(batch.documents, batch.embeddings)) {
+                documents_indexed_ += batch.documents.size();
+                indexed = true;
+            }
+            if (indexed && duplicate_detector_) {
+                for (const auto& article : batch.indexed_articles) {
+                    duplicate_detector_->insert(article);
+                }
+            }
+        }
+    });
+    
+    for (auto& worker : fetch_workers) {
+        worker.join();
+    }
+    raw_queue.close();
+    parse_worker.join();
+    embed_worker.join();
+    store_worker.join();
+    
+    stats.symbols_requested = symbols.size();
+    stats.symbols_fetched = symbols_fetched_;
+    stats.fetch_failures = fetch_failures_;
+    stats.bars_stored = bars_stored_;
+    stats.articles_stored = articles_stored_;
+    stats.duplicates_dropped = duplicates_dropped_;
+    stats.documents_indexed = documents_indexed_;
+    stats.elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    
+    RAG_LOG_INFO("Ingestion complete: " + std::to_string(stats.symbols_fetched) + "/" +
+                                           std::to_string(stats.symbols_requested) + " symbols, " +
+                                           std::to_string(stats.bars_stored) + " bars, " +
+                                           std::to_string(stats.articles_stored) + " articles (" +
+                                           std::to_string(stats.duplicates_dropped) + " duplicates dropped), " +
+                                           std::to_string(stats.documents_indexed) + " documents indexed in " +
+                                           std::to_string(stats.elapsed_seconds) + "s");
+    return stats.fetch_failures < stats.symbols_requested || symbols.empty();
+}
+
+} // namespace data
+} // namespace rag
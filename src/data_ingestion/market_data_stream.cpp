@@ -0,0 +1,310 @@
+#include "data_ingestion/market_data_stream.h"
+#include "utils/logger.h"
+#include "utils/metrics.h"
+#include <algorithm>
+#include <ctime>
+#include <limits>
+
+namespace rag {
+namespace data {
+
+namespace {
+
+// Ticks the writer takes off the queue per pass (one quote-table lock each)
+const size_t kDrainBatch = 256;
+// Empty polls spent yielding before the writer sleeps between polls
+const int kIdleSpins = 64;
+const auto kIdleSleep = std::chrono::microseconds(200);
+
+// "YYYY-MM-DD HH:MM:SS" (UTC) for a Unix time in milliseconds
+std::string barTimestamp(int64_t timestamp_ms) {
+    std::time_t seconds = static_cast<std::time_t>(timestamp_ms / 1000);
+    std::tm utc{};
+    gmtime_r(&seconds, &utc);
+    char text[24];
+    std::strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", &utc);
+    return text;
+}
+
+} // namespace
+
+MarketDataStream::MarketDataStream(std::unique_ptr<MarketFeed> feed, std::shared_ptr<Database> database,
+                                   const MarketStreamConfig& config)
+    : feed_(std::move(feed)),
+      feed_name_(feed_ ? feed_->name() : ""),
+      database_(database),
+      config_(config),
+      queue_(config.queue_capacity) {
+    config_.bar_seconds = std::max(1, config_.bar_seconds);
+}
+
+MarketDataStream::~MarketDataStream() {
+    stop();
+}
+
+bool MarketDataStream::start() {
+    if (!feed_ || running_.exchange(true)) {
+        return false;
+    }
+    input_done_ = false;
+    finished_ = false;
+    reader_ = std::thread(&MarketDataStream::readLoop, this);
+    writer_ = std::thread(&MarketDataStream::writeLoop, this);
+    RAG_LOG_INFO("Streaming market data from " + feed_name_);
+    return true;
+}
+
+void MarketDataStream::stop() {
+    if (running_.exchange(false)) {
+        feed_->close();
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        state_cv_.notify_all();
+    }
+    if (reader_.joinable()) {
+        reader_.join();
+    }
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+}
+
+void MarketDataStream::wait() {
+    std::unique_lock<std::mutex> lock(state_mutex_);
+    state_cv_.wait(lock, [this]() { return finished_ || !running_; });
+}
+
+bool MarketDataStream::getQuote(const std::string& symbol, LiveQuote& quote,
+                                std::chrono::milliseconds max_age) const {
+    std::shared_lock<std::shared_mutex> lock(quotes_mutex_);
+    auto it = quotes_.find(symbol);
+    if (it == quotes_.end() || std::chrono::steady_clock::now() - it->second.updated > max_age) {
+        return false;
+    }
+    quote = it->second;
+    return true;
+}
+
+MarketStreamStats MarketDataStream::stats() const {
+    MarketStreamStats stats;
+    stats.ticks = ticks_;
+    stats.late_ticks = late_ticks_;
+    stats.bars_stored = bars_stored_;
+    stats.queue_full_waits = queue_full_waits_;
+    stats.reconnects = reconnects_;
+    return stats;
+}
+
+void MarketDataStream::readLoop() {
+    int backoff_ms = config_.reconnect_min_ms;
+    bool connected_before = false;
+    // Sleeps backoff_ms (unless stopped), then doubles it up to the cap
+    auto back_off = [&]() {
+        std::unique_lock<std::mutex> lock(state_mutex_);
+        state_cv_.wait_for(lock, std::chrono::milliseconds(backoff_ms), [this]() { return !running_; });
+        backoff_ms = std::min(backoff_ms * 2, config_.reconnect_max_ms);
+    };
+    while (running_) {
+        if (!feed_->open()) {
+            if (!feed_->live()) {
+                break;
+            }
+            back_off();
+            continue;
+        }
+        if (connected_before) {
+            reconnects_++;
+        }
+        connected_before = true;
+        
+        // Backpressure rather than loss: a full queue stalls the reader,
+        // which stalls the socket, until the writer catches up
+        MarketTick tick;
+        bool delivered = false;
+        while (running_ && feed_->read(tick)) {
+            delivered = true;
+            tick.received = std::chrono::steady_clock::now();
+            if (!queue_.tryPush(tick)) {
+                queue_full_waits_++;
+                while (running_ && !queue_.tryPush(tick)) {
+                    std::this_thread::yield();
+                }
+            }
+        }
+        
+        if (!feed_->live()) {
+            break;
+        }
+        if (running_) {
+            RAG_LOG_WARNING("Market feed " + feed_name_ + " disconnected - reconnecting in " +
+                            std::to_string(delivered ? config_.reconnect_min_ms : backoff_ms) + " ms");
+        }
+        // Only a connection that delivered ticks resets the backoff, so a
+        // server that accepts and then drops connections is not hammered
+        if (delivered) {
+            backoff_ms = config_.reconnect_min_ms;
+        }
+        back_off();
+    }
+    input_done_ = true;
+}
+
+void MarketDataStream::writeLoop() {
+    std::vector<MarketTick> batch;
+    batch.reserve(kDrainBatch);
+    auto oldest_closed = std::chrono::steady_clock::time_point::max();
+    auto last_tick = std::chrono::steady_clock::now();
+    int idle = 0;
+    
+    while (true) {
+        // Read before draining: once the reader is done and the queue is empty, it stays empty
+        bool input_done = input_done_;
+        MarketTick tick;
+        while (batch.size() < kDrainBatch && queue_.tryPop(tick)) {
+            batch.push_back(std::move(tick));
+        }
+        
+        auto now = std::chrono::steady_clock::now();
+        bool had_bars = !closed_bars_.empty();
+        bool drained = !batch.empty();
+        if (drained) {
+            applyTicks(batch);
+            batch.clear();
+            last_tick = now;
+            idle = 0;
+        } else {
+            // No ticks: let the stream clock run on wall time so quiet symbols' bars still close
+            auto quiet_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - last_tick).count();
+            closeBars(stream_clock_ms_ + quiet_ms);
+        }
+        if (!had_bars && !closed_bars_.empty()) {
+            oldest_closed = now;
+        }
+        
+        if (!closed_bars_.empty() &&
+            (closed_bars_.size() >= config_.flush_batch ||
+             now - oldest_closed >= std::chrono::milliseconds(config_.flush_interval_ms))) {
+            flushBars();
+        }
+        
+        if (!drained) {
+            if (input_done) {
+                break;
+            }
+            if (++idle < kIdleSpins) {
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(kIdleSleep);
+            }
+        }
+    }
+    
+    closeBars(std::numeric_limits<int64_t>::max());
+    flushBars();
+    
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    finished_ = true;
+    state_cv_.notify_all();
+}
+
+void MarketDataStream::applyTicks(std::vector<MarketTick>& ticks) {
+    static auto& quote_latency = utils::stageHistogram("market_stream", "tick_to_quote");
+    
+    {
+        std::unique_lock<std::shared_mutex> lock(quotes_mutex_);
+        auto now = std::chrono::steady_clock::now();
+        for (const auto& tick : ticks) {
+            SymbolState& state = symbols_[tick.symbol];
+            if (tick.previous_close > 0.0) {
+                state.reference_price = tick.previous_close;
+            } else if (state.reference_price == 0.0) {
+                state.reference_price = tick.price;
+            }
+            
+            LiveQuote& quote = quotes_[tick.symbol];
+            quote.volume += tick.size;
+            if (quote.timestamp_ms == 0) {
+                quote.session_high = tick.price;
+                quote.session_low = tick.price;
+            }
+            quote.session_high = std::max(quote.session_high, tick.price);
+            quote.session_low = std::min(quote.session_low, tick.price);
+            if (tick.timestamp_ms >= quote.timestamp_ms) {
+                quote.price = tick.price;
+                quote.change_percent = (tick.price / state.reference_price - 1.0) * 100.0;
+                quote.timestamp_ms = tick.timestamp_ms;
+            }
+            quote.updated = now;
+        }
+        for (const auto& tick : ticks) {
+            quote_latency.record(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(now - tick.received).count()));
+        }
+    }
+    ticks_ += ticks.size();
+    
+    const int64_t bar_ms = static_cast<int64_t>(config_.bar_seconds) * 1000;
+    for (auto& tick : ticks) {
+        stream_clock_ms_ = std::max(stream_clock_ms_, tick.timestamp_ms);
+        BarBuilder& builder = symbols_[tick.symbol].builder;
+        int64_t bucket_ms = tick.timestamp_ms - tick.timestamp_ms % bar_ms;
+        
+        // A bar already closed (or one before it) can't be reopened without
+        // overwriting the stored row with a partial one
+        if (bucket_ms < builder.bucket_ms || (bucket_ms == builder.bucket_ms && !builder.open)) {
+            late_ticks_++;
+            continue;
+        }
+        if (builder.open && bucket_ms > builder.bucket_ms) {
+            closed_bars_.emplace_back(tick.symbol, std::move(builder.bar));
+        }
+        if (!builder.open || bucket_ms > builder.bucket_ms) {
+            builder.open = true;
+            builder.bucket_ms = bucket_ms;
+            builder.bar.timestamp = barTimestamp(bucket_ms);
+            builder.bar.open = builder.bar.high = builder.bar.low = tick.price;
+            builder.bar.volume = 0;
+        }
+        builder.bar.high = std::max(builder.bar.high, tick.price);
+        builder.bar.low = std::min(builder.bar.low, tick.price);
+        builder.bar.close = tick.price;
+        builder.bar.volume += tick.size;
+    }
+    closeBars(stream_clock_ms_);
+}
+
+void MarketDataStream::closeBars(int64_t clock_ms) {
+    // Bars only become closable when the clock enters a new bar period
+    const int64_t bar_ms = static_cast<int64_t>(config_.bar_seconds) * 1000;
+    int64_t period = clock_ms / bar_ms;
+    if (period == closed_period_) {
+        return;
+    }
+    closed_period_ = period;
+    
+    for (auto& [symbol, state] : symbols_) {
+        BarBuilder& builder = state.builder;
+        if (builder.open && builder.bucket_ms + bar_ms <= clock_ms) {
+            closed_bars_.emplace_back(symbol, std::move(builder.bar));
+            builder.open = false;
+        }
+    }
+}
+
+void MarketDataStream::flushBars() {
+    static auto& store_latency = utils::stageHistogram("market_stream", "store_bars");
+    if (closed_bars_.empty()) {
+        return;
+    }
+    if (database_) {
+        utils::ScopedTimer timer(store_latency);
+        if (database_->storeIntradayBars(closed_bars_)) {
+            bars_stored_ += closed_bars_.size();
+        } else {
+            RAG_LOG_ERROR("Failed to store " + std::to_string(closed_bars_.size()) + " intraday bars");
+        }
+    }
+    closed_bars_.clear();
+}
+
+} // namespace data
+} // namespace rag
@@ -0,0 +1,513 @@
+#include "data_ingestion/market_feed.h"
+#include "utils/base64.h"
+#include "utils/json_scanner.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace rag {
+namespace data {
+
+namespace {
+
+// Largest WebSocket message accepted; ticks are tiny
+const size_t kMaxFramePayload = 16 * 1024 * 1024;
+const size_t kReceiveChunk = 16 * 1024;
+
+int connectTcp(const std::string& host, int port) {
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* addresses = nullptr;
+    if (::getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses) != 0) {
+        RAG_LOG_ERROR("Cannot resolve market feed host " + host);
+        return -1;
+    }
+    
+    int fd = -1;
+    for (addrinfo* address = addresses; address; address = address->ai_next) {
+        fd = ::socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        if (::connect(fd, address->ai_addr, address->ai_addrlen) == 0) {
+            break;
+        }
+        ::close(fd);
+        fd = -1;
+    }
+    ::freeaddrinfo(addresses);
+    
+    if (fd < 0) {
+        RAG_LOG_ERROR("Cannot connect to market feed at " + host + ":" + std::to_string(port));
+        return -1;
+    }
+    int nodelay = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+    return fd;
+}
+
+bool sendAll(int fd, const char* data, size_t size) {
+    size_t sent = 0;
+    while (sent < size) {
+        ssize_t n = ::send(fd, data + sent, size - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return false;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool receiveInto(int fd, std::string& buffer) {
+    if (fd < 0) {
+        return false;
+    }
+    char chunk[kReceiveChunk];
+    ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+    if (n <= 0) {
+        return false;
+    }
+    buffer.append(chunk, static_cast<size_t>(n));
+    return true;
+}
+
+// Take the next complete line from buffer, starting at offset
+bool nextLine(std::string& buffer, size_t& offset, std::string_view& line) {
+    size_t newline = buffer.find('\n', offset);
+    if (newline == std::string::npos) {
+        buffer.erase(0, offset);
+        offset = 0;
+        return false;
+    }
+    line = std::string_view(buffer.data() + offset, newline - offset);
+    offset = newline + 1;
+    return true;
+}
+
+void shutdownSocket(const std::atomic<int>& fd) {
+    int current = fd.load();
+    if (current >= 0) {
+        ::shutdown(current, SHUT_RDWR);
+    }
+}
+
+void replaceSocket(std::atomic<int>& fd, int replacement) {
+    int previous = fd.exchange(replacement);
+    if (previous >= 0) {
+        ::close(previous);
+    }
+}
+
+void appendDouble(std::string& out, double value) {
+    char number[32];
+#if defined(__cpp_lib_to_chars)
+    out.append(number, std::to_chars(number, number + sizeof(number), value).ptr);
+#else
+    out.append(number, static_cast<size_t>(std::snprintf(number, sizeof(number), "%.15g", value)));
+#endif
+}
+
+} // namespace
+
+bool parseTickLine(std::string_view line, MarketTick& tick) {
+    while (!line.empty() && (line.back() == '\r' || line.back() == ' ')) {
+        line.remove_suffix(1);
+    }
+    if (line.empty() || line.front() == '#') {
+        return false;
+    }
+    
+    std::string_view fields[5];
+    size_t count = 0;
+    while (count < 5) {
+        size_t comma = line.find(',');
+        fields[count++] = line.substr(0, comma);
+        if (comma == std::string_view::npos) {
+            break;
+        }
+        line.remove_prefix(comma + 1);
+    }
+    
+    int64_t timestamp_ms = 0;
+    int64_t size = 0;
+    double price = 0.0;
+    double previous_close = 0.0;
+    if (count < 4 || fields[0].empty() ||
+        !utils::parseInt64(fields[1], timestamp_ms) ||
+        !utils::parseDouble(fields[2], price) || price <= 0.0 ||
+        !utils::parseInt64(fields[3], size) ||
+        (count == 5 && !utils::parseDouble(fields[4], previous_close))) {
+        return false;
+    }
+    
+    tick.symbol.assign(fields[0].data(), fields[0].size());
+    tick.timestamp_ms = timestamp_ms;
+    tick.price = price;
+    tick.size = static_cast<long>(size);
+    tick.previous_close = previous_close;
+    return true;
+}
+
+std::string formatTickLine(const MarketTick& tick) {
+    std::string line = tick.symbol;
+    line += ',';
+    line += std::to_string(tick.timestamp_ms);
+    line += ',';
+    appendDouble(line, tick.price);
+    line += ',';
+    line += std::to_string(tick.size);
+    if (tick.previous_close > 0.0) {
+        line += ',';
+        appendDouble(line, tick.previous_close);
+    }
+    return line;
+}
+
+// TcpLineFeed
+
+TcpLineFeed::TcpLineFeed(const std::string& host, int port, const std::string& subscribe_line)
+    : host_(host), port_(port), subscribe_line_(subscribe_line) {
+}
+
+TcpLineFeed::~TcpLineFeed() {
+    replaceSocket(fd_, -1);
+}
+
+std::string TcpLineFeed::name() const {
+    return "tcp://" + host_ + ":" + std::to_string(port_);
+}
+
+bool TcpLineFeed::open() {
+    replaceSocket(fd_, -1);
+    buffer_.clear();
+    offset_ = 0;
+    if (closed_) {
+        return false;
+    }
+    
+    int fd = connectTcp(host_, port_);
+    if (fd < 0) {
+        return false;
+    }
+    replaceSocket(fd_, fd);
+    if (closed_) {
+        // close() raced with the connect
+        return false;
+    }
+    if (!subscribe_line_.empty()) {
+        std::string line = subscribe_line_ + "\n";
+        if (!sendAll(fd, line.data(), line.size())) {
+            return false;
+        }
+    }
+    RAG_LOG_INFO("Connected to market feed " + name());
+    return true;
+}
+
+bool TcpLineFeed::read(MarketTick& tick) {
+    std::string_view line;
+    while (true) {
+        while (nextLine(buffer_, offset_, line)) {
+            if (parseTickLine(line, tick)) {
+                return true;
+            }
+        }
+        if (!receiveInto(fd_.load(), buffer_)) {
+            return false;
+        }
+    }
+}
+
+void TcpLineFeed::close() {
+    closed_ = true;
+    shutdownSocket(fd_);
+}
+
+// WebSocketFeed
+
+WebSocketFeed::WebSocketFeed(const std::string& url, const std::string& subscribe_message)
+    : url_(url), subscribe_message_(subscribe_message) {
+    std::string rest = url.rfind("ws://", 0) == 0 ? url.substr(5) : url;
+    size_t slash = rest.find('/');
+    if (slash != std::string::npos) {
+        path_ = rest.substr(slash);
+        rest.resize(slash);
+    }
+    size_t colon = rest.rfind(':');
+    if (colon != std::string::npos) {
+        port_ = std::atoi(rest.c_str() + colon + 1);
+        rest.resize(colon);
+    }
+    host_ = rest;
+}
+
+WebSocketFeed::~WebSocketFeed() {
+    replaceSocket(fd_, -1);
+}
+
+bool WebSocketFeed::open() {
+    replaceSocket(fd_, -1);
+    raw_.clear();
+    lines_.clear();
+    offset_ = 0;
+    if (closed_) {
+        return false;
+    }
+    
+    int fd = connectTcp(host_, port_);
+    if (fd < 0) {
+        return false;
+    }
+    replaceSocket(fd_, fd);
+    if (closed_) {
+        return false;
+    }
+    
+    // Opening handshake (RFC 6455 section 4.1). The accept hash is not
+    // checked: the server is configured, not discovered.
+    std::random_device random;
+    uint8_t nonce[16];
+    for (auto& byte : nonce) {
+        byte = static_cast<uint8_t>(random());
+    }
+    std::string request = "GET " + path_ + " HTTP/1.1\r\n"
+                          "Host: " + host_ + ":" + std::to_string(port_) + "\r\n"
+                          "Upgrade: websocket\r\n"
+                          "Connection: Upgrade\r\n"
+                          "Sec-WebSocket-Key: " + utils::base64Encode(nonce, sizeof(nonce)) + "\r\n"
+                          "Sec-WebSocket-Version: 13\r\n\r\n";
+    if (!sendAll(fd, request.data(), request.size())) {
+        return false;
+    }
+    
+    size_t header_end;
+    while ((header_end = raw_.find("\r\n\r\n")) == std::string::npos) {
+        if (raw_.size() > 16384 || !receive()) {
+            RAG_LOG_ERROR("WebSocket handshake with " + url_ + " failed");
+            return false;
+        }
+    }
+    if (raw_.compare(0, 12, "HTTP/1.1 101") != 0) {
+        RAG_LOG_ERROR("WebSocket upgrade refused by " + url_ + ": " + raw_.substr(0, raw_.find("\r\n")));
+        return false;
+    }
+    raw_.erase(0, header_end + 4);
+    
+    if (!subscribe_message_.empty() && !sendFrame(0x1, subscribe_message_)) {
+        return false;
+    }
+    RAG_LOG_INFO("Connected to market feed " + url_);
+    return true;
+}
+
+bool WebSocketFeed::read(MarketTick& tick) {
+    std::string_view line;
+    while (true) {
+        while (nextLine(lines_, offset_, line)) {
+            if (parseTickLine(line, tick)) {
+                return true;
+            }
+        }
+        if (!readFrame()) {
+            return false;
+        }
+    }
+}
+
+void WebSocketFeed::close() {
+    closed_ = true;
+    shutdownSocket(fd_);
+}
+
+bool WebSocketFeed::receive() {
+    return receiveInto(fd_.load(), raw_);
+}
+
+bool WebSocketFeed::readFrame() {
+    while (raw_.size() < 2) {
+        if (!receive()) {
+            return false;
+        }
+    }
+    auto byte = [this](size_t i) { return static_cast<uint8_t>(raw_[i]); };
+    bool fin = byte(0) & 0x80;
+    uint8_t opcode = byte(0) & 0x0F;
+    bool masked = byte(1) & 0x80;
+    uint64_t length = byte(1) & 0x7F;
+    
+    size_t header = 2;
+    size_t extended = length == 126 ? 2 : (length == 127 ? 8 : 0);
+    while (raw_.size() < header + extended + (masked ? 4 : 0)) {
+        if (!receive()) {
+            return false;
+        }
+    }
+    if (extended > 0) {
+        length = 0;
+        for (size_t i = 0; i < extended; ++i) {
+            length = (length << 8) | byte(header + i);
+        }
+        header += extended;
+    }
+    if (length > kMaxFramePayload) {
+        RAG_LOG_ERROR("WebSocket frame of " + std::to_string(length) + " bytes from " + url_ + " rejected");
+        return false;
+    }
+    uint8_t mask[4] = {0, 0, 0, 0};
+    if (masked) {
+        for (size_t i = 0; i < 4; ++i) {
+            mask[i] = byte(header + i);
+        }
+        header += 4;
+    }
+    while (raw_.size() < header + length) {
+        if (!receive()) {
+            return false;
+        }
+    }
+    
+    std::string_view payload(raw_.data() + header, static_cast<size_t>(length));
+    bool keep_open = true;
+    switch (opcode) {
+        case 0x0:  // Continuation
+        case 0x1:  // Text
+        case 0x2: {  // Binary, read as text
+            size_t start = lines_.size();
+            lines_.append(payload);
+            if (masked) {
+                for (size_t i = 0; i < payload.size(); ++i) {
+                    lines_[start + i] ^= static_cast<char>(mask[i % 4]);
+                }
+            }
+            if (fin) {
+                lines_ += '\n';  // A message ends its last line
+            }
+            break;
+        }
+        case 0x8:  // Close: echo it and stop
+            sendFrame(0x8, payload.substr(0, std::min<size_t>(payload.size(), 2)));
+            keep_open = false;
+            break;
+        case 0x9:  // Ping
+            keep_open = sendFrame(0xA, payload);
+            break;
+        default:   // Pong and reserved opcodes
+            break;
+    }
+    raw_.erase(0, header + static_cast<size_t>(length));
+    return keep_open;
+}
+
+bool WebSocketFeed::sendFrame(uint8_t opcode, std::string_view payload) {
+    // Client frames are always masked (RFC 6455 section 5.3)
+    std::string frame;
+    frame.reserve(payload.size() + 14);
+    frame += static_cast<char>(0x80 | opcode);
+    if (payload.size() < 126) {
+        frame += static_cast<char>(0x80 | payload.size());
+    } else if (payload.size() <= 0xFFFF) {
+        frame += static_cast<char>(0x80 | 126);
+        frame += static_cast<char>(payload.size() >> 8);
+        frame += static_cast<char>(payload.size() & 0xFF);
+    } else {
+        frame += static_cast<char>(0x80 | 127);
+        for (int shift = 56; shift >= 0; shift -= 8) {
+            frame += static_cast<char>((static_cast<uint64_t>(payload.size()) >> shift) & 0xFF);
+        }
+    }
+    
+    std::random_device random;
+    uint32_t key = random();
+    char mask[4];
+    std::memcpy(mask, &key, sizeof(mask));
+    frame.append(mask, sizeof(mask));
+    for (size_t i = 0; i < payload.size(); ++i) {
+        frame += static_cast<char>(payload[i] ^ mask[i % 4]);
+    }
+    return sendAll(fd_.load(), frame.data(), frame.size());
+}
+
+// ReplayFeed
+
+ReplayFeed::ReplayFeed(const std::string& path, double speed) : path_(path), speed_(speed) {
+}
+
+bool ReplayFeed::open() {
+    file_.close();
+    file_.clear();
+    file_.open(path_);
+    if (!file_) {
+        RAG_LOG_ERROR("Cannot open tick replay file " + path_);
+        return false;
+    }
+    first_timestamp_ms_ = -1;
+    return !closed_;
+}
+
+bool ReplayFeed::read(MarketTick& tick) {
+    std::string line;
+    while (!closed_ && std::getline(file_, line)) {
+        if (!parseTickLine(line, tick)) {
+            continue;
+        }
+        if (speed_ > 0.0) {
+            if (first_timestamp_ms_ < 0) {
+                first_timestamp_ms_ = tick.timestamp_ms;
+                started_ = std::chrono::steady_clock::now();
+            }
+            auto offset = std::chrono::duration<double, std::milli>(
+                static_cast<double>(tick.timestamp_ms - first_timestamp_ms_) / speed_);
+            auto due = started_ + std::chrono::duration_cast<std::chrono::steady_clock::duration>(offset);
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (closed_cv_.wait_until(lock, due, [this]() { return closed_.load(); })) {
+                return false;
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+void ReplayFeed::close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    closed_cv_.notify_all();
+}
+
+std::unique_ptr<MarketFeed> createMarketFeed(const std::string& spec, const std::string& subscribe) {
+    if (spec.rfind("tcp://", 0) == 0) {
+        std::string address = spec.substr(6);
+        size_t colon = address.rfind(':');
+        if (colon == std::string::npos) {
+            return nullptr;
+        }
+        return std::make_unique<TcpLineFeed>(address.substr(0, colon), std::atoi(address.c_str() + colon + 1),
+                                             subscribe);
+    }
+    if (spec.rfind("ws://", 0) == 0) {
+        return std::make_unique<WebSocketFeed>(spec, subscribe);
+    }
+    if (spec.rfind("replay:", 0) == 0) {
+        std::string path = spec.substr(7);
+        double speed = 0.0;
+        size_t at = path.rfind('@');
+        if (at != std::string::npos) {
+            speed = std::atof(path.c_str() + at + 1);
+            path.resize(at);
+        }
+        return std::make_unique<ReplayFeed>(path, speed);
+    }
+    return nullptr;
+}
+
+} // namespace data
+} // namespace rag
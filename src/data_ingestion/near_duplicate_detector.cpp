@@ -0,0 +1,231 @@
+#include "data_ingestion/near_duplicate_detector.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+
+namespace rag {
+namespace data {
+
+namespace {
+
+constexpr uint32_t kFileMagic = 0x484d4953; // "SIMH"
+constexpr uint32_t kFileVersion = 1;
+
+uint64_t hashWord(const std::string& word, uint64_t seed) {
+    // FNV-1a followed by a murmur-style finalizer for well-mixed bits
+    uint64_t hash = 14695981039346656037ULL ^ seed;
+    for (unsigned char c : word) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+int popcount64(uint64_t value) {
+    int count = 0;
+    while (value) {
+        value &= value - 1;
+        ++count;
+    }
+    return count;
+}
+
+} // namespace
+
+NearDuplicateDetector::NearDuplicateDetector(int max_distance)
+    : max_distance_(std::max(0, std::min(max_distance, 15))) {
+    band_count_ = max_distance_ + 1;
+    band_bits_ = 64 / band_count_;
+    bands_.resize(band_count_);
+}
+
+uint64_t NearDuplicateDetector::fingerprint(const std::string& text) {
+    // Lowercased alphanumeric words; punctuation and markup differences vanish
+    std::vector<std::string> words;
+    std::string word;
+    for (unsigned char c : text) {
+        if (std::isalnum(c)) {
+            word += static_cast<char>(std::tolower(c));
+        } else if (!word.empty()) {
+            words.push_back(word);
+            word.clear();
+        }
+    }
+    if (!word.empty()) {
+        words.push_back(word);
+    }
+    if (words.empty()) {
+        return 0;
+    }
+    
+    // Word features: short wire summaries differ by bylines and tag-ons, which
+    // shift far fewer bits with single-word features than with shingles
+    int weights[64] = {0};
+    for (const auto& w : words) {
+        uint64_t hash = hashWord(w, 0);
+        for (int bit = 0; bit < 64; ++bit) {
+            weights[bit] += (hash >> bit) & 1 ? 1 : -1;
+        }
+    }
+    
+    uint64_t fingerprint = 0;
+    for (int bit = 0; bit < 64; ++bit) {
+        if (weights[bit] > 0) {
+            fingerprint |= 1ULL << bit;
+        }
+    }
+    return fingerprint;
+}
+
+uint64_t NearDuplicateDetector::fingerprint(const NewsArticle& article) {
+    return fingerprint(article.title + " " + article.content);
+}
+
+uint64_t NearDuplicateDetector::bandKey(uint64_t fingerprint, int band) const {
+    int shift = band * band_bits_;
+    int bits = band == band_count_ - 1 ? 64 - shift : band_bits_;
+    uint64_t mask = bits >= 64 ? ~0ULL : ((1ULL << bits) - 1);
+    return (fingerprint >> shift) & mask;
+}
+
+bool NearDuplicateDetector::findLocked(uint64_t fingerprint, std::string* duplicate_of) const {
+    for (int band = 0; band < band_count_; ++band) {
+        auto it = bands_[band].find(bandKey(fingerprint, band));
+        if (it == bands_[band].end()) {
+            continue;
+        }
+        for (uint32_t index : it->second) {
+            const Entry& entry = entries_[index];
+            if (popcount64(entry.fingerprint ^ fingerprint) <= max_distance_) {
+                if (duplicate_of) {
+                    *duplicate_of = entry.article_id;
+                }
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void NearDuplicateDetector::insertLocked(uint64_t fingerprint, const std::string& article_id) {
+    uint32_t index = static_cast<uint32_t>(entries_.size());
+    entries_.push_back({fingerprint, article_id});
+    for (int band = 0; band < band_count_; ++band) {
+        bands_[band][bandKey(fingerprint, band)].push_back(index);
+    }
+}
+
+bool NearDuplicateDetector::checkAndInsert(const NewsArticle& article, std::string* duplicate_of) {
+    uint64_t hash = fingerprint(article);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (findLocked(hash, duplicate_of)) {
+        return true;
+    }
+    insertLocked(hash, article.id);
+    return false;
+}
+
+bool NearDuplicateDetector::isDuplicate(const NewsArticle& article, std::string* duplicate_of) {
+    uint64_t hash = fingerprint(article);
+    std::lock_guard<std::mutex> lock(mutex_);
+    return findLocked(hash, duplicate_of);
+}
+
+void NearDuplicateDetector::insert(const NewsArticle& article) {
+    uint64_t hash = fingerprint(article);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!findLocked(hash, nullptr)) {
+        insertLocked(hash, article.id);
+    }
+}
+
+bool NearDuplicateDetector::save(const std::string& filepath) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::string temp_path = filepath + ".tmp";
+    std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        RAG_LOG_ERROR("Failed to open near-duplicate index for writing: " + temp_path);
+        return false;
+    }
+    
+    uint64_t count = entries_.size();
+    file.write(reinterpret_cast<const char*>(&kFileMagic), sizeof(kFileMagic));
+    file.write(reinterpret_cast<const char*>(&kFileVersion), sizeof(kFileVersion));
+    file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    for (const auto& entry : entries_) {
+        uint32_t id_length = static_cast<uint32_t>(entry.article_id.size());
+        file.write(reinterpret_cast<const char*>(&entry.fingerprint), sizeof(entry.fingerprint));
+        file.write(reinterpret_cast<const char*>(&id_length), sizeof(id_length));
+        file.write(entry.article_id.data(), id_length);
+    }
+    file.close();
+    if (!file) {
+        RAG_LOG_ERROR("Failed to write near-duplicate index: " + temp_path);
+        return false;
+    }
+    
+    if (std::rename(temp_path.c_str(), filepath.c_str()) != 0) {
+        RAG_LOG_ERROR("Failed to replace near-duplicate index: " + filepath);
+        return false;
+    }
+    
+    RAG_LOG_INFO("Saved " + std::to_string(count) + " news fingerprints to: " + filepath);
+    return true;
+}
+
+bool NearDuplicateDetector::load(const std::string& filepath) {
+    std::ifstream file(filepath, std::ios::binary);
+    if (!file.is_open()) {
+        RAG_LOG_DEBUG("Near-duplicate index not found (this is normal on first run): " + filepath);
+        return false;
+    }
+    
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    uint64_t count = 0;
+    file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    file.read(reinterpret_cast<char*>(&version), sizeof(version));
+    file.read(reinterpret_cast<char*>(&count), sizeof(count));
+    if (!file || magic != kFileMagic || version != kFileVersion) {
+        RAG_LOG_ERROR("Invalid near-duplicate index file: " + filepath);
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    for (auto& band : bands_) {
+        band.clear();
+    }
+    
+    for (uint64_t i = 0; i < count; ++i) {
+        uint64_t hash = 0;
+        uint32_t id_length = 0;
+        file.read(reinterpret_cast<char*>(&hash), sizeof(hash));
+        file.read(reinterpret_cast<char*>(&id_length), sizeof(id_length));
+        std::string article_id(id_length, '\0');
+        file.read(&article_id[0], id_length);
+        if (!file) {
+            RAG_LOG_WARNING("Near-duplicate index truncated after " + std::to_string(i) + " entries");
+            break;
+        }
+        insertLocked(hash, article_id);
+    }
+    
+    RAG_LOG_INFO("Loaded " + std::to_string(entries_.size()) + " news fingerprints from: " + filepath);
+    return true;
+}
+
+size_t NearDuplicateDetector::size() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+} // namespace data
+} // namespace rag
@@ -0,0 +1,48 @@
+#include "data_ingestion/rate_limiter.h"
+#include <algorithm>
+#include <thread>
+
+namespace rag {
+namespace data {
+
+TokenBucket::TokenBucket(double requests_per_minute, double burst)
+    : rate_per_second_(std::max(requests_per_minute, 1e-6) / 60.0),
+      capacity_(std::max(burst, 1.0)),
+      tokens_(std::max(burst, 1.0)),
+      last_refill_(Clock::now()) {
+}
+
+void TokenBucket::refill(Clock::time_point now) {
+    double elapsed = std::chrono::duration<double>(now - last_refill_).count();
+    tokens_ = std::min(capacity_, tokens_ + elapsed * rate_per_second_);
+    last_refill_ = now;
+}
+
+bool TokenBucket::tryAcquire() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    refill(Clock::now());
+    if (tokens_ >= 1.0) {
+        tokens_ -= 1.0;
+        return true;
+    }
+    return false;
+}
+
+void TokenBucket::acquire() {
+    while (true) {
+        double wait_seconds;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            refill(Clock::now());
+            if (tokens_ >= 1.0) {
+                tokens_ -= 1.0;
+                return;
+            }
+            wait_seconds = (1.0 - tokens_) / rate_per_second_;
+        }
+        std::this_thread::sleep_for(std::chrono::duration<double>(wait_seconds));
+    }
+}
+
+} // namespace data
+} // namespace rag
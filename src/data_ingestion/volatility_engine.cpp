@@ -0,0 +1,279 @@
+#include "data_ingestion/volatility_engine.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <cmath>
+
+namespace rag {
+namespace data {
+
+namespace {
+
+constexpr double kTradingDaysPerYear = 252.0;
+
+double annualize(double variance) {
+    return variance > 0.0 ? std::sqrt(variance * kTradingDaysPerYear) : 0.0;
+}
+
+} // namespace
+
+VolatilityEngine::VolatilityEngine(size_t window, double ewma_lambda,
+                                   std::shared_ptr<Database> database)
+    : window_(std::max<size_t>(window, 2)),
+      ewma_lambda_(ewma_lambda),
+      database_(database) {
+}
+
+bool VolatilityEngine::applyBar(const std::string& symbol, SymbolState& state,
+                                const OHLCVData& bar, VolatilityEstimate& estimate) {
+    if (bar.close <= 0.0 || bar.high <= 0.0 || bar.low <= 0.0 || bar.open <= 0.0) {
+        RAG_LOG_WARNING("Skipping invalid bar for " + symbol + " at " + bar.timestamp);
+        return false;
+    }
+    
+    if (!state.has_last_close) {
+        // First bar only seeds the previous close
+        state.has_last_close = true;
+        state.last_close = bar.close;
+        state.first_timestamp = bar.timestamp;
+        state.last_timestamp = bar.timestamp;
+        estimate = VolatilityEstimate();
+        estimate.date = bar.timestamp;
+        return true;
+    }
+    
+    RangeTerms terms;
+    terms.log_return = std::log(bar.close / state.last_close);
+    double hl = std::log(bar.high / bar.low);
+    double co = std::log(bar.close / bar.open);
+    terms.parkinson = (hl * hl) / (4.0 * std::log(2.0));
+    terms.garman_klass = 0.5 * hl * hl - (2.0 * std::log(2.0) - 1.0) * co * co;
+    
+    // Welford insert
+    state.window.push_back(terms);
+    double n = static_cast<double>(state.window.size());
+    double delta = terms.log_return - state.mean;
+    state.mean += delta / n;
+    state.m2 += delta * (terms.log_return - state.mean);
+    state.parkinson_sum += terms.parkinson;
+    state.garman_klass_sum += terms.garman_klass;
+    
+    // Welford removal of the oldest return once the window is full
+    if (state.window.size() > window_) {
+        RangeTerms oldest = state.window.front();
+        state.window.pop_front();
+        double remaining = static_cast<double>(state.window.size());
+        double old_delta = oldest.log_return - state.mean;
+        state.mean -= old_delta / remaining;
+        state.m2 -= old_delta * (oldest.log_return - state.mean);
+        state.parkinson_sum -= oldest.parkinson;
+        state.garman_klass_sum -= oldest.garman_klass;
+    }
+    state.m2 = std::max(state.m2, 0.0);
+    
+    double squared_return = terms.log_return * terms.log_return;
+    if (!state.has_ewma) {
+        state.ewma_variance = squared_return;
+        state.has_ewma = true;
+    } else {
+        state.ewma_variance = ewma_lambda_ * state.ewma_variance + (1.0 - ewma_lambda_) * squared_return;
+    }
+    
+    size_t count = state.window.size();
+    estimate.date = bar.timestamp;
+    estimate.observations = count;
+    estimate.close_to_close = count > 1 ? annualize(state.m2 / static_cast<double>(count - 1)) : 0.0;
+    estimate.ewma = annualize(state.ewma_variance);
+    estimate.parkinson = annualize(state.parkinson_sum / static_cast<double>(count));
+    estimate.garman_klass = annualize(state.garman_klass_sum / static_cast<double>(count));
+    
+    state.last_close = bar.close;
+    state.last_timestamp = bar.timestamp;
+    state.history[bar.timestamp] = estimate;
+    return true;
+}
+
+bool VolatilityEngine::update(const std::string& symbol, const OHLCVData& bar,
+                              VolatilityEstimate* estimate) {
+    VolatilityEstimate result;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        SymbolState& state = states_[symbol];
+        if (state.has_last_close && bar.timestamp <= state.last_timestamp) {
+            return false;
+        }
+        if (!applyBar(symbol, state, bar, result)) {
+            return false;
+        }
+    }
+    
+    if (database_ && result.observations > 1) {
+        database_->storeVolatility(symbol, result.date, result.close_to_close);
+    }
+    if (estimate) {
+        *estimate = result;
+    }
+    return true;
+}
+
+size_t VolatilityEngine::backfill(const std::string& symbol, SymbolState& state,
+                                  const std::vector<const OHLCVData*>& ordered,
+                                  std::vector<std::pair<std::string, double>>& to_persist) {
+    // The rolling state only moves forward, so replay the batch from its
+    // start into a fresh state up to the newest bar already applied
+    SymbolState rebuilt;
+    size_t applied = 0;
+    bool reaches_last = false;
+    for (const OHLCVData* bar : ordered) {
+        if (bar->timestamp > state.last_timestamp) {
+            break;
+        }
+        VolatilityEstimate estimate;
+        if (!applyBar(symbol, rebuilt, *bar, estimate)) {
+            continue;
+        }
+        if (bar->timestamp < state.first_timestamp) {
+            ++applied;
+        }
+        reaches_last = bar->timestamp == state.last_timestamp;
+    }
+    if (!rebuilt.has_last_close) {
+        return 0;
+    }
+    
+    if (reaches_last) {
+        // The batch spans everything seen: its windows include the older
+        // bars, so its estimates and state replace the current ones
+        for (const auto& [date, estimate] : rebuilt.history) {
+            if (estimate.observations > 1) {
+                to_persist.emplace_back(date, estimate.close_to_close);
+            }
+        }
+        rebuilt.history.insert(state.history.begin(), state.history.end());
+        rebuilt.full_history = state.full_history;
+        state = std::move(rebuilt);
+    } else {
+        // The batch ends before the newest bar: its estimates replace those
+        // up to its end (which had shorter windows), later ones are kept
+        for (const auto& [date, estimate] : rebuilt.history) {
+            state.history[date] = estimate;
+            if (estimate.observations > 1) {
+                to_persist.emplace_back(date, estimate.close_to_close);
+            }
+        }
+        state.first_timestamp = rebuilt.first_timestamp;
+    }
+    RAG_LOG_DEBUG("Backfilled " + std::to_string(applied) + " older bars for " + symbol);
+    return applied;
+}
+
+size_t VolatilityEngine::updateSeries(const std::string& symbol, const std::vector<OHLCVData>& bars,
+                                      bool complete) {
+    // Providers return newest-first; the engine needs chronological order
+    std::vector<const OHLCVData*> ordered;
+    ordered.reserve(bars.size());
+    for (const auto& bar : bars) {
+        ordered.push_back(&bar);
+    }
+    std::sort(ordered.begin(), ordered.end(), [](const OHLCVData* a, const OHLCVData* b) {
+        return a->timestamp < b->timestamp;
+    });
+    
+    std::vector<std::pair<std::string, double>> to_persist;
+    size_t applied = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        SymbolState& state = states_[symbol];
+        if (state.has_last_close && !ordered.empty() && ordered.front()->timestamp < state.first_timestamp) {
+            applied += backfill(symbol, state, ordered, to_persist);
+        }
+        for (const OHLCVData* bar : ordered) {
+            if (state.has_last_close && bar->timestamp <= state.last_timestamp) {
+                continue;
+            }
+            VolatilityEstimate estimate;
+            if (applyBar(symbol, state, *bar, estimate)) {
+                ++applied;
+                if (estimate.observations > 1) {
+                    to_persist.emplace_back(estimate.date, estimate.close_to_close);
+                }
+            }
+        }
+        state.full_history = state.full_history || complete;
+    }
+    
+    if (database_ && !to_persist.empty()) {
+        database_->storeVolatilitySeries(symbol, to_persist);
+    }
+    
+    RAG_LOG_DEBUG("Applied " + std::to_string(applied) + " bars to volatility engine for " + symbol);
+    return applied;
+}
+
+bool VolatilityEngine::getEstimate(const std::string& symbol, const std::string& date,
+                                   VolatilityEstimate& estimate) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto state_it = states_.find(symbol);
+    if (state_it == states_.end() || state_it->second.history.empty()) {
+        return false;
+    }
+    
+    const auto& history = state_it->second.history;
+    if (date.empty()) {
+        estimate = history.rbegin()->second;
+        return true;
+    }
+    
+    // Latest estimate on or before the requested date
+    auto it = history.upper_bound(date);
+    if (it == history.begin()) {
+        return false;
+    }
+    --it;
+    estimate = it->second;
+    return true;
+}
+
+bool VolatilityEngine::getVolatility(const std::string& symbol, const std::string& date,
+                                     double& volatility) {
+    VolatilityEstimate estimate;
+    if (getEstimate(symbol, date, estimate) && estimate.observations > 1 &&
+        (date.empty() || estimate.date == date || lastTimestamp(symbol) > date)) {
+        volatility = estimate.close_to_close;
+        return true;
+    }
+    
+    // Fall back to values persisted by a previous run
+    if (database_ && !date.empty()) {
+        return database_->getVolatility(symbol, date, volatility);
+    }
+    return false;
+}
+
+std::string VolatilityEngine::lastTimestamp(const std::string& symbol) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = states_.find(symbol);
+    return it != states_.end() ? it->second.last_timestamp : std::string();
+}
+
+std::string VolatilityEngine::firstEstimateDate(const std::string& symbol) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = states_.find(symbol);
+    if (it == states_.end()) {
+        return std::string();
+    }
+    for (const auto& [date, estimate] : it->second.history) {
+        if (estimate.observations > 1) {
+            return date;
+        }
+    }
+    return std::string();
+}
+
+bool VolatilityEngine::hasFullHistory(const std::string& symbol) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = states_.find(symbol);
+    return it != states_.end() && it->second.full_history;
+}
+
+} // namespace data
+} // namespace rag
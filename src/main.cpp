@@ -7,15 +7,50 @@
 #include "vectorization/faiss_index.h"
 #include "rag/rag_agent.h"
 #include "api/grpc_server.h"
+#include "data_ingestion/ingestion_pipeline.h"
+#include "data_ingestion/market_data_stream.h"
+#include "vectorization/tokenizer.h"
 #include <cstdlib>
+#include <curl/curl.h>
+#include <fstream>
+#include <sstream>
 #include "utils/logger.h"
+#include "utils/metrics.h"
+#include "utils/metrics_server.h"
+#include "utils/tracing.h"
+#include "utils/http_client.h"
+
+// Parse "AAPL,MSFT,..." or "@path/to/symbols.txt" (one symbol per line)
+static std::vector<std::string> parseSymbolList(const std::string& arg) {
+    std::vector<std::string> symbols;
+    std::string symbol;
+    if (!arg.empty() && arg[0] == '@') {
+        std::ifstream file(arg.substr(1));
+        while (std::getline(file, symbol)) {
+            if (!symbol.empty()) {
+                symbols.push_back(symbol);
+            }
+        }
+    } else {
+        std::stringstream ss(arg);
+        while (std::getline(ss, symbol, ',')) {
+            if (!symbol.empty()) {
+                symbols.push_back(symbol);
+            }
+        }
+    }
+    return symbols;
+}
 
 int main(int argc, char** argv) {
     // Initialize logger
     rag::utils::Logger::getInstance().setLogLevel(rag::utils::LogLevel::INFO);
     rag::utils::Logger::getInstance().setLogFile("logs/rag_agent.log");
     
-    rag::utils::Logger::getInstance().info("Starting RAG Quant Trading Agent Server");
+    RAG_LOG_INFO("Starting RAG Quant Trading Agent Server");
+    
+    // libcurl global state must be set up before any worker threads start
+    curl_global_init(CURL_GLOBAL_DEFAULT);
     
     // Configuration (in production, load from config file or environment variables)
     std::string data_api_key = std::getenv("ALPHA_VANTAGE_API_KEY") ? std::getenv("ALPHA_VANTAGE_API_KEY") : "";
@@ -23,44 +58,247 @@ int main(int argc, char** argv) {
     std::string llm_api_key = std::getenv("OPENAI_API_KEY") ? std::getenv("OPENAI_API_KEY") : "";
     std::string db_path = "data/trading_data.db";
     std::string faiss_index_path = "data/faiss_index.index";
+    std::string news_fingerprints_path = "data/news_simhash.bin";
     std::string server_address = "0.0.0.0:50051";
     
+    // Arrow IPC modes (no API keys needed):
+    //   rag_agent_server --export ohlcv|intraday_bars|news|options PATH [SYMBOL]
+    //   rag_agent_server --import ohlcv|intraday_bars|news|options PATH
+    if (argc >= 4 && (std::string(argv[1]) == "--export" || std::string(argv[1]) == "--import")) {
+        rag::data::Database database(db_path);
+        size_t rows = 0;
+        bool ok = database.initialize();
+        if (ok && std::string(argv[1]) == "--export") {
+            rag::data::ArrowExportOptions options;
+            options.symbol = argc >= 5 ? argv[4] : "";
+            ok = database.exportArrow(argv[2], argv[3], options, rows);
+        } else if (ok) {
+            ok = database.importArrow(argv[2], argv[3], rows);
+        }
+        std::cout << (ok ? std::to_string(rows) + " rows" : "failed") << std::endl;
+        curl_global_cleanup();
+        return ok ? 0 : 1;
+    }
+    
     if (data_api_key.empty() || embedding_api_key.empty() || llm_api_key.empty()) {
-        rag::utils::Logger::getInstance().error("API keys not set. Please set ALPHA_VANTAGE_API_KEY and OPENAI_API_KEY environment variables.");
+        RAG_LOG_ERROR("API keys not set. Please set ALPHA_VANTAGE_API_KEY and OPENAI_API_KEY environment variables.");
         return 1;
     }
     
+    // Endpoint overrides (e.g. a local mock server for load tests)
+    std::string data_base_url = std::getenv("ALPHA_VANTAGE_BASE_URL") ? std::getenv("ALPHA_VANTAGE_BASE_URL") : "";
+    std::string openai_base_url = std::getenv("OPENAI_BASE_URL") ? std::getenv("OPENAI_BASE_URL") : "";
+    
+    // Exact BPE token counts for chunking and prompt budgets (e.g. cl100k_base.tiktoken)
+    if (std::getenv("TOKENIZER_BPE_FILE")) {
+        rag::vectorization::Tokenizer::loadBpeRanks(std::getenv("TOKENIZER_BPE_FILE"));
+    }
+    
+    // Outbound HTTP resilience: retries on 429/5xx, p95 hedging, circuit breakers
+    rag::utils::ResilienceConfig resilience;
+    if (std::getenv("HTTP_MAX_RETRIES")) {
+        resilience.max_retries = std::atoi(std::getenv("HTTP_MAX_RETRIES"));
+    }
+    if (std::getenv("HTTP_HEDGING")) {
+        resilience.hedging = std::string(std::getenv("HTTP_HEDGING")) != "0";
+    }
+    rag::utils::HttpClient::getInstance().configure(resilience);
+    if (std::getenv("HTTP_TLS_VERIFY") && std::string(std::getenv("HTTP_TLS_VERIFY")) == "0") {
+        RAG_LOG_WARNING("HTTP_TLS_VERIFY=0: server certificates are not verified");
+        rag::utils::HttpEngine::getInstance().setVerifyTls(false);
+    }
+    
     // Initialize components
     auto data_fetcher = std::make_shared<rag::data::DataFetcher>(data_api_key);
+    if (!data_base_url.empty()) {
+        data_fetcher->setBaseUrl(data_base_url);
+    }
     auto database = std::make_shared<rag::data::Database>(db_path);
     
     if (!database->initialize()) {
-        rag::utils::Logger::getInstance().error("Failed to initialize database");
+        RAG_LOG_ERROR("Failed to initialize database");
         return 1;
     }
     
-    auto embedding_service = std::make_shared<rag::vectorization::EmbeddingService>(embedding_api_key, "openai");
-    auto faiss_index = std::make_shared<rag::vectorization::FAISSIndex>(1536); // OpenAI embedding dimension
+    // EMBEDDING_PROVIDER=local embeds on CPU from LOCAL_EMBEDDING_MODEL; vectors from
+    // different providers are not comparable, so switching needs a fresh FAISS index
+    std::string embedding_provider = std::getenv("EMBEDDING_PROVIDER") ? std::getenv("EMBEDDING_PROVIDER") : "openai";
+    auto embedding_service = std::make_shared<rag::vectorization::EmbeddingService>(embedding_api_key, embedding_provider);
+    if (!openai_base_url.empty()) {
+        embedding_service->setBaseUrl(openai_base_url);
+    }
+    // EMBEDDING_BASE64=0 for OpenAI-compatible servers without encoding_format support
+    if (std::getenv("EMBEDDING_BASE64")) {
+        embedding_service->setBase64Encoding(std::string(std::getenv("EMBEDDING_BASE64")) != "0");
+    }
+    if (embedding_provider == "local") {
+        std::string model_path = std::getenv("LOCAL_EMBEDDING_MODEL") ? std::getenv("LOCAL_EMBEDDING_MODEL") : "models/static_embeddings.bin";
+        if (!embedding_service->loadLocalModel(model_path)) {
+            RAG_LOG_ERROR("Failed to load local embedding model: " + model_path);
+            return 1;
+        }
+    }
+    auto faiss_index = std::make_shared<rag::vectorization::FAISSIndex>(embedding_service->getEmbeddingDimension());
     
     if (!faiss_index->initialize()) {
-        rag::utils::Logger::getInstance().error("Failed to initialize FAISS index");
+        RAG_LOG_ERROR("Failed to initialize FAISS index");
         return 1;
     }
     
     // Try to load existing index (non-critical if file doesn't exist)
     if (!faiss_index->load(faiss_index_path)) {
-        rag::utils::Logger::getInstance().info("No existing FAISS index found. New index will be created when data is ingested.");
+        RAG_LOG_INFO("No existing FAISS index found. New index will be created when data is ingested.");
+    }
+    
+    // Index changes are logged to data/faiss_index.index.wal and survive a
+    // restart without a full save (FAISS_WAL=0 disables, FAISS_WAL_SYNC=0
+    // skips fdatasync and relies on the OS to flush)
+    if (!std::getenv("FAISS_WAL") || std::string(std::getenv("FAISS_WAL")) != "0") {
+        bool wal_sync = !std::getenv("FAISS_WAL_SYNC") || std::string(std::getenv("FAISS_WAL_SYNC")) != "0";
+        if (!faiss_index->openWal(faiss_index_path, wal_sync)) {
+            RAG_LOG_ERROR("Failed to open FAISS index WAL");
+            return 1;
+        }
+        
+        // Background checkpoints fold the WAL into the saved index without
+        // pausing searches (FAISS_CHECKPOINT_SECONDS=0 disables)
+        rag::vectorization::CheckpointOptions checkpoint_options;
+        if (std::getenv("FAISS_CHECKPOINT_SECONDS")) {
+            checkpoint_options.interval = std::chrono::seconds(std::atoll(std::getenv("FAISS_CHECKPOINT_SECONDS")));
+        }
+        if (std::getenv("FAISS_CHECKPOINT_WAL_MB")) {
+            checkpoint_options.wal_bytes = static_cast<uint64_t>(std::atoll(std::getenv("FAISS_CHECKPOINT_WAL_MB"))) << 20;
+        }
+        if (checkpoint_options.interval.count() > 0) {
+            faiss_index->startCheckpointer(faiss_index_path, checkpoint_options);
+        }
     }
     
     // Create RAG agent
     auto rag_agent = std::make_shared<rag::agent::RAGAgent>(
         data_fetcher, database, embedding_service, faiss_index, llm_api_key
     );
+    if (!openai_base_url.empty()) {
+        rag_agent->setLLMBaseUrl(openai_base_url);
+    }
+    
+    // Prometheus metrics (METRICS_PORT=0 disables)
+    auto& metrics = rag::utils::MetricsRegistry::getInstance();
+    metrics.gaugeCallback("rag_vector_index_documents", "Documents in the vector index",
+                          [faiss_index]() { return static_cast<double>(faiss_index->size()); });
+    metrics.gaugeCallback("rag_log_dropped_messages", "Log messages dropped because the log buffer was full",
+                          []() { return static_cast<double>(rag::utils::Logger::getInstance().droppedCount()); });
+    int metrics_port = std::getenv("METRICS_PORT") ? std::atoi(std::getenv("METRICS_PORT")) : 9464;
+    rag::utils::MetricsServer metrics_server("0.0.0.0", metrics_port);
+    if (metrics_port > 0) {
+        metrics_server.start();
+    }
+    
+    // Request tracing (TRACE_FILE unset disables)
+    if (std::getenv("TRACE_FILE")) {
+        rag::utils::TracingConfig tracing_config;
+        if (std::getenv("TRACE_SAMPLE_RATE")) {
+            tracing_config.sample_rate = std::atof(std::getenv("TRACE_SAMPLE_RATE"));
+        }
+        if (std::getenv("TRACE_SLOW_MS")) {
+            tracing_config.slow_threshold_ms = std::atoll(std::getenv("TRACE_SLOW_MS"));
+        }
+        rag::utils::Tracer::getInstance().configure(
+            tracing_config, std::make_shared<rag::utils::OtlpFileExporter>(std::getenv("TRACE_FILE")));
+    }
+    
+    // Near-duplicate news fingerprints, shared by bulk ingestion and the watchlist monitor
+    auto duplicate_detector = std::make_shared<rag::data::NearDuplicateDetector>();
+    duplicate_detector->load(news_fingerprints_path);
+    
+    // Bulk ingestion mode: rag_agent_server --ingest AAPL,MSFT,... | @symbols.txt
+    if (argc >= 3 && std::string(argv[1]) == "--ingest") {
+        rag::data::IngestionConfig ingestion_config;
+        ingestion_config.base_url = data_base_url;
+        if (std::getenv("ALPHA_VANTAGE_REQUESTS_PER_MINUTE")) {
+            ingestion_config.requests_per_minute = std::atof(std::getenv("ALPHA_VANTAGE_REQUESTS_PER_MINUTE"));
+        }
+        
+        rag::data::IngestionPipeline pipeline(data_api_key, database, embedding_service, faiss_index, ingestion_config);
+        pipeline.setVolatilityEngine(rag_agent->volatilityEngine());
+        pipeline.setNearDuplicateDetector(duplicate_detector);
+        
+        rag::data::IngestionStats stats;
+        bool ok = pipeline.run(parseSymbolList(argv[2]), stats);
+        faiss_index->save(faiss_index_path);
+        duplicate_detector->save(news_fingerprints_path);
+        curl_global_cleanup();
+        return ok ? 0 : 1;
+    }
+    
+    // Lexical news index for hybrid retrieval (LEXICAL_INDEX=0 disables)
+    std::shared_ptr<rag::vectorization::InvertedIndex> lexical_index;
+    if (!std::getenv("LEXICAL_INDEX") || std::string(std::getenv("LEXICAL_INDEX")) != "0") {
+        lexical_index = std::make_shared<rag::vectorization::InvertedIndex>();
+        if (lexical_index->build(*database)) {
+            rag_agent->setLexicalIndex(lexical_index);
+        } else {
+            lexical_index.reset();
+        }
+    }
+    
+    // Streaming market data: MARKET_FEED=tcp://host:port, ws://host:port/path or replay:file[@speed]
+    std::shared_ptr<rag::data::MarketDataStream> market_stream;
+    if (std::getenv("MARKET_FEED")) {
+        std::string subscribe = std::getenv("MARKET_FEED_SUBSCRIBE") ? std::getenv("MARKET_FEED_SUBSCRIBE") : "";
+        auto feed = rag::data::createMarketFeed(std::getenv("MARKET_FEED"), subscribe);
+        if (feed) {
+            rag::data::MarketStreamConfig stream_config;
+            if (std::getenv("MARKET_BAR_SECONDS")) {
+                stream_config.bar_seconds = std::atoi(std::getenv("MARKET_BAR_SECONDS"));
+            }
+            market_stream = std::make_shared<rag::data::MarketDataStream>(std::move(feed), database, stream_config);
+            market_stream->start();
+            rag_agent->setMarketDataStream(market_stream);
+            metrics.gaugeCallback("rag_market_ticks", "Ticks received from the market feed",
+                                  [market_stream]() { return static_cast<double>(market_stream->stats().ticks); });
+            metrics.gaugeCallback("rag_market_bars_stored", "Intraday bars stored from the market feed",
+                                  [market_stream]() { return static_cast<double>(market_stream->stats().bars_stored); });
+            metrics.gaugeCallback("rag_market_feed_reconnects", "Market feed reconnections",
+                                  [market_stream]() { return static_cast<double>(market_stream->stats().reconnects); });
+        } else {
+            RAG_LOG_ERROR(std::string("Unrecognized MARKET_FEED: ") + std::getenv("MARKET_FEED"));
+        }
+    }
+    
+    // Watchlist subscriptions (WATCHLIST_MONITOR=0 disables)
+    std::shared_ptr<rag::agent::WatchlistMonitor> watchlist_monitor;
+    if (!std::getenv("WATCHLIST_MONITOR") || std::string(std::getenv("WATCHLIST_MONITOR")) != "0") {
+        rag::agent::WatchlistMonitorConfig monitor_config;
+        if (std::getenv("WATCHLIST_QUOTE_SECONDS")) {
+            monitor_config.quote_interval_seconds = std::atoi(std::getenv("WATCHLIST_QUOTE_SECONDS"));
+        }
+        if (std::getenv("WATCHLIST_NEWS_SECONDS")) {
+            monitor_config.news_interval_seconds = std::atoi(std::getenv("WATCHLIST_NEWS_SECONDS"));
+        }
+        if (std::getenv("WATCHLIST_PRICE_THRESHOLD")) {
+            monitor_config.price_threshold_percent = std::atof(std::getenv("WATCHLIST_PRICE_THRESHOLD"));
+        }
+        if (std::getenv("WATCHLIST_MAX_SUBSCRIPTIONS")) {
+            monitor_config.max_subscriptions = std::strtoul(std::getenv("WATCHLIST_MAX_SUBSCRIPTIONS"), nullptr, 10);
+        }
+        watchlist_monitor = std::make_shared<rag::agent::WatchlistMonitor>(
+            data_fetcher, database, embedding_service, faiss_index, rag_agent->volatilityEngine(), monitor_config);
+        watchlist_monitor->setLexicalIndex(lexical_index);
+        watchlist_monitor->setMarketDataStream(market_stream);
+        watchlist_monitor->setNearDuplicateDetector(duplicate_detector, news_fingerprints_path);
+        watchlist_monitor->start();
+        rag_agent->setWatchlistMonitor(watchlist_monitor);
+        metrics.gaugeCallback("rag_watchlist_subscriptions", "Open watchlist subscriptions",
+                              [watchlist_monitor]() { return static_cast<double>(watchlist_monitor->subscriptionCount()); });
+        metrics.gaugeCallback("rag_watchlist_symbols", "Symbols watched across all subscriptions",
+                              [watchlist_monitor]() { return static_cast<double>(watchlist_monitor->symbolCount()); });
+    }
     
-    rag::utils::Logger::getInstance().info("RAG Agent initialized successfully");
+    RAG_LOG_INFO("RAG Agent initialized successfully");
     
     // Start gRPC server
-    rag::utils::Logger::getInstance().info("Starting gRPC server on " + server_address);
+    RAG_LOG_INFO("Starting gRPC server on " + server_address);
     RunServer(server_address, rag_agent);
     
     return 0;
@@ -1,5 +1,9 @@
 #include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
 #include <pybind11/stl.h>
+#include <climits>
+#include <cstdio>
+#include <stdexcept>
 #include "rag/rag_agent.h"
 #include "data_ingestion/data_fetcher.h"
 #include "data_ingestion/database.h"
@@ -8,51 +12,368 @@
 
 namespace py = pybind11;
 
+using rag::agent::RAGAgent;
+using rag::agent::RAGContextDoc;
+using rag::data::DataFetcher;
+using rag::data::Database;
+using rag::data::NewsArticle;
+using rag::data::OHLCVData;
+using rag::vectorization::CheckpointOptions;
+using rag::vectorization::Document;
+using rag::vectorization::EmbeddingService;
+using rag::vectorization::FAISSIndex;
+using rag::vectorization::SearchResult;
+
+namespace {
+
+// Any array-like is accepted; a C-contiguous float32 array is used in place,
+// anything else is converted once
+using FloatMatrix = py::array_t<float, py::array::c_style | py::array::forcecast>;
+
+// Hands a vector's buffer to NumPy: the array owns the vector, nothing is copied
+template <typename T>
+py::array adoptVector(std::vector<T>&& values, std::vector<py::ssize_t> shape, const py::dtype& dtype) {
+    auto* owned = new std::vector<T>(std::move(values));
+    py::capsule release(owned, [](void* vector) { delete static_cast<std::vector<T>*>(vector); });
+    return py::array(dtype, std::move(shape), owned->data(), release);
+}
+
+template <typename T>
+py::array adoptVector(std::vector<T>&& values, std::vector<py::ssize_t> shape) {
+    return adoptVector(std::move(values), std::move(shape), py::dtype::of<T>());
+}
+
+// Rows of an (N, dimension) matrix; ValueError for any other shape
+size_t matrixRows(const FloatMatrix& matrix, size_t dimension, const char* name) {
+    if (matrix.ndim() != 2 || static_cast<size_t>(matrix.shape(1)) != dimension) {
+        throw py::value_error(std::string(name) + " must have shape (N, " + std::to_string(dimension) + ")");
+    }
+    return static_cast<size_t>(matrix.shape(0));
+}
+
+// "YYYY-MM-DD[ HH:MM:SS]" (UTC) to Unix seconds; NaT's value if unparseable
+int64_t epochSeconds(const std::string& timestamp) {
+    int year = 0, month = 0, day = 0, hour = 0, minute = 0, second = 0;
+    if (std::sscanf(timestamp.c_str(), "%d-%d-%d %d:%d:%d", &year, &month, &day, &hour, &minute, &second) < 3) {
+        return INT64_MIN;
+    }
+    // Days from the civil date (proleptic Gregorian)
+    year -= month <= 2;
+    int64_t era = (year >= 0 ? year : year - 399) / 400;
+    int64_t year_of_era = year - era * 400;
+    int64_t day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int64_t day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    int64_t days = era * 146097 + day_of_era - 719468;
+    return days * 86400 + hour * 3600 + minute * 60 + second;
+}
+
+// Bars as NumPy columns, ready for pandas.DataFrame: timestamp
+// (datetime64[s]), open/high/low/close (float64) and volume (int64)
+py::dict barColumns(const std::vector<OHLCVData>& bars) {
+    size_t n = bars.size();
+    std::vector<int64_t> timestamps(n), volumes(n);
+    std::vector<double> open(n), high(n), low(n), close(n);
+    for (size_t i = 0; i < n; ++i) {
+        timestamps[i] = epochSeconds(bars[i].timestamp);
+        open[i] = bars[i].open;
+        high[i] = bars[i].high;
+        low[i] = bars[i].low;
+        close[i] = bars[i].close;
+        volumes[i] = bars[i].volume;
+    }
+    
+    py::ssize_t rows = static_cast<py::ssize_t>(n);
+    py::dict columns;
+    columns["timestamp"] = adoptVector(std::move(timestamps), {rows}, py::dtype("datetime64[s]"));
+    columns["open"] = adoptVector(std::move(open), {rows});
+    columns["high"] = adoptVector(std::move(high), {rows});
+    columns["low"] = adoptVector(std::move(low), {rows});
+    columns["close"] = adoptVector(std::move(close), {rows});
+    columns["volume"] = adoptVector(std::move(volumes), {rows});
+    return columns;
+}
+
+void check(bool ok, const std::string& what) {
+    if (!ok) {
+        throw std::runtime_error(what + " failed");
+    }
+}
+
+} // namespace
+
+// Calls that wait on the network, SQLite or an index search release the GIL,
+// so Python threads can run them in parallel
 PYBIND11_MODULE(rag_agent_py, m) {
     m.doc() = "RAG Quant Trading Agent Python Bindings";
     
+    py::class_<OHLCVData>(m, "OHLCVData")
+        .def(py::init<>())
+        .def_readwrite("timestamp", &OHLCVData::timestamp)
+        .def_readwrite("open", &OHLCVData::open)
+        .def_readwrite("high", &OHLCVData::high)
+        .def_readwrite("low", &OHLCVData::low)
+        .def_readwrite("close", &OHLCVData::close)
+        .def_readwrite("volume", &OHLCVData::volume);
+    
+    py::class_<NewsArticle>(m, "NewsArticle")
+        .def(py::init<>())
+        .def_readwrite("id", &NewsArticle::id)
+        .def_readwrite("title", &NewsArticle::title)
+        .def_readwrite("content", &NewsArticle::content)
+        .def_readwrite("source", &NewsArticle::source)
+        .def_readwrite("published_time", &NewsArticle::published_time)
+        .def_readwrite("tickers", &NewsArticle::tickers);
+    
+    py::class_<Document>(m, "Document")
+        .def(py::init<>())
+        .def_readwrite("doc_id", &Document::doc_id)
+        .def_readwrite("content", &Document::content)
+        .def_readwrite("source", &Document::source)
+        .def_readwrite("timestamp", &Document::timestamp)
+        .def_readwrite("metadata", &Document::metadata);
+    
+    py::class_<SearchResult>(m, "SearchResult")
+        .def_readonly("doc_id", &SearchResult::doc_id)
+        .def_readonly("content", &SearchResult::content)
+        .def_readonly("source", &SearchResult::source)
+        .def_readonly("timestamp", &SearchResult::timestamp)
+        .def_readonly("similarity_score", &SearchResult::similarity_score)
+        .def_readonly("metadata", &SearchResult::metadata);
+    
+    py::class_<RAGContextDoc>(m, "RAGContextDoc")
+        .def_readonly("doc_id", &RAGContextDoc::doc_id)
+        .def_readonly("content", &RAGContextDoc::content)
+        .def_readonly("source", &RAGContextDoc::source)
+        .def_readonly("timestamp", &RAGContextDoc::timestamp)
+        .def_readonly("similarity_score", &RAGContextDoc::similarity_score)
+        .def_readonly("metadata", &RAGContextDoc::metadata);
+    
     // DataFetcher
-    py::class_<rag::data::DataFetcher, std::shared_ptr<rag::data::DataFetcher>>(m, "DataFetcher")
+    py::class_<DataFetcher, std::shared_ptr<DataFetcher>>(m, "DataFetcher")
         .def(py::init<const std::string&>())
-        .def("fetch_stock_data", &rag::data::DataFetcher::fetchStockData)
-        .def("fetch_real_time_quote", &rag::data::DataFetcher::fetchRealTimeQuote)
-        .def("fetch_news", &rag::data::DataFetcher::fetchNews);
+        .def("set_base_url", &DataFetcher::setBaseUrl)
+        .def("fetch_stock_data", [](DataFetcher& fetcher, const std::string& symbol, const std::string& interval,
+                                    int days) {
+            std::vector<OHLCVData> bars;
+            bool ok;
+            {
+                py::gil_scoped_release release;
+                ok = fetcher.fetchStockData(symbol, interval, days, bars);
+            }
+            check(ok, "fetch_stock_data");
+            return barColumns(bars);
+        }, py::arg("symbol"), py::arg("interval") = "daily", py::arg("days") = 100,
+           "Bars as a dict of NumPy columns (timestamp, open, high, low, close, volume)")
+        .def("fetch_real_time_quote", [](DataFetcher& fetcher, const std::string& symbol) {
+            double price = 0.0, change_percent = 0.0;
+            bool ok;
+            {
+                py::gil_scoped_release release;
+                ok = fetcher.fetchRealTimeQuote(symbol, price, change_percent);
+            }
+            check(ok, "fetch_real_time_quote");
+            return py::make_tuple(price, change_percent);
+        }, py::arg("symbol"), "(price, change_percent)")
+        .def("fetch_news", [](DataFetcher& fetcher, const std::string& symbol, int max_articles) {
+            std::vector<NewsArticle> articles;
+            bool ok;
+            {
+                py::gil_scoped_release release;
+                ok = fetcher.fetchNews(symbol, max_articles, articles);
+            }
+            check(ok, "fetch_news");
+            return articles;
+        }, py::arg("symbol"), py::arg("max_articles") = 10);
     
     // Database
-    py::class_<rag::data::Database, std::shared_ptr<rag::data::Database>>(m, "Database")
+    py::class_<Database, std::shared_ptr<Database>>(m, "Database")
         .def(py::init<const std::string&>())
-        .def("initialize", &rag::data::Database::initialize)
-        .def("store_ohlcv_data", &rag::data::Database::storeOHLCVData)
-        .def("get_ohlcv_data", &rag::data::Database::getOHLCVData)
-        .def("store_news_article", &rag::data::Database::storeNewsArticle)
-        .def("get_news_articles", &rag::data::Database::getNewsArticles);
+        .def("initialize", &Database::initialize)
+        .def("store_ohlcv_data", &Database::storeOHLCVData, py::call_guard<py::gil_scoped_release>())
+        .def("get_ohlcv_data", [](Database& database, const std::string& symbol, const std::string& start_date,
+                                  const std::string& end_date) {
+            std::vector<OHLCVData> bars;
+            bool ok;
+            {
+                py::gil_scoped_release release;
+                ok = database.getOHLCVData(symbol, start_date, end_date, bars);
+            }
+            check(ok, "get_ohlcv_data");
+            return barColumns(bars);
+        }, py::arg("symbol"), py::arg("start_date"), py::arg("end_date"),
+           "Bars as a dict of NumPy columns (timestamp, open, high, low, close, volume)")
+        .def("get_intraday_bars", [](Database& database, const std::string& symbol, const std::string& start_time,
+                                     const std::string& end_time) {
+            std::vector<OHLCVData> bars;
+            bool ok;
+            {
+                py::gil_scoped_release release;
+                ok = database.getIntradayBars(symbol, start_time, end_time, bars);
+            }
+            check(ok, "get_intraday_bars");
+            return barColumns(bars);
+        }, py::arg("symbol"), py::arg("start_time"), py::arg("end_time"))
+        .def("store_news_article", &Database::storeNewsArticle, py::call_guard<py::gil_scoped_release>())
+        .def("store_news_articles", &Database::storeNewsArticles, py::call_guard<py::gil_scoped_release>())
+        .def("get_news_articles", [](Database& database, const std::string& symbol, int limit) {
+            std::vector<NewsArticle> articles;
+            bool ok;
+            {
+                py::gil_scoped_release release;
+                ok = database.getNewsArticles(symbol, limit, articles);
+            }
+            check(ok, "get_news_articles");
+            return articles;
+        }, py::arg("symbol"), py::arg("limit") = 50);
     
     // EmbeddingService
-    py::class_<rag::vectorization::EmbeddingService, std::shared_ptr<rag::vectorization::EmbeddingService>>(m, "EmbeddingService")
+    py::class_<EmbeddingService, std::shared_ptr<EmbeddingService>>(m, "EmbeddingService")
         .def(py::init<const std::string&, const std::string&>())
-        .def("generate_embedding", &rag::vectorization::EmbeddingService::generateEmbedding)
-        .def("generate_embeddings", &rag::vectorization::EmbeddingService::generateEmbeddings);
+        .def("set_base_url", &EmbeddingService::setBaseUrl)
+        .def_property_readonly("dimension", &EmbeddingService::getEmbeddingDimension)
+        .def("generate_embedding", [](EmbeddingService& service, const std::string& text) {
+            std::vector<float> embedding;
+            bool ok;
+            {
+                py::gil_scoped_release release;
+                ok = service.generateEmbedding(text, embedding);
+            }
+            check(ok, "generate_embedding");
+            py::ssize_t dimension = static_cast<py::ssize_t>(embedding.size());
+            return adoptVector(std::move(embedding), {dimension});
+        }, py::arg("text"), "float32 array of shape (D,)")
+        .def("generate_embeddings", [](EmbeddingService& service, const std::vector<std::string>& texts) {
+            std::vector<float> matrix;
+            bool ok;
+            {
+                py::gil_scoped_release release;
+                ok = service.generateEmbeddingMatrix(texts, matrix);
+            }
+            check(ok, "generate_embeddings");
+            py::ssize_t rows = static_cast<py::ssize_t>(texts.size());
+            py::ssize_t dimension = rows > 0 ? static_cast<py::ssize_t>(matrix.size()) / rows : 0;
+            return adoptVector(std::move(matrix), {rows, dimension});
+        }, py::arg("texts"), "float32 array of shape (N, D), one row per text");
     
     // FAISSIndex
-    py::class_<rag::vectorization::FAISSIndex, std::shared_ptr<rag::vectorization::FAISSIndex>>(m, "FAISSIndex")
+    py::class_<FAISSIndex, std::shared_ptr<FAISSIndex>>(m, "FAISSIndex")
         .def(py::init<size_t>())
-        .def("initialize", &rag::vectorization::FAISSIndex::initialize)
-        .def("add_document", &rag::vectorization::FAISSIndex::addDocument)
-        .def("search", &rag::vectorization::FAISSIndex::search)
-        .def("save", &rag::vectorization::FAISSIndex::save)
-        .def("load", &rag::vectorization::FAISSIndex::load);
-    
-    // RAGAgent
-    py::class_<rag::agent::RAGAgent, std::shared_ptr<rag::agent::RAGAgent>>(m, "RAGAgent")
-        .def(py::init<std::shared_ptr<rag::data::DataFetcher>,
-                     std::shared_ptr<rag::data::Database>,
-                     std::shared_ptr<rag::vectorization::EmbeddingService>,
-                     std::shared_ptr<rag::vectorization::FAISSIndex>,
+        .def("initialize", &FAISSIndex::initialize)
+        .def_property_readonly("dimension", &FAISSIndex::dimension)
+        .def("__len__", &FAISSIndex::size)
+        .def("add_documents", [](FAISSIndex& index, const std::vector<Document>& docs, const FloatMatrix& embeddings) {
+            if (matrixRows(embeddings, index.dimension(), "embeddings") != docs.size()) {
+                throw py::value_error("embeddings must have one row per document");
+            }
+            const float* data = embeddings.data();
+            py::gil_scoped_release release;
+            return index.addDocumentMatrix(docs, data);
+        }, py::arg("docs"), py::arg("embeddings"), "embeddings: (len(docs), D) float32")
+        .def("search", [](FAISSIndex& index, const FloatMatrix& query, size_t k) {
+            if (query.ndim() != 1 || static_cast<size_t>(query.shape(0)) != index.dimension()) {
+                throw py::value_error("query must have shape (" + std::to_string(index.dimension()) + ",)");
+            }
+            std::vector<float> embedding(query.data(), query.data() + query.shape(0));
+            py::gil_scoped_release release;
+            return index.search(embedding, k);
+        }, py::arg("query"), py::arg("k") = 10, "SearchResult list for one (D,) query")
+        .def("search_batch", [](FAISSIndex& index, const FloatMatrix& queries, size_t k) {
+            size_t n = matrixRows(queries, index.dimension(), "queries");
+            py::array_t<int64_t> labels({static_cast<py::ssize_t>(n), static_cast<py::ssize_t>(k)});
+            py::array_t<float> scores({static_cast<py::ssize_t>(n), static_cast<py::ssize_t>(k)});
+            const float* query_data = queries.data();
+            int64_t* label_data = labels.mutable_data();
+            float* score_data = scores.mutable_data();
+            {
+                py::gil_scoped_release release;
+                index.searchLabels(query_data, n, k, label_data, score_data);
+            }
+            return py::make_tuple(labels, scores);
+        }, py::arg("queries"), py::arg("k") = 10,
+           "(labels, scores) of shape (N, k) for (N, D) queries; label -1 is no match, see document_id")
+        .def("document_id", &FAISSIndex::documentId)
+        .def("get_document", [](FAISSIndex& index, const std::string& doc_id) -> py::object {
+            Document doc;
+            if (!index.getDocument(doc_id, doc)) {
+                return py::none();
+            }
+            return py::cast(std::move(doc));
+        })
+        .def("save", &FAISSIndex::save, py::call_guard<py::gil_scoped_release>())
+        .def("load", &FAISSIndex::load, py::call_guard<py::gil_scoped_release>())
+        .def("open_wal", &FAISSIndex::openWal, py::arg("filepath"), py::arg("sync") = true,
+             py::call_guard<py::gil_scoped_release>())
+        .def("start_checkpointer", [](FAISSIndex& index, const std::string& filepath, int64_t interval_seconds,
+                                      uint64_t wal_bytes) {
+            CheckpointOptions options;
+            options.interval = std::chrono::seconds(interval_seconds);
+            options.wal_bytes = wal_bytes;
+            return index.startCheckpointer(filepath, options);
+        }, py::arg("filepath"), py::arg("interval_seconds") = 300, py::arg("wal_bytes") = 64ull << 20,
+           py::call_guard<py::gil_scoped_release>())
+        .def("stop_checkpointer", &FAISSIndex::stopCheckpointer, py::call_guard<py::gil_scoped_release>());
+    
+    // RAGAgent: each call returns (text, context_docs)
+    py::class_<RAGAgent, std::shared_ptr<RAGAgent>>(m, "RAGAgent")
+        .def(py::init<std::shared_ptr<DataFetcher>,
+                     std::shared_ptr<Database>,
+                     std::shared_ptr<EmbeddingService>,
+                     std::shared_ptr<FAISSIndex>,
                      const std::string&>())
-        .def("get_stock_summary", &rag::agent::RAGAgent::getStockSummary)
-        .def("explain_volatility", &rag::agent::RAGAgent::explainVolatility)
-        .def("compare_sentiment", &rag::agent::RAGAgent::compareSentiment)
-        .def("recommend_pair", &rag::agent::RAGAgent::recommendPair)
-        .def("query_rag", &rag::agent::RAGAgent::queryRAG);
+        .def("get_stock_summary", [](RAGAgent& agent, const std::string& symbol, const std::string& period) {
+            std::string summary;
+            std::vector<RAGContextDoc> docs;
+            bool ok;
+            {
+                py::gil_scoped_release release;
+                ok = agent.getStockSummary(symbol, period, summary, docs);
+            }
+            check(ok, "get_stock_summary");
+            return py::make_tuple(summary, docs);
+        }, py::arg("symbol"), py::arg("period") = "1d")
+        .def("explain_volatility", [](RAGAgent& agent, const std::string& symbol, const std::string& date) {
+            std::string explanation;
+            std::vector<RAGContextDoc> docs;
+            bool ok;
+            {
+                py::gil_scoped_release release;
+                ok = agent.explainVolatility(symbol, date, explanation, docs);
+            }
+            check(ok, "explain_volatility");
+            return py::make_tuple(explanation, docs);
+        }, py::arg("symbol"), py::arg("date") = "")
+        .def("compare_sentiment", [](RAGAgent& agent, const std::string& ticker1, const std::string& ticker2,
+                                     const std::string& period) {
+            std::string comparison;
+            std::vector<RAGContextDoc> docs;
+            bool ok;
+            {
+                py::gil_scoped_release release;
+                ok = agent.compareSentiment(ticker1, ticker2, period, comparison, docs);
+            }
+            check(ok, "compare_sentiment");
+            return py::make_tuple(comparison, docs);
+        }, py::arg("ticker1"), py::arg("ticker2"), py::arg("period") = "1d")
+        .def("recommend_pair", [](RAGAgent& agent, const std::string& sector) {
+            std::string long_ticker, short_ticker, reasoning;
+            std::vector<RAGContextDoc> docs;
+            bool ok;
+            {
+                py::gil_scoped_release release;
+                ok = agent.recommendPair(sector, long_ticker, short_ticker, reasoning, docs);
+            }
+            check(ok, "recommend_pair");
+            return py::make_tuple(long_ticker, short_ticker, reasoning, docs);
+        }, py::arg("sector"), "(long_ticker, short_ticker, reasoning, context_docs)")
+        .def("query_rag", [](RAGAgent& agent, const std::string& query, const std::vector<std::string>& symbols) {
+            std::string answer;
+            std::vector<RAGContextDoc> docs;
+            bool ok;
+            {
+                py::gil_scoped_release release;
+                ok = agent.queryRAG(query, symbols, answer, docs);
+            }
+            check(ok, "query_rag");
+            return py::make_tuple(answer, docs);
+        }, py::arg("query"), py::arg("symbols") = std::vector<std::string>());
 }
-
@@ -0,0 +1,204 @@
+#include "rag/context_packer.h"
+#include "rag/rag_agent.h"
+#include "vectorization/document_chunker.h"
+#include "vectorization/tokenizer.h"
+#include <algorithm>
+#include <cctype>
+#include <numeric>
+#include <unordered_set>
+
+namespace rag {
+namespace agent {
+
+namespace {
+
+// Shorter matches are likely coincidental (shared phrases, boilerplate)
+const size_t kMinOverlapChars = 24;
+
+// Length of the longest suffix of a that is also a prefix of b
+size_t suffixPrefixOverlap(const std::string& a, const std::string& b) {
+    size_t max_length = std::min(a.size(), b.size());
+    if (max_length < kMinOverlapChars) {
+        return 0;
+    }
+    std::string probe = b.substr(0, kMinOverlapChars);
+    size_t pos = a.find(probe, a.size() - max_length);
+    while (pos != std::string::npos && a.size() - pos >= kMinOverlapChars) {
+        size_t length = a.size() - pos;
+        if (a.compare(pos, length, b, 0, length) == 0) {
+            return length; // Earliest match is the longest overlap
+        }
+        pos = a.find(probe, pos + 1);
+    }
+    return 0;
+}
+
+std::string trimWhitespace(const std::string& text, size_t begin, size_t end) {
+    while (begin < end && std::isspace(static_cast<unsigned char>(text[begin]))) {
+        ++begin;
+    }
+    while (end > begin && std::isspace(static_cast<unsigned char>(text[end - 1]))) {
+        --end;
+    }
+    return text.substr(begin, end - begin);
+}
+
+std::string metadataValue(const RAGContextDoc& doc, const std::string& key) {
+    auto it = doc.metadata.find(key);
+    return it != doc.metadata.end() ? it->second : "";
+}
+
+// Tokens buildPrompt spends on a document besides its content
+size_t headerTokens(const RAGContextDoc& doc) {
+    std::string header = "\n[Document 10]\nSource: " + doc.source + "\nTimestamp: " + doc.timestamp + "\nContent: \n";
+    std::string chunk_index = metadataValue(doc, "chunk_index");
+    if (!chunk_index.empty() && chunk_index != "0") {
+        header += "Title: " + metadataValue(doc, "title") + "\n";
+    }
+    return vectorization::Tokenizer::countTokens(header);
+}
+
+} // namespace
+
+std::string ContextPacker::truncateToTokens(const std::string& text, size_t max_tokens) {
+    std::vector<vectorization::TokenPiece> pieces = vectorization::Tokenizer::pretokenize(text);
+    size_t tokens = 0;
+    size_t end = 0;
+    size_t sentence_end = 0;
+    for (const auto& piece : pieces) {
+        if (tokens + piece.tokens > max_tokens) {
+            break;
+        }
+        tokens += piece.tokens;
+        end = piece.end;
+        if (piece.sentence_end) {
+            sentence_end = piece.end;
+        }
+    }
+    if (end >= text.size()) {
+        return text;
+    }
+    if (end == 0) {
+        // A single unbroken run (URL, table row) longer than the budget: cut by bytes
+        end = std::min(text.size(), max_tokens * 4);
+        while (end > 0 && (static_cast<unsigned char>(text[end]) & 0xC0) == 0x80) {
+            --end; // Don't split a UTF-8 sequence
+        }
+        return text.substr(0, end) + " ...";
+    }
+    
+    // Prefer a clean sentence end unless it throws away more than a quarter
+    if (sentence_end > 0 && sentence_end * 4 >= end * 3) {
+        return trimWhitespace(text, 0, sentence_end);
+    }
+    return trimWhitespace(text, 0, end) + " ...";
+}
+
+std::vector<RAGContextDoc> ContextPacker::pack(std::vector<RAGContextDoc> docs,
+                                               const ContextBudget& budget,
+                                               PackingStats* stats) {
+    PackingStats local_stats;
+    local_stats.input_docs = docs.size();
+    
+    std::vector<size_t> order(docs.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&docs](size_t a, size_t b) {
+        return docs[a].similarity_score > docs[b].similarity_score;
+    });
+    
+    std::vector<RAGContextDoc> packed;
+    packed.reserve(docs.size());
+    std::unordered_set<std::string> hashes;
+    size_t remaining = budget.max_context_tokens;
+    
+    for (size_t index : order) {
+        RAGContextDoc& doc = docs[index];
+        if (!hashes.insert(vectorization::DocumentChunker::contentHash(doc.content)).second) {
+            ++local_stats.duplicate_docs;
+            continue;
+        }
+        
+        // Drop text the prompt already contains: whole documents, or the
+        // overlap a chunk shares with a neighbouring chunk of the same article
+        std::string content = std::move(doc.content);
+        std::string parent = metadataValue(doc, "parent_doc_id");
+        bool duplicate = false;
+        for (const auto& kept : packed) {
+            if (kept.content.find(content) != std::string::npos) {
+                duplicate = true;
+                break;
+            }
+            if (parent.empty() || metadataValue(kept, "parent_doc_id") != parent) {
+                continue;
+            }
+            size_t leading = suffixPrefixOverlap(kept.content, content);
+            if (leading > 0) {
+                content = trimWhitespace(content, leading, content.size());
+            }
+            size_t trailing = suffixPrefixOverlap(content, kept.content);
+            if (trailing > 0) {
+                content = trimWhitespace(content, 0, content.size() - trailing);
+            }
+            if (content.empty()) {
+                duplicate = true;
+                break;
+            }
+        }
+        if (duplicate) {
+            ++local_stats.duplicate_docs;
+            continue;
+        }
+        
+        size_t overhead = headerTokens(doc);
+        if (remaining < overhead + budget.min_doc_tokens) {
+            ++local_stats.dropped_docs;
+            continue;
+        }
+        size_t allowed = std::min(budget.max_doc_tokens, remaining - overhead);
+        size_t tokens = vectorization::Tokenizer::countTokens(content);
+        bool truncated = false;
+        if (tokens > allowed) {
+            content = truncateToTokens(content, allowed);
+            tokens = vectorization::Tokenizer::countTokens(content);
+            truncated = true;
+        }
+        
+        RAGContextDoc packed_doc = std::move(doc);
+        packed_doc.content = std::move(content);
+        if (truncated) {
+            packed_doc.metadata["truncated"] = "true";
+            ++local_stats.truncated_docs;
+        }
+        packed.push_back(std::move(packed_doc));
+        remaining -= std::min(remaining, overhead + tokens);
+        local_stats.tokens += overhead + tokens;
+    }
+    
+    local_stats.packed_docs = packed.size();
+    if (stats) {
+        *stats = local_stats;
+    }
+    return packed;
+}
+
+ContextBudget ContextPacker::defaultBudget(const std::string& request_type) {
+    ContextBudget budget;
+    if (request_type == "stock_summary") {
+        budget.max_context_tokens = 1500;
+        budget.max_doc_tokens = 400;
+    } else if (request_type == "explain_volatility") {
+        budget.max_context_tokens = 2000;
+        budget.max_doc_tokens = 400;
+    } else if (request_type == "compare_sentiment" || request_type == "recommend_pair") {
+        // Many short documents across several tickers
+        budget.max_context_tokens = 2500;
+        budget.max_doc_tokens = 300;
+    } else if (request_type == "query") {
+        budget.max_context_tokens = 3000;
+        budget.max_doc_tokens = 600;
+    }
+    return budget;
+}
+
+} // namespace agent
+} // namespace rag
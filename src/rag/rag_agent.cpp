@@ -1,13 +1,190 @@
 #include "rag/rag_agent.h"
 #include "utils/logger.h"
-#include <curl/curl.h>
+#include "utils/metrics.h"
+#include "utils/tracing.h"
+#include "utils/deadline.h"
+#include "utils/http_client.h"
 #include <nlohmann/json.hpp>
 #include <sstream>
 #include <algorithm>
+#include <condition_variable>
+#include <ctime>
+#include <deque>
+#include <mutex>
 
 namespace rag {
 namespace agent {
 
+namespace {
+
+// Shares of the remaining request budget given to external calls made before
+// the LLM, which gets whatever is left. An embedding that misses its share
+// falls back to lexical retrieval instead of stalling the request.
+const double kEmbedQueryShare = 0.15;
+const double kMarketDataShare = 0.2;
+const double kNewsShare = 0.25;
+const int64_t kLLMTimeoutMs = 60000;
+
+// Completions in flight at once for a watchlist request
+const size_t kMaxConcurrentLLMCalls = 16;
+
+// Context documents kept per request type
+const size_t kStockSummaryDocs = 5;
+const size_t kVolatilityDocs = 6;
+
+// Daily bars fetched for volatility: the provider's compact output covers the
+// last 100 sessions (about 140 calendar days); anything older needs the full one
+const int kCompactHistoryDays = 100;
+const int kFullHistoryDays = 100000;
+const std::time_t kCompactHistorySeconds = 140 * 24 * 60 * 60;
+
+// Date (YYYY-MM-DD) the compact history reaches back to
+std::string compactHistoryStart() {
+    std::time_t seconds = std::time(nullptr) - kCompactHistorySeconds;
+    std::tm utc{};
+    gmtime_r(&seconds, &utc);
+    char text[16];
+    std::strftime(text, sizeof(text), "%Y-%m-%d", &utc);
+    return text;
+}
+
+std::string stockSummaryRetrievalQuery(const std::string& symbol, const std::string& period) {
+    return "Stock summary for " + symbol + " over " + period;
+}
+
+std::string volatilityRetrievalQuery(const std::string& symbol, const std::string& date) {
+    return "Volatility spike " + symbol + " " + date;
+}
+
+std::string stockSummaryQuery(const std::string& symbol, const std::string& period, bool has_price_data,
+                              double price, double change_percent) {
+    // Build query with available data
+    std::stringstream query_ss;
+    query_ss << "Provide a summary for " << symbol << " stock. ";
+    if (has_price_data) {
+        query_ss << "Current price: $" << price << " (" << change_percent << "%). ";
+    }
+    query_ss << "Period: " << period << ". ";
+    query_ss << "Include key metrics, recent news, and market sentiment.";
+    return query_ss.str();
+}
+
+// volatility is null when no estimate was found
+std::string volatilityQuery(const std::string& symbol, const std::string& date,
+                            const data::VolatilityEstimate* volatility) {
+    std::stringstream query_ss;
+    query_ss << "Explain the volatility for " << symbol << " on " << date << ". ";
+    if (volatility) {
+        query_ss << "Annualized volatility (close-to-close): " << volatility->close_to_close << ". ";
+        if (!volatility->close_to_close_only) {
+            query_ss << "EWMA: " << volatility->ewma << ", Parkinson: " << volatility->parkinson
+                     << ", Garman-Klass: " << volatility->garman_klass << ". ";
+        }
+    }
+    query_ss << "Provide context from recent news and market events.";
+    return query_ss.str();
+}
+
+// Stock summary query for a watchlist update, noting what changed in the
+// symbol's latest version. Built from symbol state only, never from one
+// subscriber's view, since the summary is shared by every subscriber.
+std::string watchlistUpdateQuery(const WatchlistChange& change, const std::string& period) {
+    std::stringstream query_ss;
+    query_ss << stockSummaryQuery(change.symbol, period, change.has_price, change.price, change.change_percent);
+    if (change.has_volatility) {
+        query_ss << " Annualized volatility (close-to-close): " << change.volatility.close_to_close << ".";
+    }
+    const WatchlistRevision& revision = change.revision;
+    std::vector<std::string> reasons;
+    if (revision.new_articles > 0) {
+        reasons.push_back(std::to_string(revision.new_articles) + " new articles");
+    }
+    if (revision.price_changed) {
+        reasons.push_back("the price moved");
+    }
+    if (revision.volatility_changed) {
+        reasons.push_back("volatility changed");
+    }
+    if (!reasons.empty()) {
+        query_ss << " Since the last update:";
+        for (size_t i = 0; i < reasons.size(); ++i) {
+            query_ss << (i == 0 ? " " : ", ") << reasons[i];
+        }
+        query_ss << ". Lead with what changed.";
+    }
+    return query_ss.str();
+}
+
+// End-to-end latency and outcome of one agent request. The request span
+// joins the caller's trace, or starts one when called outside the server.
+class RequestMetrics {
+public:
+    explicit RequestMetrics(const std::string& request)
+        : request_(request),
+          timer_(utils::MetricsRegistry::getInstance().histogram(
+              "rag_request_duration_seconds", "End-to-end agent request latency", {{"request", request}})),
+          span_("rag_agent." + request, "", utils::SpanKind::INTERNAL) {}
+    
+    ~RequestMetrics() {
+        utils::MetricsRegistry::getInstance().counter(
+            "rag_requests_total", "Agent requests by outcome",
+            {{"request", request_}, {"outcome", outcome()}}).increment();
+    }
+    
+    bool finish(bool ok) {
+        ok_ = ok;
+        if (!ok) {
+            span_.setError("request failed");
+        }
+        return ok;
+    }
+    
+private:
+    std::string request_;
+    utils::ScopedTimer timer_;
+    utils::Span span_;
+    bool ok_ = false;
+    
+    const char* outcome() const {
+        if (ok_) {
+            return "ok";
+        }
+        if (utils::Deadline::cancelled()) {
+            return "cancelled";
+        }
+        return utils::Deadline::expired() ? "deadline_exceeded" : "error";
+    }
+};
+
+utils::Counter& volatilityLookups(const std::string& result) {
+    return utils::MetricsRegistry::getInstance().counter(
+        "rag_cache_lookups_total", "Cache lookups by result", {{"cache", "volatility"}, {"result", result}});
+}
+
+utils::Counter& liveQuoteLookups(const std::string& result) {
+    return utils::MetricsRegistry::getInstance().counter(
+        "rag_cache_lookups_total", "Cache lookups by result", {{"cache", "live_quote"}, {"result", result}});
+}
+
+utils::Counter& watchlistContextLookups(const std::string& result) {
+    return utils::MetricsRegistry::getInstance().counter(
+        "rag_cache_lookups_total", "Cache lookups by result", {{"cache", "watchlist_context"}, {"result", result}});
+}
+
+// "wait" is a summary another call was already writing
+utils::Counter& watchlistSummaryLookups(const std::string& result) {
+    return utils::MetricsRegistry::getInstance().counter(
+        "rag_cache_lookups_total", "Cache lookups by result", {{"cache", "watchlist_summary"}, {"result", result}});
+}
+
+// Retrieved documents by what packing did with them
+utils::Counter& contextDocs(const std::string& outcome) {
+    return utils::MetricsRegistry::getInstance().counter(
+        "rag_context_docs_total", "Retrieved context documents by packing outcome", {{"outcome", outcome}});
+}
+
+} // namespace
+
 RAGAgent::RAGAgent(std::shared_ptr<data::DataFetcher> data_fetcher,
                    std::shared_ptr<data::Database> database,
                    std::shared_ptr<vectorization::EmbeddingService> embedding_service,
@@ -17,57 +194,241 @@ RAGAgent::RAGAgent(std::shared_ptr<data::DataFetcher> data_fetcher,
       database_(database),
       embedding_service_(embedding_service),
       faiss_index_(faiss_index),
+      volatility_engine_(std::make_shared<data::VolatilityEngine>(30, 0.94, database)),
       llm_api_key_(llm_api_key) {
 }
 
-std::vector<RAGContextDoc> RAGAgent::retrieveContext(const std::string& query, size_t k) {
-    std::vector<RAGContextDoc> context_docs;
+std::future<bool> RAGAgent::fetchQuoteAsync(const std::string& symbol, double& price, double& change_percent) {
+    if (market_stream_) {
+        data::LiveQuote quote;
+        if (market_stream_->getQuote(symbol, quote)) {
+            liveQuoteLookups("hit").increment();
+            price = quote.price;
+            change_percent = quote.change_percent;
+            std::promise<bool> ready;
+            ready.set_value(true);
+            return ready.get_future();
+        }
+        liveQuoteLookups("miss").increment();
+    }
+    return data_fetcher_->fetchRealTimeQuoteAsync(symbol, price, change_percent);
+}
+
+bool RAGAgent::lookupVolatility(const std::string& symbol, const std::string& date,
+                                data::VolatilityEstimate& estimate) {
+    static auto& lookup_latency = utils::stageHistogram("rag_agent", "volatility_lookup");
+    utils::ScopedTimer timer(lookup_latency);
+    utils::Span span("rag_agent.volatility_lookup");
+    
+    if (cachedVolatility(symbol, date, estimate)) {
+        return true;
+    }
+    
+    // Pull recent bars, or the full history for older dates; the engine skips
+    // anything it has already applied and backfills older bars
+    int days = volatilityHistoryDays(symbol, date);
+    if (days == 0) {
+        return false;
+    }
+    std::vector<data::OHLCVData> bars;
+    {
+        utils::DeadlineScope budget = utils::DeadlineScope::share(kMarketDataShare);
+        if (!data_fetcher_->fetchStockData(symbol, "daily", days, bars)) {
+            return false;
+        }
+    }
+    volatility_engine_->updateSeries(symbol, bars, days == kFullHistoryDays);
+    
+    return volatility_engine_->getEstimate(symbol, date, estimate) && estimate.observations > 1;
+}
+
+bool RAGAgent::cachedVolatility(const std::string& symbol, const std::string& date,
+                                data::VolatilityEstimate& estimate) {
+    std::string last_seen = volatility_engine_->lastTimestamp(symbol);
+    if (!last_seen.empty() && (date.empty() || date <= last_seen) &&
+        volatility_engine_->getEstimate(symbol, date, estimate) && estimate.observations > 1) {
+        static auto& engine_hits = volatilityLookups("hit");
+        engine_hits.increment();
+        return true;
+    }
+    
+    // Persisted by an earlier run (close-to-close only)
+    double persisted = 0.0;
+    if (!date.empty() && database_->getVolatility(symbol, date, persisted)) {
+        estimate = data::VolatilityEstimate();
+        estimate.date = date;
+        estimate.close_to_close = persisted;
+        estimate.close_to_close_only = true;
+        static auto& database_hits = volatilityLookups("database");
+        database_hits.increment();
+        return true;
+    }
+    
+    static auto& misses = volatilityLookups("miss");
+    misses.increment();
+    return false;
+}
+
+int RAGAgent::volatilityHistoryDays(const std::string& symbol, const std::string& date) {
+    if (date.empty()) {
+        return kCompactHistoryDays;
+    }
+    std::string first = volatility_engine_->firstEstimateDate(symbol);
+    if (first.empty()) {
+        return date < compactHistoryStart() ? kFullHistoryDays : kCompactHistoryDays;
+    }
+    if (date >= first) {
+        return kCompactHistoryDays;
+    }
+    // Before everything applied: only worth a full fetch once
+    return volatility_engine_->hasFullHistory(symbol) ? 0 : kFullHistoryDays;
+}
+
+std::vector<RAGContextDoc> RAGAgent::retrieveContext(const std::string& query, size_t k,
+                                                     const std::vector<std::string>& symbols) {
+    static auto& embed_latency = utils::stageHistogram("rag_agent", "embed_query");
+    static auto& search_latency = utils::stageHistogram("rag_agent", "vector_search");
+    static auto& lexical_latency = utils::stageHistogram("rag_agent", "lexical_search");
+    size_t candidates = k * std::max<size_t>(1, reranker_.config().candidate_multiplier);
     
-    // Generate embedding for query
+    // Embed the query in the background while the lexical index is searched;
+    // embed_query then records only the wait that is left
     std::vector<float> query_embedding;
-    if (!embedding_service_->generateEmbedding(query, query_embedding)) {
-        rag::utils::Logger::getInstance().warning("Failed to generate query embedding - continuing without vector search context");
-        // Return empty context - the RAG will work without context
-        return context_docs;
+    std::future<bool> embedding_ready;
+    {
+        utils::DeadlineScope budget = utils::DeadlineScope::share(kEmbedQueryShare);
+        embedding_ready = embedding_service_->generateEmbeddingAsync(query, query_embedding);
+    }
+    
+    // Lexical search needs no embedding, so it still works when the embedding service doesn't
+    std::vector<vectorization::SearchResult> lexical_results;
+    if (lexical_index_) {
+        utils::ScopedTimer timer(lexical_latency);
+        utils::Span span("rag_agent.lexical_search");
+        lexical_results = lexical_index_->search(query, candidates);
+    }
+    
+    bool embedded;
+    {
+        utils::ScopedTimer timer(embed_latency);
+        utils::Span span("rag_agent.embed_query");
+        embedded = embedding_ready.get();
     }
     
     // Search FAISS index
-    auto search_results = faiss_index_->search(query_embedding, k);
+    std::vector<vectorization::SearchResult> dense_results;
+    if (embedded) {
+        utils::ScopedTimer timer(search_latency);
+        utils::Span span("rag_agent.vector_search");
+        dense_results = faiss_index_->search(query_embedding, candidates);
+    }
+    
+    return fuseAndRerank(query, k, symbols, std::move(dense_results), std::move(lexical_results), embedded);
+}
+
+std::vector<std::vector<RAGContextDoc>> RAGAgent::retrieveContextBatch(
+    const std::vector<std::string>& queries, size_t k, const std::vector<std::vector<std::string>>& symbols) {
+    static auto& embed_latency = utils::stageHistogram("rag_agent", "embed_query");
+    static auto& search_latency = utils::stageHistogram("rag_agent", "vector_search");
+    static auto& lexical_latency = utils::stageHistogram("rag_agent", "lexical_search");
+    size_t candidates = k * std::max<size_t>(1, reranker_.config().candidate_multiplier);
+    
+    std::vector<std::vector<vectorization::SearchResult>> lexical_results(queries.size());
+    if (lexical_index_) {
+        utils::ScopedTimer timer(lexical_latency);
+        utils::Span span("rag_agent.lexical_search");
+        for (size_t i = 0; i < queries.size(); ++i) {
+            lexical_results[i] = lexical_index_->search(queries[i], candidates);
+        }
+    }
+    
+    // One embedding request for every query
+    std::vector<float> query_matrix;
+    bool embedded;
+    {
+        utils::ScopedTimer timer(embed_latency);
+        utils::Span span("rag_agent.embed_query");
+        span.setAttribute("rag.queries", std::to_string(queries.size()));
+        utils::DeadlineScope budget = utils::DeadlineScope::share(kEmbedQueryShare);
+        embedded = embedding_service_->generateEmbeddingMatrix(queries, query_matrix);
+    }
+    
+    // And one pass over the index
+    std::vector<std::vector<vectorization::SearchResult>> dense_results;
+    if (embedded) {
+        utils::ScopedTimer timer(search_latency);
+        utils::Span span("rag_agent.vector_search");
+        dense_results = faiss_index_->searchBatch(query_matrix, candidates);
+    }
+    dense_results.resize(queries.size());
+    
+    std::vector<std::vector<RAGContextDoc>> contexts;
+    contexts.reserve(queries.size());
+    for (size_t i = 0; i < queries.size(); ++i) {
+        contexts.push_back(fuseAndRerank(queries[i], k, i < symbols.size() ? symbols[i] : std::vector<std::string>(),
+                                         std::move(dense_results[i]), std::move(lexical_results[i]), embedded));
+    }
+    return contexts;
+}
+
+std::vector<RAGContextDoc> RAGAgent::fuseAndRerank(const std::string& query, size_t k,
+                                                   const std::vector<std::string>& symbols,
+                                                   std::vector<vectorization::SearchResult> dense_results,
+                                                   std::vector<vectorization::SearchResult> lexical_results,
+                                                   bool embedded) {
+    static auto& rerank_latency = utils::stageHistogram("rag_agent", "rerank");
+    size_t candidates = k * std::max<size_t>(1, reranker_.config().candidate_multiplier);
+    std::vector<RAGContextDoc> context_docs;
+    
+    if (!embedded) {
+        if (lexical_results.empty()) {
+            RAG_LOG_WARNING("Failed to generate query embedding - continuing without vector search context");
+            // Return empty context - the RAG will work without context
+            return context_docs;
+        }
+        RAG_LOG_WARNING("Failed to generate query embedding - using lexical retrieval only");
+    }
+    
+    std::vector<vectorization::SearchResult> search_results;
+    if (lexical_results.empty()) {
+        search_results = std::move(dense_results);
+    } else if (dense_results.empty()) {
+        search_results = std::move(lexical_results);
+    } else {
+        search_results = vectorization::reciprocalRankFusion(std::move(dense_results), std::move(lexical_results),
+                                                             candidates);
+    }
     
     // Convert to RAGContextDoc
-    for (const auto& result : search_results) {
+    context_docs.reserve(search_results.size());
+    for (auto& result : search_results) {
         RAGContextDoc doc;
-        doc.doc_id = result.doc_id;
-        doc.content = result.content;
-        doc.source = result.source;
-        doc.timestamp = result.timestamp;
+        doc.doc_id = std::move(result.doc_id);
+        doc.content = std::move(result.content);
+        doc.source = std::move(result.source);
+        doc.timestamp = std::move(result.timestamp);
         doc.similarity_score = result.similarity_score;
-        doc.metadata = result.metadata;
-        context_docs.push_back(doc);
+        doc.metadata = std::move(result.metadata);
+        context_docs.push_back(std::move(doc));
+    }
+    
+    {
+        utils::ScopedTimer timer(rerank_latency);
+        utils::Span span("rag_agent.rerank");
+        span.setAttribute("rag.candidates", std::to_string(context_docs.size()));
+        context_docs = reranker_.rerank(query, symbols, std::move(context_docs), k);
     }
     
     if (context_docs.empty()) {
-        rag::utils::Logger::getInstance().debug("No context documents retrieved from vector store");
+        RAG_LOG_DEBUG("No context documents retrieved");
     } else {
-        rag::utils::Logger::getInstance().debug("Retrieved " + std::to_string(context_docs.size()) + " context documents");
+        RAG_LOG_DEBUG("Retrieved " + std::to_string(context_docs.size()) + " context documents");
     }
     
     return context_docs;
 }
 
-static size_t WriteCallback(void* contents, size_t size, size_t nmemb, std::string* data) {
-    size_t total_size = size * nmemb;
-    data->append((char*)contents, total_size);
-    return total_size;
-}
-
-std::string RAGAgent::queryOpenAI(const std::string& prompt) {
-    CURL* curl = curl_easy_init();
-    if (!curl) {
-        rag::utils::Logger::getInstance().error("Failed to initialize CURL for LLM");
-        return "";
-    }
-    
+utils::HttpRequest RAGAgent::buildLLMRequest(const std::string& prompt) const {
     nlohmann::json request_json;
     // Using GPT-3.5-turbo for lower cost (change to "gpt-4" if you have quota)
     request_json["model"] = "gpt-3.5-turbo";
@@ -77,29 +438,30 @@ std::string RAGAgent::queryOpenAI(const std::string& prompt) {
     request_json["temperature"] = 0.7;
     request_json["max_tokens"] = 1000;
     
-    std::string json_str = request_json.dump();
-    std::string response;
-    
-    struct curl_slist* headers = nullptr;
-    headers = curl_slist_append(headers, "Content-Type: application/json");
-    std::string auth_header = "Authorization: Bearer " + llm_api_key_;
-    headers = curl_slist_append(headers, auth_header.c_str());
-    
-    curl_easy_setopt(curl, CURLOPT_URL, "https://api.openai.com/v1/chat/completions");
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, json_str.c_str());
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
-    
-    CURLcode res = curl_easy_perform(curl);
-    curl_slist_free_all(headers);
-    curl_easy_cleanup(curl);
-    
-    if (res != CURLE_OK) {
-        rag::utils::Logger::getInstance().error("CURL request failed for LLM");
+    // Retried on 429/5xx but never hedged: a duplicate completion is paid for twice
+    utils::HttpRequest request;
+    request.method = "POST";
+    request.url = llm_base_url_ + "/chat/completions";
+    request.body = request_json.dump();
+    request.headers = {"Content-Type: application/json", "Authorization: Bearer " + llm_api_key_};
+    request.endpoint = "openai:chat_completions";
+    request.span_name = "POST /chat/completions";
+    request.timeout_ms = kLLMTimeoutMs;
+    return request;
+}
+
+std::string RAGAgent::queryOpenAI(const std::string& prompt) {
+    utils::HttpResponse http_response;
+    utils::HttpClient::getInstance().perform(buildLLMRequest(prompt), http_response);
+    return parseLLMResponse(http_response);
+}
+
+std::string RAGAgent::parseLLMResponse(const utils::HttpResponse& http_response) {
+    if (!http_response.error.empty()) {
+        RAG_LOG_ERROR("CURL request failed for LLM: " + http_response.error);
         return "";
     }
+    const std::string& response = http_response.body;
     
     try {
         nlohmann::json json_response = nlohmann::json::parse(response);
@@ -109,15 +471,15 @@ std::string RAGAgent::queryOpenAI(const std::string& prompt) {
             std::string error_msg = json_response["error"].contains("message") 
                 ? json_response["error"]["message"].get<std::string>()
                 : "Unknown API error";
-            rag::utils::Logger::getInstance().error("OpenAI API error: " + error_msg);
+            RAG_LOG_ERROR("OpenAI API error: " + error_msg);
             
             // Log error type if available
             if (json_response["error"].contains("type")) {
                 std::string error_type = json_response["error"]["type"].get<std::string>();
-                rag::utils::Logger::getInstance().error("Error type: " + error_type);
+                RAG_LOG_ERROR("Error type: " + error_type);
             }
             
-            rag::utils::Logger::getInstance().debug("Full error response: " + response);
+            RAG_LOG_DEBUG("Full error response: " + response);
             return "";
         }
         
@@ -125,19 +487,19 @@ std::string RAGAgent::queryOpenAI(const std::string& prompt) {
             !json_response["choices"].empty()) {
             return json_response["choices"][0]["message"]["content"].get<std::string>();
         } else {
-            rag::utils::Logger::getInstance().error("Unexpected response format from OpenAI API");
-            rag::utils::Logger::getInstance().debug("Response: " + response.substr(0, 500));
+            RAG_LOG_ERROR("Unexpected response format from OpenAI API");
+            RAG_LOG_DEBUG("Response: " + response.substr(0, 500));
         }
     } catch (const std::exception& e) {
-        rag::utils::Logger::getInstance().error("Failed to parse LLM response: " + std::string(e.what()));
-        rag::utils::Logger::getInstance().debug("Response: " + response.substr(0, 500));
+        RAG_LOG_ERROR("Failed to parse LLM response: " + std::string(e.what()));
+        RAG_LOG_DEBUG("Response: " + response.substr(0, 500));
     }
     
     return "";
 }
 
-std::string RAGAgent::generateLLMResponse(const std::string& query, 
-                                         const std::vector<RAGContextDoc>& context_docs) {
+std::string RAGAgent::buildPrompt(const std::string& query,
+                                  const std::vector<RAGContextDoc>& context_docs) const {
     // Build prompt with context (or without if no context available)
     std::stringstream prompt_ss;
     prompt_ss << "Query: " << query << "\n\n";
@@ -147,114 +509,227 @@ std::string RAGAgent::generateLLMResponse(const std::string& query,
         for (size_t i = 0; i < context_docs.size(); ++i) {
             prompt_ss << "\n[Document " << (i + 1) << "]\n";
             prompt_ss << "Source: " << context_docs[i].source << "\n";
+            auto title_it = context_docs[i].metadata.find("title");
+            if (title_it != context_docs[i].metadata.end() && context_docs[i].metadata.count("chunk_index") &&
+                context_docs[i].metadata.at("chunk_index") != "0") {
+                // Later chunks don't repeat the headline in their text
+                prompt_ss << "Title: " << title_it->second << "\n";
+            }
             prompt_ss << "Timestamp: " << context_docs[i].timestamp << "\n";
             prompt_ss << "Content: " << context_docs[i].content << "\n";
         }
         prompt_ss << "\n\nBased on the above context, please provide a comprehensive answer to the query.\n";
     } else {
         prompt_ss << "Please provide a comprehensive answer to the query based on your knowledge.\n";
-        rag::utils::Logger::getInstance().debug("Generating LLM response without context documents");
+        RAG_LOG_DEBUG("Generating LLM response without context documents");
     }
     
-    return queryOpenAI(prompt_ss.str());
+    return prompt_ss.str();
+}
+
+void RAGAgent::setContextBudget(const std::string& request_type, const ContextBudget& budget) {
+    context_budgets_[request_type] = budget;
+}
+
+std::string RAGAgent::generateLLMResponse(const std::string& query, 
+                                         std::vector<RAGContextDoc>& context_docs,
+                                         const std::string& request_type) {
+    static auto& llm_latency = utils::stageHistogram("rag_agent", "llm");
+    
+    std::string prompt = packPrompt(query, context_docs, request_type);
+    utils::ScopedTimer timer(llm_latency);
+    utils::Span span("rag_agent.llm");
+    return queryOpenAI(prompt);
+}
+
+std::string RAGAgent::packPrompt(const std::string& query, std::vector<RAGContextDoc>& context_docs,
+                                 const std::string& request_type) {
+    static auto& prompt_latency = utils::stageHistogram("rag_agent", "build_prompt");
+    static auto& packed_docs = contextDocs("packed");
+    static auto& truncated_docs = contextDocs("truncated");
+    static auto& duplicate_docs = contextDocs("duplicate");
+    static auto& dropped_docs = contextDocs("dropped");
+    
+    utils::ScopedTimer timer(prompt_latency);
+    utils::Span span("rag_agent.build_prompt");
+    
+    auto budget_it = context_budgets_.find(request_type);
+    PackingStats stats;
+    context_docs = ContextPacker::pack(std::move(context_docs),
+                                       budget_it != context_budgets_.end()
+                                           ? budget_it->second
+                                           : ContextPacker::defaultBudget(request_type),
+                                       &stats);
+    packed_docs.increment(stats.packed_docs);
+    truncated_docs.increment(stats.truncated_docs);
+    duplicate_docs.increment(stats.duplicate_docs);
+    dropped_docs.increment(stats.dropped_docs);
+    span.setAttribute("rag.context_tokens", std::to_string(stats.tokens));
+    span.setAttribute("rag.context_docs", std::to_string(stats.packed_docs) + "/" + std::to_string(stats.input_docs));
+    
+    return buildPrompt(query, context_docs);
+}
+
+void RAGAgent::queryOpenAIConcurrent(const std::vector<std::string>& prompts,
+                                     const std::function<void(size_t, std::string&&)>& on_response) {
+    static auto& llm_latency = utils::stageHistogram("rag_agent", "llm");
+    utils::Span span("rag_agent.llm");
+    span.setAttribute("rag.prompts", std::to_string(prompts.size()));
+    
+    // Responses arrive on the HTTP loop thread and are handed back here
+    struct Completions {
+        std::mutex mutex;
+        std::condition_variable ready;
+        std::deque<std::pair<size_t, utils::HttpResponse>> responses;
+    };
+    auto completions = std::make_shared<Completions>();
+    std::vector<std::chrono::steady_clock::time_point> started(prompts.size());
+    
+    auto issue = [&](size_t index) {
+        started[index] = std::chrono::steady_clock::now();
+        utils::HttpClient::getInstance().performAsync(buildLLMRequest(prompts[index]),
+            [completions, index](utils::HttpResponse&& response) {
+                {
+                    std::lock_guard<std::mutex> lock(completions->mutex);
+                    completions->responses.emplace_back(index, std::move(response));
+                }
+                completions->ready.notify_one();
+            });
+    };
+    
+    size_t issued = 0;
+    while (issued < std::min(prompts.size(), kMaxConcurrentLLMCalls)) {
+        issue(issued++);
+    }
+    for (size_t received = 0; received < prompts.size(); ++received) {
+        std::pair<size_t, utils::HttpResponse> done;
+        {
+            std::unique_lock<std::mutex> lock(completions->mutex);
+            completions->ready.wait(lock, [&completions]() { return !completions->responses.empty(); });
+            done = std::move(completions->responses.front());
+            completions->responses.pop_front();
+        }
+        // Keep the window full before handling the response
+        if (issued < prompts.size()) {
+            issue(issued++);
+        }
+        llm_latency.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - started[done.first]).count()));
+        on_response(done.first, parseLLMResponse(done.second));
+    }
 }
 
 bool RAGAgent::getStockSummary(const std::string& symbol, const std::string& period,
                               std::string& summary, std::vector<RAGContextDoc>& context_docs) {
-    // Fetch current stock data
-    double price = 0.0, change_percent = 0.0;
-    bool has_price_data = data_fetcher_->fetchRealTimeQuote(symbol, price, change_percent);
+    RequestMetrics request("stock_summary");
+    static auto& quote_latency = utils::stageHistogram("rag_agent", "fetch_quote");
     
-    if (!has_price_data) {
-        rag::utils::Logger::getInstance().warning("Failed to fetch stock quote for " + symbol + " - continuing without price data");
-        // Continue without price data - can still generate summary from context
+    // Fetch current stock data while context is retrieved
+    double price = 0.0, change_percent = 0.0;
+    std::future<bool> quote_ready;
+    {
+        utils::DeadlineScope budget = utils::DeadlineScope::share(kMarketDataShare);
+        quote_ready = fetchQuoteAsync(symbol, price, change_percent);
     }
     
     // Retrieve relevant context (may be empty if embeddings fail)
-    std::string query = "Stock summary for " + symbol + " over " + period;
-    context_docs = retrieveContext(query, 5);
+    context_docs = retrieveContext(stockSummaryRetrievalQuery(symbol, period), kStockSummaryDocs, {symbol});
     
-    // Build query with available data
-    std::stringstream query_ss;
-    query_ss << "Provide a summary for " << symbol << " stock. ";
-    if (has_price_data) {
-        query_ss << "Current price: $" << price << " (" << change_percent << "%). ";
+    bool has_price_data;
+    {
+        utils::ScopedTimer timer(quote_latency);
+        utils::Span span("rag_agent.fetch_quote");
+        has_price_data = quote_ready.get();
+    }
+    
+    if (!has_price_data) {
+        RAG_LOG_WARNING("Failed to fetch stock quote for " + symbol + " - continuing without price data");
+        // Continue without price data - can still generate summary from context
     }
-    query_ss << "Period: " << period << ". ";
-    query_ss << "Include key metrics, recent news, and market sentiment.";
     
     // Generate response (will work even without context)
-    summary = generateLLMResponse(query_ss.str(), context_docs);
+    summary = generateLLMResponse(stockSummaryQuery(symbol, period, has_price_data, price, change_percent),
+                                  context_docs, "stock_summary");
     
     if (summary.empty()) {
-        rag::utils::Logger::getInstance().error("Failed to generate LLM response for stock summary");
-        return false;
+        RAG_LOG_ERROR("Failed to generate LLM response for stock summary");
+        return request.finish(false);
     }
     
-    return true;
+    return request.finish(true);
 }
 
 bool RAGAgent::explainVolatility(const std::string& symbol, const std::string& date,
                                 std::string& explanation, std::vector<RAGContextDoc>& context_docs) {
-    // Fetch volatility data
-    double volatility = 0.0;
-    bool has_volatility = data_fetcher_->fetchVolatility(symbol, date, volatility);
+    RequestMetrics request("explain_volatility");
+    
+    // Look up volatility from the streaming engine
+    data::VolatilityEstimate volatility;
+    bool has_volatility = lookupVolatility(symbol, date, volatility);
     
     if (!has_volatility) {
-        rag::utils::Logger::getInstance().warning("Failed to fetch volatility for " + symbol + " - generating explanation without volatility data");
+        RAG_LOG_WARNING("Failed to fetch volatility for " + symbol + " - generating explanation without volatility data");
         // Continue without volatility data
     }
     
     // Retrieve relevant context (may be empty if embeddings fail)
-    std::string query = "Volatility spike " + symbol + " " + date;
-    context_docs = retrieveContext(query, 10);
-    
-    // Build query
-    std::stringstream query_ss;
-    query_ss << "Explain the volatility for " << symbol << " on " << date << ". ";
-    if (has_volatility) {
-        query_ss << "Volatility: " << volatility << ". ";
-    }
-    query_ss << "Provide context from recent news and market events.";
+    context_docs = retrieveContext(volatilityRetrievalQuery(symbol, date), kVolatilityDocs, {symbol});
     
     // Generate response (will work even without context or volatility data)
-    explanation = generateLLMResponse(query_ss.str(), context_docs);
+    explanation = generateLLMResponse(volatilityQuery(symbol, date, has_volatility ? &volatility : nullptr),
+                                      context_docs, "explain_volatility");
     
     if (explanation.empty()) {
-        rag::utils::Logger::getInstance().error("Failed to generate LLM response for volatility explanation");
-        return false;
+        RAG_LOG_ERROR("Failed to generate LLM response for volatility explanation");
+        return request.finish(false);
     }
     
-    return true;
+    return request.finish(true);
 }
 
 bool RAGAgent::compareSentiment(const std::string& ticker1, const std::string& ticker2,
                                const std::string& period, std::string& comparison,
                                std::vector<RAGContextDoc>& context_docs) {
+    RequestMetrics request("compare_sentiment");
+    static auto& news_latency = utils::stageHistogram("rag_agent", "fetch_news");
+    
+    // Fetch news for both concurrently, and with context retrieval
+    std::vector<data::NewsArticle> articles1, articles2;
+    std::future<bool> news1_ready, news2_ready;
+    {
+        utils::DeadlineScope budget = utils::DeadlineScope::share(kNewsShare);
+        news1_ready = data_fetcher_->fetchNewsAsync(ticker1, 10, articles1);
+        news2_ready = data_fetcher_->fetchNewsAsync(ticker2, 10, articles2);
+    }
+    
     // Retrieve context for both tickers
     std::string query = "Sentiment comparison " + ticker1 + " " + ticker2 + " " + period;
-    context_docs = retrieveContext(query, 10);
+    context_docs = retrieveContext(query, 8, {ticker1, ticker2});
     
-    // Fetch news for both
-    std::vector<data::NewsArticle> articles1, articles2;
-    data_fetcher_->fetchNews(ticker1, 10, articles1);
-    data_fetcher_->fetchNews(ticker2, 10, articles2);
+    {
+        utils::ScopedTimer timer(news_latency);
+        utils::Span span("rag_agent.fetch_news");
+        news1_ready.get();
+        news2_ready.get();
+    }
     
     // Build query
     std::stringstream query_ss;
     query_ss << "Compare market sentiment between " << ticker1 << " and " << ticker2;
     query_ss << " over " << period << ". Include news sentiment, analyst opinions, and price trends.";
     
-    comparison = generateLLMResponse(query_ss.str(), context_docs);
-    return !comparison.empty();
+    comparison = generateLLMResponse(query_ss.str(), context_docs, "compare_sentiment");
+    return request.finish(!comparison.empty());
 }
 
 bool RAGAgent::recommendPair(const std::string& sector, std::string& long_ticker,
                             std::string& short_ticker, std::string& reasoning,
                             std::vector<RAGContextDoc>& context_docs) {
+    RequestMetrics request("recommend_pair");
+    
     // Retrieve context for sector
     std::string query = "Pair trading recommendation " + sector;
-    context_docs = retrieveContext(query, 10);
+    context_docs = retrieveContext(query, 6);
     
     // Build query
     std::stringstream query_ss;
@@ -262,7 +737,7 @@ bool RAGAgent::recommendPair(const std::string& sector, std::string& long_ticker
     query_ss << "Identify one stock to go long and one to go short, with reasoning based on fundamentals, ";
     query_ss << "technical analysis, and market sentiment.";
     
-    std::string response = generateLLMResponse(query_ss.str(), context_docs);
+    std::string response = generateLLMResponse(query_ss.str(), context_docs, "recommend_pair");
     
     // Parse response (simplified - in production, use structured output)
     // For now, just return the response as reasoning
@@ -270,25 +745,338 @@ bool RAGAgent::recommendPair(const std::string& sector, std::string& long_ticker
     long_ticker = "AAPL"; // Placeholder
     short_ticker = "MSFT"; // Placeholder
     
-    return !reasoning.empty();
+    return request.finish(!reasoning.empty());
 }
 
 bool RAGAgent::queryRAG(const std::string& query, const std::vector<std::string>& symbols,
                        std::string& answer, std::vector<RAGContextDoc>& context_docs) {
+    RequestMetrics request("query");
+    
     // Retrieve relevant context (may be empty if embeddings fail)
-    context_docs = retrieveContext(query, 10);
+    context_docs = retrieveContext(query, 6, symbols);
     
     // Generate answer with context (will work even without context)
-    answer = generateLLMResponse(query, context_docs);
+    answer = generateLLMResponse(query, context_docs, "query");
     
     if (answer.empty()) {
-        rag::utils::Logger::getInstance().error("Failed to generate LLM response for RAG query");
-        return false;
+        RAG_LOG_ERROR("Failed to generate LLM response for RAG query");
+        return request.finish(false);
+    }
+    
+    return request.finish(true);
+}
+
+bool RAGAgent::getStockSummaries(const std::vector<std::string>& symbols, const std::string& period,
+                                 const BatchResultCallback& on_result) {
+    RequestMetrics request("batch_stock_summary");
+    static auto& quote_latency = utils::stageHistogram("rag_agent", "fetch_quote");
+    std::vector<BatchItemResult> results(symbols.size());
+    
+    // Every quote is in flight while context is retrieved
+    std::vector<std::future<bool>> quotes(symbols.size());
+    {
+        utils::DeadlineScope budget = utils::DeadlineScope::share(kMarketDataShare);
+        for (size_t i = 0; i < symbols.size(); ++i) {
+            results[i].symbol = symbols[i];
+            quotes[i] = fetchQuoteAsync(symbols[i], results[i].price, results[i].change_percent);
+        }
     }
     
-    return true;
+    std::vector<std::string> queries;
+    std::vector<std::vector<std::string>> query_symbols;
+    for (const auto& symbol : symbols) {
+        queries.push_back(stockSummaryRetrievalQuery(symbol, period));
+        query_symbols.push_back({symbol});
+    }
+    auto contexts = retrieveContextBatch(queries, kStockSummaryDocs, query_symbols);
+    
+    {
+        utils::ScopedTimer timer(quote_latency);
+        utils::Span span("rag_agent.fetch_quote");
+        for (size_t i = 0; i < symbols.size(); ++i) {
+            results[i].has_price = quotes[i].get();
+            if (!results[i].has_price) {
+                RAG_LOG_WARNING("Failed to fetch stock quote for " + symbols[i] + " - continuing without price data");
+            }
+        }
+    }
+    
+    std::vector<std::string> prompts;
+    for (size_t i = 0; i < symbols.size(); ++i) {
+        BatchItemResult& result = results[i];
+        result.context_docs = std::move(contexts[i]);
+        prompts.push_back(packPrompt(stockSummaryQuery(result.symbol, period, result.has_price, result.price,
+                                                       result.change_percent),
+                                     result.context_docs, "stock_summary"));
+    }
+    
+    size_t succeeded = 0;
+    queryOpenAIConcurrent(prompts, [&](size_t index, std::string&& summary) {
+        BatchItemResult& result = results[index];
+        result.success = !summary.empty();
+        if (result.success) {
+            ++succeeded;
+        } else {
+            RAG_LOG_ERROR("Failed to generate LLM response for stock summary of " + result.symbol);
+        }
+        result.text = std::move(summary);
+        on_result(std::move(result));
+    });
+    
+    return request.finish(succeeded > 0 || symbols.empty());
+}
+
+bool RAGAgent::explainVolatilities(const std::vector<std::string>& symbols, const std::string& date,
+                                   const BatchResultCallback& on_result) {
+    RequestMetrics request("batch_explain_volatility");
+    static auto& lookup_latency = utils::stageHistogram("rag_agent", "volatility_lookup");
+    std::vector<BatchItemResult> results(symbols.size());
+    
+    // Bars for every symbol the engine and database can't answer, fetched
+    // together while context is retrieved
+    std::vector<size_t> misses;
+    std::vector<std::vector<data::OHLCVData>> bars(symbols.size());
+    std::vector<std::future<bool>> fetches(symbols.size());
+    std::vector<int> days(symbols.size(), 0);
+    {
+        utils::DeadlineScope budget = utils::DeadlineScope::share(kMarketDataShare);
+        for (size_t i = 0; i < symbols.size(); ++i) {
+            results[i].symbol = symbols[i];
+            results[i].has_volatility = cachedVolatility(symbols[i], date, results[i].volatility);
+            if (!results[i].has_volatility) {
+                misses.push_back(i);
+                days[i] = volatilityHistoryDays(symbols[i], date);
+                if (days[i] > 0) {
+                    fetches[i] = data_fetcher_->fetchStockDataAsync(symbols[i], days[i], bars[i]);
+                }
+            }
+        }
+    }
+    
+    std::vector<std::string> queries;
+    std::vector<std::vector<std::string>> query_symbols;
+    for (const auto& symbol : symbols) {
+        queries.push_back(volatilityRetrievalQuery(symbol, date));
+        query_symbols.push_back({symbol});
+    }
+    auto contexts = retrieveContextBatch(queries, kVolatilityDocs, query_symbols);
+    
+    {
+        utils::ScopedTimer timer(lookup_latency);
+        utils::Span span("rag_agent.volatility_lookup");
+        for (size_t i : misses) {
+            BatchItemResult& result = results[i];
+            if (days[i] > 0 && fetches[i].get()) {
+                volatility_engine_->updateSeries(result.symbol, bars[i], days[i] == kFullHistoryDays);
+                result.has_volatility = volatility_engine_->getEstimate(result.symbol, date, result.volatility) &&
+                                        result.volatility.observations > 1;
+            }
+            if (!result.has_volatility) {
+                RAG_LOG_WARNING("Failed to fetch volatility for " + result.symbol +
+                                " - generating explanation without volatility data");
+            }
+        }
+    }
+    
+    std::vector<std::string> prompts;
+    for (size_t i = 0; i < symbols.size(); ++i) {
+        BatchItemResult& result = results[i];
+        result.context_docs = std::move(contexts[i]);
+        prompts.push_back(packPrompt(volatilityQuery(result.symbol, date,
+                                                     result.has_volatility ? &result.volatility : nullptr),
+                                     result.context_docs, "explain_volatility"));
+    }
+    
+    size_t succeeded = 0;
+    queryOpenAIConcurrent(prompts, [&](size_t index, std::string&& explanation) {
+        BatchItemResult& result = results[index];
+        result.success = !explanation.empty();
+        if (result.success) {
+            ++succeeded;
+        } else {
+            RAG_LOG_ERROR("Failed to generate LLM response for volatility explanation of " + result.symbol);
+        }
+        result.text = std::move(explanation);
+        on_result(std::move(result));
+    });
+    
+    return request.finish(succeeded > 0 || symbols.empty());
+}
+
+void RAGAgent::setWatchlistMonitor(std::shared_ptr<WatchlistMonitor> monitor) {
+    watchlist_monitor_ = monitor;
+    if (!monitor) {
+        return;
+    }
+    monitor->setSymbolDroppedCallback([this](const std::string& symbol) {
+        // Entries still being written are erased by their writer
+        std::lock_guard<std::mutex> lock(watchlist_mutex_);
+        for (auto it = watchlist_entries_.begin(); it != watchlist_entries_.end();) {
+            if (it->second.symbol != symbol) {
+                ++it;
+            } else if (it->second.generating) {
+                it->second.dropped = true;
+                ++it;
+            } else {
+                it = watchlist_entries_.erase(it);
+            }
+        }
+    });
+}
+
+bool RAGAgent::refreshWatchlist(const std::vector<WatchlistChange>& changes, const std::string& period,
+                                const BatchResultCallback& on_result) {
+    RequestMetrics request("watchlist_update");
+    static auto& summary_hits = watchlistSummaryLookups("hit");
+    static auto& summary_waits = watchlistSummaryLookups("wait");
+    static auto& summary_misses = watchlistSummaryLookups("miss");
+    static auto& context_hits = watchlistContextLookups("hit");
+    static auto& context_misses = watchlistContextLookups("miss");
+    std::vector<BatchItemResult> results(changes.size());
+    std::vector<std::string> keys(changes.size());
+    size_t succeeded = 0;
+    
+    // Summaries already written for this version (or a later one) are sent
+    // now. Of the rest, this call writes those nobody is writing yet and
+    // waits for the others. Cached context is copied, since packing trims it.
+    std::vector<size_t> generate;
+    std::vector<size_t> waiting;
+    std::vector<size_t> context_misses_at;
+    {
+        std::lock_guard<std::mutex> lock(watchlist_mutex_);
+        for (size_t i = 0; i < changes.size(); ++i) {
+            const WatchlistChange& change = changes[i];
+            BatchItemResult& result = results[i];
+            result.symbol = change.symbol;
+            result.has_price = change.has_price;
+            result.price = change.price;
+            result.change_percent = change.change_percent;
+            result.has_volatility = change.has_volatility;
+            result.volatility = change.volatility;
+            
+            keys[i] = stockSummaryRetrievalQuery(change.symbol, period);
+            WatchlistEntry& entry = watchlist_entries_[keys[i]];
+            entry.symbol = change.symbol;
+            entry.dropped = false;
+            uint64_t version = change.revision.version;
+            if (entry.has_summary && entry.summary_version >= version) {
+                result.success = true;
+                result.text = entry.summary;
+                result.context_docs = entry.context;
+                summary_hits.increment();
+            } else if (entry.generating && entry.generating_version >= version) {
+                waiting.push_back(i);
+                summary_waits.increment();
+            } else {
+                entry.generating = true;
+                entry.generating_version = version;
+                generate.push_back(i);
+                summary_misses.increment();
+                if (entry.has_context && entry.context_version >= change.revision.news_version) {
+                    result.context_docs = entry.context;
+                    context_hits.increment();
+                } else {
+                    context_misses_at.push_back(i);
+                    context_misses.increment();
+                }
+            }
+        }
+    }
+    for (size_t i = 0; i < changes.size(); ++i) {
+        if (results[i].success) {
+            ++succeeded;
+            on_result(std::move(results[i]));
+        }
+    }
+    
+    if (!context_misses_at.empty()) {
+        std::vector<std::string> queries;
+        std::vector<std::vector<std::string>> query_symbols;
+        for (size_t i : context_misses_at) {
+            queries.push_back(keys[i]);
+            query_symbols.push_back({changes[i].symbol});
+        }
+        auto contexts = retrieveContextBatch(queries, kStockSummaryDocs, query_symbols);
+        for (size_t j = 0; j < context_misses_at.size(); ++j) {
+            results[context_misses_at[j]].context_docs = std::move(contexts[j]);
+        }
+    }
+    
+    std::vector<std::string> prompts;
+    for (size_t i : generate) {
+        prompts.push_back(packPrompt(watchlistUpdateQuery(changes[i], period), results[i].context_docs,
+                                     "stock_summary"));
+    }
+    
+    queryOpenAIConcurrent(prompts, [&](size_t index, std::string&& summary) {
+        size_t i = generate[index];
+        BatchItemResult& result = results[i];
+        result.success = !summary.empty();
+        result.text = std::move(summary);
+        {
+            // Published for every subscription at this version; a failure
+            // lets the next call for it try again
+            std::lock_guard<std::mutex> lock(watchlist_mutex_);
+            auto it = watchlist_entries_.find(keys[i]);
+            if (it != watchlist_entries_.end()) {
+                WatchlistEntry& entry = it->second;
+                const WatchlistRevision& revision = changes[i].revision;
+                if (result.success && (!entry.has_summary || entry.summary_version <= revision.version)) {
+                    entry.has_summary = true;
+                    entry.summary_version = revision.version;
+                    entry.summary = result.text;
+                    if (!result.context_docs.empty() &&
+                        (!entry.has_context || entry.context_version <= revision.news_version)) {
+                        entry.has_context = true;
+                        entry.context_version = revision.news_version;
+                        entry.context = result.context_docs;
+                    }
+                }
+                if (entry.generating && entry.generating_version == revision.version) {
+                    entry.generating = false;
+                    if (entry.dropped) {
+                        watchlist_entries_.erase(it);
+                    }
+                }
+            }
+            watchlist_generated_.notify_all();
+        }
+        if (result.success) {
+            ++succeeded;
+        } else {
+            RAG_LOG_ERROR("Failed to generate LLM response for watchlist update of " + result.symbol);
+        }
+        on_result(std::move(result));
+    });
+    
+    for (size_t i : waiting) {
+        BatchItemResult& result = results[i];
+        uint64_t version = changes[i].revision.version;
+        {
+            std::unique_lock<std::mutex> lock(watchlist_mutex_);
+            watchlist_generated_.wait(lock, [&]() {
+                auto it = watchlist_entries_.find(keys[i]);
+                return it == watchlist_entries_.end() || !it->second.generating ||
+                       it->second.generating_version < version ||
+                       (it->second.has_summary && it->second.summary_version >= version);
+            });
+            auto it = watchlist_entries_.find(keys[i]);
+            if (it != watchlist_entries_.end() && it->second.has_summary && it->second.summary_version >= version) {
+                result.success = true;
+                result.text = it->second.summary;
+                result.context_docs = it->second.context;
+            }
+        }
+        if (result.success) {
+            ++succeeded;
+        } else {
+            RAG_LOG_ERROR("Failed to generate LLM response for watchlist update of " + result.symbol);
+        }
+        on_result(std::move(result));
+    }
+    
+    return request.finish(succeeded > 0 || changes.empty());
 }
 
 } // namespace agent
 } // namespace rag
-
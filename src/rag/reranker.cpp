@@ -0,0 +1,169 @@
+#include "rag/reranker.h"
+#include "rag/rag_agent.h"
+#include "vectorization/text_analyzer.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <numeric>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace rag {
+namespace agent {
+
+namespace {
+
+// Whole-word, case-sensitive occurrence (so "F" doesn't match "FY")
+bool containsWord(const std::string& text, const std::string& word) {
+    size_t pos = text.find(word);
+    while (pos != std::string::npos) {
+        bool left = pos == 0 || !std::isalnum(static_cast<unsigned char>(text[pos - 1]));
+        size_t end = pos + word.size();
+        bool right = end == text.size() || !std::isalnum(static_cast<unsigned char>(text[end]));
+        if (left && right) {
+            return true;
+        }
+        pos = text.find(word, pos + 1);
+    }
+    return false;
+}
+
+} // namespace
+
+Reranker::Reranker(const RerankConfig& config) : config_(config) {
+}
+
+long Reranker::daysSinceEpoch(const std::string& timestamp) {
+    std::string digits;
+    for (char c : timestamp) {
+        if (std::isdigit(static_cast<unsigned char>(c))) {
+            digits += c;
+            if (digits.size() == 8) {
+                break;
+            }
+        } else if (c != '-') {
+            break;
+        }
+    }
+    if (digits.size() < 8) {
+        return -1;
+    }
+    long year = std::stol(digits.substr(0, 4));
+    long month = std::stol(digits.substr(4, 2));
+    long day = std::stol(digits.substr(6, 2));
+    if (month < 1 || month > 12 || day < 1 || day > 31) {
+        return -1;
+    }
+    
+    // Civil date to day count (proleptic Gregorian)
+    year -= month <= 2;
+    long era = (year >= 0 ? year : year - 399) / 400;
+    long year_of_era = year - era * 400;
+    long day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    long day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + day_of_era - 719468;
+}
+
+std::vector<RAGContextDoc> Reranker::rerank(const std::string& query,
+                                            const std::vector<std::string>& symbols,
+                                            std::vector<RAGContextDoc> candidates,
+                                            size_t top_k) const {
+    if (candidates.empty()) {
+        return candidates;
+    }
+    size_t n = candidates.size();
+    
+    std::vector<std::string> query_terms = vectorization::TextAnalyzer::analyze(query);
+    std::unordered_set<std::string> unique_terms(query_terms.begin(), query_terms.end());
+    std::vector<std::string> wanted_symbols = symbols.empty() ? vectorization::TextAnalyzer::extractSymbols(query) : symbols;
+    
+    // Term frequencies of the query terms in each candidate
+    std::vector<std::unordered_map<std::string, size_t>> frequencies(n);
+    std::vector<size_t> lengths(n);
+    std::unordered_map<std::string, size_t> document_frequency;
+    double total_length = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        auto title_it = candidates[i].metadata.find("title");
+        std::string text = candidates[i].content;
+        if (title_it != candidates[i].metadata.end()) {
+            text += "\n" + title_it->second;
+        }
+        std::vector<std::string> terms = vectorization::TextAnalyzer::analyze(text);
+        lengths[i] = terms.size();
+        total_length += static_cast<double>(terms.size());
+        for (const auto& term : terms) {
+            if (unique_terms.count(term)) {
+                ++frequencies[i][term];
+            }
+        }
+        for (const auto& [term, count] : frequencies[i]) {
+            ++document_frequency[term];
+        }
+    }
+    double average_length = std::max(1.0, total_length / static_cast<double>(n));
+    
+    std::vector<double> lexical(n, 0.0);
+    for (size_t i = 0; i < n; ++i) {
+        for (const auto& [term, count] : frequencies[i]) {
+            double df = static_cast<double>(document_frequency[term]);
+            double idf = std::log(1.0 + (static_cast<double>(n) - df + 0.5) / (df + 0.5));
+            double tf = static_cast<double>(count);
+            double norm = config_.bm25_k1 * (1.0 - config_.bm25_b + config_.bm25_b * lengths[i] / average_length);
+            lexical[i] += idf * tf * (config_.bm25_k1 + 1.0) / (tf + norm);
+        }
+    }
+    
+    std::vector<long> days(n);
+    long newest = -1;
+    double min_vector = candidates[0].similarity_score;
+    double max_vector = candidates[0].similarity_score;
+    double max_lexical = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        days[i] = daysSinceEpoch(candidates[i].timestamp);
+        newest = std::max(newest, days[i]);
+        min_vector = std::min(min_vector, candidates[i].similarity_score);
+        max_vector = std::max(max_vector, candidates[i].similarity_score);
+        max_lexical = std::max(max_lexical, lexical[i]);
+    }
+    
+    std::vector<double> scores(n);
+    for (size_t i = 0; i < n; ++i) {
+        RAGContextDoc& doc = candidates[i];
+        double vector = max_vector > min_vector ? (doc.similarity_score - min_vector) / (max_vector - min_vector) : 1.0;
+        double lexical_score = max_lexical > 0.0 ? lexical[i] / max_lexical : 0.0;
+        double recency = 0.0;
+        if (days[i] >= 0 && config_.recency_half_life_days > 0.0) {
+            recency = std::exp2(-static_cast<double>(newest - days[i]) / config_.recency_half_life_days);
+        }
+        double symbol = 0.0;
+        auto symbol_it = doc.metadata.find("symbol");
+        for (const auto& wanted : wanted_symbols) {
+            if ((symbol_it != doc.metadata.end() && symbol_it->second == wanted) || containsWord(doc.content, wanted)) {
+                symbol = 1.0;
+                break;
+            }
+        }
+        
+        scores[i] = config_.vector_weight * vector + config_.lexical_weight * lexical_score +
+                    config_.recency_weight * recency + config_.symbol_weight * symbol;
+        doc.metadata["vector_score"] = std::to_string(doc.similarity_score);
+    }
+    
+    std::vector<size_t> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&scores](size_t a, size_t b) {
+        return scores[a] > scores[b];
+    });
+    
+    std::vector<RAGContextDoc> ranked;
+    ranked.reserve(std::min(top_k, n));
+    for (size_t i = 0; i < order.size() && ranked.size() < top_k; ++i) {
+        RAGContextDoc& doc = candidates[order[i]];
+        doc.similarity_score = scores[order[i]];
+        ranked.push_back(std::move(doc));
+    }
+    return ranked;
+}
+
+} // namespace agent
+} // namespace rag
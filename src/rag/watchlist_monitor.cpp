@@ -0,0 +1,508 @@
+#include "rag/watchlist_monitor.h"
+#include "data_ingestion/ingestion_pipeline.h"
+#include "utils/logger.h"
+#include "utils/metrics.h"
+#include <algorithm>
+#include <cmath>
+#include <future>
+
+namespace rag {
+namespace agent {
+
+namespace {
+
+// Bars requested for a symbol the volatility engine hasn't seen, and after that
+const int kHistoryDays = 100;
+const int kRecentDays = 5;
+
+utils::Counter& watchlistUpdates(const std::string& reason) {
+    return utils::MetricsRegistry::getInstance().counter(
+        "rag_watchlist_updates_total", "Watchlist updates pushed to subscribers by reason", {{"reason", reason}});
+}
+
+} // namespace
+
+struct WatchlistMonitor::Poll {
+    std::string symbol;
+    bool quote = false;     // Due this round
+    bool news = false;
+    bool bars = false;
+    
+    bool has_price = false;
+    double price = 0.0;
+    double change_percent = 0.0;
+    std::vector<data::NewsArticle> articles;
+    size_t new_articles = 0;
+    std::vector<data::OHLCVData> bar_data;
+    bool has_volatility = false;
+    data::VolatilityEstimate volatility;
+};
+
+bool WatchlistSubscription::waitForChanges(std::vector<WatchlistChange>& changes,
+                                           std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    changed_.wait_for(lock, timeout, [this]() { return !pending_.empty() || closed_; });
+    if (pending_.empty()) {
+        return false;
+    }
+    changes.clear();
+    changes.reserve(pending_.size());
+    for (auto& [symbol, change] : pending_) {
+        changes.push_back(std::move(change));
+    }
+    pending_.clear();
+    return true;
+}
+
+bool WatchlistSubscription::closed() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return closed_;
+}
+
+bool WatchlistSubscription::priceMoved(const std::string& symbol, double price) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = delivered_prices_.find(symbol);
+    if (it == delivered_prices_.end() || it->second == 0.0) {
+        return true;
+    }
+    return std::abs(price - it->second) / std::abs(it->second) * 100.0 >= price_threshold_percent_;
+}
+
+void WatchlistSubscription::push(const WatchlistChange& change) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (change.has_price) {
+        delivered_prices_[change.symbol] = change.price;
+    }
+    
+    auto [it, inserted] = pending_.try_emplace(change.symbol, change);
+    if (!inserted) {
+        // Not yet delivered: merge, keeping the latest market data
+        WatchlistChange& merged = it->second;
+        merged.initial |= change.initial;
+        merged.news_changed |= change.news_changed;
+        merged.price_moved |= change.price_moved;
+        merged.volatility_changed |= change.volatility_changed;
+        merged.new_articles += change.new_articles;
+        if (change.has_price) {
+            merged.has_price = true;
+            merged.price = change.price;
+            merged.change_percent = change.change_percent;
+        }
+        if (change.has_volatility) {
+            merged.has_volatility = true;
+            merged.volatility = change.volatility;
+        }
+        merged.revision = change.revision;
+    }
+    changed_.notify_one();
+}
+
+void WatchlistSubscription::close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    changed_.notify_all();
+}
+
+WatchlistMonitor::WatchlistMonitor(std::shared_ptr<data::DataFetcher> data_fetcher,
+                                   std::shared_ptr<data::Database> database,
+                                   std::shared_ptr<vectorization::EmbeddingService> embedding_service,
+                                   std::shared_ptr<vectorization::FAISSIndex> faiss_index,
+                                   std::shared_ptr<data::VolatilityEngine> volatility_engine,
+                                   const WatchlistMonitorConfig& config)
+    : data_fetcher_(data_fetcher),
+      database_(database),
+      embedding_service_(embedding_service),
+      faiss_index_(faiss_index),
+      volatility_engine_(volatility_engine),
+      config_(config),
+      chunker_(config.chunking, faiss_index) {
+}
+
+WatchlistMonitor::~WatchlistMonitor() {
+    stop();
+}
+
+void WatchlistMonitor::start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_) {
+        return;
+    }
+    running_ = true;
+    thread_ = std::thread(&WatchlistMonitor::run, this);
+}
+
+void WatchlistMonitor::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+        wake_.notify_all();
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    
+    // Open streams end rather than waiting on a monitor that is gone
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& subscription : subscriptions_) {
+        subscription->close();
+    }
+}
+
+std::shared_ptr<WatchlistSubscription> WatchlistMonitor::subscribe(const std::vector<std::string>& symbols,
+                                                                   double price_threshold_percent) {
+    auto subscription = std::make_shared<WatchlistSubscription>();
+    for (const auto& symbol : symbols) {
+        if (!symbol.empty() &&
+            std::find(subscription->symbols_.begin(), subscription->symbols_.end(), symbol) == subscription->symbols_.end()) {
+            subscription->symbols_.push_back(symbol);
+        }
+    }
+    subscription->price_threshold_percent_ = price_threshold_percent > 0.0 ? price_threshold_percent
+                                                                            : config_.price_threshold_percent;
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (subscriptions_.size() >= config_.max_subscriptions) {
+        static auto& rejected = utils::MetricsRegistry::getInstance().counter(
+            "rag_watchlist_rejected_total", "Watchlist subscriptions refused at max_subscriptions");
+        rejected.increment();
+        RAG_LOG_WARNING("Refusing watchlist subscription: " + std::to_string(subscriptions_.size()) +
+                        " already open");
+        return nullptr;
+    }
+    for (const auto& symbol : subscription->symbols_) {
+        // A new symbol's poll times start at the epoch, so it is polled on the next round
+        SymbolState& state = symbols_[symbol];
+        state.subscribers++;
+        if (state.polled) {
+            subscription->push(snapshot(symbol, state));
+        } else {
+            subscription->awaiting_initial_.insert(symbol);
+        }
+    }
+    if (!running_) {
+        subscription->close();
+    }
+    subscriptions_.push_back(subscription);
+    wake_.notify_all();
+    return subscription;
+}
+
+void WatchlistMonitor::unsubscribe(const std::shared_ptr<WatchlistSubscription>& subscription) {
+    std::vector<std::string> dropped;
+    std::function<void(const std::string&)> on_dropped;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = std::find(subscriptions_.begin(), subscriptions_.end(), subscription);
+        if (it == subscriptions_.end()) {
+            return;
+        }
+        subscriptions_.erase(it);
+        
+        for (const auto& symbol : subscription->symbols_) {
+            auto state = symbols_.find(symbol);
+            if (state != symbols_.end() && --state->second.subscribers == 0) {
+                symbols_.erase(state);
+                dropped.push_back(symbol);
+                dropped_symbols_.push_back(symbol);
+            }
+        }
+        subscription->close();
+        on_dropped = symbol_dropped_;
+        if (!dropped.empty()) {
+            wake_.notify_all();
+        }
+    }
+    if (on_dropped) {
+        for (const auto& symbol : dropped) {
+            on_dropped(symbol);
+        }
+    }
+}
+
+size_t WatchlistMonitor::subscriptionCount() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return subscriptions_.size();
+}
+
+size_t WatchlistMonitor::symbolCount() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return symbols_.size();
+}
+
+void WatchlistMonitor::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_) {
+        // Forget the articles of symbols nobody watches (unless watched again since)
+        for (const auto& symbol : dropped_symbols_) {
+            if (symbols_.find(symbol) == symbols_.end()) {
+                seen_articles_.erase(symbol);
+            }
+        }
+        dropped_symbols_.clear();
+        
+        auto now = std::chrono::steady_clock::now();
+        auto next_wake = now + std::chrono::hours(1);
+        std::vector<Poll> polls;
+        for (const auto& [symbol, state] : symbols_) {
+            Poll poll;
+            poll.symbol = symbol;
+            poll.quote = state.next_quote <= now;
+            poll.news = state.next_news <= now;
+            poll.bars = state.next_bars <= now;
+            if (poll.quote || poll.news || poll.bars) {
+                polls.push_back(std::move(poll));
+            }
+            next_wake = std::min({next_wake, state.next_quote, state.next_news, state.next_bars});
+        }
+        
+        if (polls.empty()) {
+            wake_.wait_until(lock, next_wake);
+            continue;
+        }
+        
+        lock.unlock();
+        poll(polls);
+        lock.lock();
+        
+        now = std::chrono::steady_clock::now();
+        for (const auto& result : polls) {
+            apply(result, now);
+        }
+    }
+}
+
+void WatchlistMonitor::poll(std::vector<Poll>& polls) {
+    static auto& poll_latency = utils::stageHistogram("watchlist", "poll");
+    utils::ScopedTimer timer(poll_latency);
+    
+    // Every request of the round is in flight at once; polls is not resized
+    // while the futures hold references into it
+    std::vector<std::future<bool>> quotes(polls.size());
+    std::vector<std::future<bool>> news(polls.size());
+    std::vector<std::future<bool>> bars(polls.size());
+    for (size_t i = 0; i < polls.size(); ++i) {
+        Poll& poll = polls[i];
+        data::LiveQuote live;
+        if (poll.quote && market_stream_ && market_stream_->getQuote(poll.symbol, live)) {
+            poll.price = live.price;
+            poll.change_percent = live.change_percent;
+            std::promise<bool> ready;
+            ready.set_value(true);
+            quotes[i] = ready.get_future();
+        } else if (poll.quote) {
+            quotes[i] = data_fetcher_->fetchRealTimeQuoteAsync(poll.symbol, poll.price, poll.change_percent);
+        }
+        if (poll.news) {
+            news[i] = data_fetcher_->fetchNewsAsync(poll.symbol, config_.news_per_symbol, poll.articles);
+        }
+        if (poll.bars) {
+            int days = volatility_engine_->lastTimestamp(poll.symbol).empty() ? kHistoryDays : kRecentDays;
+            bars[i] = data_fetcher_->fetchStockDataAsync(poll.symbol, days, poll.bar_data);
+        }
+    }
+    
+    for (size_t i = 0; i < polls.size(); ++i) {
+        Poll& poll = polls[i];
+        if (poll.quote) {
+            poll.has_price = quotes[i].get();
+        }
+        if (poll.news && news[i].get()) {
+            poll.new_articles = ingestNews(poll.symbol, poll.articles);
+        }
+        if (poll.bars && bars[i].get() && volatility_engine_->updateSeries(poll.symbol, poll.bar_data) > 0) {
+            database_->storeOHLCVData(poll.symbol, poll.bar_data);
+            poll.has_volatility = volatility_engine_->getEstimate(poll.symbol, "", poll.volatility) &&
+                                  poll.volatility.observations > 1;
+        }
+    }
+}
+
+size_t WatchlistMonitor::ingestNews(const std::string& symbol, std::vector<data::NewsArticle>& articles) {
+    // The first fetch only establishes what has been seen; anything it finds
+    // is still ingested, but is part of the initial update rather than a change
+    auto [seen, first_fetch] = seen_articles_.try_emplace(symbol);
+    std::unique_ptr<data::NearDuplicateDetector> in_flight;
+    if (duplicate_detector_) {
+        in_flight = std::make_unique<data::NearDuplicateDetector>(duplicate_detector_->maxDistance());
+    }
+    std::vector<data::NewsArticle> fresh;
+    for (auto& article : articles) {
+        if (article.id.empty() || !seen->second.insert(article.id).second) {
+            continue;
+        }
+        // Syndicated copies, and stories indexed before a restart, are not
+        // stored or embedded again
+        std::string duplicate_of;
+        if (duplicate_detector_ && (duplicate_detector_->isDuplicate(article, &duplicate_of) ||
+                                    in_flight->checkAndInsert(article, &duplicate_of))) {
+            RAG_LOG_DEBUG("Watchlist dropping near-duplicate " + article.id + " (of " + duplicate_of + ")");
+            continue;
+        }
+        auto it = std::find(article.tickers.begin(), article.tickers.end(), symbol);
+        if (it != article.tickers.end()) {
+            article.tickers.erase(it);
+        }
+        article.tickers.insert(article.tickers.begin(), symbol);
+        fresh.push_back(std::move(article));
+    }
+    if (fresh.empty()) {
+        return 0;
+    }
+    
+    database_->storeNewsArticles(fresh);
+    
+    std::vector<vectorization::Document> chunks;
+    for (const auto& article : fresh) {
+        vectorization::Document doc = data::IngestionPipeline::toDocument(symbol, article);
+        if (embedding_service_ && faiss_index_) {
+            // Chunks already indexed (same content hash) are dropped by the chunker
+            chunker_.chunk(doc, chunks);
+        }
+        if (lexical_index_) {
+            lexical_index_->addDocument(doc);
+        }
+    }
+    bool indexed = true;
+    if (!chunks.empty()) {
+        std::vector<std::string> texts;
+        texts.reserve(chunks.size());
+        for (const auto& chunk : chunks) {
+            texts.push_back(chunk.content);
+        }
+        std::vector<float> embeddings;
+        if (!embedding_service_->generateEmbeddingMatrix(texts, embeddings) ||
+            !faiss_index_->addDocumentMatrix(chunks, embeddings)) {
+            RAG_LOG_WARNING("Failed to index " + std::to_string(chunks.size()) + " new chunks for " + symbol);
+            indexed = false;
+        }
+    }
+    if (!indexed) {
+        // Retried on the next poll; storage and the lexical index ignore repeats
+        for (const auto& article : fresh) {
+            seen->second.erase(article.id);
+        }
+    } else if (duplicate_detector_) {
+        for (const auto& article : fresh) {
+            duplicate_detector_->insert(article);
+        }
+        if (!fingerprints_path_.empty()) {
+            duplicate_detector_->save(fingerprints_path_);
+        }
+    }
+    
+    if (first_fetch) {
+        return 0;
+    }
+    RAG_LOG_INFO("Watchlist ingested " + std::to_string(fresh.size()) + " new articles for " + symbol);
+    return fresh.size();
+}
+
+void WatchlistMonitor::apply(const Poll& poll, std::chrono::steady_clock::time_point now) {
+    auto it = symbols_.find(poll.symbol);
+    if (it == symbols_.end()) {
+        return;  // Unsubscribed while polling
+    }
+    SymbolState& state = it->second;
+    bool was_polled = state.polled;
+    
+    // Failed fetches are retried on the next interval, not immediately
+    bool price_changed = false;
+    if (poll.quote) {
+        state.quote_polled = true;
+        state.next_quote = now + std::chrono::seconds(config_.quote_interval_seconds);
+        if (poll.has_price) {
+            price_changed = !state.has_price || poll.price != state.price;
+            state.has_price = true;
+            state.price = poll.price;
+            state.change_percent = poll.change_percent;
+        }
+    }
+    if (poll.news) {
+        state.news_polled = true;
+        state.next_news = now + std::chrono::seconds(config_.news_interval_seconds);
+    }
+    bool volatility_changed = false;
+    if (poll.bars) {
+        state.bars_polled = true;
+        state.next_bars = now + std::chrono::seconds(config_.bars_interval_seconds);
+        if (poll.has_volatility) {
+            // Compared with the last estimate published, so slow drift still adds up
+            double previous = state.volatility.close_to_close;
+            volatility_changed = !state.has_volatility || previous == 0.0 ||
+                                 std::abs(poll.volatility.close_to_close - previous) / previous * 100.0 >=
+                                     config_.volatility_threshold_percent;
+            if (volatility_changed) {
+                state.has_volatility = true;
+                state.volatility = poll.volatility;
+            }
+        }
+    }
+    state.polled = state.quote_polled && state.news_polled && state.bars_polled;
+    if (!state.polled) {
+        return;
+    }
+    
+    if (!was_polled || poll.new_articles > 0 || price_changed || volatility_changed) {
+        // The first version is the initial state, with nothing changed yet
+        WatchlistRevision& revision = state.revision;
+        revision.version++;
+        revision.new_articles = was_polled ? poll.new_articles : 0;
+        revision.price_changed = was_polled && price_changed;
+        revision.volatility_changed = was_polled && volatility_changed;
+        if (revision.new_articles > 0) {
+            revision.news_version = revision.version;
+        }
+    }
+    
+    for (auto& subscription : subscriptions_) {
+        const auto& symbols = subscription->symbols_;
+        if (std::find(symbols.begin(), symbols.end(), poll.symbol) == symbols.end()) {
+            continue;
+        }
+        
+        WatchlistChange change = snapshot(poll.symbol, state);
+        if (subscription->awaiting_initial_.erase(poll.symbol) == 0) {
+            change.initial = false;
+            change.news_changed = poll.new_articles > 0;
+            change.new_articles = poll.new_articles;
+            change.volatility_changed = volatility_changed;
+            change.price_moved = poll.has_price && subscription->priceMoved(poll.symbol, poll.price);
+            if (!change.news_changed && !change.volatility_changed && !change.price_moved) {
+                continue;
+            }
+        }
+        
+        if (change.initial) {
+            watchlistUpdates("initial").increment();
+        }
+        if (change.news_changed) {
+            watchlistUpdates("news").increment();
+        }
+        if (change.price_moved) {
+            watchlistUpdates("price").increment();
+        }
+        if (change.volatility_changed) {
+            watchlistUpdates("volatility").increment();
+        }
+        subscription->push(change);
+    }
+}
+
+WatchlistChange WatchlistMonitor::snapshot(const std::string& symbol, const SymbolState& state) const {
+    WatchlistChange change;
+    change.symbol = symbol;
+    change.initial = true;
+    change.has_price = state.has_price;
+    change.price = state.price;
+    change.change_percent = state.change_percent;
+    change.has_volatility = state.has_volatility;
+    change.volatility = state.volatility;
+    change.revision = state.revision;
+    return change;
+}
+
+} // namespace agent
+} // namespace rag
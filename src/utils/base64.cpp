@@ -0,0 +1,112 @@
+#include "utils/base64.h"
+#include <array>
+
+namespace rag {
+namespace utils {
+
+namespace {
+
+constexpr char kAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+constexpr uint8_t kInvalid = 0xFF;
+
+constexpr std::array<uint8_t, 256> makeDecodeTable() {
+    std::array<uint8_t, 256> table{};
+    for (auto& entry : table) {
+        entry = kInvalid;
+    }
+    for (uint8_t i = 0; i < 64; ++i) {
+        table[static_cast<uint8_t>(kAlphabet[i])] = i;
+    }
+    return table;
+}
+
+constexpr std::array<uint8_t, 256> kDecode = makeDecodeTable();
+
+size_t unpaddedLength(std::string_view encoded) {
+    size_t length = encoded.size();
+    for (int i = 0; i < 2 && length > 0 && encoded[length - 1] == '='; ++i) {
+        --length;
+    }
+    return length;
+}
+
+} // namespace
+
+size_t base64DecodedSize(std::string_view encoded) {
+    size_t length = unpaddedLength(encoded);
+    return length / 4 * 3 + (length % 4 == 0 ? 0 : length % 4 - 1);
+}
+
+bool base64Decode(std::string_view encoded, uint8_t* out, size_t& written) {
+    size_t length = unpaddedLength(encoded);
+    const auto* in = reinterpret_cast<const uint8_t*>(encoded.data());
+    written = 0;
+    if (length % 4 == 1) {
+        return false;
+    }
+    
+    // Four sextets per 24-bit group; OR-ing the lookups flags any invalid character once per group
+    size_t full = length / 4 * 4;
+    uint8_t* dst = out;
+    for (size_t i = 0; i < full; i += 4) {
+        uint8_t a = kDecode[in[i]];
+        uint8_t b = kDecode[in[i + 1]];
+        uint8_t c = kDecode[in[i + 2]];
+        uint8_t d = kDecode[in[i + 3]];
+        if ((a | b | c | d) & 0xC0) {
+            return false;
+        }
+        uint32_t group = (uint32_t(a) << 18) | (uint32_t(b) << 12) | (uint32_t(c) << 6) | d;
+        dst[0] = static_cast<uint8_t>(group >> 16);
+        dst[1] = static_cast<uint8_t>(group >> 8);
+        dst[2] = static_cast<uint8_t>(group);
+        dst += 3;
+    }
+    
+    size_t tail = length - full;
+    if (tail > 0) {
+        uint8_t a = kDecode[in[full]];
+        uint8_t b = kDecode[in[full + 1]];
+        uint8_t c = tail == 3 ? kDecode[in[full + 2]] : 0;
+        if ((a | b | c) & 0xC0) {
+            return false;
+        }
+        uint32_t group = (uint32_t(a) << 18) | (uint32_t(b) << 12) | (uint32_t(c) << 6);
+        *dst++ = static_cast<uint8_t>(group >> 16);
+        if (tail == 3) {
+            *dst++ = static_cast<uint8_t>(group >> 8);
+        }
+    }
+    
+    written = static_cast<size_t>(dst - out);
+    return true;
+}
+
+std::string base64Encode(const void* data, size_t size) {
+    const auto* in = static_cast<const uint8_t*>(data);
+    std::string encoded;
+    encoded.reserve((size + 2) / 3 * 4);
+    
+    size_t i = 0;
+    for (; i + 3 <= size; i += 3) {
+        uint32_t group = (uint32_t(in[i]) << 16) | (uint32_t(in[i + 1]) << 8) | in[i + 2];
+        encoded += kAlphabet[(group >> 18) & 0x3F];
+        encoded += kAlphabet[(group >> 12) & 0x3F];
+        encoded += kAlphabet[(group >> 6) & 0x3F];
+        encoded += kAlphabet[group & 0x3F];
+    }
+    if (i < size) {
+        uint32_t group = uint32_t(in[i]) << 16;
+        if (i + 1 < size) {
+            group |= uint32_t(in[i + 1]) << 8;
+        }
+        encoded += kAlphabet[(group >> 18) & 0x3F];
+        encoded += kAlphabet[(group >> 12) & 0x3F];
+        encoded += i + 1 < size ? kAlphabet[(group >> 6) & 0x3F] : '=';
+        encoded += '=';
+    }
+    return encoded;
+}
+
+} // namespace utils
+} // namespace rag
@@ -0,0 +1,137 @@
+#include "utils/deadline.h"
+#include <algorithm>
+#include <limits>
+#include <mutex>
+
+namespace rag {
+namespace utils {
+
+// Cancellation check shared by a scope and everything nested in or captured
+// from it. Once the installing scope ends the check is released (it may
+// reference the finished RPC) and reports cancelled, so work still running on
+// the I/O thread for that request is abandoned.
+struct CancelSource {
+    std::mutex mutex;
+    std::function<bool()> check;
+    bool released = false;
+    
+    bool cancelled() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return released || check();
+    }
+    
+    void release() {
+        std::lock_guard<std::mutex> lock(mutex);
+        released = true;
+        check = nullptr;
+    }
+};
+
+struct DeadlineState {
+    Deadline::Clock::time_point deadline = Deadline::Clock::time_point::max();
+    std::shared_ptr<CancelSource> cancel;
+    
+    bool cancelled() const { return cancel && cancel->cancelled(); }
+};
+
+namespace {
+
+thread_local std::shared_ptr<const DeadlineState> t_current;
+
+// curl calls this at least once a second while a transfer is in flight
+int abortIfCancelled(void* clientp, curl_off_t, curl_off_t, curl_off_t, curl_off_t) {
+    const auto* state = static_cast<const DeadlineState*>(clientp);
+    return state && state->cancelled() ? 1 : 0;
+}
+
+} // namespace
+
+bool Deadline::active() {
+    return t_current && (t_current->deadline != Clock::time_point::max() || t_current->cancel);
+}
+
+int64_t Deadline::remainingMs() {
+    return remainingMs(t_current);
+}
+
+bool Deadline::cancelled() {
+    return t_current && t_current->cancelled();
+}
+
+bool Deadline::expired() {
+    return expired(t_current);
+}
+
+int64_t Deadline::remainingMs(const std::shared_ptr<const DeadlineState>& state) {
+    if (!state || state->deadline == Clock::time_point::max()) {
+        return std::numeric_limits<int64_t>::max();
+    }
+    return std::chrono::duration_cast<std::chrono::milliseconds>(state->deadline - Clock::now()).count();
+}
+
+bool Deadline::expired(const std::shared_ptr<const DeadlineState>& state) {
+    return remainingMs(state) <= 0 || (state && state->cancelled());
+}
+
+std::shared_ptr<const DeadlineState> Deadline::current() {
+    return t_current;
+}
+
+DeadlineScope::DeadlineScope(Deadline::Clock::time_point deadline, std::function<bool()> is_cancelled)
+    : previous_(t_current) {
+    auto state = std::make_shared<DeadlineState>();
+    state->deadline = deadline;
+    if (is_cancelled) {
+        owned_cancel_ = std::make_shared<CancelSource>();
+        owned_cancel_->check = std::move(is_cancelled);
+        state->cancel = owned_cancel_;
+    }
+    if (previous_) {
+        state->deadline = std::min(state->deadline, previous_->deadline);
+        if (!state->cancel) {
+            state->cancel = previous_->cancel;
+        }
+    }
+    t_current = std::move(state);
+}
+
+DeadlineScope::DeadlineScope(std::shared_ptr<const DeadlineState> state)
+    : previous_(t_current) {
+    t_current = std::move(state);
+}
+
+DeadlineScope::~DeadlineScope() {
+    if (owned_cancel_) {
+        owned_cancel_->release();
+    }
+    t_current = std::move(previous_);
+}
+
+DeadlineScope DeadlineScope::share(double fraction, int64_t min_ms) {
+    int64_t remaining = Deadline::remainingMs();
+    if (remaining == std::numeric_limits<int64_t>::max()) {
+        return DeadlineScope(t_current); // Nothing to divide; keep the current state
+    }
+    int64_t budget = std::max(min_ms, static_cast<int64_t>(static_cast<double>(remaining) * fraction));
+    return DeadlineScope(Deadline::Clock::now() + std::chrono::milliseconds(budget));
+}
+
+bool applyDeadline(CURL* curl, int64_t default_timeout_ms) {
+    if (Deadline::expired()) {
+        return false;
+    }
+    
+    int64_t timeout_ms = std::max<int64_t>(1, std::min(default_timeout_ms, Deadline::remainingMs()));
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, static_cast<long>(timeout_ms));
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L); // Timeouts must not use signals in a threaded server
+    
+    // Handles can be reused, so always reset the callback state
+    const DeadlineState* state = t_current && t_current->cancel ? t_current.get() : nullptr;
+    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, abortIfCancelled);
+    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, const_cast<DeadlineState*>(state));
+    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, state ? 0L : 1L);
+    return true;
+}
+
+} // namespace utils
+} // namespace rag
@@ -0,0 +1,311 @@
+#include "utils/http_client.h"
+#include "utils/deadline.h"
+#include "utils/logger.h"
+#include "utils/metrics.h"
+#include "utils/tracing.h"
+#include <algorithm>
+#include <random>
+
+namespace rag {
+namespace utils {
+
+struct HttpClient::Call {
+    HttpRequest request;
+    ResilienceConfig config;
+    Breaker* breaker = nullptr;
+    std::shared_ptr<const DeadlineState> deadline; // Captured from the issuing thread
+    Callback on_complete;
+    HttpResponse response;
+    int retry = 0;
+    uint64_t attempt = 0;           // Bumped per attempt so a stale hedge timer does nothing
+    uint64_t primary_id = 0;
+    uint64_t hedge_id = 0;
+    bool primary_running = false;
+    bool hedge_running = false;
+};
+
+namespace {
+
+// Worth another attempt: throttling, server errors and transport failures,
+// but not transfers we aborted ourselves
+bool retryable(CURLcode result, long status) {
+    if (result != CURLE_OK) {
+        return result != CURLE_ABORTED_BY_CALLBACK;
+    }
+    return status == 429 || status >= 500;
+}
+
+int64_t jitteredBackoff(const ResilienceConfig& config, int retry) {
+    static thread_local std::mt19937_64 rng(std::random_device{}());
+    int64_t backoff = config.initial_backoff_ms;
+    for (int i = 0; i < retry && backoff < config.max_backoff_ms; ++i) {
+        backoff *= 2;
+    }
+    backoff = std::min(backoff, config.max_backoff_ms);
+    // Half fixed, half random, so synchronized clients spread out
+    return backoff / 2 + static_cast<int64_t>(rng() % static_cast<uint64_t>(backoff / 2 + 1));
+}
+
+Counter& hedges(const std::string& endpoint, const char* winner) {
+    return MetricsRegistry::getInstance().counter(
+        "rag_http_hedges_total", "Hedged external HTTP requests by which transfer answered first",
+        {{"endpoint", endpoint}, {"winner", winner}});
+}
+
+} // namespace
+
+// Never destroyed, like the engine whose loop thread calls back into it
+HttpClient& HttpClient::getInstance() {
+    static HttpClient* instance = new HttpClient();
+    return *instance;
+}
+
+void HttpClient::configure(const ResilienceConfig& config) {
+    std::unique_lock<std::shared_mutex> lock(config_mutex_);
+    config_ = config;
+}
+
+ResilienceConfig HttpClient::config() const {
+    std::shared_lock<std::shared_mutex> lock(config_mutex_);
+    return config_;
+}
+
+HttpClient::Breaker& HttpClient::breaker(const std::string& endpoint) {
+    {
+        std::shared_lock<std::shared_mutex> lock(breakers_mutex_);
+        auto it = breakers_.find(endpoint);
+        if (it != breakers_.end()) {
+            return *it->second;
+        }
+    }
+    std::unique_lock<std::shared_mutex> lock(breakers_mutex_);
+    auto& entry = breakers_[endpoint];
+    if (!entry) {
+        entry = std::make_unique<Breaker>();
+        MetricsRegistry::getInstance().gauge("rag_http_circuit_open", "1 while the endpoint's circuit breaker is open",
+                                             {{"endpoint", endpoint}}).set(0.0);
+    }
+    return *entry;
+}
+
+bool HttpClient::allowRequest(const std::string& endpoint, Breaker& breaker, const ResilienceConfig& config) {
+    std::lock_guard<std::mutex> lock(breaker.mutex);
+    switch (breaker.state) {
+        case Breaker::State::CLOSED:
+            return true;
+        case Breaker::State::OPEN:
+            if (std::chrono::steady_clock::now() - breaker.opened_at <
+                std::chrono::milliseconds(config.breaker_open_ms)) {
+                return false;
+            }
+            breaker.state = Breaker::State::HALF_OPEN;
+            breaker.probe_in_flight = true;
+            RAG_LOG_INFO("Circuit breaker half-open for " + endpoint + ": sending a probe");
+            return true;
+        case Breaker::State::HALF_OPEN:
+            if (breaker.probe_in_flight) {
+                return false;
+            }
+            breaker.probe_in_flight = true;
+            return true;
+    }
+    return false;
+}
+
+void HttpClient::recordOutcome(const std::string& endpoint, Breaker& breaker, Outcome outcome,
+                               const ResilienceConfig& config) {
+    std::lock_guard<std::mutex> lock(breaker.mutex);
+    breaker.probe_in_flight = false;
+    auto& open_gauge = MetricsRegistry::getInstance().gauge(
+        "rag_http_circuit_open", "1 while the endpoint's circuit breaker is open", {{"endpoint", endpoint}});
+    
+    if (outcome == Outcome::HEALTHY) {
+        breaker.consecutive_failures = 0;
+        if (breaker.state != Breaker::State::CLOSED) {
+            breaker.state = Breaker::State::CLOSED;
+            open_gauge.set(0.0);
+            RAG_LOG_INFO("Circuit breaker closed for " + endpoint);
+        }
+    } else if (outcome == Outcome::FAILED) {
+        ++breaker.consecutive_failures;
+        if (breaker.state == Breaker::State::HALF_OPEN ||
+            (breaker.state == Breaker::State::CLOSED &&
+             breaker.consecutive_failures >= config.breaker_failure_threshold)) {
+            breaker.state = Breaker::State::OPEN;
+            breaker.opened_at = std::chrono::steady_clock::now();
+            open_gauge.set(1.0);
+            RAG_LOG_WARNING("Circuit breaker opened for " + endpoint + " after " +
+                            std::to_string(breaker.consecutive_failures) + " consecutive failures");
+        }
+    }
+}
+
+int64_t HttpClient::hedgeDelayMs(const std::string& endpoint, const ResilienceConfig& config) const {
+    const auto& latency = MetricsRegistry::getInstance().histogram(
+        "rag_http_request_duration_seconds", "External HTTP request latency", {{"endpoint", endpoint}});
+    if (latency.count() < config.hedge_min_samples) {
+        return -1; // No reliable p95 yet
+    }
+    return std::max<int64_t>(config.min_hedge_delay_ms,
+                             static_cast<int64_t>(latency.percentile(config.hedge_quantile) / 1000));
+}
+
+void HttpClient::performAsync(const HttpRequest& request, Callback on_complete) {
+    auto call = std::make_shared<Call>();
+    call->request = request;
+    call->config = config();
+    call->breaker = &breaker(request.endpoint);
+    call->deadline = Deadline::current();
+    call->on_complete = std::move(on_complete);
+    
+    if (!allowRequest(request.endpoint, *call->breaker, call->config)) {
+        MetricsRegistry::getInstance().counter(
+            "rag_http_rejected_total", "External HTTP requests failed fast by an open circuit breaker",
+            {{"endpoint", request.endpoint}}).increment();
+        call->response.error = "circuit breaker open";
+        complete(call);
+        return;
+    }
+    HttpEngine::getInstance().post([this, call]() { startAttempt(call); });
+}
+
+std::future<HttpResponse> HttpClient::submit(const HttpRequest& request) {
+    auto promise = std::make_shared<std::promise<HttpResponse>>();
+    std::future<HttpResponse> future = promise->get_future();
+    performAsync(request, [promise](HttpResponse&& response) { promise->set_value(std::move(response)); });
+    return future;
+}
+
+bool HttpClient::perform(const HttpRequest& request, HttpResponse& response) {
+    Span span(request.span_name.empty() ? request.method + " " + request.endpoint : request.span_name,
+              SpanKind::CLIENT);
+    if (request.record_url) {
+        span.setAttribute("http.url", request.url);
+    }
+    
+    if (HttpEngine::getInstance().onLoopThread()) {
+        // Waiting here would stall the loop that has to complete the request
+        response = HttpResponse();
+        response.error = "blocking HTTP call on the I/O thread";
+        RAG_LOG_ERROR(response.error + ": " + request.endpoint);
+        span.setError(response.error);
+        return false;
+    }
+    response = submit(request).get();
+    
+    span.setAttribute("http.status_code", std::to_string(response.status));
+    if (response.attempts > 1) {
+        span.setAttribute("http.attempts", std::to_string(response.attempts));
+    }
+    if (response.hedged) {
+        span.setAttribute("http.hedged", "true");
+    }
+    if (!response.ok()) {
+        span.setError(!response.error.empty() ? response.error : "HTTP " + std::to_string(response.status));
+    }
+    return response.ok();
+}
+
+void HttpClient::startAttempt(const std::shared_ptr<Call>& call) {
+    auto& engine = HttpEngine::getInstance();
+    uint64_t attempt = ++call->attempt;
+    call->hedge_id = 0;
+    call->primary_id = engine.start(call->request, call->deadline,
+                                    [this, call](HttpTransferResult&& result) {
+                                        onTransferDone(call, false, std::move(result));
+                                    });
+    if (call->primary_id == 0) {
+        // Expired (possibly while backing off); a retry keeps the last failure
+        recordOutcome(call->request.endpoint, *call->breaker, Outcome::NEUTRAL, call->config);
+        if (call->response.attempts == 0) {
+            call->response.error = Deadline::expired(call->deadline) ? "deadline exceeded"
+                                                                      : "failed to initialize CURL";
+        }
+        complete(call);
+        return;
+    }
+    ++call->response.attempts;
+    call->primary_running = true;
+    
+    const auto& request = call->request;
+    int64_t hedge_delay = request.idempotent && call->config.hedging ? hedgeDelayMs(request.endpoint, call->config)
+                                                                     : -1;
+    if (hedge_delay >= 0) {
+        engine.schedule(hedge_delay, [this, call, attempt]() { sendHedge(call, attempt); });
+    }
+}
+
+void HttpClient::sendHedge(const std::shared_ptr<Call>& call, uint64_t attempt) {
+    if (attempt != call->attempt || !call->primary_running || call->hedge_id != 0) {
+        return; // The attempt already finished
+    }
+    call->hedge_id = HttpEngine::getInstance().start(call->request, call->deadline,
+                                                     [this, call](HttpTransferResult&& result) {
+                                                         onTransferDone(call, true, std::move(result));
+                                                     });
+    if (call->hedge_id != 0) {
+        call->hedge_running = true;
+        call->response.hedged = true;
+    }
+}
+
+void HttpClient::onTransferDone(const std::shared_ptr<Call>& call, bool hedge, HttpTransferResult&& result) {
+    (hedge ? call->hedge_running : call->primary_running) = false;
+    bool& other_running = hedge ? call->primary_running : call->hedge_running;
+    
+    // First final answer wins; if everything in flight failed, report the last failure
+    if (other_running) {
+        if (retryable(result.code, result.status)) {
+            return;
+        }
+        HttpEngine::getInstance().cancel(hedge ? call->primary_id : call->hedge_id);
+        other_running = false;
+    }
+    if (call->response.hedged) {
+        hedges(call->request.endpoint, hedge ? "hedge" : "original").increment();
+    }
+    concludeAttempt(call, std::move(result));
+}
+
+void HttpClient::concludeAttempt(const std::shared_ptr<Call>& call, HttpTransferResult&& result) {
+    const auto& request = call->request;
+    const auto& config = call->config;
+    auto& response = call->response;
+    response.status = result.status;
+    response.body = std::move(result.body);
+    response.error = result.code == CURLE_OK ? "" : curl_easy_strerror(result.code);
+    
+    bool failed = retryable(result.code, result.status);
+    // Timeouts and aborts caused by our own deadline say nothing about the endpoint
+    bool ours = result.code == CURLE_ABORTED_BY_CALLBACK || (failed && Deadline::expired(call->deadline));
+    recordOutcome(request.endpoint, *call->breaker,
+                  ours ? Outcome::NEUTRAL : failed ? Outcome::FAILED : Outcome::HEALTHY, config);
+    if (!failed || ours || call->retry >= config.max_retries) {
+        complete(call);
+        return;
+    }
+    
+    int64_t backoff = jitteredBackoff(config, call->retry);
+    if (result.retry_after_ms >= 0) {
+        backoff = std::min(config.max_backoff_ms, std::max(backoff, result.retry_after_ms));
+    }
+    if (backoff >= Deadline::remainingMs(call->deadline) || !allowRequest(request.endpoint, *call->breaker, config)) {
+        complete(call);
+        return;
+    }
+    ++call->retry;
+    MetricsRegistry::getInstance().counter("rag_http_retries_total", "External HTTP requests retried",
+                                           {{"endpoint", request.endpoint}}).increment();
+    RAG_LOG_DEBUG("Retrying " + request.endpoint + " in " + std::to_string(backoff) + " ms (" +
+                  (response.error.empty() ? "HTTP " + std::to_string(response.status) : response.error) + ")");
+    // The timer holds no thread; startAttempt gives up if the request expired meanwhile
+    HttpEngine::getInstance().schedule(backoff, [this, call]() { startAttempt(call); });
+}
+
+void HttpClient::complete(const std::shared_ptr<Call>& call) {
+    Callback on_complete = std::move(call->on_complete);
+    on_complete(std::move(call->response));
+}
+
+} // namespace utils
+} // namespace rag
@@ -0,0 +1,344 @@
+#include "utils/http_engine.h"
+#include "utils/http_client.h"
+#include "utils/deadline.h"
+#include "utils/logger.h"
+#include "utils/metrics.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#define RAG_HTTP_ENGINE_EPOLL 1
+#endif
+
+namespace rag {
+namespace utils {
+
+struct HttpEngine::Transfer {
+    uint64_t id = 0;
+    CURL* handle = nullptr;
+    curl_slist* headers = nullptr;
+    std::string request_body;       // POSTFIELDS is not copied by curl
+    std::string endpoint;
+    HttpTransferResult result;
+    std::shared_ptr<const DeadlineState> deadline; // Referenced by the progress callback
+    Callback on_complete;
+    std::chrono::steady_clock::time_point start;
+};
+
+namespace {
+
+size_t writeCallback(void* contents, size_t size, size_t nmemb, void* userp) {
+    static_cast<std::string*>(userp)->append(static_cast<char*>(contents), size * nmemb);
+    return size * nmemb;
+}
+
+// Numeric value of a header line if it is `name` (lowercase, with the colon)
+bool numericHeader(const char* buffer, size_t length, const char* name, long long& value) {
+    size_t name_length = std::strlen(name);
+    if (length <= name_length) {
+        return false;
+    }
+    for (size_t i = 0; i < name_length; ++i) {
+        if (std::tolower(static_cast<unsigned char>(buffer[i])) != name[i]) {
+            return false;
+        }
+    }
+    std::string text(buffer + name_length, length - name_length);
+    char* end = nullptr;
+    value = std::strtoll(text.c_str(), &end, 10);
+    return end != text.c_str() && value >= 0;
+}
+
+// Picks up Retry-After (delta-seconds form) for 429/503 backoff, and sizes the
+// body buffer from Content-Length so multi-megabyte responses aren't regrown
+size_t headerCallback(char* buffer, size_t size, size_t nitems, void* userp) {
+    const size_t kMaxReserve = 64 << 20;
+    size_t length = size * nitems;
+    auto* result = static_cast<HttpTransferResult*>(userp);
+    long long value = 0;
+    if (numericHeader(buffer, length, "retry-after:", value)) {
+        result->retry_after_ms = value * 1000;
+    } else if (numericHeader(buffer, length, "content-length:", value)) {
+        result->body.reserve(std::min<size_t>(static_cast<size_t>(value), kMaxReserve));
+    }
+    return length;
+}
+
+int64_t elapsedMs(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - since).count();
+}
+
+} // namespace
+
+// Never destroyed: the loop thread runs until the process exits, and tearing
+// curl down from a static destructor could run after curl_global_cleanup
+HttpEngine& HttpEngine::getInstance() {
+    static HttpEngine* instance = new HttpEngine();
+    return *instance;
+}
+
+HttpEngine::HttpEngine() : multi_(curl_multi_init()) {
+#ifdef RAG_HTTP_ENGINE_EPOLL
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = wake_fd_;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event);
+    
+    curl_multi_setopt(multi_, CURLMOPT_SOCKETFUNCTION, socketCallback);
+    curl_multi_setopt(multi_, CURLMOPT_SOCKETDATA, this);
+    curl_multi_setopt(multi_, CURLMOPT_TIMERFUNCTION, timerCallback);
+    curl_multi_setopt(multi_, CURLMOPT_TIMERDATA, this);
+#endif
+    curl_multi_setopt(multi_, CURLMOPT_MAX_HOST_CONNECTIONS, 64L);
+    
+    MetricsRegistry::getInstance().gaugeCallback("rag_http_in_flight", "Outbound HTTP transfers in flight",
+                                                 [this]() { return static_cast<double>(inFlight()); });
+    
+    std::thread loop(&HttpEngine::run, this);
+    loop_thread_id_ = loop.get_id();
+    loop.detach();
+}
+
+void HttpEngine::post(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        posted_.push_back(std::move(task));
+    }
+    wake();
+}
+
+void HttpEngine::schedule(int64_t delay_ms, std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        timers_.push(Timer{std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max<int64_t>(0, delay_ms)),
+                           timer_sequence_++, std::move(task)});
+    }
+    wake();
+}
+
+void HttpEngine::wake() {
+#ifdef RAG_HTTP_ENGINE_EPOLL
+    uint64_t one = 1;
+    ssize_t written = ::write(wake_fd_, &one, sizeof(one));
+    (void)written; // EAGAIN means a wakeup is already pending
+#else
+    curl_multi_wakeup(multi_);
+#endif
+}
+
+uint64_t HttpEngine::start(const HttpRequest& request, std::shared_ptr<const DeadlineState> deadline,
+                           Callback on_complete) {
+    if (Deadline::expired(deadline)) {
+        return 0;
+    }
+    
+    auto transfer = std::make_unique<Transfer>();
+    transfer->handle = curl_easy_init();
+    if (!transfer->handle) {
+        RAG_LOG_ERROR("Failed to initialize CURL for " + request.endpoint);
+        return 0;
+    }
+    {
+        // applyDeadline reads the calling thread's deadline
+        DeadlineScope scope(deadline);
+        if (!applyDeadline(transfer->handle, request.timeout_ms)) {
+            curl_easy_cleanup(transfer->handle);
+            return 0;
+        }
+    }
+    
+    transfer->id = next_id_++;
+    transfer->endpoint = request.endpoint;
+    transfer->deadline = std::move(deadline);
+    transfer->on_complete = std::move(on_complete);
+    for (const auto& header : request.headers) {
+        transfer->headers = curl_slist_append(transfer->headers, header.c_str());
+    }
+    
+    CURL* handle = transfer->handle;
+    curl_easy_setopt(handle, CURLOPT_URL, request.url.c_str());
+    if (request.method == "POST") {
+        transfer->request_body = request.body;
+        curl_easy_setopt(handle, CURLOPT_POSTFIELDS, transfer->request_body.c_str());
+        curl_easy_setopt(handle, CURLOPT_POSTFIELDSIZE, static_cast<long>(transfer->request_body.size()));
+    }
+    curl_easy_setopt(handle, CURLOPT_HTTPHEADER, transfer->headers);
+    curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, writeCallback);
+    curl_easy_setopt(handle, CURLOPT_WRITEDATA, &transfer->result.body);
+    curl_easy_setopt(handle, CURLOPT_HEADERFUNCTION, headerCallback);
+    curl_easy_setopt(handle, CURLOPT_HEADERDATA, &transfer->result);
+    curl_easy_setopt(handle, CURLOPT_FOLLOWLOCATION, 1L);
+    if (!verify_tls_.load(std::memory_order_relaxed)) {
+        curl_easy_setopt(handle, CURLOPT_SSL_VERIFYPEER, 0L);
+        curl_easy_setopt(handle, CURLOPT_SSL_VERIFYHOST, 0L);
+    }
+    curl_easy_setopt(handle, CURLOPT_PRIVATE, transfer.get());
+    
+    transfer->start = std::chrono::steady_clock::now();
+    uint64_t id = transfer->id;
+    transfers_.emplace(id, std::move(transfer));
+    in_flight_.fetch_add(1, std::memory_order_relaxed);
+    curl_multi_add_handle(multi_, handle);
+    return id;
+}
+
+void HttpEngine::cancel(uint64_t id) {
+    auto it = transfers_.find(id);
+    if (it == transfers_.end()) {
+        return;
+    }
+    curl_multi_remove_handle(multi_, it->second->handle);
+    curl_easy_cleanup(it->second->handle);
+    curl_slist_free_all(it->second->headers);
+    transfers_.erase(it);
+    in_flight_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void HttpEngine::processCompleted() {
+    int queued = 0;
+    while (CURLMsg* message = curl_multi_info_read(multi_, &queued)) {
+        if (message->msg != CURLMSG_DONE) {
+            continue;
+        }
+        CURLcode code = message->data.result;
+        char* private_data = nullptr;
+        curl_easy_getinfo(message->easy_handle, CURLINFO_PRIVATE, &private_data);
+        auto it = transfers_.find(reinterpret_cast<Transfer*>(private_data)->id);
+        std::unique_ptr<Transfer> transfer = std::move(it->second);
+        transfers_.erase(it);
+        
+        transfer->result.code = code;
+        curl_easy_getinfo(transfer->handle, CURLINFO_RESPONSE_CODE, &transfer->result.status);
+        curl_multi_remove_handle(multi_, transfer->handle);
+        curl_easy_cleanup(transfer->handle);
+        curl_slist_free_all(transfer->headers);
+        in_flight_.fetch_sub(1, std::memory_order_relaxed);
+        
+        recordHttpRequest(transfer->endpoint,
+                          std::chrono::duration_cast<std::chrono::microseconds>(
+                              std::chrono::steady_clock::now() - transfer->start).count(),
+                          code == CURLE_OK && transfer->result.status >= 200 && transfer->result.status < 300);
+        try {
+            transfer->on_complete(std::move(transfer->result));
+        } catch (const std::exception& e) {
+            RAG_LOG_ERROR("HTTP completion callback failed: " + std::string(e.what()));
+        }
+    }
+}
+
+void HttpEngine::runTasks() {
+    std::vector<std::function<void()>> tasks;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks.swap(posted_);
+        auto now = std::chrono::steady_clock::now();
+        while (!timers_.empty() && timers_.top().due <= now) {
+            tasks.push_back(std::move(const_cast<Timer&>(timers_.top()).task));
+            timers_.pop();
+        }
+    }
+    for (auto& task : tasks) {
+        try {
+            task();
+        } catch (const std::exception& e) {
+            RAG_LOG_ERROR("HTTP engine task failed: " + std::string(e.what()));
+        }
+    }
+}
+
+int HttpEngine::nextWaitMs() {
+    int64_t wait = 1000; // Upper bound, so a lost wakeup only costs a second
+    if (curl_timeout_ms_ >= 0) {
+        wait = std::min(wait, std::max<int64_t>(0, curl_timeout_ms_ - elapsedMs(curl_timer_set_)));
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!posted_.empty()) {
+        return 0;
+    }
+    if (!timers_.empty()) {
+        wait = std::min(wait, std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::milliseconds>(
+            timers_.top().due - std::chrono::steady_clock::now()).count()));
+    }
+    return static_cast<int>(wait);
+}
+
+void HttpEngine::run() {
+    int running = 0;
+#ifdef RAG_HTTP_ENGINE_EPOLL
+    const int kMaxEvents = 256;
+    epoll_event events[kMaxEvents];
+    while (true) {
+        int count = epoll_wait(epoll_fd_, events, kMaxEvents, nextWaitMs());
+        for (int i = 0; i < count; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == wake_fd_) {
+                uint64_t value;
+                ssize_t drained = ::read(wake_fd_, &value, sizeof(value));
+                (void)drained;
+                continue;
+            }
+            int flags = 0;
+            if (events[i].events & EPOLLIN) {
+                flags |= CURL_CSELECT_IN;
+            }
+            if (events[i].events & EPOLLOUT) {
+                flags |= CURL_CSELECT_OUT;
+            }
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                flags |= CURL_CSELECT_ERR;
+            }
+            curl_multi_socket_action(multi_, fd, flags, &running);
+        }
+        if (curl_timeout_ms_ >= 0 && elapsedMs(curl_timer_set_) >= curl_timeout_ms_) {
+            curl_timeout_ms_ = -1; // The action may set a new timer
+            curl_multi_socket_action(multi_, CURL_SOCKET_TIMEOUT, 0, &running);
+        }
+        processCompleted();
+        runTasks();
+    }
+#else
+    while (true) {
+        curl_multi_poll(multi_, nullptr, 0, nextWaitMs(), nullptr);
+        curl_multi_perform(multi_, &running);
+        processCompleted();
+        runTasks();
+    }
+#endif
+}
+
+int HttpEngine::socketCallback(CURL*, curl_socket_t socket, int what, void* userp, void* socketp) {
+#ifdef RAG_HTTP_ENGINE_EPOLL
+    auto* engine = static_cast<HttpEngine*>(userp);
+    if (what == CURL_POLL_REMOVE) {
+        epoll_ctl(engine->epoll_fd_, EPOLL_CTL_DEL, socket, nullptr);
+        return 0;
+    }
+    epoll_event event{};
+    event.events = ((what & CURL_POLL_IN) ? EPOLLIN : 0u) | ((what & CURL_POLL_OUT) ? EPOLLOUT : 0u);
+    event.data.fd = socket;
+    if (socketp) {
+        epoll_ctl(engine->epoll_fd_, EPOLL_CTL_MOD, socket, &event);
+    } else {
+        epoll_ctl(engine->epoll_fd_, EPOLL_CTL_ADD, socket, &event);
+        curl_multi_assign(engine->multi_, socket, engine); // Marks the socket as registered
+    }
+#endif
+    return 0;
+}
+
+int HttpEngine::timerCallback(CURLM*, long timeout_ms, void* userp) {
+    auto* engine = static_cast<HttpEngine*>(userp);
+    engine->curl_timeout_ms_ = timeout_ms;
+    engine->curl_timer_set_ = std::chrono::steady_clock::now();
+    return 0;
+}
+
+} // namespace utils
+} // namespace rag
@@ -0,0 +1,427 @@
+#include "utils/json_scanner.h"
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace rag {
+namespace utils {
+
+namespace {
+
+constexpr uint8_t kFirst = 1;       // No element read yet
+constexpr uint8_t kObject = 2;      // Closed by '}' rather than ']'
+
+inline bool isWhitespace(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+inline bool isValueEnd(char c) {
+    return c == ',' || c == '}' || c == ']' || isWhitespace(c);
+}
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+void appendUtf8(std::string& out, uint32_t code_point) {
+    if (code_point < 0x80) {
+        out += static_cast<char>(code_point);
+    } else if (code_point < 0x800) {
+        out += static_cast<char>(0xC0 | (code_point >> 6));
+        out += static_cast<char>(0x80 | (code_point & 0x3F));
+    } else if (code_point < 0x10000) {
+        out += static_cast<char>(0xE0 | (code_point >> 12));
+        out += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code_point & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (code_point >> 18));
+        out += static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code_point & 0x3F));
+    }
+}
+
+// First of `"{}[]` at or after from, for skipping whole containers
+size_t findStructural(std::string_view input, size_t from) {
+#if defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i open_brace = _mm_set1_epi8('{');
+    const __m128i close_brace = _mm_set1_epi8('}');
+    const __m128i open_bracket = _mm_set1_epi8('[');
+    const __m128i close_bracket = _mm_set1_epi8(']');
+    while (from + 16 <= input.size()) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input.data() + from));
+        __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, open_brace)),
+                                    _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, close_brace),
+                                                              _mm_cmpeq_epi8(chunk, open_bracket)),
+                                                 _mm_cmpeq_epi8(chunk, close_bracket)));
+        int mask = _mm_movemask_epi8(hits);
+        if (mask != 0) {
+            return from + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+        }
+        from += 16;
+    }
+#endif
+    for (; from < input.size(); ++from) {
+        char c = input[from];
+        if (c == '"' || c == '{' || c == '}' || c == '[' || c == ']') {
+            return from;
+        }
+    }
+    return std::string_view::npos;
+}
+
+std::string_view trim(std::string_view text) {
+    while (!text.empty() && isWhitespace(text.front())) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && isWhitespace(text.back())) {
+        text.remove_suffix(1);
+    }
+    if (!text.empty() && text.front() == '+') {
+        text.remove_prefix(1);
+    }
+    return text;
+}
+
+} // namespace
+
+bool JsonScanner::fail() {
+    failed_ = true;
+    return false;
+}
+
+void JsonScanner::skipWhitespace() {
+    while (pos_ < input_.size() && isWhitespace(input_[pos_])) {
+        ++pos_;
+    }
+}
+
+bool JsonScanner::expect(char c) {
+    skipWhitespace();
+    if (pos_ >= input_.size() || input_[pos_] != c) {
+        return fail();
+    }
+    ++pos_;
+    return true;
+}
+
+char JsonScanner::peek() {
+    if (failed_) {
+        return 0;
+    }
+    skipWhitespace();
+    return pos_ < input_.size() ? input_[pos_] : 0;
+}
+
+bool JsonScanner::beginObject() {
+    if (failed_ || !expect('{')) {
+        return false;
+    }
+    first_.push_back(kFirst | kObject);
+    return true;
+}
+
+bool JsonScanner::beginArray() {
+    if (failed_ || !expect('[')) {
+        return false;
+    }
+    first_.push_back(kFirst);
+    return true;
+}
+
+bool JsonScanner::nextKey(std::string_view& key) {
+    if (failed_ || first_.empty() || !(first_.back() & kObject)) {
+        return fail();
+    }
+    skipWhitespace();
+    if (pos_ >= input_.size()) {
+        return fail();
+    }
+    if (input_[pos_] == '}') {
+        ++pos_;
+        first_.pop_back();
+        return false;
+    }
+    if (!(first_.back() & kFirst) && !expect(',')) {
+        return false;
+    }
+    first_.back() &= static_cast<uint8_t>(~kFirst);
+    return readKey(key);
+}
+
+bool JsonScanner::readKey(std::string_view& key) {
+    return readString(key) && expect(':');
+}
+
+bool JsonScanner::nextElement() {
+    if (failed_ || first_.empty() || (first_.back() & kObject)) {
+        return fail();
+    }
+    skipWhitespace();
+    if (pos_ >= input_.size()) {
+        return fail();
+    }
+    if (input_[pos_] == ']') {
+        ++pos_;
+        first_.pop_back();
+        return false;
+    }
+    if (!(first_.back() & kFirst) && !expect(',')) {
+        return false;
+    }
+    first_.back() &= static_cast<uint8_t>(~kFirst);
+    return true;
+}
+
+size_t JsonScanner::findQuoteOrEscape(size_t from) const {
+#if defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    while (from + 16 <= input_.size()) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input_.data() + from));
+        int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)));
+        if (mask != 0) {
+            return from + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+        }
+        from += 16;
+    }
+#endif
+    for (; from < input_.size(); ++from) {
+        if (input_[from] == '"' || input_[from] == '\\') {
+            return from;
+        }
+    }
+    return std::string_view::npos;
+}
+
+// Decodes from the first backslash at `end` to the closing quote, which `end` is left on
+bool JsonScanner::unescape(size_t start, size_t& end) {
+    scratch_.assign(input_.data() + start, end - start);
+    while (input_[end] == '\\') {
+        if (end + 1 >= input_.size()) {
+            return fail();
+        }
+        char c = input_[end + 1];
+        end += 2;
+        switch (c) {
+            case '"': scratch_ += '"'; break;
+            case '\\': scratch_ += '\\'; break;
+            case '/': scratch_ += '/'; break;
+            case 'b': scratch_ += '\b'; break;
+            case 'f': scratch_ += '\f'; break;
+            case 'n': scratch_ += '\n'; break;
+            case 'r': scratch_ += '\r'; break;
+            case 't': scratch_ += '\t'; break;
+            case 'u': {
+                auto readUnit = [this](size_t at, uint32_t& unit) {
+                    if (at + 4 > input_.size()) {
+                        return false;
+                    }
+                    unit = 0;
+                    for (size_t i = at; i < at + 4; ++i) {
+                        int digit = hexValue(input_[i]);
+                        if (digit < 0) {
+                            return false;
+                        }
+                        unit = (unit << 4) | static_cast<uint32_t>(digit);
+                    }
+                    return true;
+                };
+                uint32_t unit = 0;
+                if (!readUnit(end, unit)) {
+                    return fail();
+                }
+                end += 4;
+                if (unit >= 0xD800 && unit <= 0xDBFF) {
+                    // High surrogate: must pair with a following \uDC00-\uDFFF
+                    uint32_t low = 0;
+                    if (end + 6 > input_.size() || input_[end] != '\\' || input_[end + 1] != 'u' ||
+                        !readUnit(end + 2, low) || low < 0xDC00 || low > 0xDFFF) {
+                        return fail();
+                    }
+                    end += 6;
+                    unit = 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+                } else if (unit >= 0xDC00 && unit <= 0xDFFF) {
+                    return fail();
+                }
+                appendUtf8(scratch_, unit);
+                break;
+            }
+            default:
+                return fail();
+        }
+        size_t next = findQuoteOrEscape(end);
+        if (next == std::string_view::npos) {
+            return fail();
+        }
+        scratch_.append(input_.data() + end, next - end);
+        end = next;
+    }
+    return true;
+}
+
+bool JsonScanner::readString(std::string_view& value) {
+    if (failed_ || !expect('"')) {
+        return false;
+    }
+    size_t start = pos_;
+    size_t end = findQuoteOrEscape(start);
+    if (end == std::string_view::npos) {
+        return fail();
+    }
+    if (input_[end] == '"') {
+        value = input_.substr(start, end - start);
+    } else {
+        if (!unescape(start, end)) {
+            return false;
+        }
+        value = scratch_;
+    }
+    pos_ = end + 1;
+    return true;
+}
+
+bool JsonScanner::readString(std::string& value) {
+    std::string_view view;
+    if (!readString(view)) {
+        return false;
+    }
+    value.assign(view.data(), view.size());
+    return true;
+}
+
+bool JsonScanner::readNumber(double& value) {
+    if (failed_) {
+        return false;
+    }
+    skipWhitespace();
+    size_t start = pos_;
+    while (pos_ < input_.size() && !isValueEnd(input_[pos_])) {
+        ++pos_;
+    }
+    if (!parseDouble(input_.substr(start, pos_ - start), value)) {
+        return fail();
+    }
+    return true;
+}
+
+// Skipped containers are checked for balance and bracket matching only
+bool JsonScanner::skipValue() {
+    if (failed_) {
+        return false;
+    }
+    skipWhitespace();
+    if (pos_ >= input_.size()) {
+        return fail();
+    }
+    char c = input_[pos_];
+    if (c == '"') {
+        size_t end = findQuoteOrEscape(pos_ + 1);
+        while (end != std::string_view::npos && input_[end] == '\\') {
+            end = findQuoteOrEscape(end + 2);
+        }
+        if (end == std::string_view::npos) {
+            return fail();
+        }
+        pos_ = end + 1;
+        return true;
+    }
+    if (c == '{' || c == '[') {
+        uint64_t objects = 0;       // Bit per level below 64: 1 = object
+        size_t depth = 0;
+        size_t at = pos_;
+        while (true) {
+            at = findStructural(input_, at);
+            if (at == std::string_view::npos) {
+                return fail();
+            }
+            char token = input_[at];
+            if (token == '"') {
+                size_t end = findQuoteOrEscape(at + 1);
+                while (end != std::string_view::npos && input_[end] == '\\') {
+                    end = findQuoteOrEscape(end + 2);
+                }
+                if (end == std::string_view::npos) {
+                    return fail();
+                }
+                at = end + 1;
+                continue;
+            }
+            if (token == '{' || token == '[') {
+                if (depth < 64) {
+                    objects = (objects & ~(uint64_t(1) << depth)) | (uint64_t(token == '{') << depth);
+                }
+                ++depth;
+            } else {
+                if (depth == 0) {
+                    return fail();
+                }
+                --depth;
+                if (depth < 64 && ((objects >> depth) & 1) != uint64_t(token == '}')) {
+                    return fail();
+                }
+            }
+            ++at;
+            if (depth == 0) {
+                pos_ = at;
+                return true;
+            }
+        }
+    }
+    // Number or literal
+    size_t start = pos_;
+    while (pos_ < input_.size() && !isValueEnd(input_[pos_])) {
+        ++pos_;
+    }
+    std::string_view token = input_.substr(start, pos_ - start);
+    double ignored = 0.0;
+    if (token == "true" || token == "false" || token == "null" || parseDouble(token, ignored)) {
+        return true;
+    }
+    return fail();
+}
+
+bool parseDouble(std::string_view text, double& value) {
+    text = trim(text);
+    if (text.empty()) {
+        return false;
+    }
+#if defined(__cpp_lib_to_chars)
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return result.ec == std::errc() && result.ptr == text.data() + text.size();
+#else
+    // Standard libraries without floating-point from_chars (older libc++)
+    char buffer[64];
+    if (text.size() >= sizeof(buffer)) {
+        return false;
+    }
+    std::memcpy(buffer, text.data(), text.size());
+    buffer[text.size()] = '\0';
+    char* end = nullptr;
+    value = std::strtod(buffer, &end);
+    return end == buffer + text.size();
+#endif
+}
+
+bool parseInt64(std::string_view text, int64_t& value) {
+    text = trim(text);
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return !text.empty() && result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+} // namespace utils
+} // namespace rag
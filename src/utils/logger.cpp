@@ -1,8 +1,7 @@
 #include "utils/logger.h"
-#include <iostream>
 #include <chrono>
-#include <iomanip>
-#include <sstream>
+#include <cstring>
+#include <ctime>
 
 namespace rag {
 namespace utils {
@@ -12,42 +11,82 @@ Logger& Logger::getInstance() {
     return instance;
 }
 
+Logger::Logger() : ring_(new Record[kRingCapacity]) {
+    for (size_t i = 0; i < kRingCapacity; ++i) {
+        ring_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    writer_ = std::thread(&Logger::writerLoop, this);
+}
+
+Logger::~Logger() {
+    running_.store(false);
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        wake_cv_.notify_one();
+    }
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+    if (log_file_) {
+        std::fclose(log_file_);
+    }
+}
+
 void Logger::setLogLevel(LogLevel level) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    log_level_ = level;
+    log_level_.store(static_cast<int>(level), std::memory_order_relaxed);
 }
 
 void Logger::setLogFile(const std::string& filepath) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    if (log_file_.is_open()) {
-        log_file_.close();
+    std::lock_guard<std::mutex> lock(file_mutex_);
+    if (log_file_) {
+        std::fclose(log_file_);
     }
-    log_file_.open(filepath, std::ios::app);
+    log_file_ = std::fopen(filepath.c_str(), "a");
 }
 
 void Logger::log(LogLevel level, const std::string& message) {
-    if (level < log_level_) {
+    if (!isEnabled(level)) {
         return;
     }
     
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    auto now = std::chrono::system_clock::now();
-    auto time_t = std::chrono::system_clock::to_time_t(now);
-    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-        now.time_since_epoch()) % 1000;
-    
-    std::stringstream ss;
-    ss << std::put_time(std::localtime(&time_t), "%Y-%m-%d %H:%M:%S");
-    ss << '.' << std::setfill('0') << std::setw(3) << ms.count();
-    
-    std::string log_entry = "[" + ss.str() + "] [" + levelToString(level) + "] " + message;
+    // Claim a slot (bounded MPMC ring, used here with a single consumer)
+    const size_t mask = kRingCapacity - 1;
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    Record* record;
+    while (true) {
+        record = &ring_[pos & mask];
+        size_t sequence = record->sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // Full: drop instead of stalling the request path
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            pos = enqueue_pos_.load(std::memory_order_relaxed);
+        }
+    }
     
-    std::cout << log_entry << std::endl;
+    record->timestamp_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    record->level = level;
+    size_t length = message.size();
+    if (length > kMaxMessageBytes) {
+        static const char kTruncated[] = "...[truncated]";
+        length = kMaxMessageBytes;
+        std::memcpy(record->text, message.data(), length - (sizeof(kTruncated) - 1));
+        std::memcpy(record->text + length - (sizeof(kTruncated) - 1), kTruncated, sizeof(kTruncated) - 1);
+    } else {
+        std::memcpy(record->text, message.data(), length);
+    }
+    record->length = static_cast<uint32_t>(length);
+    record->sequence.store(pos + 1, std::memory_order_release);
     
-    if (log_file_.is_open()) {
-        log_file_ << log_entry << std::endl;
-        log_file_.flush();
+    if (level == LogLevel::ERROR || writer_sleeping_.load(std::memory_order_acquire)) {
+        wake_cv_.notify_one();
     }
 }
 
@@ -67,7 +106,108 @@ void Logger::error(const std::string& message) {
     log(LogLevel::ERROR, message);
 }
 
-std::string Logger::levelToString(LogLevel level) {
+void Logger::flush() {
+    size_t target = enqueue_pos_.load(std::memory_order_acquire);
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    wake_cv_.notify_one();
+    while (written_.load(std::memory_order_acquire) < target && running_.load()) {
+        flushed_cv_.wait_for(lock, std::chrono::milliseconds(10));
+        wake_cv_.notify_one();
+    }
+}
+
+bool Logger::dequeue(std::string& batch, int64_t& last_second, std::string& time_prefix) {
+    Record& record = ring_[dequeue_pos_ & (kRingCapacity - 1)];
+    size_t sequence = record.sequence.load(std::memory_order_acquire);
+    if (sequence != dequeue_pos_ + 1) {
+        return false;
+    }
+    
+    // Formatting happens here, off the caller's thread; the date/time prefix
+    // only changes once per second
+    int64_t seconds = record.timestamp_us / 1000000;
+    if (seconds != last_second) {
+        std::time_t time = static_cast<std::time_t>(seconds);
+        std::tm local_time;
+        localtime_r(&time, &local_time);
+        char buffer[32];
+        std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &local_time);
+        time_prefix = buffer;
+        last_second = seconds;
+    }
+    
+    char millis[8];
+    std::snprintf(millis, sizeof(millis), ".%03d", static_cast<int>((record.timestamp_us / 1000) % 1000));
+    
+    batch += '[';
+    batch += time_prefix;
+    batch += millis;
+    batch += "] [";
+    batch += levelToString(record.level);
+    batch += "] ";
+    batch.append(record.text, record.length);
+    batch += '\n';
+    
+    record.sequence.store(dequeue_pos_ + kRingCapacity, std::memory_order_release);
+    ++dequeue_pos_;
+    return true;
+}
+
+void Logger::writerLoop() {
+    std::string batch;
+    batch.reserve(64 * 1024);
+    int64_t last_second = -1;
+    std::string time_prefix;
+    
+    while (true) {
+        batch.clear();
+        size_t count = 0;
+        while (count < 1024 && dequeue(batch, last_second, time_prefix)) {
+            ++count;
+        }
+        
+        uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+        if (dropped != dropped_reported_) {
+            batch += "[logger] dropped " + std::to_string(dropped - dropped_reported_) +
+                     " messages (ring buffer full)\n";
+            dropped_reported_ = dropped;
+        }
+        
+        if (!batch.empty()) {
+            std::fwrite(batch.data(), 1, batch.size(), stdout);
+            std::fflush(stdout);
+            {
+                std::lock_guard<std::mutex> lock(file_mutex_);
+                if (log_file_) {
+                    std::fwrite(batch.data(), 1, batch.size(), log_file_);
+                    std::fflush(log_file_);
+                }
+            }
+            written_.store(dequeue_pos_, std::memory_order_release);
+            std::lock_guard<std::mutex> lock(wake_mutex_);
+            flushed_cv_.notify_all();
+            continue;
+        }
+        
+        if (!running_.load()) {
+            break; // Drained after shutdown was requested
+        }
+        
+        // Idle: sleep until a producer wakes us (bounded, so a lost wakeup
+        // only delays output)
+        writer_sleeping_.store(true);
+        {
+            std::unique_lock<std::mutex> lock(wake_mutex_);
+            Record& next = ring_[dequeue_pos_ & (kRingCapacity - 1)];
+            if (next.sequence.load(std::memory_order_acquire) != dequeue_pos_ + 1 && running_.load()) {
+                wake_cv_.wait_for(lock, std::chrono::milliseconds(50));
+            }
+        }
+        writer_sleeping_.store(false);
+    }
+}
+
+const char* Logger::levelToString(LogLevel level) {
     switch (level) {
         case LogLevel::DEBUG: return "DEBUG";
         case LogLevel::INFO: return "INFO";
@@ -79,4 +219,3 @@ std::string Logger::levelToString(LogLevel level) {
 
 } // namespace utils
 } // namespace rag
-
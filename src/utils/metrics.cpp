@@ -0,0 +1,187 @@
+#include "utils/metrics.h"
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <sstream>
+
+namespace rag {
+namespace utils {
+
+void Gauge::add(double delta) {
+    double current = value_.load(std::memory_order_relaxed);
+    while (!value_.compare_exchange_weak(current, current + delta, std::memory_order_relaxed)) {
+    }
+}
+
+int Histogram::bucketIndex(uint64_t value) {
+    if (value < static_cast<uint64_t>(kSubBuckets)) {
+        return static_cast<int>(value);
+    }
+    int exponent = 63 - __builtin_clzll(value);
+    int sub_bucket = static_cast<int>((value >> (exponent - kSubBucketBits)) & (kSubBuckets - 1));
+    return (exponent - kSubBucketBits + 1) * kSubBuckets + sub_bucket;
+}
+
+uint64_t Histogram::bucketUpperBound(int index) {
+    int band = index / kSubBuckets;
+    uint64_t sub_bucket = static_cast<uint64_t>(index % kSubBuckets);
+    if (band == 0) {
+        return sub_bucket;
+    }
+    int shift = band - 1;
+    uint64_t lower = (static_cast<uint64_t>(kSubBuckets) + sub_bucket) << shift;
+    return lower + ((1ULL << shift) - 1);
+}
+
+void Histogram::record(uint64_t micros) {
+    buckets_[bucketIndex(micros)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(micros, std::memory_order_relaxed);
+}
+
+uint64_t Histogram::percentile(double q) const {
+    uint64_t total = count();
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t target = static_cast<uint64_t>(std::ceil(q * static_cast<double>(total)));
+    target = std::max<uint64_t>(1, std::min(target, total));
+    
+    uint64_t seen = 0;
+    for (int i = 0; i < kBucketCount; ++i) {
+        seen += buckets_[i].load(std::memory_order_relaxed);
+        if (seen >= target) {
+            return bucketUpperBound(i);
+        }
+    }
+    return bucketUpperBound(kBucketCount - 1);
+}
+
+MetricsRegistry& MetricsRegistry::getInstance() {
+    static MetricsRegistry instance;
+    return instance;
+}
+
+std::string MetricsRegistry::formatLabels(const MetricLabels& labels) {
+    std::string result;
+    for (const auto& [key, value] : labels) {
+        if (!result.empty()) {
+            result += ',';
+        }
+        result += key + "=\"";
+        for (char c : value) {
+            if (c == '"' || c == '\\') {
+                result += '\\';
+                result += c;
+            } else if (c == '\n') {
+                result += "\\n";
+            } else {
+                result += c;
+            }
+        }
+        result += '"';
+    }
+    return result;
+}
+
+MetricsRegistry::Series& MetricsRegistry::series(const std::string& name, const std::string& help,
+                                                 Type type, const MetricLabels& labels) {
+    std::string label_key = formatLabels(labels);
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto family_it = families_.find(name);
+        if (family_it != families_.end()) {
+            auto series_it = family_it->second.series.find(label_key);
+            if (series_it != family_it->second.series.end()) {
+                return series_it->second;
+            }
+        }
+    }
+    
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    Family& family = families_[name];
+    if (family.series.empty()) {
+        family.help = help;
+        family.type = type;
+    }
+    Series& series = family.series[label_key];
+    if (!series.counter && !series.gauge && !series.histogram) {
+        switch (type) {
+            case Type::COUNTER: series.counter = std::make_unique<Counter>(); break;
+            case Type::GAUGE: series.gauge = std::make_unique<Gauge>(); break;
+            case Type::SUMMARY: series.histogram = std::make_unique<Histogram>(); break;
+        }
+    }
+    return series;
+}
+
+Counter& MetricsRegistry::counter(const std::string& name, const std::string& help, const MetricLabels& labels) {
+    return *series(name, help, Type::COUNTER, labels).counter;
+}
+
+Gauge& MetricsRegistry::gauge(const std::string& name, const std::string& help, const MetricLabels& labels) {
+    return *series(name, help, Type::GAUGE, labels).gauge;
+}
+
+Histogram& MetricsRegistry::histogram(const std::string& name, const std::string& help, const MetricLabels& labels) {
+    return *series(name, help, Type::SUMMARY, labels).histogram;
+}
+
+void MetricsRegistry::gaugeCallback(const std::string& name, const std::string& help,
+                                    std::function<double()> callback, const MetricLabels& labels) {
+    Series& gauge_series = series(name, help, Type::GAUGE, labels);
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    gauge_series.callback = std::move(callback);
+}
+
+std::string MetricsRegistry::renderPrometheus() const {
+    static const double kQuantiles[] = {0.5, 0.9, 0.95, 0.99};
+    
+    std::ostringstream out;
+    out.precision(9);
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    for (const auto& [name, family] : families_) {
+        const char* type = family.type == Type::COUNTER ? "counter"
+                         : family.type == Type::GAUGE ? "gauge" : "summary";
+        out << "# HELP " << name << " " << family.help << "\n";
+        out << "# TYPE " << name << " " << type << "\n";
+        
+        for (const auto& [labels, series] : family.series) {
+            std::string braced = labels.empty() ? "" : "{" + labels + "}";
+            if (series.counter) {
+                out << name << braced << " " << series.counter->value() << "\n";
+            } else if (series.gauge) {
+                double value = series.callback ? series.callback() : series.gauge->value();
+                out << name << braced << " " << value << "\n";
+            } else if (series.histogram) {
+                // Durations are recorded in microseconds and exported in seconds
+                for (double q : kQuantiles) {
+                    std::ostringstream quantile;
+                    quantile << q;
+                    out << name << "{" << labels << (labels.empty() ? "" : ",") << "quantile=\"" << quantile.str()
+                        << "\"} " << series.histogram->percentile(q) / 1e6 << "\n";
+                }
+                out << name << "_sum" << braced << " " << series.histogram->sum() / 1e6 << "\n";
+                out << name << "_count" << braced << " " << series.histogram->count() << "\n";
+            }
+        }
+    }
+    return out.str();
+}
+
+Histogram& stageHistogram(const std::string& component, const std::string& stage) {
+    return MetricsRegistry::getInstance().histogram(
+        "rag_stage_duration_seconds", "Time spent in each processing stage",
+        {{"component", component}, {"stage", stage}});
+}
+
+void recordHttpRequest(const std::string& endpoint, uint64_t micros, bool success) {
+    auto& registry = MetricsRegistry::getInstance();
+    registry.histogram("rag_http_request_duration_seconds", "External HTTP request latency",
+                       {{"endpoint", endpoint}}).record(micros);
+    registry.counter("rag_http_requests_total", "External HTTP requests by outcome",
+                     {{"endpoint", endpoint}, {"outcome", success ? "ok" : "error"}}).increment();
+}
+
+} // namespace utils
+} // namespace rag
@@ -0,0 +1,117 @@
+#include "utils/metrics_server.h"
+#include "utils/metrics.h"
+#include "utils/logger.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <cstring>
+
+namespace rag {
+namespace utils {
+
+MetricsServer::MetricsServer(const std::string& address, int port)
+    : address_(address), port_(port) {
+}
+
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+bool MetricsServer::start() {
+    listen_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd_ < 0) {
+        RAG_LOG_ERROR("Failed to create metrics socket");
+        return false;
+    }
+    int reuse = 1;
+    ::setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(port_));
+    if (::inet_pton(AF_INET, address_.c_str(), &address.sin_addr) != 1 ||
+        ::bind(listen_fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(listen_fd_, 16) != 0) {
+        RAG_LOG_ERROR("Failed to listen for metrics on " + address_ + ":" + std::to_string(port_));
+        ::close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+    
+    socklen_t length = sizeof(address);
+    ::getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&address), &length);
+    port_ = ntohs(address.sin_port);
+    
+    running_ = true;
+    thread_ = std::thread(&MetricsServer::serveLoop, this);
+    RAG_LOG_INFO("Metrics available at http://" + address_ + ":" + std::to_string(port_) + "/metrics");
+    return true;
+}
+
+void MetricsServer::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    ::shutdown(listen_fd_, SHUT_RDWR);
+    ::close(listen_fd_);
+    listen_fd_ = -1;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void MetricsServer::serveLoop() {
+    while (running_) {
+        int fd = ::accept(listen_fd_, nullptr, nullptr);
+        if (fd < 0) {
+            continue;
+        }
+        handleConnection(fd);
+        ::close(fd);
+    }
+}
+
+void MetricsServer::handleConnection(int fd) {
+    // Don't let a stalled client block later scrapes
+    timeval timeout{2, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    
+    std::string request;
+    char buffer[4096];
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < 65536) {
+        ssize_t n = ::recv(fd, buffer, sizeof(buffer), 0);
+        if (n <= 0) {
+            return;
+        }
+        request.append(buffer, static_cast<size_t>(n));
+    }
+    
+    std::string status = "200 OK";
+    std::string content_type = "text/plain; version=0.0.4";
+    std::string body;
+    if (request.rfind("GET /metrics", 0) == 0) {
+        body = MetricsRegistry::getInstance().renderPrometheus();
+    } else {
+        status = "404 Not Found";
+        body = "Not found\n";
+    }
+    
+    std::string response = "HTTP/1.1 " + status + "\r\n" +
+                           "Content-Type: " + content_type + "\r\n" +
+                           "Content-Length: " + std::to_string(body.size()) + "\r\n" +
+                           "Connection: close\r\n\r\n" + body;
+    size_t sent = 0;
+    while (sent < response.size()) {
+        ssize_t n = ::send(fd, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            break;
+        }
+        sent += static_cast<size_t>(n);
+    }
+}
+
+} // namespace utils
+} // namespace rag
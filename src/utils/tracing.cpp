@@ -0,0 +1,311 @@
+#include "utils/tracing.h"
+#include "utils/logger.h"
+#include <nlohmann/json.hpp>
+#include <chrono>
+#include <random>
+
+namespace rag {
+namespace utils {
+
+struct TraceBuffer {
+    std::string trace_id;
+    bool sampled = false;
+    std::mutex mutex;
+    std::vector<SpanData> spans;
+};
+
+namespace {
+
+thread_local TraceContext t_current;
+
+std::mt19937_64& threadRng() {
+    thread_local std::mt19937_64 rng(std::random_device{}() ^
+                                     std::hash<std::thread::id>()(std::this_thread::get_id()));
+    return rng;
+}
+
+std::string randomHex(size_t bytes) {
+    static const char kDigits[] = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(bytes * 2);
+    uint64_t bits = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+        if (i % 8 == 0) {
+            do {
+                bits = threadRng()();
+            } while (bits == 0);
+        }
+        unsigned char byte = static_cast<unsigned char>(bits >> ((i % 8) * 8));
+        hex += kDigits[byte >> 4];
+        hex += kDigits[byte & 0xf];
+    }
+    return hex;
+}
+
+bool isHex(const std::string& value) {
+    for (char c : value) {
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) {
+            return false;
+        }
+    }
+    return value.find_first_not_of('0') != std::string::npos; // All-zero ids are invalid
+}
+
+// W3C Trace Context: "00-<32 hex trace id>-<16 hex parent id>-<2 hex flags>"
+bool parseTraceparent(const std::string& header, std::string& trace_id,
+                      std::string& parent_id, bool& sampled) {
+    if (header.size() < 55 || header.compare(0, 3, "00-") != 0 || header[35] != '-' || header[52] != '-') {
+        return false;
+    }
+    std::string trace = header.substr(3, 32);
+    std::string parent = header.substr(36, 16);
+    std::string flags = header.substr(53, 2);
+    if (!isHex(trace) || !isHex(parent) || flags.find_first_not_of("0123456789abcdef") != std::string::npos) {
+        return false;
+    }
+    trace_id = trace;
+    parent_id = parent;
+    sampled = (std::stoi(flags, nullptr, 16) & 0x01) != 0;
+    return true;
+}
+
+int64_t nowUnixNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+int otlpKind(SpanKind kind) {
+    switch (kind) {
+        case SpanKind::SERVER: return 2;
+        case SpanKind::CLIENT: return 3;
+        default: return 1;
+    }
+}
+
+} // namespace
+
+OtlpFileExporter::OtlpFileExporter(const std::string& filepath, const std::string& service_name)
+    : service_name_(service_name), file_(std::fopen(filepath.c_str(), "a")) {
+    if (!file_) {
+        RAG_LOG_ERROR("Failed to open trace file: " + filepath);
+    }
+    writer_ = std::thread(&OtlpFileExporter::writerLoop, this);
+}
+
+OtlpFileExporter::~OtlpFileExporter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    cv_.notify_one();
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+    if (file_) {
+        std::fclose(file_);
+    }
+}
+
+void OtlpFileExporter::exportSpans(std::vector<SpanData> spans) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& span : spans) {
+        pending_.push_back(std::move(span));
+    }
+    cv_.notify_one();
+}
+
+void OtlpFileExporter::writerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cv_.wait_for(lock, std::chrono::seconds(1), [this] { return !pending_.empty() || !running_; });
+        if (!pending_.empty()) {
+            std::vector<SpanData> batch;
+            batch.swap(pending_);
+            lock.unlock();
+            if (file_) {
+                std::string line = toJson(batch);
+                line += '\n';
+                std::fwrite(line.data(), 1, line.size(), file_);
+                std::fflush(file_);
+            }
+            lock.lock();
+            continue;
+        }
+        if (!running_) {
+            break;
+        }
+    }
+}
+
+std::string OtlpFileExporter::toJson(const std::vector<SpanData>& spans) const {
+    nlohmann::json json_spans = nlohmann::json::array();
+    for (const auto& span : spans) {
+        nlohmann::json json_span;
+        json_span["traceId"] = span.trace_id;
+        json_span["spanId"] = span.span_id;
+        if (!span.parent_span_id.empty()) {
+            json_span["parentSpanId"] = span.parent_span_id;
+        }
+        json_span["name"] = span.name;
+        json_span["kind"] = otlpKind(span.kind);
+        json_span["startTimeUnixNano"] = std::to_string(span.start_unix_nanos);
+        json_span["endTimeUnixNano"] = std::to_string(span.end_unix_nanos);
+        json_span["attributes"] = nlohmann::json::array();
+        for (const auto& [key, value] : span.attributes) {
+            json_span["attributes"].push_back({{"key", key}, {"value", {{"stringValue", value}}}});
+        }
+        if (span.error) {
+            json_span["status"] = {{"code", 2}, {"message", span.status_message}};
+        }
+        json_spans.push_back(std::move(json_span));
+    }
+    
+    nlohmann::json resource;
+    resource["attributes"] = nlohmann::json::array();
+    resource["attributes"].push_back({{"key", "service.name"}, {"value", {{"stringValue", service_name_}}}});
+    
+    nlohmann::json scope_spans;
+    scope_spans["scope"] = {{"name", "rag"}};
+    scope_spans["spans"] = std::move(json_spans);
+    
+    nlohmann::json resource_spans;
+    resource_spans["resource"] = std::move(resource);
+    resource_spans["scopeSpans"] = nlohmann::json::array({std::move(scope_spans)});
+    
+    nlohmann::json request;
+    request["resourceSpans"] = nlohmann::json::array({std::move(resource_spans)});
+    return request.dump();
+}
+
+Tracer& Tracer::getInstance() {
+    static Tracer instance;
+    return instance;
+}
+
+void Tracer::configure(const TracingConfig& config, std::shared_ptr<SpanExporter> exporter) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    config_ = config;
+    exporter_ = exporter;
+    enabled_.store(exporter != nullptr, std::memory_order_relaxed);
+}
+
+std::shared_ptr<SpanExporter> Tracer::exporter() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return exporter_;
+}
+
+TraceContext Tracer::currentContext() {
+    return t_current;
+}
+
+Span::Span(const std::string& name, SpanKind kind) {
+    if (!t_current.buffer || !Tracer::getInstance().enabled()) {
+        return;
+    }
+    data_.parent_span_id = t_current.span_id;
+    begin(name, kind);
+}
+
+Span::Span(const std::string& name, const std::string& traceparent, SpanKind kind) {
+    Tracer& tracer = Tracer::getInstance();
+    if (!tracer.enabled()) {
+        return;
+    }
+    if (traceparent.empty() && t_current.buffer) {
+        // Already inside a trace on this thread: nest instead of starting another
+        data_.parent_span_id = t_current.span_id;
+        begin(name, kind);
+        return;
+    }
+    
+    auto buffer = std::make_shared<TraceBuffer>();
+    if (!parseTraceparent(traceparent, buffer->trace_id, data_.parent_span_id, buffer->sampled)) {
+        buffer->trace_id = randomHex(16);
+        data_.parent_span_id.clear();
+        buffer->sampled = std::uniform_real_distribution<double>(0.0, 1.0)(threadRng()) < tracer.config().sample_rate;
+    }
+    root_ = true;
+    previous_ = t_current;
+    t_current = TraceContext{buffer, ""};
+    begin(name, kind);
+}
+
+void Span::begin(const std::string& name, SpanKind kind) {
+    if (!root_) {
+        previous_ = t_current;
+    }
+    active_ = true;
+    data_.trace_id = t_current.buffer->trace_id;
+    data_.span_id = randomHex(8);
+    data_.name = name;
+    data_.kind = kind;
+    data_.start_unix_nanos = nowUnixNanos();
+    t_current.span_id = data_.span_id;
+}
+
+Span::~Span() {
+    if (!active_) {
+        return;
+    }
+    data_.end_unix_nanos = nowUnixNanos();
+    std::shared_ptr<TraceBuffer> buffer = t_current.buffer;
+    t_current = previous_;
+    if (!buffer) {
+        return;
+    }
+    
+    Tracer& tracer = Tracer::getInstance();
+    int64_t duration_ms = (data_.end_unix_nanos - data_.start_unix_nanos) / 1000000;
+    std::vector<SpanData> finished;
+    {
+        std::lock_guard<std::mutex> lock(buffer->mutex);
+        if (root_ || buffer->spans.size() < tracer.config().max_spans_per_trace) {
+            buffer->spans.push_back(std::move(data_));
+        }
+        if (root_) {
+            if (buffer->sampled || duration_ms >= tracer.config().slow_threshold_ms) {
+                finished.swap(buffer->spans);
+            } else {
+                buffer->spans.clear();
+            }
+        }
+    }
+    
+    if (!finished.empty()) {
+        if (auto exporter = tracer.exporter()) {
+            exporter->exportSpans(std::move(finished));
+        }
+    }
+}
+
+void Span::setAttribute(const std::string& key, const std::string& value) {
+    if (active_) {
+        data_.attributes.emplace_back(key, value);
+    }
+}
+
+void Span::setError(const std::string& message) {
+    if (active_) {
+        data_.error = true;
+        data_.status_message = message;
+    }
+}
+
+std::string Span::traceparent() const {
+    if (!active_) {
+        return "";
+    }
+    bool sampled = t_current.buffer && t_current.buffer->sampled;
+    return "00-" + data_.trace_id + "-" + data_.span_id + (sampled ? "-01" : "-00");
+}
+
+TraceContextScope::TraceContextScope(const TraceContext& context) : previous_(t_current) {
+    t_current = context;
+}
+
+TraceContextScope::~TraceContextScope() {
+    t_current = previous_;
+}
+
+} // namespace utils
+} // namespace rag
@@ -0,0 +1,151 @@
+#include "vectorization/document_chunker.h"
+#include "vectorization/tokenizer.h"
+#include "utils/logger.h"
+#include "utils/metrics.h"
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+
+namespace rag {
+namespace vectorization {
+
+DocumentChunker::DocumentChunker(const ChunkingConfig& config, std::shared_ptr<FAISSIndex> faiss_index)
+    : config_(config), faiss_index_(faiss_index) {
+    if (config_.max_tokens == 0) {
+        config_.max_tokens = 1;
+    }
+    if (config_.overlap_tokens >= config_.max_tokens) {
+        config_.overlap_tokens = config_.max_tokens / 2;
+    }
+}
+
+std::string DocumentChunker::contentHash(const std::string& text) {
+    // FNV-1a over lowercased text with whitespace runs collapsed
+    uint64_t hash = 14695981039346656037ULL;
+    bool pending_space = false;
+    bool started = false;
+    for (unsigned char c : text) {
+        if (std::isspace(c)) {
+            pending_space = started;
+            continue;
+        }
+        if (pending_space) {
+            hash ^= ' ';
+            hash *= 1099511628211ULL;
+            pending_space = false;
+        }
+        hash ^= static_cast<unsigned char>(std::tolower(c));
+        hash *= 1099511628211ULL;
+        started = true;
+    }
+    
+    char buffer[17];
+    std::snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(hash));
+    return buffer;
+}
+
+std::vector<std::string> DocumentChunker::split(const std::string& text) const {
+    std::vector<std::string> chunks;
+    std::vector<TokenPiece> pieces = Tokenizer::pretokenize(text);
+    size_t n = pieces.size();
+    size_t start = 0;
+    
+    while (start < n) {
+        // Grow the chunk up to the token budget, remembering the last sentence end
+        size_t end = start;
+        size_t tokens = 0;
+        size_t last_break = n;
+        size_t tokens_at_break = 0;
+        while (end < n && tokens + pieces[end].tokens <= config_.max_tokens) {
+            tokens += pieces[end].tokens;
+            if (pieces[end].sentence_end) {
+                last_break = end;
+                tokens_at_break = tokens;
+            }
+            ++end;
+        }
+        if (end == start) {
+            end = start + 1; // A single piece larger than the budget
+        }
+        
+        // Cut at the sentence boundary unless that would leave the chunk too small
+        if (end < n && last_break < n && tokens_at_break >= config_.max_tokens / 2) {
+            end = last_break + 1;
+        }
+        
+        size_t begin_byte = pieces[start].begin;
+        size_t end_byte = pieces[end - 1].end;
+        while (begin_byte < end_byte && std::isspace(static_cast<unsigned char>(text[begin_byte]))) {
+            ++begin_byte;
+        }
+        while (end_byte > begin_byte && std::isspace(static_cast<unsigned char>(text[end_byte - 1]))) {
+            --end_byte;
+        }
+        if (end_byte > begin_byte) {
+            chunks.push_back(text.substr(begin_byte, end_byte - begin_byte));
+        }
+        
+        if (end >= n) {
+            break;
+        }
+        
+        // Step back to repeat up to overlap_tokens, always making progress
+        size_t next = end;
+        size_t overlap = 0;
+        while (next > start + 1 && overlap + pieces[next - 1].tokens <= config_.overlap_tokens) {
+            overlap += pieces[next - 1].tokens;
+            --next;
+        }
+        start = next;
+    }
+    
+    return chunks;
+}
+
+size_t DocumentChunker::chunk(const Document& parent, std::vector<Document>& chunks) {
+    static auto& duplicate_chunks = utils::MetricsRegistry::getInstance().counter(
+        "rag_cache_lookups_total", "Cache lookups by result", {{"cache", "chunk_content"}, {"result", "hit"}});
+    static auto& new_chunks = utils::MetricsRegistry::getInstance().counter(
+        "rag_cache_lookups_total", "Cache lookups by result", {{"cache", "chunk_content"}, {"result", "miss"}});
+    
+    std::vector<std::string> pieces = split(parent.content);
+    size_t added = 0;
+    
+    for (size_t i = 0; i < pieces.size(); ++i) {
+        std::string hash = contentHash(pieces[i]);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!seen_hashes_.insert(hash).second) {
+                duplicate_chunks.increment();
+                continue;
+            }
+        }
+        if (faiss_index_ && faiss_index_->containsContent(hash)) {
+            duplicate_chunks.increment();
+            continue;
+        }
+        new_chunks.increment();
+        
+        Document chunk;
+        chunk.doc_id = parent.doc_id + "#" + std::to_string(i);
+        chunk.content = std::move(pieces[i]);
+        chunk.source = parent.source;
+        chunk.timestamp = parent.timestamp;
+        chunk.metadata = parent.metadata;
+        chunk.metadata["parent_doc_id"] = parent.doc_id;
+        chunk.metadata["chunk_index"] = std::to_string(i);
+        chunk.metadata["chunk_count"] = std::to_string(pieces.size());
+        chunk.metadata["content_hash"] = hash;
+        chunks.push_back(std::move(chunk));
+        ++added;
+    }
+    
+    if (added < pieces.size()) {
+        RAG_LOG_DEBUG("Dropped " + std::to_string(pieces.size() - added) +
+                                                " duplicate chunks of " + parent.doc_id);
+    }
+    return added;
+}
+
+} // namespace vectorization
+} // namespace rag
@@ -1,8 +1,13 @@
 #include "vectorization/embedding_service.h"
 #include "utils/logger.h"
-#include <curl/curl.h>
+#include "utils/http_client.h"
+#include "utils/tracing.h"
+#include "utils/json_scanner.h"
+#include "utils/base64.h"
 #include <nlohmann/json.hpp>
 #include <sstream>
+#include <algorithm>
+#include <cstring>
 
 namespace rag {
 namespace vectorization {
@@ -14,100 +19,260 @@ EmbeddingService::EmbeddingService(const std::string& api_key, const std::string
     }
 }
 
-static size_t WriteCallback(void* contents, size_t size, size_t nmemb, std::string* data) {
-    size_t total_size = size * nmemb;
-    data->append((char*)contents, total_size);
-    return total_size;
-}
-
 bool EmbeddingService::generateEmbedding(const std::string& text, std::vector<float>& embedding) {
     if (provider_ == "openai") {
         return generateOpenAIEmbedding(text, embedding);
     } else if (provider_ == "vertex") {
         return generateVertexAIEmbedding(text, embedding);
+    } else if (provider_ == "local") {
+        utils::Span span("local_embedding");
+        return local_model_.embed(text, embedding);
     }
     return false;
 }
 
-bool EmbeddingService::generateOpenAIEmbedding(const std::string& text, std::vector<float>& embedding) {
-    CURL* curl = curl_easy_init();
-    if (!curl) {
-        rag::utils::Logger::getInstance().error("Failed to initialize CURL for embedding");
+bool EmbeddingService::loadLocalModel(const std::string& filepath) {
+    if (!local_model_.load(filepath)) {
         return false;
     }
+    embedding_dimension_ = local_model_.dimension();
+    return true;
+}
+
+std::future<bool> EmbeddingService::generateEmbeddingAsync(const std::string& text, std::vector<float>& embedding) {
+    if (provider_ != "openai") {
+        return std::async(std::launch::deferred, [this, text, &embedding]() {
+            return generateEmbedding(text, embedding);
+        });
+    }
     
+    auto pending = utils::HttpClient::getInstance().submit(buildOpenAIRequest(text));
+    return std::async(std::launch::deferred, [this, pending = std::move(pending), &embedding]() mutable {
+        size_t rows = 0;
+        return parseOpenAIResponse(pending.get(), embeddingSink(embedding), rows);
+    });
+}
+
+utils::HttpRequest EmbeddingService::buildOpenAIRequest(const nlohmann::json& input) const {
     nlohmann::json request_json;
-    request_json["input"] = text;
+    request_json["input"] = input;
     request_json["model"] = "text-embedding-3-small"; // or text-embedding-ada-002
+    if (base64_encoding_) {
+        // A quarter of the bytes of a float array, and decoding is a table lookup
+        request_json["encoding_format"] = "base64";
+    }
     
-    std::string json_str = request_json.dump();
-    std::string response;
-    
-    struct curl_slist* headers = nullptr;
-    headers = curl_slist_append(headers, "Content-Type: application/json");
-    std::string auth_header = "Authorization: Bearer " + api_key_;
-    headers = curl_slist_append(headers, auth_header.c_str());
-    
-    curl_easy_setopt(curl, CURLOPT_URL, "https://api.openai.com/v1/embeddings");
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, json_str.c_str());
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
-    
-    CURLcode res = curl_easy_perform(curl);
-    curl_slist_free_all(headers);
-    curl_easy_cleanup(curl);
+    utils::HttpRequest request;
+    request.method = "POST";
+    request.url = base_url_ + "/embeddings";
+    request.body = request_json.dump();
+    request.headers = {"Content-Type: application/json", "Authorization: Bearer " + api_key_};
+    request.endpoint = "openai:embeddings";
+    request.span_name = "POST /embeddings";
+    request.idempotent = true; // Same input, same vectors: safe to hedge
+    return request;
+}
+
+namespace {
+
+// Walk the "data" array, decoding each item's "embedding" (base64 float32 or
+// a float array) into the row sink returns for its "index"
+template<typename Sink>
+bool readEmbeddingData(utils::JsonScanner& json, std::string_view body, const Sink& sink, size_t& rows) {
+    thread_local std::vector<float> values;    // Float-array fallback
+    std::string escaped;                        // base64 seen before "index" that needed unescaping
+    std::string_view key;
     
-    if (res != CURLE_OK) {
-        rag::utils::Logger::getInstance().error("CURL request failed for embedding");
+    if (!json.beginArray()) {
         return false;
     }
-    
-    try {
-        nlohmann::json json_response = nlohmann::json::parse(response);
-        
-        // Check for API errors
-        if (json_response.contains("error")) {
-            std::string error_msg = json_response["error"].contains("message") 
-                ? json_response["error"]["message"].get<std::string>()
-                : "Unknown API error";
-            rag::utils::Logger::getInstance().error("OpenAI API error: " + error_msg);
-            rag::utils::Logger::getInstance().debug("Full response: " + response);
+    while (json.nextElement()) {
+        if (!json.beginObject()) {
             return false;
         }
+        double index = -1;
+        std::string_view encoded;
+        bool is_array = false;
+        bool has_embedding = false;
+        while (json.nextKey(key)) {
+            if (key == "index") {
+                json.readNumber(index);
+            } else if (key == "embedding" && json.peek() == '"') {
+                if (!json.readString(encoded)) {
+                    return false;
+                }
+                // Unescaped views live in the scanner's buffer until its next call
+                if (encoded.data() < body.data() || encoded.data() >= body.data() + body.size()) {
+                    escaped.assign(encoded.data(), encoded.size());
+                    encoded = escaped;
+                }
+                has_embedding = true;
+            } else if (key == "embedding" && json.peek() == '[') {
+                values.clear();
+                json.beginArray();
+                double value;
+                while (json.nextElement() && json.readNumber(value)) {
+                    values.push_back(static_cast<float>(value));
+                }
+                is_array = true;
+                has_embedding = true;
+            } else {
+                json.skipValue();
+            }
+        }
+        if (!json.ok()) {
+            return false;
+        }
+        if (!has_embedding || index < 0) {
+            continue;
+        }
         
-        if (json_response.contains("data") && json_response["data"].is_array() && 
-            !json_response["data"].empty()) {
-            auto embedding_data = json_response["data"][0]["embedding"];
-            embedding.clear();
-            for (const auto& val : embedding_data) {
-                embedding.push_back(val.get<float>());
+        size_t bytes = is_array ? values.size() * sizeof(float) : utils::base64DecodedSize(encoded);
+        if (bytes % sizeof(float) != 0) {
+            return false;
+        }
+        float* row = sink(static_cast<size_t>(index), bytes / sizeof(float));
+        if (!row) {
+            continue;
+        }
+        if (is_array) {
+            std::memcpy(row, values.data(), bytes);
+        } else {
+            size_t written = 0;
+            if (!utils::base64Decode(encoded, reinterpret_cast<uint8_t*>(row), written)) {
+                return false;
+            }
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+            auto* words = reinterpret_cast<uint32_t*>(row);
+            for (size_t i = 0; i < bytes / sizeof(float); ++i) {
+                words[i] = __builtin_bswap32(words[i]);
+            }
+#endif
+        }
+        ++rows;
+    }
+    return json.ok();
+}
+
+} // namespace
+
+bool EmbeddingService::parseOpenAIResponse(const utils::HttpResponse& http_response, const RowSink& sink,
+                                           size_t& rows) {
+    rows = 0;
+    if (!http_response.error.empty()) {
+        RAG_LOG_ERROR("CURL request failed for embedding: " + http_response.error);
+        return false;
+    }
+    const std::string& response = http_response.body;
+    
+    utils::JsonScanner json(response);
+    std::string_view key;
+    bool has_error = false;
+    std::string error_msg = "Unknown API error";
+    bool decoded = json.beginObject();
+    while (decoded && json.nextKey(key)) {
+        if (key == "data") {
+            decoded = readEmbeddingData(json, response, sink, rows);
+        } else if (key == "error" && json.peek() == '{') {
+            has_error = true;
+            json.beginObject();
+            while (json.nextKey(key)) {
+                key == "message" ? json.readString(error_msg) : json.skipValue();
             }
-            embedding_dimension_ = embedding.size();
-            rag::utils::Logger::getInstance().debug("Generated embedding with dimension: " + std::to_string(embedding_dimension_));
-            return true;
         } else {
-            rag::utils::Logger::getInstance().error("Unexpected response format from OpenAI API");
-            rag::utils::Logger::getInstance().debug("Response: " + response);
+            json.skipValue();
         }
-    } catch (const std::exception& e) {
-        rag::utils::Logger::getInstance().error("Failed to parse embedding response: " + std::string(e.what()));
-        rag::utils::Logger::getInstance().debug("Response: " + response);
     }
     
-    return false;
+    if (!decoded || !json.ok()) {
+        RAG_LOG_ERROR("Failed to parse embedding response at offset " + std::to_string(json.offset()));
+        RAG_LOG_DEBUG("Response: " + response);
+        return false;
+    }
+    if (has_error) {
+        RAG_LOG_ERROR("OpenAI API error: " + error_msg);
+        RAG_LOG_DEBUG("Full response: " + response);
+        return false;
+    }
+    if (rows == 0) {
+        RAG_LOG_ERROR("Unexpected response format from OpenAI API");
+        RAG_LOG_DEBUG("Response: " + response);
+        return false;
+    }
+    return true;
+}
+
+EmbeddingService::RowSink EmbeddingService::embeddingSink(std::vector<float>& embedding) {
+    return [this, &embedding](size_t index, size_t dimension) -> float* {
+        if (index != 0 || dimension == 0) {
+            return nullptr;
+        }
+        embedding.resize(dimension);
+        embedding_dimension_ = dimension;
+        RAG_LOG_DEBUG("Generated embedding with dimension: " + std::to_string(dimension));
+        return embedding.data();
+    };
+}
+
+bool EmbeddingService::generateOpenAIEmbedding(const std::string& text, std::vector<float>& embedding) {
+    utils::HttpResponse http_response;
+    utils::HttpClient::getInstance().perform(buildOpenAIRequest(text), http_response);
+    size_t rows = 0;
+    return parseOpenAIResponse(http_response, embeddingSink(embedding), rows);
+}
+
+bool EmbeddingService::generateOpenAIEmbeddings(const std::vector<std::string>& texts, const RowSink& sink) {
+    // One request per batch; the API accepts up to 2048 inputs
+    const size_t max_inputs_per_request = 2048;
+    size_t total_rows = 0;
+    
+    for (size_t start = 0; start < texts.size(); start += max_inputs_per_request) {
+        size_t end = std::min(texts.size(), start + max_inputs_per_request);
+        
+        // Results carry their input index; don't rely on response order
+        auto chunk_sink = [&](size_t index, size_t dimension) -> float* {
+            return start + index < end ? sink(start + index, dimension) : nullptr;
+        };
+        utils::HttpResponse http_response;
+        utils::HttpClient::getInstance().perform(
+            buildOpenAIRequest(std::vector<std::string>(texts.begin() + start, texts.begin() + end)), http_response);
+        size_t rows = 0;
+        if (!parseOpenAIResponse(http_response, chunk_sink, rows)) {
+            return false;
+        }
+        total_rows += rows;
+    }
+    
+    if (total_rows < texts.size()) {
+        RAG_LOG_ERROR("Batch embedding response is missing inputs");
+        return false;
+    }
+    RAG_LOG_DEBUG("Generated " + std::to_string(texts.size()) + " embeddings in batch");
+    return true;
 }
 
 bool EmbeddingService::generateVertexAIEmbedding(const std::string& text, std::vector<float>& embedding) {
     // Vertex AI embedding implementation
     // This would use Google Cloud Vertex AI API
-    rag::utils::Logger::getInstance().info("Vertex AI embeddings not fully implemented yet");
+    RAG_LOG_INFO("Vertex AI embeddings not fully implemented yet");
     return false;
 }
 
 bool EmbeddingService::generateEmbeddings(const std::vector<std::string>& texts,
                                          std::vector<std::vector<float>>& embeddings) {
+    if (provider_ == "openai") {
+        embeddings.resize(texts.size());
+        return generateOpenAIEmbeddings(texts, [this, &embeddings](size_t index, size_t dimension) -> float* {
+            embeddings[index].resize(dimension);
+            embedding_dimension_ = dimension;
+            return embeddings[index].data();
+        });
+    } else if (provider_ == "local") {
+        utils::Span span("local_embedding.batch");
+        span.setAttribute("batch_size", std::to_string(texts.size()));
+        return local_model_.embedBatch(texts, embeddings);
+    }
+    
     embeddings.clear();
     for (const auto& text : texts) {
         std::vector<float> embedding;
@@ -119,6 +284,43 @@ bool EmbeddingService::generateEmbeddings(const std::vector<std::string>& texts,
     return true;
 }
 
+bool EmbeddingService::generateEmbeddingMatrix(const std::vector<std::string>& texts, std::vector<float>& matrix) {
+    if (provider_ == "openai") {
+        // Rows land at index * dimension; the first vector fixes the dimension
+        size_t dimension = embedding_dimension_;
+        size_t filled = 0;
+        matrix.resize(texts.size() * dimension);
+        return generateOpenAIEmbeddings(texts, [&](size_t index, size_t row_dimension) -> float* {
+            if (row_dimension != dimension) {
+                if (filled > 0 || row_dimension == 0) {
+                    RAG_LOG_ERROR("Embedding dimension mismatch in batch");
+                    return nullptr;
+                }
+                dimension = row_dimension;
+                embedding_dimension_ = dimension;
+                matrix.resize(texts.size() * dimension);
+            }
+            ++filled;
+            return matrix.data() + index * dimension;
+        });
+    }
+    
+    std::vector<std::vector<float>> embeddings;
+    if (!generateEmbeddings(texts, embeddings)) {
+        return false;
+    }
+    matrix.clear();
+    matrix.reserve(embeddings.size() * embedding_dimension_);
+    for (const auto& embedding : embeddings) {
+        if (embedding.size() != embeddings.front().size()) {
+            RAG_LOG_ERROR("Embedding dimension mismatch in batch");
+            return false;
+        }
+        matrix.insert(matrix.end(), embedding.begin(), embedding.end());
+    }
+    return true;
+}
+
 } // namespace vectorization
 } // namespace rag
 
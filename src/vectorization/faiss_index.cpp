@@ -1,14 +1,91 @@
 #include "vectorization/faiss_index.h"
+#include "vectorization/index_wal.h"
 #include "utils/logger.h"
+#include "utils/metrics.h"
 #include <fstream>
+#include <algorithm>
+#include <cstdio>
+#include <mutex>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
 #ifndef NO_FAISS
-#include <faiss/utils.h>
+#include <faiss/index_io.h>
 #endif
 
 namespace rag {
 namespace vectorization {
 
+// The .meta file is line-based, so newlines inside fields are escaped
+static std::string escapeLine(const std::string& value) {
+    std::string escaped;
+    escaped.reserve(value.size());
+    for (char c : value) {
+        if (c == '\\') {
+            escaped += "\\\\";
+        } else if (c == '\n') {
+            escaped += "\\n";
+        } else if (c == '\r') {
+            escaped += "\\r";
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+static std::string unescapeLine(const std::string& value) {
+    std::string unescaped;
+    unescaped.reserve(value.size());
+    for (size_t i = 0; i < value.size(); ++i) {
+        if (value[i] == '\\' && i + 1 < value.size()) {
+            char next = value[++i];
+            unescaped += next == 'n' ? '\n' : next == 'r' ? '\r' : next;
+        } else {
+            unescaped += value[i];
+        }
+    }
+    return unescaped;
+}
+
+// fsync a file (or directory) so a following rename is durable
+static bool syncPath(const std::string& path, bool directory = false) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC | (directory ? O_DIRECTORY : 0));
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = ::fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+}
+
+static bool pathExists(const std::string& path) {
+    struct stat st;
+    return ::stat(path.c_str(), &st) == 0;
+}
+
+static std::string parentDirectory(const std::string& path) {
+    size_t slash = path.rfind('/');
+    return slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+}
+
+// Finishes or discards a save interrupted by a crash. save() writes both
+// temp files, then renames the metadata (the commit point) and the index.
+static void recoverCheckpoint(const std::string& filepath) {
+    std::string index_temp = filepath + ".tmp";
+    std::string meta_temp = filepath + ".meta.tmp";
+    if (pathExists(index_temp) && !pathExists(meta_temp)) {
+        RAG_LOG_WARNING("Completing interrupted index checkpoint: " + filepath);
+        std::rename(index_temp.c_str(), filepath.c_str());
+    } else {
+        std::remove(index_temp.c_str());
+        std::remove(meta_temp.c_str());
+    }
+}
+
 FAISSIndex::FAISSIndex(size_t dimension) : dimension_(dimension) {
 #ifdef NO_FAISS
     // Stub implementation when FAISS is not available
@@ -19,121 +96,180 @@ FAISSIndex::FAISSIndex(size_t dimension) : dimension_(dimension) {
 }
 
 FAISSIndex::~FAISSIndex() {
+    stopCheckpointer();
 }
 
 bool FAISSIndex::initialize() {
     if (dimension_ == 0) {
-        rag::utils::Logger::getInstance().error("Invalid embedding dimension: 0");
+        RAG_LOG_ERROR("Invalid embedding dimension: 0");
         return false;
     }
-    
+
 #ifdef NO_FAISS
-    rag::utils::Logger::getInstance().info("FAISS index initialized (stub mode) with dimension: " + std::to_string(dimension_));
+    RAG_LOG_INFO("FAISS index initialized (stub mode) with dimension: " + std::to_string(dimension_));
 #else
-    rag::utils::Logger::getInstance().info("FAISS index initialized with dimension: " + std::to_string(dimension_));
+    RAG_LOG_INFO("FAISS index initialized with dimension: " + std::to_string(dimension_));
 #endif
     return true;
 }
 
 bool FAISSIndex::addDocument(const Document& doc, const std::vector<float>& embedding) {
     if (embedding.size() != dimension_) {
-        rag::utils::Logger::getInstance().error("Embedding dimension mismatch");
+        RAG_LOG_ERROR("Embedding dimension mismatch");
         return false;
     }
-    
+
 #ifdef NO_FAISS
     // Stub implementation - just store metadata
-    rag::utils::Logger::getInstance().warning("FAISS not available - storing document metadata only");
-#else
-    // Add to FAISS index
-    index_->add(1, embedding.data());
+    RAG_LOG_WARNING("FAISS not available - storing document metadata only");
 #endif
+    if (!insertDocuments(&doc, 1, embedding.data())) {
+        return false;
+    }
     
-    // Store document metadata
-    documents_[doc.doc_id] = doc;
-    doc_ids_.push_back(doc.doc_id);
-    
-    rag::utils::Logger::getInstance().debug("Added document: " + doc.doc_id);
+    RAG_LOG_DEBUG("Added document: " + doc.doc_id);
     return true;
 }
 
 bool FAISSIndex::addDocuments(const std::vector<Document>& docs,
                               const std::vector<std::vector<float>>& embeddings) {
     if (docs.size() != embeddings.size()) {
-        rag::utils::Logger::getInstance().error("Document and embedding count mismatch");
+        RAG_LOG_ERROR("Document and embedding count mismatch");
         return false;
     }
     
-#ifdef NO_FAISS
-    // Stub implementation - just store metadata
-    rag::utils::Logger::getInstance().warning("FAISS not available - storing document metadata only");
-#else
-    // Prepare batch embedding matrix
+    // Prepare batch embedding matrix outside the lock
     std::vector<float> embedding_matrix;
+    embedding_matrix.reserve(embeddings.size() * dimension_);
     for (const auto& embedding : embeddings) {
         if (embedding.size() != dimension_) {
-            rag::utils::Logger::getInstance().error("Embedding dimension mismatch in batch");
+            RAG_LOG_ERROR("Embedding dimension mismatch in batch");
             return false;
         }
         embedding_matrix.insert(embedding_matrix.end(), embedding.begin(), embedding.end());
     }
-    
-    // Add to FAISS index
-    index_->add(docs.size(), embedding_matrix.data());
+    return addDocumentMatrix(docs, embedding_matrix);
+}
+
+bool FAISSIndex::addDocumentMatrix(const std::vector<Document>& docs, const std::vector<float>& embedding_matrix) {
+    if (embedding_matrix.size() != docs.size() * dimension_) {
+        RAG_LOG_ERROR("Embedding matrix does not match " + std::to_string(docs.size()) + " documents of dimension " +
+                      std::to_string(dimension_));
+        return false;
+    }
+    return addDocumentMatrix(docs, embedding_matrix.data());
+}
+
+bool FAISSIndex::addDocumentMatrix(const std::vector<Document>& docs, const float* embedding_matrix) {
+#ifdef NO_FAISS
+    // Stub implementation - just store metadata
+    RAG_LOG_WARNING("FAISS not available - storing document metadata only");
 #endif
-    
-    // Store document metadata
-    for (size_t i = 0; i < docs.size(); ++i) {
-        documents_[docs[i].doc_id] = docs[i];
-        doc_ids_.push_back(docs[i].doc_id);
+    if (!insertDocuments(docs.data(), docs.size(), embedding_matrix)) {
+        return false;
     }
     
-    rag::utils::Logger::getInstance().info("Added " + std::to_string(docs.size()) + " documents to index");
+    RAG_LOG_INFO("Added " + std::to_string(docs.size()) + " documents to index");
     return true;
 }
 
+bool FAISSIndex::insertDocuments(const Document* docs, size_t count, const float* embedding_matrix) {
+    // The WAL record is serialized before taking the lock
+    std::string record;
+    if (wal_open_.load(std::memory_order_acquire)) {
+        record = IndexWal::encodeAdd(docs, count, embedding_matrix, dimension_);
+    }
+    
+    IndexWal* wal = nullptr;
+    uint64_t lsn = 0;
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        if (wal_) {
+            if (record.empty()) {
+                record = IndexWal::encodeAdd(docs, count, embedding_matrix, dimension_);
+            }
+            lsn = wal_->append(std::move(record));
+            if (lsn == 0) {
+                RAG_LOG_ERROR("Index WAL unavailable; not adding " + std::to_string(count) + " documents");
+                return false;
+            }
+            wal = wal_.get();
+            applied_lsn_ = lsn;
+        }
+#ifndef NO_FAISS
+        index_->add(count, embedding_matrix);
+#endif
+        for (size_t i = 0; i < count; ++i) {
+            trackDocument(docs[i]);
+        }
+    }
+    
+    // Searches see the documents already; the writer waits for the sync
+    // without the lock, sharing it with concurrent writers
+    return !wal || wal->waitDurable(lsn);
+}
+
 std::vector<SearchResult> FAISSIndex::search(const std::vector<float>& query_embedding,
                                             size_t k) {
-    std::vector<SearchResult> results;
-    
     if (query_embedding.size() != dimension_) {
-        rag::utils::Logger::getInstance().error("Query embedding dimension mismatch");
-        return results;
+        RAG_LOG_ERROR("Query embedding dimension mismatch");
+        return {};
     }
     
+    auto results = searchBatch(query_embedding, k);
+    return results.empty() ? std::vector<SearchResult>() : std::move(results.front());
+}
+
+std::vector<std::vector<SearchResult>> FAISSIndex::searchBatch(const std::vector<float>& query_matrix,
+                                                               [[maybe_unused]] size_t k) {
+    if (dimension_ == 0 || query_matrix.size() % dimension_ != 0) {
+        RAG_LOG_ERROR("Query matrix dimension mismatch");
+        return {};
+    }
+    size_t queries = query_matrix.size() / dimension_;
+    std::vector<std::vector<SearchResult>> results(queries);
+
 #ifdef NO_FAISS
     // Stub implementation - return empty results or all documents
-    rag::utils::Logger::getInstance().warning("FAISS not available - returning empty search results");
+    RAG_LOG_WARNING("FAISS not available - returning empty search results");
     return results;
 #else
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    
     if (index_->ntotal == 0) {
-        rag::utils::Logger::getInstance().warning("Index is empty, cannot search");
+        RAG_LOG_WARNING("Index is empty, cannot search");
         return results;
     }
     
     // Adjust k if necessary
     size_t actual_k = std::min(k, static_cast<size_t>(index_->ntotal));
     
-    // Prepare output arrays
-    std::vector<faiss::idx_t> indices(actual_k);
-    std::vector<float> distances(actual_k);
+    // Prepare output arrays, actual_k per query
+    std::vector<faiss::idx_t> indices(queries * actual_k);
+    std::vector<float> distances(queries * actual_k);
     
-    // Search
-    index_->search(1, query_embedding.data(), actual_k, distances.data(), indices.data());
+    // One search call for every query: FAISS scans the index once per block of queries
+    index_->search(queries, query_matrix.data(), actual_k, distances.data(), indices.data());
     
-    // Convert to SearchResult
-    for (size_t i = 0; i < actual_k; ++i) {
-        if (indices[i] >= 0 && indices[i] < static_cast<faiss::idx_t>(doc_ids_.size())) {
-            std::string doc_id = doc_ids_[indices[i]];
-            if (documents_.find(doc_id) != documents_.end()) {
+    // Convert to SearchResult: the one copy out of the index; later stages move it
+    for (size_t q = 0; q < queries; ++q) {
+        results[q].reserve(actual_k);
+        for (size_t i = q * actual_k; i < (q + 1) * actual_k; ++i) {
+            if (indices[i] < 0 || indices[i] >= static_cast<faiss::idx_t>(doc_ids_.size())) {
+                continue;
+            }
+            const std::string& doc_id = doc_ids_[indices[i]];
+            auto doc_it = documents_.find(doc_id);
+            if (doc_it != documents_.end()) {
+                const Document& doc = *doc_it->second;
                 SearchResult result;
                 result.doc_id = doc_id;
-                result.content = documents_[doc_id].content;
-                result.source = documents_[doc_id].source;
-                result.timestamp = documents_[doc_id].timestamp;
-                result.metadata = documents_[doc_id].metadata;
+                result.content = doc.content;
+                result.source = doc.source;
+                result.timestamp = doc.timestamp;
+                result.metadata = doc.metadata;
                 result.similarity_score = 1.0f / (1.0f + distances[i]); // Convert L2 distance to similarity
-                results.push_back(result);
+                results[q].push_back(std::move(result));
             }
         }
     }
@@ -142,86 +278,409 @@ std::vector<SearchResult> FAISSIndex::search(const std::vector<float>& query_emb
 #endif
 }
 
+bool FAISSIndex::searchLabels([[maybe_unused]] const float* queries, size_t n, size_t k,
+                              int64_t* labels, float* scores) {
+    static_assert(sizeof(faiss::idx_t) == sizeof(int64_t), "FAISS labels are written in place");
+    std::fill(labels, labels + n * k, -1);
+    std::fill(scores, scores + n * k, 0.0f);
+    if (n == 0 || k == 0) {
+        return true;
+    }
+
+#ifdef NO_FAISS
+    RAG_LOG_WARNING("FAISS not available - returning empty search results");
+    return true;
+#else
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    if (index_->ntotal == 0) {
+        return true;
+    }
+    
+    // FAISS pads rows with label -1 when k exceeds the index size
+    index_->search(n, queries, k, scores, reinterpret_cast<faiss::idx_t*>(labels));
+    for (size_t i = 0; i < n * k; ++i) {
+        if (labels[i] < 0 || labels[i] >= static_cast<int64_t>(doc_ids_.size()) ||
+            documents_.find(doc_ids_[labels[i]]) == documents_.end()) {
+            labels[i] = -1;
+            scores[i] = 0.0f;
+            continue;
+        }
+        scores[i] = 1.0f / (1.0f + scores[i]); // Convert L2 distance to similarity
+    }
+    return true;
+#endif
+}
+
+std::string FAISSIndex::documentId(int64_t label) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    if (label < 0 || label >= static_cast<int64_t>(doc_ids_.size())) {
+        return "";
+    }
+    return doc_ids_[label];
+}
+
 bool FAISSIndex::removeDocument(const std::string& doc_id) {
     // FAISS doesn't support efficient removal, so we'd need to rebuild the index
     // For now, just remove from metadata
-    if (documents_.find(doc_id) != documents_.end()) {
-        documents_.erase(doc_id);
-        rag::utils::Logger::getInstance().info("Removed document metadata: " + doc_id);
+    IndexWal* wal = nullptr;
+    uint64_t lsn = 0;
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        auto it = documents_.find(doc_id);
+        if (it == documents_.end()) {
+            return false;
+        }
+        if (wal_) {
+            lsn = wal_->append(IndexWal::encodeRemove(doc_id));
+            if (lsn == 0) {
+                RAG_LOG_ERROR("Index WAL unavailable; not removing " + doc_id);
+                return false;
+            }
+            wal = wal_.get();
+            applied_lsn_ = lsn;
+        }
+        eraseDocument(it);
+        RAG_LOG_INFO("Removed document metadata: " + doc_id);
         // Note: The embedding is still in the index, but won't be found in search results
         // due to missing metadata
-        return true;
     }
-    return false;
+    return !wal || wal->waitDurable(lsn);
 }
 
 bool FAISSIndex::getDocument(const std::string& doc_id, Document& doc) {
-    if (documents_.find(doc_id) != documents_.end()) {
-        doc = documents_[doc_id];
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto it = documents_.find(doc_id);
+    if (it != documents_.end()) {
+        doc = *it->second;
         return true;
     }
     return false;
 }
 
+bool FAISSIndex::contains(const std::string& doc_id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return documents_.find(doc_id) != documents_.end();
+}
+
+bool FAISSIndex::containsContent(const std::string& content_hash) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return content_hashes_.count(content_hash) > 0;
+}
+
+void FAISSIndex::trackDocument(const Document& doc) {
+    preserveForSnapshot(doc.doc_id);
+    documents_[doc.doc_id] = std::make_shared<const Document>(doc);
+    doc_ids_.push_back(doc.doc_id);
+    auto hash_it = doc.metadata.find("content_hash");
+    if (hash_it != doc.metadata.end()) {
+        content_hashes_.insert(hash_it->second);
+    }
+}
+
+void FAISSIndex::eraseDocument(std::map<std::string, std::shared_ptr<const Document>>::iterator it) {
+    preserveForSnapshot(it->first);
+    auto hash_it = it->second->metadata.find("content_hash");
+    if (hash_it != it->second->metadata.end()) {
+        content_hashes_.erase(hash_it->second);
+    }
+    documents_.erase(it);
+}
+
+void FAISSIndex::preserveForSnapshot(const std::string& doc_id) {
+    if (!snapshotting_ || snapshot_undo_.count(doc_id) > 0) {
+        return;
+    }
+    // Keep the snapshot-time version (null: absent) for the checkpoint copier
+    auto it = documents_.find(doc_id);
+    snapshot_undo_.emplace(doc_id, it == documents_.end() ? nullptr : it->second);
+}
+
+void FAISSIndex::applyRecord(WalRecord&& record) {
+    if (record.type == WalRecord::Type::ADD) {
+#ifndef NO_FAISS
+        index_->add(record.docs.size(), record.vectors.data());
+#endif
+        for (const auto& doc : record.docs) {
+            trackDocument(doc);
+        }
+    } else {
+        auto it = documents_.find(record.doc_id);
+        if (it != documents_.end()) {
+            eraseDocument(it);
+        }
+    }
+    applied_lsn_ = record.lsn;
+}
+
+bool FAISSIndex::openWal(const std::string& filepath, bool sync) {
+    auto wal = std::make_unique<IndexWal>(filepath + ".wal", dimension_, sync);
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    if (wal_) {
+        RAG_LOG_WARNING("Index WAL already open: " + wal_->path());
+        return false;
+    }
+    
+    size_t replayed = 0;
+    bool opened = wal->open(applied_lsn_, [&](WalRecord&& record) {
+        if (record.lsn > applied_lsn_) {
+            applyRecord(std::move(record));
+            ++replayed;
+        }
+    });
+    if (!opened) {
+        return false;
+    }
+    wal_ = std::move(wal);
+    wal_open_.store(true, std::memory_order_release);
+    RAG_LOG_INFO("Index WAL open: " + wal_->path() + " (replayed " + std::to_string(replayed) + " operations)");
+    return true;
+}
+
+bool FAISSIndex::startCheckpointer(const std::string& filepath, const CheckpointOptions& options) {
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        if (!wal_ || wal_->path() != filepath + ".wal") {
+            RAG_LOG_ERROR("Background checkpoints need the index WAL open for " + filepath);
+            return false;
+        }
+    }
+    if (checkpointer_.joinable()) {
+        RAG_LOG_WARNING("Index checkpointer already running");
+        return false;
+    }
+    checkpointer_stop_ = false;
+    checkpointer_ = std::thread(&FAISSIndex::runCheckpointer, this, filepath, options);
+    RAG_LOG_INFO("Background index checkpoints every " + std::to_string(options.interval.count()) + "s or " +
+                 std::to_string(options.wal_bytes >> 20) + " MB of WAL: " + filepath);
+    return true;
+}
+
+void FAISSIndex::stopCheckpointer() {
+    if (!checkpointer_.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(checkpointer_mutex_);
+        checkpointer_stop_ = true;
+    }
+    checkpointer_cv_.notify_all();
+    checkpointer_.join();
+}
+
+void FAISSIndex::runCheckpointer(std::string filepath, CheckpointOptions options) {
+#ifdef __linux__
+    // Lowest normal CPU and I/O priority for this thread only: serving
+    // threads go first, but checkpoints still finish under sustained load
+    ::setpriority(PRIO_PROCESS, static_cast<id_t>(::syscall(SYS_gettid)), 19);
+#ifdef SYS_ioprio_set
+    ::syscall(SYS_ioprio_set, 1 /* IOPRIO_WHO_PROCESS: this thread */, 0, (2 << 13) | 7 /* best effort, lowest */);
+#endif
+#endif
+    IndexWal* wal = nullptr;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        wal = wal_.get(); // Open for the index's lifetime once set
+    }
+    
+    std::chrono::milliseconds poll = std::min<std::chrono::milliseconds>(options.interval, std::chrono::seconds(1));
+    if (poll.count() <= 0) {
+        poll = std::chrono::milliseconds(100);
+    }
+    auto last_checkpoint = std::chrono::steady_clock::now();
+    auto retry_after = last_checkpoint;
+    std::unique_lock<std::mutex> lock(checkpointer_mutex_);
+    while (!checkpointer_stop_) {
+        checkpointer_cv_.wait_for(lock, poll);
+        if (checkpointer_stop_) {
+            break;
+        }
+        auto now = std::chrono::steady_clock::now();
+        bool pending = wal->lastLsn() > checkpoint_lsn_.load(std::memory_order_acquire);
+        bool due = wal->activeBytes() >= options.wal_bytes || now - last_checkpoint >= options.interval;
+        if (!pending || !due || now < retry_after) {
+            continue;
+        }
+        
+        lock.unlock();
+        bool ok = save(filepath);
+        lock.lock();
+        last_checkpoint = std::chrono::steady_clock::now();
+        if (!ok) {
+            RAG_LOG_WARNING("Background index checkpoint failed; retrying in " +
+                            std::to_string(options.interval.count()) + "s");
+            retry_after = last_checkpoint + options.interval;
+        }
+    }
+}
+
 bool FAISSIndex::save(const std::string& filepath) {
+    static auto& checkpoint_latency = utils::stageHistogram("faiss_index", "checkpoint");
+    static auto& snapshot_latency = utils::stageHistogram("faiss_index", "checkpoint_snapshot");
+    std::lock_guard<std::mutex> checkpoint_lock(checkpoint_mutex_);
+    utils::ScopedTimer timer(checkpoint_latency);
+    std::string metadata_filepath = filepath + ".meta";
+    std::string index_temp = filepath + ".tmp";
+    std::string metadata_temp = metadata_filepath + ".tmp";
+    
+    // Point-in-time snapshot: only the size and LSN are taken at once.
+    // Writers hold the exclusive lock, so under the shared lock the snapshot
+    // state below is ours alone.
+    size_t snapshot_size = 0;
+    uint64_t snapshot_lsn = 0;
+    IndexWal* sealed_wal = nullptr;
+    {
+        utils::ScopedTimer snapshot_timer(snapshot_latency);
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        snapshot_size = doc_ids_.size();
+        snapshot_lsn = applied_lsn_;
+        // The WAL splits exactly here
+        if (wal_ && wal_->path() == filepath + ".wal") {
+            if (!wal_->rotate(snapshot_lsn)) {
+                RAG_LOG_ERROR("Failed to seal index WAL for checkpoint: " + wal_->path());
+                return false;
+            }
+            sealed_wal = wal_.get();
+        }
+        snapshotting_ = true;
+    }
+    
+    // Then the rest is copied a chunk at a time. Positions below the size
+    // never change and documents are immutable, so only their pointers are
+    // copied; a document replaced or removed since the snapshot is read from
+    // the pre-image its writer saved. The lock only keeps an add from
+    // reallocating storage mid-chunk.
+    constexpr size_t kCopyChunk = 1024;
+    std::vector<std::string> doc_ids(snapshot_size);
+    std::vector<std::shared_ptr<const Document>> documents(snapshot_size);
+#ifndef NO_FAISS
+    faiss::IndexFlatL2 snapshot(dimension_);
+#endif
+    for (size_t start = 0; start < snapshot_size; start += kCopyChunk) {
+        size_t end = std::min(start + kCopyChunk, snapshot_size);
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        for (size_t i = start; i < end; ++i) {
+            doc_ids[i] = doc_ids_[i];
+            auto undo_it = snapshot_undo_.find(doc_ids[i]);
+            if (undo_it != snapshot_undo_.end()) {
+                documents[i] = undo_it->second;
+                continue;
+            }
+            auto doc_it = documents_.find(doc_ids[i]);
+            if (doc_it != documents_.end()) {
+                documents[i] = doc_it->second;
+            }
+        }
+#ifndef NO_FAISS
+        snapshot.add(end - start, index_->get_xb() + start * dimension_);
+#endif
+    }
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        snapshotting_ = false;
+        snapshot_undo_.clear();
+    }
+    
     try {
+        
+        // Metadata first: an index temp without a metadata temp means the
+        // metadata was already renamed into place (see recoverCheckpoint)
+        std::ofstream meta_file(metadata_temp, std::ios::trunc);
+        if (!meta_file.is_open()) {
+            RAG_LOG_ERROR("Failed to open metadata file for writing");
+            return false;
+        }
+        
+        // Simple serialization (in production, use protobuf or JSON). Every
+        // vector position gets an entry; removed documents are written with
+        // metadata count -1 so positions stay aligned with the FAISS index.
+        meta_file << snapshot_size << std::endl;
+        for (size_t i = 0; i < snapshot_size; ++i) {
+            meta_file << doc_ids[i] << std::endl;
+            if (!documents[i]) {
+                meta_file << std::endl << std::endl << std::endl << -1 << std::endl;
+                continue;
+            }
+            const auto& doc = *documents[i];
+            meta_file << escapeLine(doc.content) << std::endl;
+            meta_file << escapeLine(doc.source) << std::endl;
+            meta_file << escapeLine(doc.timestamp) << std::endl;
+            meta_file << doc.metadata.size() << std::endl;
+            for (const auto& [key, value] : doc.metadata) {
+                meta_file << escapeLine(key) << std::endl << escapeLine(value) << std::endl;
+            }
+        }
+        // WAL records up to here are in this checkpoint
+        meta_file << "lsn " << snapshot_lsn << std::endl;
+        meta_file.close();
+        if (!meta_file || !syncPath(metadata_temp)) {
+            RAG_LOG_ERROR("Failed to write metadata file: " + metadata_temp);
+            return false;
+        }
+
 #ifdef NO_FAISS
         // Stub implementation - just save metadata
-        rag::utils::Logger::getInstance().warning("FAISS not available - saving metadata only");
+        RAG_LOG_WARNING("FAISS not available - saving metadata only");
 #else
         // Save FAISS index
-        faiss::write_index(index_.get(), filepath.c_str());
+        faiss::write_index(&snapshot, index_temp.c_str());
+        if (!syncPath(index_temp)) {
+            RAG_LOG_ERROR("Failed to sync index file: " + index_temp);
+            return false;
+        }
 #endif
         
-        // Save metadata to separate file
-        std::string metadata_filepath = filepath + ".meta";
-        std::ofstream meta_file(metadata_filepath);
-        if (!meta_file.is_open()) {
-            rag::utils::Logger::getInstance().error("Failed to open metadata file for writing");
+        if (std::rename(metadata_temp.c_str(), metadata_filepath.c_str()) != 0) {
+            RAG_LOG_ERROR("Failed to replace metadata file: " + metadata_filepath);
+            return false;
+        }
+#ifndef NO_FAISS
+        if (std::rename(index_temp.c_str(), filepath.c_str()) != 0) {
+            RAG_LOG_ERROR("Failed to replace index file: " + filepath);
             return false;
         }
+#endif
+        syncPath(parentDirectory(filepath), true);
         
-        // Simple serialization (in production, use protobuf or JSON)
-        meta_file << doc_ids_.size() << std::endl;
-        for (const auto& doc_id : doc_ids_) {
-            meta_file << doc_id << std::endl;
-            if (documents_.find(doc_id) != documents_.end()) {
-                const auto& doc = documents_[doc_id];
-                meta_file << doc.content << std::endl;
-                meta_file << doc.source << std::endl;
-                meta_file << doc.timestamp << std::endl;
-                meta_file << doc.metadata.size() << std::endl;
-                for (const auto& [key, value] : doc.metadata) {
-                    meta_file << key << std::endl << value << std::endl;
-                }
-            }
+        // The checkpoint covers every sealed segment; later writes are in the active file
+        if (sealed_wal) {
+            sealed_wal->dropSealed(snapshot_lsn);
+            checkpoint_lsn_.store(snapshot_lsn, std::memory_order_release);
         }
-        meta_file.close();
         
-        rag::utils::Logger::getInstance().info("Saved FAISS index to: " + filepath);
+        RAG_LOG_INFO("Saved FAISS index to: " + filepath + " (" + std::to_string(snapshot_size) + " vectors)");
         return true;
     } catch (const std::exception& e) {
-        rag::utils::Logger::getInstance().error("Failed to save index: " + std::string(e.what()));
+        RAG_LOG_ERROR("Failed to save index: " + std::string(e.what()));
         return false;
     }
 }
 
 bool FAISSIndex::load(const std::string& filepath) {
+    std::lock_guard<std::mutex> checkpoint_lock(checkpoint_mutex_);
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    recoverCheckpoint(filepath);
     try {
 #ifdef NO_FAISS
         // Stub implementation - just load metadata
-        rag::utils::Logger::getInstance().warning("FAISS not available - loading metadata only");
+        RAG_LOG_WARNING("FAISS not available - loading metadata only");
 #else
         // Load FAISS index
         faiss::Index* loaded_index = faiss::read_index(filepath.c_str());
         if (!loaded_index) {
-            rag::utils::Logger::getInstance().error("Failed to load FAISS index");
+            RAG_LOG_ERROR("Failed to load FAISS index");
+            return false;
+        }
+        if (static_cast<size_t>(loaded_index->d) != dimension_) {
+            // Built with a different embedding provider; vectors are not comparable
+            RAG_LOG_ERROR("FAISS index dimension " + std::to_string(loaded_index->d) +
+                          " does not match embedding dimension " + std::to_string(dimension_));
+            delete loaded_index;
             return false;
         }
         
         index_.reset(dynamic_cast<faiss::IndexFlatL2*>(loaded_index));
         if (!index_) {
-            rag::utils::Logger::getInstance().error("Loaded index is not IndexFlatL2");
+            RAG_LOG_ERROR("Loaded index is not IndexFlatL2");
             delete loaded_index;
             return false;
         }
@@ -232,12 +691,13 @@ bool FAISSIndex::load(const std::string& filepath) {
         std::ifstream meta_file(metadata_filepath);
         if (!meta_file.is_open()) {
             // This is expected on first run when no index exists yet
-            rag::utils::Logger::getInstance().debug("Metadata file not found (this is normal on first run): " + metadata_filepath);
+            RAG_LOG_DEBUG("Metadata file not found (this is normal on first run): " + metadata_filepath);
             return false;
         }
         
         documents_.clear();
         doc_ids_.clear();
+        content_hashes_.clear();
         
         size_t doc_count;
         meta_file >> doc_count;
@@ -252,32 +712,67 @@ bool FAISSIndex::load(const std::string& filepath) {
             std::getline(meta_file, doc.content);
             std::getline(meta_file, doc.source);
             std::getline(meta_file, doc.timestamp);
+            doc.content = unescapeLine(doc.content);
+            doc.source = unescapeLine(doc.source);
+            doc.timestamp = unescapeLine(doc.timestamp);
             
-            size_t metadata_count;
+            long long metadata_count;
             meta_file >> metadata_count;
             meta_file.ignore();
+            if (metadata_count < 0) {
+                // Removed before the checkpoint; keeps its vector position
+                doc_ids_.push_back(doc_id);
+                continue;
+            }
             
-            for (size_t j = 0; j < metadata_count; ++j) {
+            for (long long j = 0; j < metadata_count; ++j) {
                 std::string key, value;
                 std::getline(meta_file, key);
                 std::getline(meta_file, value);
-                doc.metadata[key] = value;
+                doc.metadata[unescapeLine(key)] = unescapeLine(value);
             }
             
-            documents_[doc_id] = doc;
-            doc_ids_.push_back(doc_id);
+            trackDocument(doc);
         }
         
+        // Checkpoints written before the WAL existed have no LSN
+        std::string tag;
+        uint64_t checkpoint_lsn = 0;
+        if (!(meta_file >> tag >> checkpoint_lsn) || tag != "lsn") {
+            checkpoint_lsn = 0;
+        }
         meta_file.close();
-        rag::utils::Logger::getInstance().info("Loaded FAISS index from: " + filepath);
+
+#ifndef NO_FAISS
+        if (static_cast<size_t>(index_->ntotal) != doc_ids_.size()) {
+            RAG_LOG_ERROR("FAISS index holds " + std::to_string(index_->ntotal) + " vectors but its metadata " +
+                          std::to_string(doc_ids_.size()));
+            return false;
+        }
+#endif
+        
+        // Replay operations logged after the checkpoint
+        applied_lsn_ = checkpoint_lsn;
+        checkpoint_lsn_.store(checkpoint_lsn, std::memory_order_release);
+        size_t replayed = 0;
+        IndexWal::replay(filepath + ".wal", dimension_, [&](WalRecord&& record) {
+            if (record.lsn > applied_lsn_) {
+                applyRecord(std::move(record));
+                ++replayed;
+            }
+        });
+        
+        RAG_LOG_INFO("Loaded FAISS index from: " + filepath +
+                     (replayed > 0 ? " (replayed " + std::to_string(replayed) + " logged operations)" : ""));
         return true;
     } catch (const std::exception& e) {
-        rag::utils::Logger::getInstance().error("Failed to load index: " + std::string(e.what()));
+        RAG_LOG_ERROR("Failed to load index: " + std::string(e.what()));
         return false;
     }
 }
 
 size_t FAISSIndex::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
     return documents_.size();
 }
 
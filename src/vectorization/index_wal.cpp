@@ -0,0 +1,534 @@
+#include "vectorization/index_wal.h"
+#include "utils/logger.h"
+#include "utils/metrics.h"
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace rag {
+namespace vectorization {
+
+namespace {
+
+constexpr uint32_t kWalMagic = 0x4c415746; // "FWAL"
+constexpr uint32_t kWalVersion = 1;
+constexpr size_t kHeaderSize = 16;         // magic, version, dimension, reserved
+constexpr size_t kFrameHeader = 8;         // body length, CRC
+constexpr uint32_t kMaxBody = 1u << 30;
+
+const std::array<uint32_t, 256>& crcTable() {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            t[i] = c;
+        }
+        return t;
+    }();
+    return table;
+}
+
+// CRC-32 (IEEE); continue a finished CRC by passing it back as crc
+uint32_t crc32(const void* data, size_t size, uint32_t crc = 0) {
+    const auto& table = crcTable();
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+template <typename T>
+void put(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void putString(std::string& out, const std::string& value) {
+    put<uint32_t>(out, static_cast<uint32_t>(value.size()));
+    out.append(value);
+}
+
+// Frame header placeholders, filled in by finishFrame
+std::string startFrame(WalRecord::Type type, size_t reserve) {
+    std::string frame;
+    frame.reserve(kFrameHeader + 1 + reserve + sizeof(uint64_t));
+    frame.append(kFrameHeader, '\0');
+    put<uint8_t>(frame, static_cast<uint8_t>(type));
+    return frame;
+}
+
+// Length and CRC of the body; append adds the LSN to both CRC and frame
+std::string finishFrame(std::string frame) {
+    uint32_t length = static_cast<uint32_t>(frame.size() - kFrameHeader);
+    uint32_t crc = crc32(frame.data() + kFrameHeader, length);
+    std::memcpy(&frame[0], &length, sizeof(length));
+    std::memcpy(&frame[4], &crc, sizeof(crc));
+    return frame;
+}
+
+// Bounds-checked reads over a record body
+class BodyReader {
+public:
+    BodyReader(const char* data, size_t size) : data_(data), size_(size) {}
+    
+    template <typename T>
+    bool get(T& value) {
+        if (size_ - offset_ < sizeof(T)) {
+            return false;
+        }
+        std::memcpy(&value, data_ + offset_, sizeof(T));
+        offset_ += sizeof(T);
+        return true;
+    }
+    
+    bool getString(std::string& value) {
+        uint32_t length = 0;
+        if (!get(length) || size_ - offset_ < length) {
+            return false;
+        }
+        value.assign(data_ + offset_, length);
+        offset_ += length;
+        return true;
+    }
+    
+    bool getFloats(std::vector<float>& values, size_t count) {
+        if ((size_ - offset_) / sizeof(float) < count) {
+            return false;
+        }
+        values.resize(count);
+        std::memcpy(values.data(), data_ + offset_, count * sizeof(float));
+        offset_ += count * sizeof(float);
+        return true;
+    }
+    
+    bool done() const { return offset_ == size_; }
+    
+private:
+    const char* data_;
+    size_t size_;
+    size_t offset_ = 0;
+};
+
+bool decodeBody(const char* data, size_t size, size_t dimension, WalRecord& record) {
+    BodyReader reader(data, size);
+    uint8_t type = 0;
+    if (!reader.get(type)) {
+        return false;
+    }
+    record.type = static_cast<WalRecord::Type>(type);
+    if (record.type == WalRecord::Type::REMOVE) {
+        return reader.getString(record.doc_id) && reader.done();
+    }
+    if (record.type != WalRecord::Type::ADD) {
+        return false;
+    }
+    
+    uint32_t count = 0;
+    if (!reader.get(count)) {
+        return false;
+    }
+    record.docs.resize(count);
+    for (auto& doc : record.docs) {
+        uint32_t metadata_count = 0;
+        if (!reader.getString(doc.doc_id) || !reader.getString(doc.content) || !reader.getString(doc.source) ||
+            !reader.getString(doc.timestamp) || !reader.get(metadata_count)) {
+            return false;
+        }
+        for (uint32_t i = 0; i < metadata_count; ++i) {
+            std::string key, value;
+            if (!reader.getString(key) || !reader.getString(value)) {
+                return false;
+            }
+            doc.metadata.emplace(std::move(key), std::move(value));
+        }
+    }
+    return reader.getFloats(record.vectors, static_cast<size_t>(count) * dimension) && reader.done();
+}
+
+enum class ReadResult { MISSING, OK, BAD_HEADER };
+
+// Applies intact records in order; valid_end is the offset just past the last one
+ReadResult readLog(const std::string& path, size_t dimension, const std::function<void(WalRecord&&)>& apply,
+                   uint64_t& valid_end, uint64_t& file_size, uint64_t& last_lsn) {
+    valid_end = 0;
+    file_size = 0;
+    last_lsn = 0;
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return ReadResult::MISSING;
+    }
+    file_size = static_cast<uint64_t>(file.tellg());
+    file.seekg(0);
+    
+    uint32_t header[4] = {};
+    if (!file.read(reinterpret_cast<char*>(header), sizeof(header))) {
+        // Torn while being created: treat as empty
+        return ReadResult::OK;
+    }
+    if (header[0] != kWalMagic || header[1] != kWalVersion) {
+        RAG_LOG_ERROR("Not an index WAL: " + path);
+        return ReadResult::BAD_HEADER;
+    }
+    if (header[2] != dimension) {
+        RAG_LOG_ERROR("Index WAL " + path + " has dimension " + std::to_string(header[2]) +
+                      ", index has " + std::to_string(dimension));
+        return ReadResult::BAD_HEADER;
+    }
+    valid_end = kHeaderSize;
+    
+    std::string body;
+    while (true) {
+        uint32_t frame[2] = {};
+        if (!file.read(reinterpret_cast<char*>(frame), sizeof(frame))) {
+            break;
+        }
+        uint32_t length = frame[0];
+        uint64_t lsn = 0;
+        if (length == 0 || length > kMaxBody || file_size - valid_end < kFrameHeader + length + sizeof(lsn)) {
+            break;
+        }
+        body.resize(length + sizeof(lsn));
+        if (!file.read(&body[0], static_cast<std::streamsize>(body.size()))) {
+            break;
+        }
+        std::memcpy(&lsn, body.data() + length, sizeof(lsn));
+        
+        WalRecord record;
+        if (crc32(body.data(), body.size()) != frame[1] || lsn <= last_lsn ||
+            !decodeBody(body.data(), length, dimension, record)) {
+            break;
+        }
+        record.lsn = lsn;
+        last_lsn = lsn;
+        valid_end += kFrameHeader + body.size();
+        apply(std::move(record));
+    }
+    return ReadResult::OK;
+}
+
+bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+std::string parentDirectory(const std::string& path) {
+    size_t slash = path.rfind('/');
+    return slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+}
+
+void syncDirectory(const std::string& path) {
+    int fd = ::open(parentDirectory(path).c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd >= 0) {
+        ::fsync(fd);
+        ::close(fd);
+    }
+}
+
+// Sealed segments of a log (path.<last LSN>), oldest first
+std::vector<std::pair<uint64_t, std::string>> sealedSegments(const std::string& path) {
+    std::vector<std::pair<uint64_t, std::string>> segments;
+    std::string directory = parentDirectory(path);
+    size_t slash = path.rfind('/');
+    std::string prefix = (slash == std::string::npos ? path : path.substr(slash + 1)) + ".";
+    DIR* dir = ::opendir(directory.c_str());
+    if (!dir) {
+        return segments;
+    }
+    while (dirent* entry = ::readdir(dir)) {
+        std::string name = entry->d_name;
+        if (name.size() <= prefix.size() || name.compare(0, prefix.size(), prefix) != 0 ||
+            name.find_first_not_of("0123456789", prefix.size()) != std::string::npos) {
+            continue;
+        }
+        segments.emplace_back(std::stoull(name.substr(prefix.size())), directory + "/" + name);
+    }
+    ::closedir(dir);
+    std::sort(segments.begin(), segments.end());
+    return segments;
+}
+
+// Applies the sealed segments, then the active file; false on a foreign or
+// mismatched header
+bool readAll(const std::string& path, size_t dimension, const std::function<void(WalRecord&&)>& apply,
+             uint64_t& valid_end, uint64_t& file_size, uint64_t& last_lsn) {
+    uint64_t max_lsn = 0;
+    for (const auto& segment : sealedSegments(path)) {
+        if (readLog(segment.second, dimension, apply, valid_end, file_size, last_lsn) == ReadResult::BAD_HEADER) {
+            return false;
+        }
+        max_lsn = std::max(max_lsn, last_lsn);
+    }
+    if (readLog(path, dimension, apply, valid_end, file_size, last_lsn) == ReadResult::BAD_HEADER) {
+        return false;
+    }
+    last_lsn = std::max(max_lsn, last_lsn);
+    return true;
+}
+
+utils::Counter& walRecords() {
+    static auto& counter = utils::MetricsRegistry::getInstance().counter(
+        "rag_index_wal_records_total", "Vector index operations appended to the write-ahead log");
+    return counter;
+}
+
+utils::Counter& walSyncs() {
+    static auto& counter = utils::MetricsRegistry::getInstance().counter(
+        "rag_index_wal_syncs_total", "Write-ahead log group commits (one write and sync each)");
+    return counter;
+}
+
+} // namespace
+
+IndexWal::IndexWal(const std::string& path, size_t dimension, bool sync)
+    : path_(path), dimension_(dimension), sync_(sync) {
+}
+
+IndexWal::~IndexWal() {
+    if (fd_ >= 0) {
+        waitDurable(lastLsn());
+        ::close(fd_);
+    }
+}
+
+bool IndexWal::open(uint64_t min_lsn, const std::function<void(WalRecord&&)>& apply) {
+    uint64_t valid_end = 0;
+    uint64_t file_size = 0;
+    uint64_t last_lsn = 0;
+    if (!readAll(path_, dimension_, apply, valid_end, file_size, last_lsn)) {
+        return false;
+    }
+    
+    fd_ = ::open(path_.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        RAG_LOG_ERROR("Failed to open index WAL " + path_ + ": " + std::strerror(errno));
+        return false;
+    }
+    if (valid_end < kHeaderSize) {
+        // New (or torn while being created): start over with a header
+        uint32_t header[4] = {kWalMagic, kWalVersion, static_cast<uint32_t>(dimension_), 0};
+        if (::ftruncate(fd_, 0) != 0 || !writeAll(fd_, reinterpret_cast<const char*>(header), sizeof(header)) ||
+            ::fdatasync(fd_) != 0) {
+            RAG_LOG_ERROR("Failed to initialize index WAL " + path_ + ": " + std::strerror(errno));
+            return false;
+        }
+    } else if (valid_end < file_size) {
+        RAG_LOG_WARNING("Index WAL " + path_ + ": discarding " + std::to_string(file_size - valid_end) +
+                        " bytes after the last intact record");
+        if (::ftruncate(fd_, static_cast<off_t>(valid_end)) != 0 || ::fdatasync(fd_) != 0) {
+            RAG_LOG_ERROR("Failed to truncate index WAL " + path_ + ": " + std::strerror(errno));
+            return false;
+        }
+    }
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    last_lsn_ = durable_lsn_ = std::max(last_lsn, min_lsn);
+    active_bytes_ = std::max<uint64_t>(valid_end, kHeaderSize);
+    return true;
+}
+
+bool IndexWal::replay(const std::string& path, size_t dimension, const std::function<void(WalRecord&&)>& apply) {
+    uint64_t valid_end = 0;
+    uint64_t file_size = 0;
+    uint64_t last_lsn = 0;
+    return readAll(path, dimension, apply, valid_end, file_size, last_lsn);
+}
+
+std::string IndexWal::encodeAdd(const Document* docs, size_t count, const float* vectors, size_t dimension) {
+    size_t size = sizeof(uint32_t) + count * dimension * sizeof(float);
+    for (const Document* doc_it = docs; doc_it != docs + count; ++doc_it) {
+        const Document& doc = *doc_it;
+        size += 5 * sizeof(uint32_t) + doc.doc_id.size() + doc.content.size() + doc.source.size() + doc.timestamp.size();
+        for (const auto& [key, value] : doc.metadata) {
+            size += 2 * sizeof(uint32_t) + key.size() + value.size();
+        }
+    }
+    
+    std::string frame = startFrame(WalRecord::Type::ADD, size);
+    put<uint32_t>(frame, static_cast<uint32_t>(count));
+    for (const Document* doc_it = docs; doc_it != docs + count; ++doc_it) {
+        const Document& doc = *doc_it;
+        putString(frame, doc.doc_id);
+        putString(frame, doc.content);
+        putString(frame, doc.source);
+        putString(frame, doc.timestamp);
+        put<uint32_t>(frame, static_cast<uint32_t>(doc.metadata.size()));
+        for (const auto& [key, value] : doc.metadata) {
+            putString(frame, key);
+            putString(frame, value);
+        }
+    }
+    frame.append(reinterpret_cast<const char*>(vectors), count * dimension * sizeof(float));
+    return finishFrame(std::move(frame));
+}
+
+std::string IndexWal::encodeRemove(const std::string& doc_id) {
+    std::string frame = startFrame(WalRecord::Type::REMOVE, sizeof(uint32_t) + doc_id.size());
+    putString(frame, doc_id);
+    return finishFrame(std::move(frame));
+}
+
+uint64_t IndexWal::append(std::string&& record) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (failed_ || fd_ < 0) {
+        return 0;
+    }
+    uint64_t lsn = ++last_lsn_;
+    active_bytes_ += record.size() + sizeof(lsn);
+    uint32_t crc = 0;
+    std::memcpy(&crc, record.data() + 4, sizeof(crc));
+    crc = crc32(&lsn, sizeof(lsn), crc);
+    std::memcpy(&record[4], &crc, sizeof(crc));
+    
+    if (pending_.empty()) {
+        pending_ = std::move(record);
+    } else {
+        pending_.append(record);
+    }
+    put<uint64_t>(pending_, lsn);
+    walRecords().increment();
+    return lsn;
+}
+
+bool IndexWal::waitDurable(uint64_t lsn) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (durable_lsn_ < lsn) {
+        if (failed_) {
+            return false;
+        }
+        if (flushing_) {
+            flushed_.wait(lock);
+            continue;
+        }
+        
+        // Lead this group: write out everything queued so far
+        flushing_ = true;
+        std::string batch;
+        batch.swap(pending_);
+        uint64_t batch_lsn = last_lsn_;
+        lock.unlock();
+        
+        bool ok;
+        {
+            utils::ScopedTimer timer(utils::stageHistogram("index_wal", "commit"));
+            ok = writeAll(fd_, batch.data(), batch.size()) && (!sync_ || ::fdatasync(fd_) == 0);
+        }
+        if (!ok) {
+            RAG_LOG_ERROR("Index WAL write failed, further index changes are not durable: " +
+                          std::string(std::strerror(errno)));
+        }
+        walSyncs().increment();
+        
+        lock.lock();
+        flushing_ = false;
+        if (ok) {
+            durable_lsn_ = std::max(durable_lsn_, batch_lsn);
+        } else {
+            failed_ = true;
+        }
+        flushed_.notify_all();
+    }
+    return true;
+}
+
+bool IndexWal::rotate(uint64_t& sealed_lsn) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    flushed_.wait(lock, [this]() { return !flushing_; });
+    sealed_lsn = last_lsn_;
+    if (failed_ || fd_ < 0) {
+        return false;
+    }
+    if (active_bytes_ <= kHeaderSize) {
+        // Nothing logged since the last rotation
+        return true;
+    }
+    
+    // Queued records belong to the segment being sealed; their waiters are done
+    if (!pending_.empty()) {
+        bool ok = writeAll(fd_, pending_.data(), pending_.size()) && (!sync_ || ::fdatasync(fd_) == 0);
+        walSyncs().increment();
+        if (!ok) {
+            RAG_LOG_ERROR("Index WAL write failed, further index changes are not durable: " +
+                          std::string(std::strerror(errno)));
+            failed_ = true;
+            flushed_.notify_all();
+            return false;
+        }
+        pending_.clear();
+    }
+    durable_lsn_ = last_lsn_;
+    flushed_.notify_all();
+    
+    // A crash between the rename and the new header leaves no active file,
+    // which open() creates
+    std::string sealed_path = path_ + "." + std::to_string(sealed_lsn);
+    if (std::rename(path_.c_str(), sealed_path.c_str()) != 0) {
+        RAG_LOG_ERROR("Failed to seal index WAL " + path_ + ": " + std::strerror(errno));
+        return false;
+    }
+    int fd = ::open(path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    uint32_t header[4] = {kWalMagic, kWalVersion, static_cast<uint32_t>(dimension_), 0};
+    if (fd < 0 || !writeAll(fd, reinterpret_cast<const char*>(header), sizeof(header)) ||
+        (sync_ && ::fdatasync(fd) != 0)) {
+        // Appends would otherwise land in the sealed segment, which the
+        // checkpoint deletes
+        RAG_LOG_ERROR("Failed to start new index WAL " + path_ + ": " + std::strerror(errno));
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        failed_ = true;
+        return false;
+    }
+    if (sync_) {
+        syncDirectory(path_);
+    }
+    ::close(fd_);
+    fd_ = fd;
+    active_bytes_ = kHeaderSize;
+    return true;
+}
+
+void IndexWal::dropSealed(uint64_t lsn) {
+    bool dropped = false;
+    for (const auto& segment : sealedSegments(path_)) {
+        if (segment.first <= lsn) {
+            dropped = std::remove(segment.second.c_str()) == 0 || dropped;
+        }
+    }
+    if (dropped) {
+        syncDirectory(path_);
+    }
+}
+
+uint64_t IndexWal::lastLsn() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_lsn_;
+}
+
+uint64_t IndexWal::activeBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return active_bytes_;
+}
+
+} // namespace vectorization
+} // namespace rag
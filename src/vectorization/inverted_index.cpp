@@ -0,0 +1,396 @@
+#include "vectorization/inverted_index.h"
+#include "vectorization/text_analyzer.h"
+#include "data_ingestion/database.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <numeric>
+#include <queue>
+#include <unordered_set>
+
+namespace rag {
+namespace vectorization {
+
+namespace {
+
+const uint32_t kEndOfList = UINT32_MAX;
+
+void writeVarint(std::vector<uint8_t>& out, uint32_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+uint32_t readVarint(const uint8_t*& in) {
+    uint32_t value = 0;
+    int shift = 0;
+    while (*in & 0x80) {
+        value |= static_cast<uint32_t>(*in++ & 0x7f) << shift;
+        shift += 7;
+    }
+    value |= static_cast<uint32_t>(*in++) << shift;
+    return value;
+}
+
+} // namespace
+
+// Iterates one term's postings in doc order. Block metadata is consulted
+// without decoding, so skipped blocks cost nothing.
+class InvertedIndex::Cursor {
+public:
+    Cursor(const PostingList& list, double idf, double k1, double b, double average_length)
+        : list_(list), idf_(idf), k1_(k1), b_(b), average_length_(average_length),
+          block_count_(list.blocks.size() + (list.tail.empty() ? 0 : 1)) {
+        for (size_t i = 0; i < block_count_; ++i) {
+            max_score_ = std::max(max_score_, score(blockMaxTf(i), blockMinLength(i)));
+        }
+        load(0);
+    }
+    
+    uint32_t doc() const { return doc_; }
+    uint32_t tf() const { return tfs_[pos_]; }
+    double maxScore() const { return max_score_; }
+    
+    double score(uint32_t tf, uint32_t length) const {
+        double f = static_cast<double>(tf);
+        return idf_ * f * (k1_ + 1.0) / (f + k1_ * (1.0 - b_ + b_ * length / average_length_));
+    }
+    
+    void next() {
+        if (++pos_ < docs_.size()) {
+            doc_ = docs_[pos_];
+        } else {
+            load(block_ + 1);
+        }
+    }
+    
+    void nextGEQ(uint32_t target) {
+        if (doc_ >= target) {
+            return;
+        }
+        size_t block = block_;
+        while (block < block_count_ && blockLastDoc(block) < target) {
+            ++block;
+        }
+        if (block != block_) {
+            load(block);
+        }
+        while (doc_ < target) {
+            next();
+        }
+    }
+    
+    // Upper bound on this term's score within the block holding target
+    double blockMax(uint32_t target, uint32_t& block_end) const {
+        size_t block = block_;
+        while (block < block_count_ && blockLastDoc(block) < target) {
+            ++block;
+        }
+        if (block == block_count_) {
+            block_end = kEndOfList;
+            return 0.0;
+        }
+        block_end = blockLastDoc(block);
+        return score(blockMaxTf(block), blockMinLength(block));
+    }
+    
+private:
+    const PostingList& list_;
+    double idf_;
+    double k1_;
+    double b_;
+    double average_length_;
+    size_t block_count_;
+    double max_score_ = 0.0;
+    
+    size_t block_ = 0;
+    size_t pos_ = 0;
+    uint32_t doc_ = kEndOfList;
+    std::vector<uint32_t> docs_;
+    std::vector<uint32_t> tfs_;
+    
+    bool isTail(size_t block) const { return block == list_.blocks.size(); }
+    uint32_t blockLastDoc(size_t block) const {
+        return isTail(block) ? list_.tail.back().first : list_.blocks[block].last_doc;
+    }
+    uint32_t blockMaxTf(size_t block) const {
+        return isTail(block) ? list_.tail_max_tf : list_.blocks[block].max_tf;
+    }
+    uint32_t blockMinLength(size_t block) const {
+        return isTail(block) ? list_.tail_min_length : list_.blocks[block].min_length;
+    }
+    
+    void load(size_t block) {
+        block_ = block;
+        pos_ = 0;
+        docs_.clear();
+        tfs_.clear();
+        if (block >= block_count_) {
+            doc_ = kEndOfList;
+            return;
+        }
+        if (isTail(block)) {
+            for (const auto& [doc, tf] : list_.tail) {
+                docs_.push_back(doc);
+                tfs_.push_back(tf);
+            }
+        } else {
+            const Block& meta = list_.blocks[block];
+            const uint8_t* in = list_.bytes.data() + meta.offset;
+            uint32_t doc = meta.base_doc;
+            for (uint16_t i = 0; i < meta.count; ++i) {
+                doc += readVarint(in);
+                docs_.push_back(doc);
+                tfs_.push_back(readVarint(in));
+            }
+        }
+        doc_ = docs_[0];
+    }
+};
+
+InvertedIndex::InvertedIndex(double k1, double b) : k1_(k1), b_(b) {
+}
+
+void InvertedIndex::seal(PostingList& list) {
+    Block block;
+    block.base_doc = list.blocks.empty() ? 0 : list.blocks.back().last_doc;
+    block.last_doc = list.tail.back().first;
+    block.offset = static_cast<uint32_t>(list.bytes.size());
+    block.count = static_cast<uint16_t>(list.tail.size());
+    block.max_tf = static_cast<uint16_t>(std::min<uint32_t>(list.tail_max_tf, UINT16_MAX));
+    block.min_length = list.tail_min_length;
+    
+    uint32_t previous = block.base_doc;
+    for (const auto& [doc, tf] : list.tail) {
+        writeVarint(list.bytes, doc - previous);
+        writeVarint(list.bytes, std::min<uint32_t>(tf, UINT16_MAX));
+        previous = doc;
+    }
+    list.blocks.push_back(block);
+    list.tail.clear();
+    list.tail_max_tf = 0;
+    list.tail_min_length = UINT32_MAX;
+}
+
+void InvertedIndex::append(PostingList& list, uint32_t doc, uint32_t tf, uint32_t length) {
+    list.tail.emplace_back(doc, tf);
+    list.tail_max_tf = std::max(list.tail_max_tf, tf);
+    list.tail_min_length = std::min(list.tail_min_length, length);
+    ++list.document_frequency;
+    if (list.tail.size() == kBlockSize) {
+        seal(list);
+    }
+}
+
+bool InvertedIndex::addDocument(const Document& doc) {
+    std::vector<std::string> terms = TextAnalyzer::analyze(doc.content);
+    std::unordered_map<std::string, uint32_t> frequencies;
+    for (const auto& term : terms) {
+        ++frequencies[term];
+    }
+    
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    if (ids_.count(doc.doc_id)) {
+        return false;
+    }
+    uint32_t id = static_cast<uint32_t>(documents_.size());
+    uint32_t length = static_cast<uint32_t>(std::max<size_t>(1, terms.size()));
+    ids_[doc.doc_id] = id;
+    documents_.push_back(doc);
+    lengths_.push_back(length);
+    total_length_ += length;
+    for (const auto& [term, tf] : frequencies) {
+        append(postings_[term], id, tf, length);
+    }
+    return true;
+}
+
+bool InvertedIndex::build(data::Database& database) {
+    std::vector<data::NewsArticle> articles;
+    if (!database.getAllNewsArticles(articles)) {
+        RAG_LOG_ERROR("Failed to load news articles for the lexical index");
+        return false;
+    }
+    
+    for (const auto& article : articles) {
+        Document doc;
+        doc.doc_id = article.id;
+        doc.content = article.title + "\n" + article.content;
+        doc.source = article.source;
+        doc.timestamp = article.published_time;
+        if (!article.tickers.empty()) {
+            doc.metadata["symbol"] = article.tickers[0];
+        }
+        doc.metadata["title"] = article.title;
+        doc.metadata["type"] = "news";
+        addDocument(doc);
+    }
+    
+    RAG_LOG_INFO("Lexical index built over " + std::to_string(size()) + " news articles");
+    return true;
+}
+
+size_t InvertedIndex::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return documents_.size();
+}
+
+std::vector<SearchResult> InvertedIndex::search(const std::string& query, size_t k) const {
+    std::vector<std::string> terms = TextAnalyzer::analyze(query);
+    std::unordered_set<std::string> unique_terms(terms.begin(), terms.end());
+    
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    std::vector<SearchResult> results;
+    if (documents_.empty() || k == 0) {
+        return results;
+    }
+    
+    double n = static_cast<double>(documents_.size());
+    double average_length = static_cast<double>(total_length_) / n;
+    std::vector<Cursor> storage;
+    storage.reserve(unique_terms.size());
+    for (const auto& term : unique_terms) {
+        auto it = postings_.find(term);
+        if (it == postings_.end()) {
+            continue;
+        }
+        double df = static_cast<double>(it->second.document_frequency);
+        double idf = std::log(1.0 + (n - df + 0.5) / (df + 0.5));
+        storage.emplace_back(it->second, idf, k1_, b_, average_length);
+    }
+    std::vector<Cursor*> cursors;
+    for (auto& cursor : storage) {
+        cursors.push_back(&cursor);
+    }
+    
+    // Min-heap of the best k (score, doc) so far
+    using Entry = std::pair<double, uint32_t>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> top;
+    auto threshold = [&top, k]() { return top.size() < k ? 0.0 : top.top().first; };
+    
+    while (true) {
+        std::sort(cursors.begin(), cursors.end(), [](const Cursor* a, const Cursor* b) {
+            return a->doc() < b->doc();
+        });
+        
+        // Pivot: first cursor at which the summed maxima can beat the threshold
+        double bound = 0.0;
+        size_t pivot = cursors.size();
+        for (size_t i = 0; i < cursors.size(); ++i) {
+            bound += cursors[i]->maxScore();
+            if (bound > threshold()) {
+                pivot = i;
+                break;
+            }
+        }
+        if (pivot == cursors.size() || cursors[pivot]->doc() == kEndOfList) {
+            break;
+        }
+        uint32_t pivot_doc = cursors[pivot]->doc();
+        while (pivot + 1 < cursors.size() && cursors[pivot + 1]->doc() == pivot_doc) {
+            ++pivot;
+        }
+        
+        // Block-max check: can the current blocks actually reach the threshold?
+        double block_bound = 0.0;
+        uint32_t skip_to = kEndOfList;
+        for (size_t i = 0; i <= pivot; ++i) {
+            uint32_t block_end;
+            block_bound += cursors[i]->blockMax(pivot_doc, block_end);
+            skip_to = std::min(skip_to, block_end == kEndOfList ? kEndOfList : block_end + 1);
+        }
+        if (block_bound <= threshold()) {
+            if (pivot + 1 < cursors.size()) {
+                skip_to = std::min(skip_to, cursors[pivot + 1]->doc());
+            }
+            for (size_t i = 0; i <= pivot; ++i) {
+                cursors[i]->nextGEQ(skip_to);
+            }
+            continue;
+        }
+        
+        if (cursors[0]->doc() == pivot_doc) {
+            double score = 0.0;
+            for (size_t i = 0; i <= pivot; ++i) {
+                score += cursors[i]->score(cursors[i]->tf(), lengths_[pivot_doc]);
+                cursors[i]->next();
+            }
+            if (top.size() < k) {
+                top.emplace(score, pivot_doc);
+            } else if (score > top.top().first) {
+                top.pop();
+                top.emplace(score, pivot_doc);
+            }
+        } else {
+            for (size_t i = 0; i < pivot && cursors[i]->doc() < pivot_doc; ++i) {
+                cursors[i]->nextGEQ(pivot_doc);
+            }
+        }
+    }
+    
+    while (!top.empty()) {
+        const Document& doc = documents_[top.top().second];
+        SearchResult result;
+        result.doc_id = doc.doc_id;
+        result.content = doc.content;
+        result.source = doc.source;
+        result.timestamp = doc.timestamp;
+        result.similarity_score = top.top().first;
+        result.metadata = doc.metadata;
+        results.push_back(std::move(result));
+        top.pop();
+    }
+    std::reverse(results.begin(), results.end());
+    return results;
+}
+
+std::vector<SearchResult> reciprocalRankFusion(std::vector<SearchResult> dense,
+                                               std::vector<SearchResult> lexical,
+                                               size_t k, double rrf_k) {
+    std::vector<SearchResult> fused;
+    std::vector<double> scores;
+    std::unordered_map<std::string, std::vector<size_t>> by_article;
+    
+    for (size_t rank = 0; rank < dense.size(); ++rank) {
+        auto parent_it = dense[rank].metadata.find("parent_doc_id");
+        const std::string& article = parent_it != dense[rank].metadata.end() ? parent_it->second : dense[rank].doc_id;
+        by_article[article].push_back(fused.size());
+        fused.push_back(std::move(dense[rank]));
+        fused.back().metadata["retrieval"] = "vector";
+        scores.push_back(1.0 / (rrf_k + static_cast<double>(rank + 1)));
+    }
+    for (size_t rank = 0; rank < lexical.size(); ++rank) {
+        double score = 1.0 / (rrf_k + static_cast<double>(rank + 1));
+        auto it = by_article.find(lexical[rank].doc_id);
+        if (it != by_article.end()) {
+            for (size_t index : it->second) {
+                scores[index] += score;
+                fused[index].metadata["retrieval"] = "hybrid";
+            }
+        } else {
+            fused.push_back(std::move(lexical[rank]));
+            fused.back().metadata["retrieval"] = "lexical";
+            scores.push_back(score);
+        }
+    }
+    
+    std::vector<size_t> order(fused.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&scores](size_t a, size_t b) {
+        return scores[a] > scores[b];
+    });
+    
+    std::vector<SearchResult> results;
+    for (size_t i = 0; i < order.size() && results.size() < k; ++i) {
+        SearchResult& result = fused[order[i]];
+        result.similarity_score = scores[order[i]];
+        results.push_back(std::move(result));
+    }
+    return results;
+}
+
+} // namespace vectorization
+} // namespace rag
@@ -0,0 +1,267 @@
+#include "vectorization/local_embedding_model.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define RAG_HAVE_X86_SIMD 1
+#endif
+
+namespace rag {
+namespace vectorization {
+
+namespace {
+
+const char kMagic[8] = {'R', 'A', 'G', 'S', 'T', 'E', 'M', 'B'};
+const size_t kMaxTokensPerText = 4096;
+const size_t kMaxWordChars = 100;
+
+void addRowScalar(float* sum, const float* row, size_t dimension) {
+    for (size_t i = 0; i < dimension; ++i) {
+        sum[i] += row[i];
+    }
+}
+
+float dotScalar(const float* a, const float* b, size_t dimension) {
+    float total = 0.0f;
+    for (size_t i = 0; i < dimension; ++i) {
+        total += a[i] * b[i];
+    }
+    return total;
+}
+
+#ifdef RAG_HAVE_X86_SIMD
+__attribute__((target("avx2,fma")))
+void addRowAvx2(float* sum, const float* row, size_t dimension) {
+    size_t i = 0;
+    for (; i + 8 <= dimension; i += 8) {
+        _mm256_storeu_ps(sum + i, _mm256_add_ps(_mm256_loadu_ps(sum + i), _mm256_loadu_ps(row + i)));
+    }
+    for (; i < dimension; ++i) {
+        sum[i] += row[i];
+    }
+}
+
+__attribute__((target("avx2,fma")))
+float dotAvx2(const float* a, const float* b, size_t dimension) {
+    __m256 acc = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= dimension; i += 8) {
+        acc = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc);
+    }
+    __m128 low = _mm256_castps256_ps128(acc);
+    __m128 high = _mm256_extractf128_ps(acc, 1);
+    low = _mm_add_ps(low, high);
+    low = _mm_hadd_ps(low, low);
+    low = _mm_hadd_ps(low, low);
+    float total = _mm_cvtss_f32(low);
+    for (; i < dimension; ++i) {
+        total += a[i] * b[i];
+    }
+    return total;
+}
+#endif
+
+struct Kernels {
+    void (*add_row)(float*, const float*, size_t);
+    float (*dot)(const float*, const float*, size_t);
+};
+
+const Kernels& kernels() {
+    static const Kernels selected = [] {
+#ifdef RAG_HAVE_X86_SIMD
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+            return Kernels{addRowAvx2, dotAvx2};
+        }
+#endif
+        return Kernels{addRowScalar, dotScalar};
+    }();
+    return selected;
+}
+
+template <typename T>
+bool readValue(std::ifstream& file, T& value) {
+    return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+bool isPunctuation(unsigned char c) {
+    return c < 0x80 && std::ispunct(c);
+}
+
+} // namespace
+
+bool LocalEmbeddingModel::load(const std::string& filepath) {
+    std::ifstream file(filepath, std::ios::binary);
+    if (!file.is_open()) {
+        RAG_LOG_ERROR("Local embedding model not found: " + filepath);
+        return false;
+    }
+    
+    char magic[8];
+    uint32_t version = 0, vocab_size = 0, dimension = 0, flags = 0;
+    if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, kMagic, sizeof(magic)) != 0 ||
+        !readValue(file, version) || version != 1 || !readValue(file, vocab_size) ||
+        !readValue(file, dimension) || !readValue(file, flags) || dimension == 0) {
+        RAG_LOG_ERROR("Invalid local embedding model file: " + filepath);
+        return false;
+    }
+    
+    std::unordered_map<std::string, uint32_t> vocab;
+    vocab.reserve(vocab_size);
+    std::string token;
+    for (uint32_t id = 0; id < vocab_size; ++id) {
+        uint16_t length = 0;
+        if (!readValue(file, length)) {
+            RAG_LOG_ERROR("Truncated vocabulary in " + filepath);
+            return false;
+        }
+        token.resize(length);
+        if (length > 0 && !file.read(&token[0], length)) {
+            RAG_LOG_ERROR("Truncated vocabulary in " + filepath);
+            return false;
+        }
+        vocab.emplace(token, id);
+    }
+    
+    std::vector<float> vectors(static_cast<size_t>(vocab_size) * dimension);
+    if (!file.read(reinterpret_cast<char*>(vectors.data()), vectors.size() * sizeof(float))) {
+        RAG_LOG_ERROR("Truncated embedding matrix in " + filepath);
+        return false;
+    }
+    
+    vocab_ = std::move(vocab);
+    vectors_ = std::move(vectors);
+    dimension_ = dimension;
+    lowercase_ = (flags & 1) != 0;
+    RAG_LOG_INFO("Loaded local embedding model " + filepath + " (" + std::to_string(vocab_size) +
+                 " tokens, dimension " + std::to_string(dimension) + ")");
+    return true;
+}
+
+void LocalEmbeddingModel::appendWordPieces(const std::string& word, std::vector<uint32_t>& ids) const {
+    if (word.size() > kMaxWordChars) {
+        return;
+    }
+    
+    // Greedy longest-match-first, continuation pieces prefixed with "##"
+    size_t word_start = ids.size();
+    size_t start = 0;
+    std::string piece;
+    while (start < word.size()) {
+        size_t end = word.size();
+        bool found = false;
+        while (end > start) {
+            piece = start > 0 ? "##" + word.substr(start, end - start) : word.substr(start, end - start);
+            auto it = vocab_.find(piece);
+            if (it != vocab_.end()) {
+                ids.push_back(it->second);
+                found = true;
+                break;
+            }
+            --end;
+        }
+        if (!found) {
+            ids.resize(word_start); // Unknown word: contributes nothing, like [UNK]
+            return;
+        }
+        start = end;
+    }
+}
+
+void LocalEmbeddingModel::tokenize(const std::string& text, std::vector<uint32_t>& ids) const {
+    std::string word;
+    auto flush = [&]() {
+        if (!word.empty()) {
+            appendWordPieces(word, ids);
+            word.clear();
+        }
+    };
+    
+    for (char raw : text) {
+        unsigned char c = static_cast<unsigned char>(raw);
+        if (std::isspace(c)) {
+            flush();
+        } else if (isPunctuation(c)) {
+            flush();
+            word = raw;
+            flush();
+        } else {
+            word += lowercase_ && c < 0x80 ? static_cast<char>(std::tolower(c)) : raw;
+        }
+        if (ids.size() >= kMaxTokensPerText) {
+            return;
+        }
+    }
+    flush();
+}
+
+bool LocalEmbeddingModel::embed(const std::string& text, std::vector<float>& embedding) const {
+    if (!loaded()) {
+        return false;
+    }
+    
+    std::vector<uint32_t> ids;
+    tokenize(text, ids);
+    embedding.assign(dimension_, 0.0f);
+    if (ids.empty()) {
+        return true; // Nothing recognizable: zero vector, matches nothing
+    }
+    
+    const Kernels& simd = kernels();
+    for (uint32_t id : ids) {
+        simd.add_row(embedding.data(), vectors_.data() + static_cast<size_t>(id) * dimension_, dimension_);
+    }
+    
+    // Mean pooling then L2 normalization; the mean's scale cancels out
+    float norm = std::sqrt(simd.dot(embedding.data(), embedding.data(), dimension_));
+    if (norm > 0.0f) {
+        float inverse = 1.0f / norm;
+        for (float& value : embedding) {
+            value *= inverse;
+        }
+    }
+    return true;
+}
+
+bool LocalEmbeddingModel::embedBatch(const std::vector<std::string>& texts,
+                                     std::vector<std::vector<float>>& embeddings, size_t threads) const {
+    if (!loaded()) {
+        return false;
+    }
+    embeddings.assign(texts.size(), std::vector<float>());
+    
+    // Threads only pay off once each has a few dozen texts
+    const size_t min_texts_per_thread = 32;
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = std::max<size_t>(1, std::min(threads, texts.size() / min_texts_per_thread));
+    
+    auto work = [&](size_t first, size_t stride) {
+        for (size_t i = first; i < texts.size(); i += stride) {
+            embed(texts[i], embeddings[i]);
+        }
+    };
+    if (threads == 1) {
+        work(0, 1);
+        return true;
+    }
+    
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < threads; ++t) {
+        workers.emplace_back(work, t, threads);
+    }
+    work(0, threads);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    return true;
+}
+
+} // namespace vectorization
+} // namespace rag
@@ -0,0 +1,120 @@
+#include "vectorization/text_analyzer.h"
+#include <cctype>
+#include <unordered_set>
+
+namespace rag {
+namespace vectorization {
+
+namespace {
+
+bool isWordChar(unsigned char c) {
+    return std::isalnum(c) || c >= 0x80;
+}
+
+bool isJoiner(char c) {
+    return c == '-' || c == '.' || c == '&' || c == '\'';
+}
+
+const std::unordered_set<std::string>& stopwords() {
+    static const std::unordered_set<std::string> words = {
+        "a", "an", "and", "are", "as", "at", "be", "been", "but", "by", "for", "from", "has", "have",
+        "in", "into", "is", "it", "its", "of", "on", "or", "over", "that", "the", "their", "this",
+        "to", "was", "were", "which", "will", "with", "what", "how", "why", "about", "after", "than"};
+    return words;
+}
+
+// Uppercase words that are almost never tickers in financial news
+const std::unordered_set<std::string>& commonCapitals() {
+    static const std::unordered_set<std::string> words = {
+        "A", "I", "AI", "CEO", "CFO", "COO", "CTO", "EPS", "ETF", "EU", "FDA", "FED", "GDP", "IPO",
+        "M", "NYSE", "Q", "SEC", "UK", "US", "USA", "USD", "YOY"};
+    return words;
+}
+
+// Split into raw words, keeping joiners that sit between word characters
+template <typename Callback>
+void forEachWord(const std::string& text, Callback callback) {
+    size_t i = 0;
+    size_t n = text.size();
+    while (i < n) {
+        while (i < n && !isWordChar(static_cast<unsigned char>(text[i]))) {
+            ++i;
+        }
+        size_t begin = i;
+        while (i < n) {
+            unsigned char c = static_cast<unsigned char>(text[i]);
+            if (isWordChar(c)) {
+                ++i;
+            } else if (isJoiner(text[i]) && i + 1 < n && isWordChar(static_cast<unsigned char>(text[i + 1]))) {
+                i += 2;
+            } else {
+                break;
+            }
+        }
+        if (i > begin) {
+            callback(text.substr(begin, i - begin));
+        }
+    }
+}
+
+std::string foldPlural(std::string term) {
+    size_t n = term.size();
+    if (n > 4 && term.compare(n - 3, 3, "ies") == 0) {
+        term.replace(n - 3, 3, "y");
+    } else if (n > 3 && term[n - 1] == 's' && term[n - 2] != 's' && term[n - 2] != 'u' && term[n - 2] != 'i' &&
+               std::isalpha(static_cast<unsigned char>(term[n - 2]))) {
+        term.pop_back();
+    }
+    return term;
+}
+
+} // namespace
+
+std::vector<std::string> TextAnalyzer::analyze(const std::string& text) {
+    std::vector<std::string> terms;
+    forEachWord(text, [&terms](std::string word) {
+        for (char& c : word) {
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+        if (word.size() > 2 && word.compare(word.size() - 2, 2, "'s") == 0) {
+            word.resize(word.size() - 2);
+        }
+        std::string term;
+        term.reserve(word.size());
+        for (char c : word) {
+            if (c != '\'') {
+                term += c;
+            }
+        }
+        if (term.empty() || stopwords().count(term)) {
+            return;
+        }
+        terms.push_back(foldPlural(std::move(term)));
+    });
+    return terms;
+}
+
+std::vector<std::string> TextAnalyzer::extractSymbols(const std::string& text) {
+    std::vector<std::string> symbols;
+    forEachWord(text, [&symbols](const std::string& word) {
+        size_t dot = word.find('.');
+        std::string base = word.substr(0, dot);
+        if (base.empty() || base.size() > 5 || commonCapitals().count(base)) {
+            return;
+        }
+        for (char c : base) {
+            if (!std::isupper(static_cast<unsigned char>(c))) {
+                return;
+            }
+        }
+        // Share classes: "BRK.B"
+        if (dot != std::string::npos && (word.size() - dot != 2 || !std::isupper(static_cast<unsigned char>(word.back())))) {
+            return;
+        }
+        symbols.push_back(word);
+    });
+    return symbols;
+}
+
+} // namespace vectorization
+} // namespace rag
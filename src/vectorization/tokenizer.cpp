@@ -0,0 +1,226 @@
+#include "vectorization/tokenizer.h"
+#include "utils/logger.h"
+#include <atomic>
+#include <cctype>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <numeric>
+#include <unordered_map>
+
+namespace rag {
+namespace vectorization {
+
+namespace {
+
+using BpeRanks = std::unordered_map<std::string, uint32_t>;
+
+std::shared_ptr<const BpeRanks> g_bpe_ranks;
+
+std::shared_ptr<const BpeRanks> bpeRanks() {
+    return std::atomic_load(&g_bpe_ranks);
+}
+
+bool decodeBase64(const std::string& input, std::string& output) {
+    static const std::string kAlphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    output.clear();
+    uint32_t buffer = 0;
+    int bits = 0;
+    for (char c : input) {
+        if (c == '=') {
+            break;
+        }
+        size_t value = kAlphabet.find(c);
+        if (value == std::string::npos) {
+            return false;
+        }
+        buffer = (buffer << 6) | static_cast<uint32_t>(value);
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            output += static_cast<char>((buffer >> bits) & 0xff);
+        }
+    }
+    return true;
+}
+
+// Byte-level BPE: repeatedly merge the adjacent pair with the lowest rank
+size_t bpeTokenCount(const BpeRanks& ranks, const std::string& text, size_t begin, size_t end) {
+    size_t length = end - begin;
+    if (length <= 1) {
+        return length;
+    }
+    
+    // Common words repeat constantly; remember their counts per thread
+    thread_local std::unordered_map<std::string, uint32_t> cache;
+    std::string piece = text.substr(begin, length);
+    auto cached = cache.find(piece);
+    if (cached != cache.end()) {
+        return cached->second;
+    }
+    
+    size_t count = 1;
+    if (!ranks.count(piece)) {
+        std::vector<size_t> bounds(length + 1);
+        std::iota(bounds.begin(), bounds.end(), 0);
+        std::string pair;
+        while (bounds.size() > 2) {
+            uint32_t best_rank = UINT32_MAX;
+            size_t best = 0;
+            for (size_t i = 0; i + 2 < bounds.size(); ++i) {
+                pair.assign(piece, bounds[i], bounds[i + 2] - bounds[i]);
+                auto it = ranks.find(pair);
+                if (it != ranks.end() && it->second < best_rank) {
+                    best_rank = it->second;
+                    best = i;
+                }
+            }
+            if (best_rank == UINT32_MAX) {
+                break;
+            }
+            bounds.erase(bounds.begin() + best + 1);
+        }
+        count = bounds.size() - 1;
+    }
+    
+    if (cache.size() >= 65536) {
+        cache.clear();
+    }
+    cache.emplace(std::move(piece), static_cast<uint32_t>(count));
+    return count;
+}
+
+bool isLetter(unsigned char c) {
+    // Treat UTF-8 continuation/lead bytes as letters so words stay intact
+    return std::isalpha(c) || c >= 0x80;
+}
+
+size_t estimatePieceTokens(const std::string& text, size_t begin, size_t end) {
+    size_t length = end - begin;
+    unsigned char first = static_cast<unsigned char>(text[begin]);
+    if (first == ' ' && length > 1) {
+        // Leading space merges into the following word
+        ++begin;
+        --length;
+        first = static_cast<unsigned char>(text[begin]);
+    }
+    if (std::isspace(first)) {
+        return 1;
+    }
+    if (isLetter(first)) {
+        // Common words are one token; long or rare words split every ~6 chars
+        return (length + 5) / 6;
+    }
+    if (std::isdigit(first)) {
+        return 1; // Digit runs are pre-split into groups of at most three
+    }
+    return length; // Punctuation rarely merges beyond one or two chars
+}
+
+} // namespace
+
+std::vector<TokenPiece> Tokenizer::pretokenize(const std::string& text) {
+    std::shared_ptr<const BpeRanks> ranks = bpeRanks();
+    std::vector<TokenPiece> pieces;
+    size_t i = 0;
+    size_t n = text.size();
+    
+    while (i < n) {
+        size_t begin = i;
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        
+        // A single space attaches to the word, number or punctuation that follows
+        if (c == ' ' && i + 1 < n && !std::isspace(static_cast<unsigned char>(text[i + 1]))) {
+            ++i;
+            c = static_cast<unsigned char>(text[i]);
+        }
+        
+        if (isLetter(c)) {
+            while (i < n && isLetter(static_cast<unsigned char>(text[i]))) {
+                ++i;
+            }
+            // Contractions ('s, 't, 're, ...) stay attached
+            if (i + 1 < n && text[i] == '\'' && std::isalpha(static_cast<unsigned char>(text[i + 1]))) {
+                size_t suffix_begin = i;
+                i += 2;
+                while (i < n && std::isalpha(static_cast<unsigned char>(text[i])) && i - suffix_begin < 3) {
+                    ++i;
+                }
+            }
+        } else if (std::isdigit(c)) {
+            size_t digits = 0;
+            while (i < n && std::isdigit(static_cast<unsigned char>(text[i])) && digits < 3) {
+                ++i;
+                ++digits;
+            }
+        } else if (std::isspace(c)) {
+            while (i < n && std::isspace(static_cast<unsigned char>(text[i]))) {
+                ++i;
+            }
+        } else {
+            while (i < n) {
+                unsigned char p = static_cast<unsigned char>(text[i]);
+                if (std::isspace(p) || isLetter(p) || std::isdigit(p)) {
+                    break;
+                }
+                ++i;
+            }
+        }
+        
+        TokenPiece piece;
+        piece.begin = begin;
+        piece.end = i;
+        // Very long runs (URLs, base64 blobs) would make the merge loop quadratic
+        piece.tokens = ranks && i - begin <= 256 ? bpeTokenCount(*ranks, text, begin, i)
+                                                 : estimatePieceTokens(text, begin, i);
+        
+        char last = text[i - 1];
+        bool at_boundary = i == n || std::isspace(static_cast<unsigned char>(text[i]));
+        piece.sentence_end = last == '\n' || ((last == '.' || last == '!' || last == '?') && at_boundary);
+        pieces.push_back(piece);
+    }
+    
+    return pieces;
+}
+
+size_t Tokenizer::countTokens(const std::string& text) {
+    size_t total = 0;
+    for (const auto& piece : pretokenize(text)) {
+        total += piece.tokens;
+    }
+    return total;
+}
+
+bool Tokenizer::loadBpeRanks(const std::string& filepath) {
+    std::ifstream file(filepath);
+    if (!file.is_open()) {
+        RAG_LOG_WARNING("BPE ranks file not found: " + filepath + " - using heuristic token counts");
+        return false;
+    }
+    
+    auto ranks = std::make_shared<BpeRanks>();
+    std::string line;
+    std::string token;
+    while (std::getline(file, line)) {
+        size_t space = line.find(' ');
+        if (space == std::string::npos || !decodeBase64(line.substr(0, space), token)) {
+            continue;
+        }
+        (*ranks)[token] = static_cast<uint32_t>(std::stoul(line.substr(space + 1)));
+    }
+    
+    if (ranks->empty()) {
+        RAG_LOG_WARNING("No BPE ranks in " + filepath + " - using heuristic token counts");
+        return false;
+    }
+    std::atomic_store(&g_bpe_ranks, std::shared_ptr<const BpeRanks>(ranks));
+    RAG_LOG_INFO("Loaded " + std::to_string(ranks->size()) + " BPE ranks from " + filepath);
+    return true;
+}
+
+bool Tokenizer::hasBpeRanks() {
+    return bpeRanks() != nullptr;
+}
+
+} // namespace vectorization
+} // namespace rag